@@ -0,0 +1,10 @@
+// filled once per frame by FrameUniforms_Update (frame_uniforms.hpp), std140
+layout(std140) uniform FrameBlock{
+    mat4 u_View;
+    mat4 u_Projection;
+    mat4 u_ViewProjection;
+    mat4 u_InverseView;
+    mat4 u_InverseProjection;
+    mat4 u_InverseViewProjection;
+    vec4 u_CameraPosition;
+};
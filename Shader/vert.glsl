@@ -1,16 +1,54 @@
 #version 410 core
 
+// one source for every variant, SHADER_* are set per variant (shader_source.hpp)
+
 layout(location=0) in vec3 position;
 layout(location=1) in vec3 vertexColors;
 
-uniform mat4 u_ModelMatrix;
-uniform mat4 u_Projection;
-uniform mat4 u_ViewMatrix;
+#include "frame_block.glsl"
+
+#if SHADER_INSTANCED
+// per instance projection * view * model, filled by Instancing_Flush (instancing.hpp), takes locations 2..5
+layout(location=2) in mat4 a_ModelViewProjection;
+#elif SHADER_INDIRECT
+// index of the draw within the multi draw, fed from baseInstance by Indirect_Draw (indirect.hpp)
+layout(location=8) in uint a_DrawIndex;
+
+// IndirectDrawRecord (draw_commands.hpp)
+struct DrawRecord{
+    uint matrixIndex;
+    uint material;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, binding=1) readonly buffer DrawRecordBlock{
+    DrawRecord u_DrawRecords[];
+};
+
+// projection * view * model of every mesh drawn this frame
+layout(std430, binding=2) readonly buffer MatrixBlock{
+    mat4 u_ModelViewProjections[];
+};
+#else
+// projection * view * model, precomputed for all visible meshes in one batch (matrix_batch.hpp)
+// and uploaded in one buffer, the drawn mesh's block is bound per draw (frame_uniforms.hpp)
+layout(std140) uniform ObjectBlock{
+    mat4 u_ModelViewProjection;
+};
+#endif
 
 out vec3 v_vertexColors;
 
 void main(){
     v_vertexColors = vertexColors;
-    vec4 newPosition = u_Projection * u_ViewMatrix * u_ModelMatrix * vec4(position, 1.0f);
+#if SHADER_INSTANCED
+    gl_Position = a_ModelViewProjection * vec4(position, 1.0f);
+#elif SHADER_INDIRECT
+    DrawRecord record = u_DrawRecords[a_DrawIndex];
+    gl_Position = u_ModelViewProjections[record.matrixIndex] * vec4(position, 1.0f);
+#else
+    vec4 newPosition = u_ModelViewProjection * vec4(position, 1.0f);
     gl_Position = vec4(newPosition.x, newPosition.y ,newPosition.z, newPosition.w); //w need for perspective position
+#endif
 }
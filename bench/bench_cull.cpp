@@ -0,0 +1,55 @@
+// Headless frustum culling microbenchmark, no window or GL context needed. One
+// thread (the job system isn't started), bench_jobs measures the split over cores.
+//   make bench_cull && ./bench_cull [count]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include "../culling.hpp"
+
+int main(int argc, char **argv){
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    const int iterations = 50;
+
+    // spheres scattered around the camera, about a tenth end up visible
+    BoundsTable table;
+    Bounds_Reserve(&table, count);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 2.0f);
+    for(size_t i=0; i<count; i++){
+        Bounds_Push(&table, glm::vec3(position(rng), position(rng), position(rng)), radius(rng));
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f/9.0f, 0.1f, 150.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum_FromMatrix(projection * view);
+
+    std::vector<uint32_t> visible(count);
+    size_t reference = 0;
+    const CullKernel kernels[] = {CULL_KERNEL_SCALAR, CULL_KERNEL_SSE, CULL_KERNEL_AVX2};
+    for(CullKernel kernel : kernels){
+        Cull_SetKernel(kernel);
+        if(Cull_GetKernel() != kernel){
+            printf("%-8s unsupported on this CPU\n", Cull_KernelName(kernel));
+            continue;
+        }
+        size_t visibleCount = Cull_Spheres(frustum, &table, visible.data());     // warm up
+        auto start = std::chrono::steady_clock::now();
+        for(int i=0; i<iterations; i++){
+            visibleCount = Cull_Spheres(frustum, &table, visible.data());
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if(kernel == CULL_KERNEL_SCALAR){
+            reference = visibleCount;
+        }
+        printf("%-8s %zu spheres: %6.3f ns/object, %zu visible%s\n", Cull_KernelName(kernel), count,
+               ns / iterations / count, visibleCount, visibleCount == reference ? "" : "  (MISMATCH vs scalar)");
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Indirect command building: bucketing N meshes and writing their DrawElementsIndirectCommand,
+// record and matrix, as Indirect_Draw does into its mapped buffers. No window or GL context
+// needed, the arenas are only filled CPU side.
+//   make bench_draw_commands && ./bench_draw_commands [meshes...]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../draw_commands.hpp"
+#include "../jobs.hpp"
+
+// pipelines x arenas x index types the meshes are spread over
+#define BENCH_PIPELINES 3
+#define BENCH_ARENAS 2
+#define BENCH_RANGES 64
+
+// every mesh shows up in exactly one command, inside a bucket matching it
+static bool Validate(const DrawCommandBuilder *builder, const Mesh3D *const *meshes, const glm::mat4 *modelViewProjections,
+                     size_t count, const DrawElementsIndirectCommand *commands, const IndirectDrawRecord *records,
+                     const glm::mat4 *matrices){
+    std::vector<bool> seen(count, false);
+    size_t total = 0;
+    for(const DrawBucket &bucket : builder->m_Buckets){
+        for(uint32_t slot=bucket.m_First; slot<bucket.m_First+bucket.m_Count; slot++){
+            uint32_t input = records[slot].m_MatrixIndex;
+            if(input >= count || seen[input] || builder->m_Order[slot] != input){
+                return false;
+            }
+            seen[input] = true;
+            const Mesh3D *mesh = meshes[input];
+            const GeometryRange &range = mesh->m_Arena->m_Ranges[mesh->m_GeometryRange];
+            if(mesh->m_Pipeline != bucket.m_Pipeline || mesh->m_VertexArrayObject != bucket.m_VertexArrayObject
+               || mesh->m_IndexType != bucket.m_IndexType || commands[slot].m_BaseInstance != slot
+               || commands[slot].m_Count != (uint32_t)mesh->m_IndexCount
+               || commands[slot].m_BaseVertex != (int32_t)range.m_Vertices.m_Offset
+               || commands[slot].m_FirstIndex != range.m_Indices.m_Offset * (4 / range.m_IndexSize)
+               || matrices[input] != modelViewProjections[input]){
+                return false;
+            }
+        }
+        total += bucket.m_Count;
+    }
+    return total == count;
+}
+
+static bool Run(size_t count, std::mt19937 &rng){
+    static Pipeline pipelines[BENCH_PIPELINES];
+    static GeometryArena arenas[BENCH_ARENAS];
+    for(int a=0; a<BENCH_ARENAS; a++){
+        arenas[a].m_VertexArrayObject = a + 1;
+        arenas[a].m_Ranges.resize(BENCH_RANGES);
+        for(uint32_t r=0; r<BENCH_RANGES; r++){
+            arenas[a].m_Ranges[r].m_Vertices.m_Offset = r * 1000;
+            arenas[a].m_Ranges[r].m_Indices.m_Offset = r * 3000;
+            arenas[a].m_Ranges[r].m_IndexCount = 6 * (r + 1);
+            arenas[a].m_Ranges[r].m_IndexSize = (r & 1) ? 4 : 2;
+        }
+    }
+
+    // runs of similar meshes with the occasional switch, like a culled scene
+    std::vector<Mesh3D> storage(count);
+    std::vector<Mesh3D*> meshes(count);
+    std::vector<glm::mat4> modelViewProjections(count);
+    int pipeline = 0, arena = 0;
+    for(size_t i=0; i<count; i++){
+        if(rng() % 64 == 0){
+            pipeline = rng() % BENCH_PIPELINES;
+            arena = rng() % BENCH_ARENAS;
+        }
+        Mesh3D &mesh = storage[i];
+        mesh.m_Arena = &arenas[arena];
+        mesh.m_VertexArrayObject = arenas[arena].m_VertexArrayObject;
+        mesh.m_GeometryRange = rng() % BENCH_RANGES;
+        mesh.m_IndexCount = arenas[arena].m_Ranges[mesh.m_GeometryRange].m_IndexCount;
+        mesh.m_IndexType = arenas[arena].m_Ranges[mesh.m_GeometryRange].m_IndexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        mesh.m_Pipeline = &pipelines[pipeline];
+        mesh.m_Material = (uint16_t)(rng() % 16);
+        modelViewProjections[i] = glm::mat4((float)i);
+        meshes[i] = &mesh;
+    }
+
+    std::vector<DrawElementsIndirectCommand> commands(count);
+    std::vector<IndirectDrawRecord> records(count);
+    std::vector<glm::mat4> matrices(count);
+    DrawCommandBuilder builder;
+
+    const int frames = count >= 1000000 ? 10 : 100;
+    double best = 1e30, total = 0.0;
+    for(int frame=0; frame<frames; frame++){
+        auto start = std::chrono::steady_clock::now();
+        DrawCommands_Build(&builder, meshes.data(), modelViewProjections.data(), count,
+                           commands.data(), records.data(), matrices.data());
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+        total += ms;
+    }
+    bool valid = Validate(&builder, meshes.data(), modelViewProjections.data(), count,
+                          commands.data(), records.data(), matrices.data());
+    printf("%8zu meshes: %8.3f ms/frame (best %.3f), %.1f ns/draw, %zu buckets = multi draw calls, %u chunks on %u workers, %s\n",
+           count, total / frames, best, best * 1e6 / count, builder.m_Buckets.size(),
+           builder.m_Chunks, Jobs_WorkerCount(), valid ? "valid" : "INVALID");
+    return valid;
+}
+
+int main(int argc, char **argv){
+    std::vector<size_t> counts;
+    for(int i=1; i<argc; i++){
+        counts.push_back(strtoull(argv[i], nullptr, 10));
+    }
+    if(counts.empty()){
+        counts = {10000, 100000, 1000000};
+    }
+    Jobs_Init();
+    std::mt19937 rng(1234);
+    bool valid = true;
+    for(size_t count : counts){
+        valid = Run(count, rng) && valid;
+    }
+    Jobs_Shutdown();
+    return valid ? 0 : 1;
+}
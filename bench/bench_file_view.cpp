@@ -0,0 +1,193 @@
+// Writes a directory of N files (9 in 10 shader sized, 1-8 KB of text, the rest
+// 16-256 KB assets) and times reading all of them, every byte touched: the old
+// line by line load_shader_as_string and ifstream get_file_contents, mmap for
+// every file, FileView_Open one by one and FileView_OpenBatch. "cold" drops the
+// files from the page cache first, "warm" reads them again right after.
+//   make bench_file_view && ./bench_file_view [files] [directory]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../util.h"
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// asks the kernel to drop the file's pages, the next read comes from disk
+static void EvictFromPageCache(const char *path){
+    int fd = open(path, O_RDONLY);
+    if(fd >= 0){
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// cheap enough that the reads dominate, touches every page
+static uint64_t Checksum(const char *data, size_t size){
+    uint64_t sum = size;
+    size_t i = 0;
+    for(; i+8 <= size; i+=8){
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        sum += word;
+    }
+    for(; i<size; i++){
+        sum += (unsigned char)data[i];
+    }
+    return sum;
+}
+
+// load_shader_as_string before FileView
+static std::string ReadLines(const char *path){
+    std::string result = "";
+    std::string line = "";
+    std::ifstream file(path);
+    while(std::getline(file, line)){
+        result += line + '\n';
+    }
+    return result;
+}
+
+// get_file_contents before FileView
+static std::string ReadStream(const char *path){
+    std::ifstream in(path, std::ios::binary);
+    std::string contents;
+    in.seekg(0, std::ios::end);
+    contents.resize(in.tellg());
+    in.seekg(0, std::ios::beg);
+    in.read(&contents[0], contents.size());
+    return contents;
+}
+
+// no small file buffer, what FILE_VIEW_MMAP_THRESHOLD is measured against
+static uint64_t ReadMapped(const char *path){
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    fstat(fd, &info);
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+    uint64_t sum = Checksum((const char *)mapping, info.st_size);
+    munmap(mapping, info.st_size);
+    return sum;
+}
+
+static bool WriteFiles(const std::string &directory, size_t count, std::vector<std::string> *paths, size_t *totalBytes){
+    mkdir(directory.c_str(), 0755);
+    std::string line = "    vec4 position = u_ModelViewProjection * vec4(a_Position, 1.0); // filler\n";
+    std::vector<char> asset(256 * 1024);
+    for(size_t i=0; i<asset.size(); i++){
+        asset[i] = (char)(i * 2654435761u >> 24);
+    }
+    srand(1);
+    *totalBytes = 0;
+    for(size_t i=0; i<count; i++){
+        bool isAsset = i % 10 == 9;
+        char name[64];
+        snprintf(name, sizeof(name), isAsset ? "/asset_%05zu.bin" : "/shader_%05zu.glsl", i);
+        paths->push_back(directory + name);
+        FILE *file = fopen(paths->back().c_str(), "wb");
+        if(file == nullptr){
+            return false;
+        }
+        size_t size = isAsset ? 16*1024 + rand() % (240*1024) : 1024 + rand() % (7*1024);
+        if(isAsset){
+            fwrite(asset.data(), 1, size, file);
+        }else{
+            for(size_t written=0; written<size; written+=line.size()){
+                fwrite(line.data(), 1, std::min(line.size(), size - written), file);
+            }
+        }
+        fclose(file);
+        *totalBytes += size;
+    }
+    return true;
+}
+
+int main(int argc, char **argv){
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000;
+    std::string directory = argc > 2 ? argv[2] : "bench_file_view_data";
+    std::vector<std::string> paths;
+    size_t totalBytes = 0;
+    if(!WriteFiles(directory, count, &paths, &totalBytes)){
+        fprintf(stderr, "could not write the files under %s\n", directory.c_str());
+        return 1;
+    }
+    std::vector<const char *> pathList;
+    for(const std::string &path : paths){
+        pathList.push_back(path.c_str());
+    }
+    printf("%zu files, %.1f MB, %u threads\n", count, totalBytes / 1048576.0, std::max(1u, std::thread::hardware_concurrency()));
+
+    const char *names[] = {"getline (old load_shader_as_string)", "ifstream (old get_file_contents)", "mmap every file",
+                           "FileView_Open", "FileView_OpenBatch"};
+    uint64_t expected = 0;
+    bool ok = true;
+    for(int method=0; method<5; method++){
+        double times[2];
+        for(int pass=0; pass<2; pass++){
+            if(pass == 0){
+                for(const std::string &path : paths){
+                    EvictFromPageCache(path.c_str());
+                }
+            }
+            uint64_t sum = 0;
+            auto start = std::chrono::steady_clock::now();
+            if(method == 0){
+                for(const std::string &path : paths){
+                    std::string text = ReadLines(path.c_str());
+                    sum += Checksum(text.data(), text.size());
+                }
+            }else if(method == 1){
+                for(const std::string &path : paths){
+                    std::string text = ReadStream(path.c_str());
+                    sum += Checksum(text.data(), text.size());
+                }
+            }else if(method == 2){
+                for(const std::string &path : paths){
+                    sum += ReadMapped(path.c_str());
+                }
+            }else if(method == 3){
+                for(const std::string &path : paths){
+                    FileView view;
+                    FileView_Open(&view, path.c_str());
+                    sum += Checksum(view.m_Data, view.m_Size);
+                }
+            }else{
+                std::vector<FileView> views(count);
+                FileView_OpenBatch(views.data(), pathList.data(), count);
+                for(const FileView &view : views){
+                    sum += Checksum(view.m_Data, view.m_Size);
+                }
+            }
+            times[pass] = MillisecondsSince(start);
+            // getline adds a newline to files that don't end in one (the assets), only the others are compared to it
+            if(method == 1 && pass == 0){
+                expected = sum;
+            }else if(method > 1 && sum != expected){
+                ok = false;
+            }
+        }
+        printf("%-38s cold %8.1f ms, warm %8.1f ms (%7.0f MB/s)\n", names[method], times[0], times[1],
+               totalBytes / 1048576.0 / (times[1] / 1000.0));
+    }
+
+    for(const std::string &path : paths){
+        remove(path.c_str());
+    }
+    rmdir(directory.c_str());
+    printf("contents match: %s\n", ok ? "yes" : "NO");
+    return ok ? 0 : 1;
+}
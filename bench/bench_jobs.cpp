@@ -0,0 +1,180 @@
+// Job system scaling on the frame workloads: transform pool update, frustum
+// culling and the frame task graph (transforms -> bounds + cull -> MVPs of the
+// visible objects), each run with 1, 2, 4 ... workers. No window or GL context.
+//   make bench_jobs && ./bench_jobs [max workers] [objects]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include "../culling.hpp"
+#include "../jobs.hpp"
+#include "../transform.hpp"
+
+struct Scene{
+    TransformPool m_Pool;
+    std::vector<Transform> m_Transforms;
+    BoundsTable m_Bounds;
+    Frustum m_Frustum;
+    glm::mat4 m_ViewProjection;
+    std::vector<uint32_t> m_Visible;
+    size_t m_VisibleCount = 0;
+    std::vector<glm::mat4> m_ModelViewProjections;
+    TaskGraph m_Graph;
+};
+
+static void MarkRootsDirty(Scene *scene){
+    for(const uint32_t root : scene->m_Pool.m_Levels[0]){
+        scene->m_Pool.m_Dirty[root] = 1;
+    }
+}
+
+static void BuildScene(Scene *scene, size_t count){
+    // mostly roots with a few levels of children, objects spread around the camera
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for(size_t i=0; i<count; i++){
+        Transform parent;
+        if(i > 0 && rng() % 5 == 0){
+            parent = scene->m_Transforms[rng() % i];
+        }
+        Transform t = TransformPool_Create(&scene->m_Pool, parent);
+        glm::vec3 offset = parent.m_Index == TRANSFORM_NONE ? glm::vec3(position(rng), position(rng), position(rng))
+                                                            : glm::vec3(unit(rng), unit(rng), unit(rng));
+        TransformPool_SetTranslation(&scene->m_Pool, t, offset);
+        TransformPool_Rotate(&scene->m_Pool, t, unit(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+        scene->m_Transforms.push_back(t);
+    }
+    TransformPool_Update(&scene->m_Pool);
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f/9.0f, 0.1f, 150.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    scene->m_ViewProjection = projection * view;
+    scene->m_Frustum = Frustum_FromMatrix(scene->m_ViewProjection);
+    scene->m_Visible.resize(count);
+    scene->m_ModelViewProjections.resize(count);
+
+    TaskGraph *graph = &scene->m_Graph;
+    TaskId transforms = TaskGraph_Add(graph, "transforms", [scene](){
+        TransformPool_Update(&scene->m_Pool);
+    });
+    TaskId cull = TaskGraph_Add(graph, "cull", [scene](){
+        size_t count = scene->m_Transforms.size();
+        Bounds_Resize(&scene->m_Bounds, count);
+        Jobs_ParallelFor(count, 4096, [scene](size_t first, size_t last){
+            for(size_t i=first; i<last; i++){
+                const glm::mat4 &world = TransformPool_World(&scene->m_Pool, scene->m_Transforms[i]);
+                Bounds_Set(&scene->m_Bounds, i, glm::vec3(world[3]), 1.0f);
+            }
+        });
+        scene->m_VisibleCount = Cull_Spheres(scene->m_Frustum, &scene->m_Bounds, scene->m_Visible.data());
+    }, {transforms});
+    TaskGraph_Add(graph, "matrices", [scene](){
+        Jobs_ParallelFor(scene->m_VisibleCount, 4096, [scene](size_t first, size_t last){
+            for(size_t i=first; i<last; i++){
+                scene->m_ModelViewProjections[i] = scene->m_ViewProjection
+                    * TransformPool_World(&scene->m_Pool, scene->m_Transforms[scene->m_Visible[i]]);
+            }
+        });
+    }, {cull});
+    // fills the bounds the cull-only runs use
+    TaskGraph_Run(graph);
+}
+
+// best of the runs, ms
+template<typename Function>
+static double Time(int runs, Function function){
+    double best = 1e30;
+    for(int i=0; i<runs; i++){
+        auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static double AverageUtilisation(){
+    std::vector<JobWorkerStats> stats;
+    double windowMs = 0.0;
+    Jobs_GetStats(&stats, &windowMs);
+    double sum = 0.0;
+    for(const JobWorkerStats &worker : stats){
+        sum += worker.m_Utilisation;
+    }
+    return stats.empty() ? 0.0 : sum / stats.size();
+}
+
+int main(int argc, char **argv){
+    unsigned maxWorkers = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+    const int runs = 20;
+
+    Scene scene;
+    BuildScene(&scene, count);
+    printf("%zu objects, %zu levels, %u hardware threads\n", count, scene.m_Pool.m_Levels.size(),
+           std::thread::hardware_concurrency());
+
+    const char *names[] = {"transforms", "cull", "frame graph"};
+    double base[3] = {0.0, 0.0, 0.0};
+    size_t referenceVisible = 0, referenceUpdated = 0;
+    bool ok = true;
+    for(unsigned workers=1; ; workers = std::min(workers * 2, maxWorkers)){
+        Jobs_Init(workers);
+        double ms[3], utilisation[3];
+
+        Jobs_ResetStats();
+        ms[0] = Time(runs, [&](){
+            MarkRootsDirty(&scene);
+            TransformPool_Update(&scene.m_Pool);
+        });
+        utilisation[0] = AverageUtilisation();
+
+        Jobs_ResetStats();
+        size_t visible = 0;
+        ms[1] = Time(runs, [&](){
+            visible = Cull_Spheres(scene.m_Frustum, &scene.m_Bounds, scene.m_Visible.data());
+        });
+        utilisation[1] = AverageUtilisation();
+
+        Jobs_ResetStats();
+        ms[2] = Time(runs, [&](){
+            MarkRootsDirty(&scene);
+            TaskGraph_Run(&scene.m_Graph);
+        });
+        utilisation[2] = AverageUtilisation();
+
+        // same work whatever the split
+        if(workers == 1){
+            referenceVisible = scene.m_VisibleCount;
+            referenceUpdated = scene.m_Pool.m_UpdatedCount;
+        }else if(visible != referenceVisible || scene.m_VisibleCount != referenceVisible
+                 || scene.m_Pool.m_UpdatedCount != referenceUpdated){
+            ok = false;
+        }
+
+        for(int w=0; w<3; w++){
+            if(workers == 1){
+                base[w] = ms[w];
+            }
+            double speedup = base[w] / ms[w];
+            printf("%2u workers %-12s %8.3f ms, %5.2fx, %5.1f%% efficiency, %5.1f%% busy\n", workers, names[w], ms[w],
+                   speedup, speedup / workers * 100.0, utilisation[w] * 100.0);
+        }
+        if(workers == 1){
+            TaskGraph_PrintStats(&scene.m_Graph);
+        }
+        Jobs_Shutdown();
+        if(workers >= maxWorkers){
+            break;
+        }
+    }
+    printf("%zu visible, %zu world matrices per update, results match: %s\n", referenceVisible, referenceUpdated, ok ? "yes" : "NO");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+// Batched mat4 kernels against plain glm loops, no window or GL context needed.
+//   make bench_matrix && ./bench_matrix [count]
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../matrix_batch.hpp"
+
+static const int gIterations = 20;
+
+template<typename F>
+static double MillionPerSecond(size_t count, F &&run){
+    run();  // warm up
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<gIterations; i++){
+        run();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)count * gIterations / seconds / 1e6;
+}
+
+static float MaxError(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b){
+    float error = 0.0f;
+    for(size_t i=0; i<a.size(); i++){
+        for(int c=0; c<4; c++){
+            for(int r=0; r<4; r++){
+                error = std::fmax(error, std::fabs(a[i][c][r] - b[i][c][r]));
+            }
+        }
+    }
+    return error;
+}
+
+int main(int argc, char **argv){
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<glm::vec3> translation(count), scale(count);
+    std::vector<glm::quat> rotation(count);
+    std::vector<glm::mat4> a(count), b(count), out(count), reference(count);
+    for(size_t i=0; i<count; i++){
+        translation[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * 50.0f;
+        scale[i] = glm::vec3(1.5f + unit(rng), 1.5f + unit(rng), 1.5f + unit(rng));
+        rotation[i] = glm::angleAxis(unit(rng) * 3.0f, glm::normalize(glm::vec3(unit(rng), unit(rng), 0.5f)));
+        a[i] = glm::translate(glm::mat4(1.0f), translation[i]) * glm::mat4_cast(rotation[i]) * glm::scale(glm::mat4(1.0f), scale[i]);
+        b[i] = glm::rotate(a[i], unit(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    const glm::mat4 viewProjection = b[0];
+
+    printf("%zu matrices, million matrices/second (max abs error vs glm)\n", count);
+    printf("%-10s %18s %18s %18s %18s\n", "", "multiply", "multiply shared", "compose TRS", "inverse affine");
+
+    double glmRate[4];
+    glmRate[0] = MillionPerSecond(count, [&](){ for(size_t i=0; i<count; i++) reference[i] = a[i] * b[i]; });
+    glmRate[1] = MillionPerSecond(count, [&](){ for(size_t i=0; i<count; i++) out[i] = viewProjection * b[i]; });
+    glmRate[2] = MillionPerSecond(count, [&](){
+        for(size_t i=0; i<count; i++)
+            out[i] = glm::translate(glm::mat4(1.0f), translation[i]) * glm::mat4_cast(rotation[i]) * glm::scale(glm::mat4(1.0f), scale[i]);
+    });
+    glmRate[3] = MillionPerSecond(count, [&](){ for(size_t i=0; i<count; i++) out[i] = glm::inverse(a[i]); });
+    printf("%-10s %18.1f %18.1f %18.1f %18.1f\n", "glm", glmRate[0], glmRate[1], glmRate[2], glmRate[3]);
+
+    std::vector<glm::mat4> referenceShared(count), referenceInverse(count);
+    for(size_t i=0; i<count; i++){
+        referenceShared[i] = viewProjection * b[i];
+        referenceInverse[i] = glm::inverse(a[i]);
+    }
+
+    const MatBatchVariant variants[] = {MATBATCH_SCALAR, MATBATCH_SSE4, MATBATCH_AVX2};
+    for(MatBatchVariant variant : variants){
+        MatBatch_SetVariant(variant);
+        if(MatBatch_GetVariant() != variant){
+            printf("%-10s unsupported on this CPU\n", MatBatch_VariantName(variant));
+            continue;
+        }
+        double rate[4];
+        float error[4];
+        rate[0] = MillionPerSecond(count, [&](){ MatBatch_Multiply(a.data(), b.data(), out.data(), count); });
+        error[0] = MaxError(out, reference);
+        rate[1] = MillionPerSecond(count, [&](){ MatBatch_MultiplyShared(viewProjection, b.data(), out.data(), count); });
+        error[1] = MaxError(out, referenceShared);
+        rate[2] = MillionPerSecond(count, [&](){ MatBatch_ComposeTRS(translation.data(), rotation.data(), scale.data(), out.data(), count); });
+        error[2] = MaxError(out, a);
+        rate[3] = MillionPerSecond(count, [&](){ MatBatch_InverseAffine(a.data(), out.data(), count); });
+        error[3] = MaxError(out, referenceInverse);
+        printf("%-10s", MatBatch_VariantName(variant));
+        for(int op=0; op<4; op++){
+            printf(" %8.1f (%7.1e)", rate[op], error[op]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
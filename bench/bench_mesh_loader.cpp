@@ -0,0 +1,136 @@
+// Writes an OBJ grid of about N triangles (v/vt/vn, shared corners) and times loading it,
+// then times startup from the binary cache with the file paged out (cold) and in (warm).
+//   make bench_mesh_loader && ./bench_mesh_loader [triangles] [path]
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../mesh_loader.hpp"
+#include "../mesh_cache.hpp"
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// asks the kernel to drop the file's pages, the next read comes from disk
+static void EvictFromPageCache(const char *path){
+    int fd = open(path, O_RDONLY);
+    if(fd >= 0){
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// open + validate + the copy glBufferData would make out of the mapping
+static double TimeCacheStartup(const char *path, std::vector<uint8_t> *upload){
+    auto start = std::chrono::steady_clock::now();
+    MeshCacheView view;
+    if(!MeshCache_Open(path, &view)){
+        return -1.0;
+    }
+    memcpy(upload->data(), view.m_Vertices, view.m_Header->m_VertexBytes);
+    memcpy(upload->data() + view.m_Header->m_VertexBytes, view.m_Indices, view.m_Header->m_IndexBytes);
+    MeshCache_Close(&view);
+    return MillisecondsSince(start);
+}
+
+static bool WriteGrid(const char *path, size_t side){
+    FILE *file = fopen(path, "wb");
+    if(file == nullptr){
+        return false;
+    }
+    for(size_t y=0; y<=side; y++){
+        for(size_t x=0; x<=side; x++){
+            float u = (float)x / side, v = (float)y / side;
+            fprintf(file, "v %.6f %.6f %.6f\n", u*2.0f - 1.0f, v*2.0f - 1.0f, 0.1f*sinf(u*20.0f)*cosf(v*20.0f));
+        }
+    }
+    for(size_t y=0; y<=side; y++){
+        for(size_t x=0; x<=side; x++){
+            fprintf(file, "vt %.6f %.6f\n", (float)x / side, (float)y / side);
+        }
+    }
+    fprintf(file, "vn 0 0 1\n");
+    const size_t row = side + 1;
+    for(size_t y=0; y<side; y++){
+        for(size_t x=0; x<side; x++){
+            size_t a = y*row + x + 1, b = a + 1, c = a + row, d = c + 1;
+            // quads, so the loader's fan triangulation is exercised too
+            fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", a, a, b, b, d, d, c, c);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv){
+    size_t triangles = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000000;
+    const char *path = argc > 2 ? argv[2] : "/tmp/bench_mesh_loader.obj";
+    size_t side = (size_t)std::sqrt(triangles / 2.0);
+    if(side == 0){
+        side = 1;
+    }
+
+    if(!WriteGrid(path, side)){
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+
+    MeshData warmUp;
+    MeshLoader_Load(path, &warmUp);  // page cache warm up
+
+    auto start = std::chrono::steady_clock::now();
+    MeshData data;
+    bool loaded = MeshLoader_Load(path, &data);
+    double ms = MillisecondsSince(start);
+    if(!loaded){
+        fprintf(stderr, "%s\n", data.m_Error.c_str());
+        return 1;
+    }
+
+    size_t expectedVertices = (side + 1) * (side + 1);
+    size_t vertexCount = data.m_Vertices.size() / VertexFormat_Stride(data.m_Format);
+    printf("%u threads, %zu triangles, %zu vertices (expected %zu after dedupe)\n",
+           std::thread::hardware_concurrency(), data.m_Indices.size() / 3, vertexCount, expectedVertices);
+    printf("parse: %.1f ms, %.1f M triangles/s\n", ms, data.m_Indices.size() / 3 / ms / 1e3);
+
+    start = std::chrono::steady_clock::now();
+    if(!MeshCache_Write(path, &data)){
+        return 1;
+    }
+    printf("cache write: %.1f ms\n", MillisecondsSince(start));
+
+    std::vector<uint8_t> upload(data.m_Vertices.size() * sizeof(float) + data.m_Indices.size() * 4);
+    std::string cachePath = std::string(path) + ".meshcache";
+    EvictFromPageCache(cachePath.c_str());
+    EvictFromPageCache(path);
+    double cold = TimeCacheStartup(path, &upload);
+    double warm = TimeCacheStartup(path, &upload);
+    printf("cache startup: cold %.1f ms, warm %.1f ms (parse was %.1f ms)\n", cold, warm, ms);
+
+    // touching the source keeps the cache (same hash), editing it invalidates it
+    MeshCacheView view;
+    utimensat(AT_FDCWD, path, nullptr, 0);
+    bool kept = MeshCache_Open(path, &view);
+    MeshCache_Close(&view);
+    FILE *append = fopen(path, "ab");
+    fputs("# edited\n", append);
+    fclose(append);
+    bool stale = !MeshCache_Open(path, &view);
+    MeshCache_Close(&view);
+    printf("cache kept after touch: %s, rejected after edit: %s\n", kept ? "yes" : "NO", stale ? "yes" : "NO");
+
+    remove(cachePath.c_str());
+    remove(path);
+    return vertexCount == expectedVertices && cold >= 0.0 && warm >= 0.0 && kept && stale ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Offset allocator churn: random allocate/free against a shadow list, then compaction.
+// No window or GL context needed.
+//   make bench_offset_allocator && ./bench_offset_allocator [allocations]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../offset_allocator.hpp"
+
+struct Live{
+    OffsetAllocation m_Allocation;
+    uint32_t m_Size;
+};
+
+static void PrintStats(const char *label, const OffsetAllocator *allocator){
+    OffsetAllocatorStats stats = OffsetAllocator_GetStats(allocator);
+    printf("%-10s size %u, used %u (%.1f%%), %u allocations, %u free regions, largest free %u, fragmentation %.3f\n",
+           label, stats.m_Size, stats.m_Used, 100.0 * stats.m_Used / stats.m_Size, stats.m_Allocations,
+           stats.m_FreeRegions, stats.m_LargestFree, stats.m_Fragmentation);
+}
+
+// every live allocation inside the range and no two overlapping
+static bool Validate(const std::vector<Live> &live, uint32_t size){
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for(const Live &entry : live){
+        ranges.emplace_back(entry.m_Allocation.m_Offset, entry.m_Size);
+    }
+    std::sort(ranges.begin(), ranges.end());
+    for(size_t i=0; i<ranges.size(); i++){
+        if(ranges[i].first + ranges[i].second > size){
+            return false;
+        }
+        if(i > 0 && ranges[i-1].first + ranges[i-1].second > ranges[i].first){
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv){
+    size_t operations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    const uint32_t size = 1u << 26;
+    OffsetAllocator allocator;
+    OffsetAllocator_Create(&allocator, size);
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> sizes(1, 4096);
+    std::vector<Live> live;
+    std::vector<uint32_t> requested(operations);
+    for(uint32_t &value : requested){
+        value = sizes(rng);
+    }
+
+    size_t failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i=0; i<operations; i++){
+        // keep about 60% of the range in use: free a random allocation half the time once warm
+        if(!live.empty() && (rng() & 1) && allocator.m_Used > size / 2){
+            size_t victim = rng() % live.size();
+            OffsetAllocator_Free(&allocator, live[victim].m_Allocation);
+            live[victim] = live.back();
+            live.pop_back();
+            continue;
+        }
+        OffsetAllocation allocation = OffsetAllocator_Allocate(&allocator, requested[i]);
+        if(allocation.m_Offset == OFFSET_ALLOCATOR_NONE){
+            failed++;
+            continue;
+        }
+        live.push_back({allocation, requested[i]});
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu operations, %.1f ns/op, %zu failed allocations\n", operations, seconds * 1e9 / operations, failed);
+    PrintStats("churned", &allocator);
+    bool valid = Validate(live, size);
+
+    // compaction, allocations are found again through the node index
+    start = std::chrono::steady_clock::now();
+    std::vector<size_t> liveByNode(allocator.m_Nodes.size(), (size_t)-1);
+    for(size_t i=0; i<live.size(); i++){
+        liveByNode[live[i].m_Allocation.m_Node] = i;
+    }
+    size_t moves = 0;
+    OffsetAllocation moved;
+    while(true){
+        OffsetAllocation movable = OffsetAllocator_FirstMovable(&allocator, moved);
+        if(movable.m_Node == OFFSET_ALLOCATOR_NONE){
+            break;
+        }
+        moved = OffsetAllocator_SlideDown(&allocator, movable);
+        live[liveByNode[movable.m_Node]].m_Allocation = moved;
+        moves++;
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("compaction: %zu moves in %.1f ms\n", moves, seconds * 1e3);
+    PrintStats("compacted", &allocator);
+    valid = valid && Validate(live, size);
+
+    for(const Live &entry : live){
+        OffsetAllocator_Free(&allocator, entry.m_Allocation);
+    }
+    OffsetAllocatorStats stats = OffsetAllocator_GetStats(&allocator);
+    valid = valid && stats.m_Used == 0 && stats.m_FreeRegions == 1 && stats.m_LargestFree == size;
+    printf("%s\n", valid ? "valid" : "INVALID");
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+// Cost of a PROFILE_SCOPE: not recording, recording on one thread and on
+// several threads at once with the collector draining every "frame", against
+// the same loop without a scope. make bench_profiler PROFILER=0 for the compiled
+// out build (every row then costs the same as the baseline).
+//   make bench_profiler && ./bench_profiler [scopes per thread] [threads] [trace.json]
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+#include "../profiler.hpp"
+
+// enough work that the loop isn't optimised away, little enough to not hide the scope
+static thread_local volatile uint64_t tSink = 0;
+
+static void Work(uint64_t i){
+    tSink = tSink + i;
+}
+
+static void RunScopes(size_t count){
+    for(size_t i=0; i<count; i++){
+        PROFILE_SCOPE("bench scope");
+        Work(i);
+    }
+}
+
+static void RunBaseline(size_t count){
+    for(size_t i=0; i<count; i++){
+        Work(i);
+    }
+}
+
+static uint64_t ThreadCpuNs(){
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// thread CPU ns per iteration averaged over the threads, so sharing cores doesn't
+// count; the collector drains the rings while they record
+template<typename Function>
+static double Time(size_t count, unsigned threads, Function function){
+    std::atomic<unsigned> done{0};
+    std::atomic<uint64_t> cpuNs{0};
+    std::vector<std::thread> workers;
+    for(unsigned t=0; t<threads; t++){
+        workers.emplace_back([&](){
+            uint64_t start = ThreadCpuNs();
+            // in frame sized batches so the rings never overflow
+            for(size_t first=0; first<count; first+=PROFILER_RING_SIZE/4){
+                function(std::min<size_t>(PROFILER_RING_SIZE/4, count - first));
+                std::this_thread::yield();
+            }
+            cpuNs += ThreadCpuNs() - start;
+            done++;
+        });
+    }
+    while(done.load() < threads){
+        Profiler_Collect();
+        std::this_thread::yield();
+    }
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+    Profiler_Collect();
+    return (double)cpuNs.load() / threads / count;
+}
+
+int main(int argc, char **argv){
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    unsigned threads = argc > 2 ? (unsigned)strtoul(argv[2], nullptr, 10) : 4;
+    const char *trace = argc > 3 ? argv[3] : nullptr;
+    printf("%zu scopes per thread, profiler %s\n", count, PROFILER_ENABLED ? "compiled in" : "compiled out");
+
+    double baseline = Time(count, 1, RunBaseline);
+    double idle = Time(count, 1, RunScopes);
+    Profiler_Init(trace);
+    double one = Time(count, 1, RunScopes);
+    double many = Time(count, threads, RunScopes);
+
+    printf("baseline                 %6.1f ns/iteration\n", baseline);
+    printf("scope, not recording     %6.1f ns/iteration (+%.1f)\n", idle, idle - baseline);
+    printf("scope, 1 thread          %6.1f ns/iteration (+%.1f)\n", one, one - baseline);
+    printf("scope, %u threads         %6.1f ns/iteration (+%.1f)\n", threads, many, many - baseline);
+    Profiler_PrintStats();
+    Profiler_Shutdown();
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Transform pool update benchmark, no window or GL context needed.
+//   make bench_transforms && ./bench_transforms [count]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "../jobs.hpp"
+#include "../transform.hpp"
+
+static double TimeUpdate(TransformPool *pool, int iterations){
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++){
+        // touch the roots every iteration so the dirty set is the same each time
+        for(const uint32_t root : pool->m_Levels[0]){
+            pool->m_Dirty[root] = 1;
+        }
+        TransformPool_Update(pool);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char **argv){
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 250000;
+    const int iterations = 20;
+    Jobs_Init();
+
+    // 80% roots, the rest hang below a random earlier node (up to a few levels deep)
+    TransformPool pool;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for(size_t i=0; i<count; i++){
+        Transform parent;
+        if(i > 0 && rng() % 5 == 0){
+            parent.m_Index = rng() % i;
+        }
+        Transform t = TransformPool_Create(&pool, parent);
+        TransformPool_SetTranslation(&pool, t, glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f);
+        TransformPool_Rotate(&pool, t, unit(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    TransformPool_Update(&pool);
+
+    double allDirty = TimeUpdate(&pool, iterations);
+    size_t updated = pool.m_UpdatedCount;
+
+    // nothing dirty: only the walk over the levels
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++){
+        TransformPool_Update(&pool);
+    }
+    double clean = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    printf("%zu transforms, %zu levels, %u workers\n", count, pool.m_Levels.size(), Jobs_WorkerCount());
+    printf("  all dirty : %7.3f ms/update (%zu world matrices)\n", allDirty, updated);
+    printf("  none dirty: %7.3f ms/update\n", clean);
+    Jobs_Shutdown();
+    return 0;
+}
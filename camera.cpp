@@ -19,6 +19,10 @@ glm::mat4 Camera::GetViewMatrix() const{
     return glm::lookAt(myEye, myEye+mViewDirection, mUpVector);
 }
 
+glm::vec3 Camera::GetEyePosition() const{
+    return myEye;
+}
+
 glm::mat4 Camera::GetProjectionMatrix() const{
    // return glm::perspective(glm::radians(45.0f), (float)gApp.SCREEN_WIDTH/(float)gApp.SCREEN_HEIGHT, 0.1f, 100.0f);
    return mProjectionMatrix;
@@ -40,6 +44,16 @@ void Camera::MouseLook(int mouseX, int mouseY){
     glm::vec2 mouseDelta = mOldMousePosition - currentMouse;
 }
 
+void Camera::Interpolate(const Camera &previous, const Camera &current, float t){
+    *this = current;
+    myEye = glm::mix(previous.myEye, current.myEye, t);
+    // a turn of less than 180 degrees per step, otherwise take the newer direction
+    glm::vec3 direction = glm::mix(previous.mViewDirection, current.mViewDirection, t);
+    if(glm::length(direction) > 1e-4f){
+        mViewDirection = glm::normalize(direction);
+    }
+}
+
 void Camera::MoveForward(float speed){
     myEye += (mViewDirection*speed);
 }
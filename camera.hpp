@@ -8,6 +8,7 @@ class Camera{
         Camera();
         // The ultimate view matrix we will produce
         glm::mat4 GetViewMatrix() const;
+        glm::vec3 GetEyePosition() const;
 
         void SetProjectionMatrix();
         glm::mat4 GetProjectionMatrix() const;
@@ -19,6 +20,9 @@ class Camera{
         void MoveLeft(float speed);
         void MoveRight(float speed);
 
+        // Becomes the state t of the way from previous to current (rendering between two simulation steps)
+        void Interpolate(const Camera &previous, const Camera &current, float t);
+
     private:
         glm::mat4 mProjectionMatrix;
 
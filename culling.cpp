@@ -0,0 +1,218 @@
+#include "culling.hpp"
+#include "jobs.hpp"
+
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CULL_X86 1
+#include <immintrin.h>
+#endif
+
+// below this a chunk costs about as much to hand out as to cull
+#define CULL_MIN_PARALLEL_CHUNK 8192
+
+Frustum Frustum_FromMatrix(const glm::mat4 &m){
+    // rows of the column-major matrix
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.m_Planes[0] = row3 + row0;  // left
+    frustum.m_Planes[1] = row3 - row0;  // right
+    frustum.m_Planes[2] = row3 + row1;  // bottom
+    frustum.m_Planes[3] = row3 - row1;  // top
+    frustum.m_Planes[4] = row3 + row2;  // near
+    frustum.m_Planes[5] = row3 - row2;  // far
+    for(glm::vec4 &plane : frustum.m_Planes){
+        float length = glm::length(glm::vec3(plane));
+        plane = plane / length;
+    }
+    return frustum;
+}
+
+void Bounds_Clear(BoundsTable *table){
+    table->m_CenterX.clear();
+    table->m_CenterY.clear();
+    table->m_CenterZ.clear();
+    table->m_Radius.clear();
+}
+
+void Bounds_Reserve(BoundsTable *table, size_t count){
+    table->m_CenterX.reserve(count);
+    table->m_CenterY.reserve(count);
+    table->m_CenterZ.reserve(count);
+    table->m_Radius.reserve(count);
+}
+
+void Bounds_Resize(BoundsTable *table, size_t count){
+    table->m_CenterX.resize(count);
+    table->m_CenterY.resize(count);
+    table->m_CenterZ.resize(count);
+    table->m_Radius.resize(count);
+}
+
+void Bounds_Push(BoundsTable *table, glm::vec3 center, float radius){
+    table->m_CenterX.push_back(center.x);
+    table->m_CenterY.push_back(center.y);
+    table->m_CenterZ.push_back(center.z);
+    table->m_Radius.push_back(radius);
+}
+
+// [first, last) one sphere at a time, also handles the tails of the SIMD kernels
+static size_t CullScalar(const Frustum &frustum, const BoundsTable *table, size_t first, size_t last, uint32_t *out){
+    const float *cx = table->m_CenterX.data();
+    const float *cy = table->m_CenterY.data();
+    const float *cz = table->m_CenterZ.data();
+    const float *r = table->m_Radius.data();
+    size_t written = 0;
+    for(size_t i=first; i<last; i++){
+        bool inside = true;
+        for(int p=0; p<6; p++){
+            const glm::vec4 &plane = frustum.m_Planes[p];
+            float distance = plane.x*cx[i] + plane.y*cy[i] + plane.z*cz[i] + plane.w;
+            inside &= distance > -r[i];
+        }
+        out[written] = (uint32_t)i;
+        written += inside;
+    }
+    return written;
+}
+
+#ifdef CULL_X86
+// set bits of mask -> indices base+bit
+static inline size_t EmitMask(unsigned mask, size_t base, uint32_t *out){
+    size_t written = 0;
+    while(mask){
+        out[written++] = (uint32_t)(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return written;
+}
+
+__attribute__((target("sse4.1")))
+static size_t CullSSE(const Frustum &frustum, const BoundsTable *table, size_t first, size_t last, uint32_t *out){
+    size_t blocks = first + (last - first) / 4 * 4;
+    __m128 planes[6][4];
+    for(int p=0; p<6; p++){
+        for(int c=0; c<4; c++){
+            planes[p][c] = _mm_set1_ps(frustum.m_Planes[p][c]);
+        }
+    }
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    size_t written = 0;
+    for(size_t i=first; i<blocks; i+=4){
+        __m128 cx = _mm_loadu_ps(&table->m_CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&table->m_CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&table->m_CenterZ[i]);
+        __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(&table->m_Radius[i]), signBit);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int p=0; p<6; p++){
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], cx), _mm_mul_ps(planes[p][1], cy)),
+                                  _mm_add_ps(_mm_mul_ps(planes[p][2], cz), planes[p][3]));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(d, negRadius));
+        }
+        written += EmitMask((unsigned)_mm_movemask_ps(inside), i, out + written);
+    }
+    return written + CullScalar(frustum, table, blocks, last, out + written);
+}
+
+__attribute__((target("avx2")))
+static size_t CullAVX2(const Frustum &frustum, const BoundsTable *table, size_t first, size_t last, uint32_t *out){
+    size_t blocks = first + (last - first) / 8 * 8;
+    __m256 planes[6][4];
+    for(int p=0; p<6; p++){
+        for(int c=0; c<4; c++){
+            planes[p][c] = _mm256_set1_ps(frustum.m_Planes[p][c]);
+        }
+    }
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    size_t written = 0;
+    for(size_t i=first; i<blocks; i+=8){
+        __m256 cx = _mm256_loadu_ps(&table->m_CenterX[i]);
+        __m256 cy = _mm256_loadu_ps(&table->m_CenterY[i]);
+        __m256 cz = _mm256_loadu_ps(&table->m_CenterZ[i]);
+        __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(&table->m_Radius[i]), signBit);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for(int p=0; p<6; p++){
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], cx), _mm256_mul_ps(planes[p][1], cy)),
+                                     _mm256_add_ps(_mm256_mul_ps(planes[p][2], cz), planes[p][3]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GT_OQ));
+        }
+        written += EmitMask((unsigned)_mm256_movemask_ps(inside), i, out + written);
+    }
+    return written + CullScalar(frustum, table, blocks, last, out + written);
+}
+#endif
+
+static CullKernel DetectKernel(){
+#ifdef CULL_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return CULL_KERNEL_AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1")){
+        return CULL_KERNEL_SSE;
+    }
+#endif
+    return CULL_KERNEL_SCALAR;
+}
+
+static CullKernel gCullKernel = DetectKernel();
+
+CullKernel Cull_GetKernel(){
+    return gCullKernel;
+}
+
+void Cull_SetKernel(CullKernel kernel){
+    // never pick something the CPU can't run
+    if(kernel > DetectKernel()){
+        kernel = DetectKernel();
+    }
+    gCullKernel = kernel;
+}
+
+const char* Cull_KernelName(CullKernel kernel){
+    switch(kernel){
+        case CULL_KERNEL_AVX2: return "avx2";
+        case CULL_KERNEL_SSE:  return "sse4.1";
+        default:               return "scalar";
+    }
+}
+
+static size_t CullRange(const Frustum &frustum, const BoundsTable *table, size_t first, size_t last, uint32_t *out){
+#ifdef CULL_X86
+    switch(gCullKernel){
+        case CULL_KERNEL_AVX2: return CullAVX2(frustum, table, first, last, out);
+        case CULL_KERNEL_SSE:  return CullSSE(frustum, table, first, last, out);
+        default: break;
+    }
+#endif
+    return CullScalar(frustum, table, first, last, out);
+}
+
+size_t Cull_Spheres(const Frustum &frustum, const BoundsTable *table, uint32_t *visibleOut){
+    size_t count = Bounds_Count(table);
+    size_t chunks = Jobs_ChunkCount(count, CULL_MIN_PARALLEL_CHUNK);
+    if(chunks <= 1){
+        return CullRange(frustum, table, 0, count, visibleOut);
+    }
+
+    // every chunk writes its indices at its own offset, then they're packed down in order
+    std::vector<size_t> firsts(chunks), visible(chunks);
+    Jobs_ParallelChunks(chunks, count, [&](size_t c, size_t first, size_t last){
+        firsts[c] = first;
+        visible[c] = CullRange(frustum, table, first, last, visibleOut + first);
+    });
+    size_t written = visible[0];
+    for(size_t c=1; c<chunks; c++){
+        memmove(visibleOut + written, visibleOut + firsts[c], visible[c] * sizeof(uint32_t));
+        written += visible[c];
+    }
+    return written;
+}
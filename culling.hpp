@@ -0,0 +1,57 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ax+by+cz+d = 0 per plane, normals point into the frustum and are normalized
+struct Frustum{
+    glm::vec4 m_Planes[6];
+};
+
+// Gribb/Hartmann extraction from a (projection * view) matrix
+Frustum Frustum_FromMatrix(const glm::mat4 &viewProjection);
+
+// World space bounding spheres as structure of arrays, so the kernels
+// load 4 (SSE) or 8 (AVX2) consecutive spheres per instruction
+struct BoundsTable{
+    std::vector<float> m_CenterX;
+    std::vector<float> m_CenterY;
+    std::vector<float> m_CenterZ;
+    std::vector<float> m_Radius;
+};
+
+void Bounds_Clear(BoundsTable *table);
+void Bounds_Reserve(BoundsTable *table, size_t count);
+void Bounds_Push(BoundsTable *table, glm::vec3 center, float radius);
+// count entries to be filled in place with Bounds_Set, e.g. from several jobs
+void Bounds_Resize(BoundsTable *table, size_t count);
+inline void Bounds_Set(BoundsTable *table, size_t i, glm::vec3 center, float radius){
+    table->m_CenterX[i] = center.x;
+    table->m_CenterY[i] = center.y;
+    table->m_CenterZ[i] = center.z;
+    table->m_Radius[i] = radius;
+}
+inline size_t Bounds_Count(const BoundsTable *table){ return table->m_Radius.size(); }
+
+enum CullKernel{
+    CULL_KERNEL_SCALAR = 0,
+    CULL_KERNEL_SSE,
+    CULL_KERNEL_AVX2,
+};
+
+// Picked once from the running CPU, Cull_SetKernel overrides it (benchmarks)
+CullKernel Cull_GetKernel();
+void Cull_SetKernel(CullKernel kernel);
+const char* Cull_KernelName(CullKernel kernel);
+
+// Writes the indices of spheres touching the frustum to visibleOut (room for
+// Bounds_Count entries) in ascending order, returns how many were written.
+// Big tables are culled in chunks on the job system's workers
+size_t Cull_Spheres(const Frustum &frustum, const BoundsTable *table, uint32_t *visibleOut);
+
+#endif
@@ -0,0 +1,127 @@
+#include "draw_commands.hpp"
+#include "jobs.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// smaller pieces cost more to hand to a worker than to build
+#define DRAW_COMMANDS_MIN_PARALLEL_CHUNK 4096
+
+static bool SameBucket(const DrawBucket &bucket, const Mesh3D *mesh){
+    return bucket.m_Pipeline == mesh->m_Pipeline && bucket.m_VertexArrayObject == mesh->m_VertexArrayObject
+        && bucket.m_IndexType == mesh->m_IndexType;
+}
+
+static bool SameBucket(const DrawBucket &a, const DrawBucket &b){
+    return a.m_Pipeline == b.m_Pipeline && a.m_VertexArrayObject == b.m_VertexArrayObject
+        && a.m_IndexType == b.m_IndexType;
+}
+
+// distinct buckets of one range, m_Count = draws in it. Meshes mostly come in runs
+// sharing a bucket, so the last hit is checked before searching.
+static void FindBuckets(const Mesh3D *const *meshes, size_t first, size_t last,
+                        std::vector<DrawBucket> *buckets, uint32_t *bucketOf){
+    buckets->clear();
+    uint32_t current = 0;
+    for(size_t i=first; i<last; i++){
+        const Mesh3D *mesh = meshes[i];
+        if(buckets->empty() || !SameBucket((*buckets)[current], mesh)){
+            current = 0;
+            while(current < buckets->size() && !SameBucket((*buckets)[current], mesh)){
+                current++;
+            }
+            if(current == buckets->size()){
+                DrawBucket bucket;
+                bucket.m_Pipeline = mesh->m_Pipeline;
+                bucket.m_VertexArrayObject = mesh->m_VertexArrayObject;
+                bucket.m_IndexType = mesh->m_IndexType;
+                buckets->push_back(bucket);
+            }
+        }
+        (*buckets)[current].m_Count++;
+        bucketOf[i] = current;
+    }
+}
+
+static void WriteCommands(DrawCommandBuilder *builder, size_t chunk, const Mesh3D *const *meshes,
+                          size_t first, size_t last, DrawElementsIndirectCommand *commands, IndirectDrawRecord *records){
+    uint32_t *cursors = builder->m_ChunkCursors[chunk].data();
+    for(size_t i=first; i<last; i++){
+        const Mesh3D *mesh = meshes[i];
+        const GeometryRange &range = mesh->m_Arena->m_Ranges[mesh->m_GeometryRange];
+        uint32_t slot = cursors[builder->m_BucketOf[i]]++;
+
+        DrawElementsIndirectCommand command;
+        command.m_Count = (uint32_t)mesh->m_IndexCount;
+        command.m_InstanceCount = 1;
+        // the arena keeps index offsets in 4 byte units
+        command.m_FirstIndex = range.m_Indices.m_Offset * (4 / range.m_IndexSize);
+        command.m_BaseVertex = (int32_t)range.m_Vertices.m_Offset;
+        command.m_BaseInstance = slot;
+        commands[slot] = command;
+
+        IndirectDrawRecord record = {(uint32_t)i, mesh->m_Material, {0, 0}};
+        records[slot] = record;
+        builder->m_Order[slot] = (uint32_t)i;
+    }
+}
+
+void DrawCommands_Build(DrawCommandBuilder *builder, const Mesh3D *const *meshes, const glm::mat4 *modelViewProjections,
+                        size_t count, DrawElementsIndirectCommand *commands, IndirectDrawRecord *records, glm::mat4 *matrices){
+    unsigned chunks = (unsigned)Jobs_ChunkCount(count, DRAW_COMMANDS_MIN_PARALLEL_CHUNK);
+    builder->m_Chunks = chunks;
+    builder->m_Buckets.clear();
+    builder->m_BucketOf.resize(count);
+    builder->m_Order.resize(count);
+    builder->m_ChunkBuckets.resize(chunks);
+    builder->m_ChunkCursors.resize(chunks);
+
+    // 1. every range finds its own buckets, and copies its matrices
+    Jobs_ParallelChunks(chunks, count, [&](size_t c, size_t first, size_t last){
+        FindBuckets(meshes, first, last, &builder->m_ChunkBuckets[c], builder->m_BucketOf.data());
+        memcpy(matrices + first, modelViewProjections + first, (last - first) * sizeof(glm::mat4));
+    });
+
+    // 2. merge them, chunk local bucket -> global one, and count the draws per bucket
+    std::vector<std::vector<uint32_t>> remap(chunks);
+    for(unsigned c=0; c<chunks; c++){
+        for(const DrawBucket &local : builder->m_ChunkBuckets[c]){
+            size_t global = 0;
+            while(global < builder->m_Buckets.size() && !SameBucket(builder->m_Buckets[global], local)){
+                global++;
+            }
+            if(global == builder->m_Buckets.size()){
+                DrawBucket bucket = local;
+                bucket.m_Count = 0;
+                builder->m_Buckets.push_back(bucket);
+            }
+            remap[c].push_back((uint32_t)global);
+            builder->m_Buckets[global].m_Count += local.m_Count;
+        }
+    }
+    uint32_t firstCommand = 0;
+    for(DrawBucket &bucket : builder->m_Buckets){
+        bucket.m_First = firstCommand;
+        firstCommand += bucket.m_Count;
+    }
+
+    // each chunk writes its draws of a bucket right after the previous chunk's
+    std::vector<uint32_t> next(builder->m_Buckets.size());
+    for(size_t b=0; b<builder->m_Buckets.size(); b++){
+        next[b] = builder->m_Buckets[b].m_First;
+    }
+    for(unsigned c=0; c<chunks; c++){
+        std::vector<uint32_t> &cursors = builder->m_ChunkCursors[c];
+        const std::vector<DrawBucket> &locals = builder->m_ChunkBuckets[c];
+        cursors.resize(locals.size());
+        for(size_t l=0; l<locals.size(); l++){
+            cursors[l] = next[remap[c][l]];
+            next[remap[c][l]] += locals[l].m_Count;
+        }
+    }
+
+    // 3. commands and records at their final slots
+    Jobs_ParallelChunks(chunks, count, [&](size_t c, size_t first, size_t last){
+        WriteCommands(builder, c, meshes, first, last, commands, records);
+    });
+}
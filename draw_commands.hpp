@@ -0,0 +1,58 @@
+#ifndef DRAW_COMMANDS_HPP
+#define DRAW_COMMANDS_HPP
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+#include "pipeline.hpp"
+
+// layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand{
+    uint32_t m_Count;
+    uint32_t m_InstanceCount;
+    uint32_t m_FirstIndex;          // in indices, not bytes
+    int32_t m_BaseVertex;
+    uint32_t m_BaseInstance;        // = the command's index, used to find its IndirectDrawRecord
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must be tightly packed");
+
+// Per draw data read by the SHADER_INDIRECT variant of Shader/vert.glsl, std430
+struct IndirectDrawRecord{
+    uint32_t m_MatrixIndex;         // into the matrix buffer
+    uint32_t m_Material;            // Mesh3D::m_Material
+    uint32_t m_Padding[2];
+};
+static_assert(sizeof(IndirectDrawRecord) == 16, "IndirectDrawRecord must follow std430 packing");
+
+// Draws that can go out in one glMultiDrawElementsIndirect: same pipeline, VAO (arena) and index type
+struct DrawBucket{
+    const Pipeline *m_Pipeline = nullptr;   // base pipeline of the meshes
+    GLuint m_VertexArrayObject = 0;
+    GLenum m_IndexType = 0;
+    uint32_t m_First = 0;                   // first command
+    uint32_t m_Count = 0;
+};
+
+struct DrawCommandBuilder{
+    std::vector<DrawBucket> m_Buckets;      // of the last build, commands are contiguous per bucket
+    std::vector<uint32_t> m_Order;          // input index of each command
+
+    // scratch kept between frames
+    std::vector<uint32_t> m_BucketOf;       // per input, the chunk local bucket
+    std::vector<std::vector<DrawBucket>> m_ChunkBuckets;
+    std::vector<std::vector<uint32_t>> m_ChunkCursors;   // per chunk, local bucket -> next command
+    unsigned m_Chunks = 0;                  // input ranges of the last build, run as jobs
+};
+
+// Buckets the meshes and writes one command + record per mesh in bucket order and
+// the matrices in input order (record.m_MatrixIndex = input index). Split into
+// jobs by input range; the destinations are only written, front to back per
+// bucket, so they can point straight into write-combined mapped buffers.
+void DrawCommands_Build(DrawCommandBuilder *builder, const Mesh3D *const *meshes, const glm::mat4 *modelViewProjections,
+                        size_t count, DrawElementsIndirectCommand *commands, IndirectDrawRecord *records, glm::mat4 *matrices);
+
+#endif
@@ -0,0 +1,165 @@
+#include "frame_pacing.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+#include <time.h>
+
+static uint64_t ReadClock(clockid_t clock){
+    timespec now;
+    clock_gettime(clock, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+uint64_t Clock_Now(){
+    return ReadClock(CLOCK_MONOTONIC);
+}
+
+void Clock_SleepUntil(uint64_t deadline){
+    timespec until;
+    until.tv_sec = (time_t)(deadline / 1000000000ull);
+    until.tv_nsec = (long)(deadline % 1000000000ull);
+    // absolute, so a signal interrupting it doesn't stretch the wait
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR){
+    }
+}
+
+static inline void CpuRelax(){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+void FramePacer_SetRate(FramePacer *pacer, double fps){
+    pacer->m_FrameNs = fps > 0.0 ? (uint64_t)(1e9 / fps) : 0;
+    pacer->m_NextFrame = 0;
+}
+
+void FramePacer_Wait(FramePacer *pacer){
+    if(pacer->m_FrameNs == 0){
+        return;
+    }
+    uint64_t now = Clock_Now();
+    if(pacer->m_NextFrame == 0){
+        pacer->m_NextFrame = now;
+    }
+    uint64_t deadline = pacer->m_NextFrame + pacer->m_FrameNs;
+
+    if(now >= deadline){
+        // late already: start the next frame from here rather than rushing to catch up
+        pacer->m_Missed++;
+        pacer->m_NextFrame = now;
+        return;
+    }
+
+    if(deadline - now > pacer->m_SpinNs){
+        uint64_t wakeAt = deadline - pacer->m_SpinNs;
+        Clock_SleepUntil(wakeAt);
+        uint64_t woke = Clock_Now();
+        pacer->m_SleptNs += woke - now;
+        now = woke;
+
+        // keep the spin at twice the recent oversleep, growing at once and shrinking slowly
+        uint64_t late = woke > wakeAt ? woke - wakeAt : 0;
+        uint64_t spin = std::min<uint64_t>(FRAME_PACER_MAX_SPIN_NS, std::max<uint64_t>(FRAME_PACER_MIN_SPIN_NS, late * 2));
+        if(spin > pacer->m_SpinNs){
+            pacer->m_SpinNs = spin;
+        }else{
+            pacer->m_SpinNs -= (pacer->m_SpinNs - spin) / 16;
+        }
+    }
+
+    uint64_t spinStart = now;
+    while(now < deadline){
+        CpuRelax();
+        now = Clock_Now();
+    }
+    pacer->m_SpunNs += now - spinStart;
+    // keep the cadence: an overslept frame doesn't push every following one back
+    pacer->m_NextFrame = now - deadline < pacer->m_FrameNs ? deadline : now;
+}
+
+bool FrameStats_Open(FrameStats *stats, const char *exportPath){
+    stats->m_FrameMs.clear();
+    stats->m_LastFrame = Clock_Now();
+    stats->m_WindowStart = stats->m_LastFrame;
+    stats->m_ProcessCpuStart = ReadClock(CLOCK_PROCESS_CPUTIME_ID);
+    stats->m_ThreadCpuStart = ReadClock(CLOCK_THREAD_CPUTIME_ID);
+    stats->m_SleptStart = 0;
+    stats->m_SpunStart = 0;
+    stats->m_MissedStart = 0;
+    stats->m_Elapsed = 0.0;
+    if(exportPath == nullptr){
+        return true;
+    }
+    stats->m_Export = fopen(exportPath, "w");
+    if(stats->m_Export == nullptr){
+        fprintf(stderr, "Could not open %s for frame stats\n", exportPath);
+        return false;
+    }
+    fprintf(stats->m_Export, "time_s,frames,fps,avg_ms,min_ms,p99_ms,max_ms,process_cpu_pct,render_thread_cpu_pct,"
+                             "limiter_sleep_ms,limiter_spin_ms,missed\n");
+    return true;
+}
+
+void FrameStats_Close(FrameStats *stats){
+    if(stats->m_Export){
+        fclose(stats->m_Export);
+        stats->m_Export = nullptr;
+    }
+}
+
+bool FrameStats_Frame(FrameStats *stats, const FramePacer *pacer){
+    uint64_t now = Clock_Now();
+    stats->m_FrameMs.push_back((float)((now - stats->m_LastFrame) / 1e6));
+    stats->m_LastFrame = now;
+    uint64_t window = now - stats->m_WindowStart;
+    if(window < FRAME_STATS_WINDOW_NS){
+        return false;
+    }
+
+    uint64_t processCpu = ReadClock(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t threadCpu = ReadClock(CLOCK_THREAD_CPUTIME_ID);
+    std::vector<float> &times = stats->m_FrameMs;
+    FrameStatsSummary &summary = stats->m_Summary;
+    summary.m_Frames = (uint32_t)times.size();
+    summary.m_Fps = summary.m_Frames / (window / 1e9);
+    summary.m_AverageMs = window / 1e6 / summary.m_Frames;
+    std::sort(times.begin(), times.end());
+    summary.m_MinMs = times.front();
+    summary.m_P99Ms = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+    summary.m_MaxMs = times.back();
+    summary.m_ProcessCpu = (double)(processCpu - stats->m_ProcessCpuStart) / window;
+    summary.m_ThreadCpu = (double)(threadCpu - stats->m_ThreadCpuStart) / window;
+    summary.m_SleptMs = (pacer->m_SleptNs - stats->m_SleptStart) / 1e6 / summary.m_Frames;
+    summary.m_SpunMs = (pacer->m_SpunNs - stats->m_SpunStart) / 1e6 / summary.m_Frames;
+    summary.m_Missed = pacer->m_Missed - stats->m_MissedStart;
+
+    stats->m_Elapsed += window / 1e9;
+    if(stats->m_Export){
+        fprintf(stats->m_Export, "%.3f,%u,%.2f,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%.3f,%.3f,%u\n", stats->m_Elapsed,
+                summary.m_Frames, summary.m_Fps, summary.m_AverageMs, summary.m_MinMs, summary.m_P99Ms, summary.m_MaxMs,
+                summary.m_ProcessCpu * 100.0, summary.m_ThreadCpu * 100.0, summary.m_SleptMs, summary.m_SpunMs,
+                summary.m_Missed);
+        fflush(stats->m_Export);
+    }
+
+    times.clear();
+    stats->m_WindowStart = now;
+    stats->m_ProcessCpuStart = processCpu;
+    stats->m_ThreadCpuStart = threadCpu;
+    stats->m_SleptStart = pacer->m_SleptNs;
+    stats->m_SpunStart = pacer->m_SpunNs;
+    stats->m_MissedStart = pacer->m_Missed;
+    return true;
+}
+
+void FrameStats_Print(const FrameStats *stats){
+    const FrameStatsSummary &summary = stats->m_Summary;
+    printf("frames: %.1f fps, avg %.3f ms, min %.3f, p99 %.3f, max %.3f, cpu %.1f%% of a core (render thread %.1f%%), "
+           "limiter slept %.3f spun %.3f ms/frame, %u late\n", summary.m_Fps, summary.m_AverageMs, summary.m_MinMs,
+           summary.m_P99Ms, summary.m_MaxMs, summary.m_ProcessCpu * 100.0, summary.m_ThreadCpu * 100.0,
+           summary.m_SleptMs, summary.m_SpunMs, summary.m_Missed);
+}
@@ -0,0 +1,77 @@
+#ifndef FRAME_PACING_HPP
+#define FRAME_PACING_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Monotonic nanoseconds (CLOCK_MONOTONIC), unaffected by wall clock changes.
+// The simulation's tick times and the frame pacing share this time base.
+uint64_t Clock_Now();
+// Sleeps until deadline (a Clock_Now value), no spinning
+void Clock_SleepUntil(uint64_t deadline);
+
+// sleeps usually wake up 50-100 us late, up to a ms on a loaded system
+#define FRAME_PACER_MIN_SPIN_NS 100000
+#define FRAME_PACER_MAX_SPIN_NS 4000000
+
+// Frame limiter: sleeps through most of the wait so an idle frame costs no CPU,
+// then spins the last stretch for an accurate deadline. The spin shrinks or grows
+// with how late the sleeps actually wake up.
+struct FramePacer{
+    uint64_t m_FrameNs = 0;             // target frame time, 0 = unlimited
+    uint64_t m_NextFrame = 0;
+    uint64_t m_SpinNs = 1000000;
+
+    // totals, FrameStats reports them per window
+    uint64_t m_SleptNs = 0;
+    uint64_t m_SpunNs = 0;
+    uint32_t m_Missed = 0;              // frames that were already past their deadline
+};
+
+// fps <= 0 turns the limiter off
+void FramePacer_SetRate(FramePacer *pacer, double fps);
+// Blocks until the next frame is due, call once per frame after the swap
+void FramePacer_Wait(FramePacer *pacer);
+
+// reported once per window
+#define FRAME_STATS_WINDOW_NS 1000000000ull
+
+struct FrameStatsSummary{
+    uint32_t m_Frames = 0;
+    double m_Fps = 0.0;
+    double m_AverageMs = 0.0;
+    double m_MinMs = 0.0;
+    double m_P99Ms = 0.0;
+    double m_MaxMs = 0.0;
+    double m_ProcessCpu = 0.0;          // CPU time of all threads / wall time, 1.0 = one core busy
+    double m_ThreadCpu = 0.0;           // of the thread calling FrameStats_Frame (render thread)
+    double m_SleptMs = 0.0;             // frame limiter, per frame
+    double m_SpunMs = 0.0;
+    uint32_t m_Missed = 0;
+};
+
+// Frame times and CPU use over fixed windows, optionally appended to a CSV file
+struct FrameStats{
+    std::vector<float> m_FrameMs;       // of the current window
+    uint64_t m_LastFrame = 0;
+    uint64_t m_WindowStart = 0;
+    uint64_t m_ProcessCpuStart = 0;
+    uint64_t m_ThreadCpuStart = 0;
+    uint64_t m_SleptStart = 0;
+    uint64_t m_SpunStart = 0;
+    uint32_t m_MissedStart = 0;
+    double m_Elapsed = 0.0;             // seconds since FrameStats_Open, CSV time column
+    FILE *m_Export = nullptr;
+    FrameStatsSummary m_Summary;        // last complete window
+};
+
+// exportPath may be null, otherwise the CSV is created with a header line
+bool FrameStats_Open(FrameStats *stats, const char *exportPath);
+void FrameStats_Close(FrameStats *stats);
+// Once per frame on the render thread. Returns true when a window closed and
+// m_Summary holds its numbers.
+bool FrameStats_Frame(FrameStats *stats, const FramePacer *pacer);
+void FrameStats_Print(const FrameStats *stats);
+
+#endif
@@ -0,0 +1,91 @@
+#include "frame_uniforms.hpp"
+#include "gl_state.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstring>
+
+void FrameUniforms_Create(FrameUniformRing *ring){
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    ring->m_Alignment = alignment;
+    StreamRing_Create(&ring->m_Stream, sizeof(FrameUniforms) + alignment);
+}
+
+void FrameUniforms_Delete(FrameUniformRing *ring){
+    StreamRing_Delete(&ring->m_Stream);
+}
+
+void FrameUniforms_BindPipeline(const Pipeline *pipeline){
+    constexpr uint32_t FrameBlock = HashName("FrameBlock");
+    constexpr uint32_t ObjectBlock = HashName("ObjectBlock");
+    Pipeline_BindUniformBlock(pipeline, FrameBlock, FRAME_UNIFORMS_BINDING);
+    Pipeline_BindUniformBlock(pipeline, ObjectBlock, OBJECT_UNIFORMS_BINDING);
+}
+
+void FrameUniforms_Update(FrameUniformRing *ring, const Camera &camera){
+    FrameUniforms &frame = ring->m_Current;
+    frame.m_View = camera.GetViewMatrix();
+    frame.m_Projection = camera.GetProjectionMatrix();
+    frame.m_ViewProjection = frame.m_Projection * frame.m_View;
+    frame.m_InverseView = glm::inverse(frame.m_View);
+    frame.m_InverseProjection = glm::inverse(frame.m_Projection);
+    frame.m_InverseViewProjection = glm::inverse(frame.m_ViewProjection);
+    frame.m_CameraPosition = glm::vec4(camera.GetEyePosition(), 1.0f);
+
+    // the segment's fence from three frames ago is waited on if the GPU still reads it
+    StreamRing *stream = &ring->m_Stream;
+    StreamRing_BeginFrame(stream);
+    StreamAllocation block = StreamRing_Allocate(stream, sizeof(FrameUniforms), ring->m_Alignment);
+    if(block.m_Data == nullptr){
+        // keeps the last frame's block bound
+        return;
+    }
+    memcpy(block.m_Data, &frame, sizeof(FrameUniforms));
+    StreamRing_Flush(stream);
+    GLState_BindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, stream->m_Buffer, block.m_Offset, block.m_Size);
+}
+
+void FrameUniforms_EndFrame(FrameUniformRing *ring){
+    StreamRing_EndFrame(&ring->m_Stream);
+}
+
+void ObjectUniforms_Create(ObjectUniformRing *ring, size_t capacity){
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    ring->m_Stride = std::max<GLsizeiptr>(alignment, sizeof(glm::mat4));
+    StreamRing_Create(&ring->m_Stream, (GLsizeiptr)std::max<size_t>(capacity, 1) * ring->m_Stride);
+}
+
+void ObjectUniforms_Delete(ObjectUniformRing *ring){
+    StreamRing_Delete(&ring->m_Stream);
+}
+
+void ObjectUniforms_Begin(ObjectUniformRing *ring, size_t count){
+    StreamRing *stream = &ring->m_Stream;
+    GLsizeiptr bytes = (GLsizeiptr)count * ring->m_Stride;
+    // grows by doubling, waiting on the GPU only the frames the scene outgrows it
+    StreamRing_Reserve(stream, bytes);
+    StreamRing_BeginFrame(stream);
+    ring->m_Blocks = count > 0 ? StreamRing_Allocate(stream, bytes, ring->m_Stride) : StreamAllocation();
+    ring->m_Count = ring->m_Blocks.m_Data ? count : 0;
+}
+
+void ObjectUniforms_Flush(ObjectUniformRing *ring){
+    StreamRing_Flush(&ring->m_Stream);
+}
+
+bool ObjectUniforms_Bind(const ObjectUniformRing *ring, size_t index){
+    if(index >= ring->m_Count){
+        return false;
+    }
+    GLState_BindBufferRange(GL_UNIFORM_BUFFER, OBJECT_UNIFORMS_BINDING, ring->m_Stream.m_Buffer,
+                            ring->m_Blocks.m_Offset + (GLintptr)index * ring->m_Stride, sizeof(glm::mat4));
+    return true;
+}
+
+void ObjectUniforms_EndFrame(ObjectUniformRing *ring){
+    StreamRing_EndFrame(&ring->m_Stream);
+    ring->m_Blocks = StreamAllocation();
+    ring->m_Count = 0;
+}
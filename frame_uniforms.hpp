@@ -0,0 +1,83 @@
+#ifndef FRAME_UNIFORMS_HPP
+#define FRAME_UNIFORMS_HPP
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <cstddef>
+#include <cstring>
+
+#include "camera.hpp"
+#include "pipeline.hpp"
+#include "stream_ring.hpp"
+
+// Binding point of "FrameBlock" in every pipeline
+#define FRAME_UNIFORMS_BINDING 0
+// Binding point of "ObjectBlock", the drawn mesh's matrix in the plain (non instanced) pipelines
+#define OBJECT_UNIFORMS_BINDING 1
+
+// std140 layout, must match the FrameBlock declaration in Shader/frame_block.glsl
+struct FrameUniforms{
+    glm::mat4 m_View;
+    glm::mat4 m_Projection;
+    glm::mat4 m_ViewProjection;
+    glm::mat4 m_InverseView;
+    glm::mat4 m_InverseProjection;
+    glm::mat4 m_InverseViewProjection;
+    glm::vec4 m_CameraPosition;     // xyz eye, w unused
+};
+static_assert(sizeof(FrameUniforms) == 6*64 + 16, "FrameUniforms must follow std140 packing");
+
+// One block a frame from a fenced StreamRing, so a frame never overwrites the
+// block of one the GPU is still reading however far behind the driver queues
+struct FrameUniformRing{
+    StreamRing m_Stream;
+    GLsizeiptr m_Alignment = 256;       // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+
+    FrameUniforms m_Current;            // CPU copy of what was uploaded this frame
+};
+
+void FrameUniforms_Create(FrameUniformRing *ring);
+void FrameUniforms_Delete(FrameUniformRing *ring);
+
+// Connects the pipeline's FrameBlock and ObjectBlock (those it has) to
+// FRAME_UNIFORMS_BINDING and OBJECT_UNIFORMS_BINDING
+void FrameUniforms_BindPipeline(const Pipeline *pipeline);
+
+// Once per frame: computes the camera matrices, writes them to the next ring
+// segment and binds that segment to FRAME_UNIFORMS_BINDING
+void FrameUniforms_Update(FrameUniformRing *ring, const Camera &camera);
+// After the frame's last draw, fences the segment
+void FrameUniforms_EndFrame(FrameUniformRing *ring);
+
+// Every visible mesh's projection * view * model uploaded once a frame into one
+// StreamRing allocation, one ObjectBlock per mesh at m_Stride. Drawing a mesh only
+// binds its block's range, instead of a glUniformMatrix4fv copying the matrix
+struct ObjectUniformRing{
+    StreamRing m_Stream;
+    GLsizeiptr m_Stride = 256;          // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, at least a mat4
+    StreamAllocation m_Blocks;          // this frame's, m_Data null when nothing was allocated
+    size_t m_Count = 0;
+};
+
+void ObjectUniforms_Create(ObjectUniformRing *ring, size_t capacity);
+void ObjectUniforms_Delete(ObjectUniformRing *ring);
+
+// Once per frame before the blocks are written, room for count meshes (the ring grows
+// between frames when needed)
+void ObjectUniforms_Begin(ObjectUniformRing *ring, size_t count);
+// Any thread between Begin and Flush, the block of mesh index
+inline void ObjectUniforms_Write(ObjectUniformRing *ring, size_t index, const glm::mat4 &modelViewProjection){
+    if(index >= ring->m_Count){
+        return;
+    }
+    memcpy((uint8_t*)ring->m_Blocks.m_Data + index * ring->m_Stride, &modelViewProjection, sizeof(glm::mat4));
+}
+// Render thread after the writes, uploads them when the ring isn't persistently mapped
+void ObjectUniforms_Flush(ObjectUniformRing *ring);
+// Binds the block of mesh index to OBJECT_UNIFORMS_BINDING, false if there is none this frame
+bool ObjectUniforms_Bind(const ObjectUniformRing *ring, size_t index);
+// After the frame's last draw, fences the segment
+void ObjectUniforms_EndFrame(ObjectUniformRing *ring);
+
+#endif
@@ -0,0 +1,218 @@
+#include "geometry_arena.hpp"
+#include "mesh_loader.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm>
+
+GeometryArena gGeometryArenas[GEOMETRY_ARENA_FORMATS];
+
+// starting sizes, doubled whenever an allocation doesn't fit
+#define GEOMETRY_ARENA_INITIAL_VERTICES (64 * 1024)
+#define GEOMETRY_ARENA_INITIAL_INDEX_UNITS (64 * 1024)
+
+// The VAO captures the vertex buffer per attribute and the index buffer, so this
+// runs again whenever the buffers are replaced by a bigger one
+static void BindArenaBuffers(GeometryArena *arena){
+    const GLsizei stride = arena->m_VertexSize;
+    GLState_BindVertexArray(arena->m_VertexArrayObject);
+    GLState_BindBuffer(GL_ARRAY_BUFFER, arena->m_VertexBuffer);
+    GLState_BindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->m_IndexBuffer);
+    //    vertex
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, false, stride, (void *)0);
+    //    color
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, false, stride, (void *)(sizeof(GLfloat)*3));
+    //    normal, texcoord (2..5 are the instance matrix columns)
+    int normalOffset = VertexFormat_Offset(arena->m_Format, VERTEX_NORMAL);
+    if(normalOffset >= 0){
+        glEnableVertexAttribArray(VERTEX_NORMAL_LOCATION);
+        glVertexAttribPointer(VERTEX_NORMAL_LOCATION, 3, GL_FLOAT, false, stride, (void *)(sizeof(GLfloat)*normalOffset));
+    }
+    int texcoordOffset = VertexFormat_Offset(arena->m_Format, VERTEX_TEXCOORD);
+    if(texcoordOffset >= 0){
+        glEnableVertexAttribArray(VERTEX_TEXCOORD_LOCATION);
+        glVertexAttribPointer(VERTEX_TEXCOORD_LOCATION, 2, GL_FLOAT, false, stride, (void *)(sizeof(GLfloat)*texcoordOffset));
+    }
+    GLState_BindVertexArray(0);
+}
+
+void GeometryArena_Create(GeometryArena *arena, uint32_t format, uint32_t vertexCapacity, uint32_t indexCapacity){
+    *arena = GeometryArena();
+    arena->m_Format = format;
+    arena->m_VertexSize = VertexFormat_Stride(format) * sizeof(GLfloat);
+    OffsetAllocator_Create(&arena->m_VertexAllocator, vertexCapacity);
+    OffsetAllocator_Create(&arena->m_IndexAllocator, indexCapacity);
+
+    glGenVertexArrays(1, &arena->m_VertexArrayObject);
+    glGenBuffers(1, &arena->m_VertexBuffer);
+    GLState_BindBuffer(GL_ARRAY_BUFFER, arena->m_VertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCapacity * arena->m_VertexSize, nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &arena->m_IndexBuffer);
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, arena->m_IndexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)indexCapacity * 4, nullptr, GL_STATIC_DRAW);
+    BindArenaBuffers(arena);
+}
+
+void GeometryArena_Delete(GeometryArena *arena){
+    GLState_DeleteBuffers(1, &arena->m_VertexBuffer);
+    GLState_DeleteBuffers(1, &arena->m_IndexBuffer);
+    GLState_DeleteBuffers(1, &arena->m_CopyBuffer);
+    GLState_DeleteVertexArrays(1, &arena->m_VertexArrayObject);
+    *arena = GeometryArena();
+}
+
+GeometryArena* GeometryArena_ForFormat(uint32_t format){
+    GeometryArena *arena = &gGeometryArenas[format % GEOMETRY_ARENA_FORMATS];
+    if(arena->m_VertexArrayObject == 0){
+        GeometryArena_Create(arena, format, GEOMETRY_ARENA_INITIAL_VERTICES, GEOMETRY_ARENA_INITIAL_INDEX_UNITS);
+    }
+    return arena;
+}
+
+void GeometryArena_DeleteAll(){
+    for(GeometryArena &arena : gGeometryArenas){
+        if(arena.m_VertexArrayObject != 0){
+            GeometryArena_Delete(&arena);
+        }
+    }
+}
+
+// New buffer of newBytes with the old contents copied over GPU side
+static GLuint GrowBuffer(GLuint buffer, size_t oldBytes, size_t newBytes){
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+    GLState_BindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+    GLState_DeleteBuffers(1, &buffer);
+    return grown;
+}
+
+static OffsetAllocation AllocateGrowing(GeometryArena *arena, OffsetAllocator *allocator, GLuint *buffer,
+                                        size_t unitSize, uint32_t count, uint32_t range){
+    OffsetAllocation allocation = OffsetAllocator_Allocate(allocator, count, range);
+    if(allocation.m_Offset != OFFSET_ALLOCATOR_NONE || count == 0){
+        return allocation;
+    }
+    uint32_t oldSize = allocator->m_Size;
+    uint32_t newSize = std::max(oldSize * 2, oldSize + count);
+    *buffer = GrowBuffer(*buffer, (size_t)oldSize * unitSize, (size_t)newSize * unitSize);
+    OffsetAllocator_Grow(allocator, newSize);
+    BindArenaBuffers(arena);
+    arena->m_Grows++;
+    return OffsetAllocator_Allocate(allocator, count, range);
+}
+
+uint32_t GeometryArena_Allocate(GeometryArena *arena, const void *vertices, uint32_t vertexCount,
+                                const void *indices, uint32_t indexCount, uint32_t indexSize){
+    uint32_t range;
+    if(!arena->m_FreeRanges.empty()){
+        range = arena->m_FreeRanges.back();
+        arena->m_FreeRanges.pop_back();
+    }else{
+        range = (uint32_t)arena->m_Ranges.size();
+        arena->m_Ranges.emplace_back();
+    }
+
+    uint32_t indexUnits = (indexCount * indexSize + 3) / 4;
+    GeometryRange entry;
+    entry.m_Vertices = AllocateGrowing(arena, &arena->m_VertexAllocator, &arena->m_VertexBuffer,
+                                       arena->m_VertexSize, vertexCount, range);
+    entry.m_Indices = AllocateGrowing(arena, &arena->m_IndexAllocator, &arena->m_IndexBuffer,
+                                      4, indexUnits, range);
+    entry.m_IndexCount = indexCount;
+    entry.m_IndexSize = indexSize;
+    arena->m_Ranges[range] = entry;
+
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, arena->m_VertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)entry.m_Vertices.m_Offset * arena->m_VertexSize,
+                    (GLsizeiptr)vertexCount * arena->m_VertexSize, vertices);
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, arena->m_IndexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)entry.m_Indices.m_Offset * 4,
+                    (GLsizeiptr)indexCount * indexSize, indices);
+    return range;
+}
+
+void GeometryArena_Free(GeometryArena *arena, uint32_t range){
+    if(range == GEOMETRY_RANGE_NONE){
+        return;
+    }
+    GeometryRange &entry = arena->m_Ranges[range];
+    OffsetAllocator_Free(&arena->m_VertexAllocator, entry.m_Vertices);
+    OffsetAllocator_Free(&arena->m_IndexAllocator, entry.m_Indices);
+    entry = GeometryRange();
+    arena->m_FreeRanges.push_back(range);
+}
+
+// glCopyBufferSubData rejects overlapping ranges within one buffer, those go
+// through the staging buffer
+static void MoveWithinBuffer(GeometryArena *arena, GLuint buffer, size_t from, size_t to, size_t bytes){
+    GLState_BindBuffer(GL_COPY_READ_BUFFER, buffer);
+    if(from - to >= bytes){
+        GLState_BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, to, bytes);
+        return;
+    }
+    if(arena->m_CopyBufferSize < bytes){
+        if(arena->m_CopyBuffer == 0){
+            glGenBuffers(1, &arena->m_CopyBuffer);
+        }
+        arena->m_CopyBufferSize = std::max(bytes, arena->m_CopyBufferSize * 2);
+        GLState_BindBuffer(GL_COPY_WRITE_BUFFER, arena->m_CopyBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, arena->m_CopyBufferSize, nullptr, GL_STREAM_COPY);
+    }
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, arena->m_CopyBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, 0, bytes);
+    GLState_BindBuffer(GL_COPY_READ_BUFFER, arena->m_CopyBuffer);
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, to, bytes);
+}
+
+static size_t Compact(GeometryArena *arena, OffsetAllocator *allocator, GLuint buffer, size_t unitSize,
+                      bool indices, size_t maxBytes){
+    size_t moved = 0;
+    OffsetAllocation from;
+    while(moved < maxBytes){
+        OffsetAllocation movable = OffsetAllocator_FirstMovable(allocator, from);
+        if(movable.m_Node == OFFSET_ALLOCATOR_NONE){
+            break;
+        }
+        uint32_t range = allocator->m_Nodes[movable.m_Node].m_UserData;
+        size_t bytes = (size_t)OffsetAllocator_AllocationSize(allocator, movable) * unitSize;
+        from = OffsetAllocator_SlideDown(allocator, movable);
+        MoveWithinBuffer(arena, buffer, (size_t)movable.m_Offset * unitSize, (size_t)from.m_Offset * unitSize, bytes);
+        if(indices){
+            arena->m_Ranges[range].m_Indices = from;
+        }else{
+            arena->m_Ranges[range].m_Vertices = from;
+        }
+        moved += bytes;
+    }
+    return moved;
+}
+
+size_t GeometryArena_Defragment(GeometryArena *arena, size_t maxBytes){
+    size_t moved = Compact(arena, &arena->m_VertexAllocator, arena->m_VertexBuffer, arena->m_VertexSize, false, maxBytes);
+    if(moved < maxBytes){
+        moved += Compact(arena, &arena->m_IndexAllocator, arena->m_IndexBuffer, 4, true, maxBytes - moved);
+    }
+    arena->m_BytesMoved = moved;
+    return moved;
+}
+
+size_t GeometryArena_DefragmentAll(size_t maxBytes){
+    size_t moved = 0;
+    for(GeometryArena &arena : gGeometryArenas){
+        if(arena.m_VertexArrayObject != 0 && moved < maxBytes){
+            moved += GeometryArena_Defragment(&arena, maxBytes - moved);
+        }
+    }
+    return moved;
+}
+
+void GeometryArena_GetStats(const GeometryArena *arena, OffsetAllocatorStats *vertices, OffsetAllocatorStats *indices){
+    *vertices = OffsetAllocator_GetStats(&arena->m_VertexAllocator);
+    *indices = OffsetAllocator_GetStats(&arena->m_IndexAllocator);
+}
@@ -0,0 +1,75 @@
+#ifndef GEOMETRY_ARENA_HPP
+#define GEOMETRY_ARENA_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "offset_allocator.hpp"
+
+#define GEOMETRY_RANGE_NONE 0xFFFFFFFFu
+// one arena per VertexAttributeBits combination (4 bits)
+#define GEOMETRY_ARENA_FORMATS 16
+
+// One mesh's slice of an arena. Offsets live here rather than in the mesh so
+// defragmentation can move the data without knowing who uses it.
+struct GeometryRange{
+    OffsetAllocation m_Vertices;    // in vertices, doubles as the base vertex
+    OffsetAllocation m_Indices;     // in 4 byte units, 16 bit meshes pack two per unit
+    uint32_t m_IndexCount = 0;
+    uint32_t m_IndexSize = 0;       // 2 or 4
+};
+
+// Shared VBO + EBO (and the VAO describing them) for every mesh of one vertex
+// format, so the meshes draw with glDrawElementsBaseVertex without rebinding
+struct GeometryArena{
+    uint32_t m_Format = 0;
+    uint32_t m_VertexSize = 0;      // bytes
+    GLuint m_VertexArrayObject = 0;
+    GLuint m_VertexBuffer = 0;
+    GLuint m_IndexBuffer = 0;
+    GLuint m_CopyBuffer = 0;        // staging for moves whose source and destination overlap
+    size_t m_CopyBufferSize = 0;
+
+    OffsetAllocator m_VertexAllocator;
+    OffsetAllocator m_IndexAllocator;
+
+    std::vector<GeometryRange> m_Ranges;
+    std::vector<uint32_t> m_FreeRanges;
+
+    // stats
+    size_t m_BytesMoved = 0;        // by the last GeometryArena_Defragment
+    unsigned m_Grows = 0;
+};
+
+// Created on first use, deleted by GeometryArena_DeleteAll
+extern GeometryArena gGeometryArenas[GEOMETRY_ARENA_FORMATS];
+GeometryArena* GeometryArena_ForFormat(uint32_t format);
+void GeometryArena_DeleteAll();
+
+void GeometryArena_Create(GeometryArena *arena, uint32_t format, uint32_t vertexCapacity, uint32_t indexCapacity);
+void GeometryArena_Delete(GeometryArena *arena);
+
+// Copies the data in (growing the buffers when needed), returns the range handle
+uint32_t GeometryArena_Allocate(GeometryArena *arena, const void *vertices, uint32_t vertexCount,
+                                const void *indices, uint32_t indexCount, uint32_t indexSize);
+void GeometryArena_Free(GeometryArena *arena, uint32_t range);
+
+inline GLint GeometryArena_BaseVertex(const GeometryArena *arena, uint32_t range){
+    return (GLint)arena->m_Ranges[range].m_Vertices.m_Offset;
+}
+// byte offset into the index buffer, the "indices" argument of glDrawElements*
+inline const void* GeometryArena_IndexOffset(const GeometryArena *arena, uint32_t range){
+    return (const void*)((size_t)arena->m_Ranges[range].m_Indices.m_Offset * 4);
+}
+
+// Slides ranges down over the holes in front of them, lowest first, until about
+// maxBytes were copied. Copies are queued GPU side, draws already issued still see
+// the old data and later draws the new one. Returns the bytes moved.
+size_t GeometryArena_Defragment(GeometryArena *arena, size_t maxBytes);
+size_t GeometryArena_DefragmentAll(size_t maxBytes);
+
+void GeometryArena_GetStats(const GeometryArena *arena, OffsetAllocatorStats *vertices, OffsetAllocatorStats *indices);
+
+#endif
@@ -0,0 +1,322 @@
+#include "gl_debug.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifndef GL_CONTEXT_FLAGS
+#define GL_CONTEXT_FLAGS 0x821E
+#endif
+
+// a lost context can keep reporting, the per frame fallback reads no more than this
+#define GL_DEBUG_MAX_POLLED_ERRORS 8
+
+GLDebug gGLDebug;
+
+static const char* SourceName(GLenum source){
+    switch(source){
+        case GL_DEBUG_SOURCE_API: return "api";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+static const char* TypeName(GLenum type){
+    switch(type){
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        case GL_DEBUG_TYPE_MARKER: return "marker";
+        default: return "other";
+    }
+}
+
+static const char* SeverityName(GLenum severity){
+    switch(severity){
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+        default: return "notification";
+    }
+}
+
+static void Print(const GLDebugMessage &message, const char *group){
+    fprintf(stderr, "GL debug [frame %u] %s %s, %s severity (0x%x)%s%s: %s\n", message.m_Frame,
+            SourceName(message.m_Source), TypeName(message.m_Type), SeverityName(message.m_Severity), message.m_Id,
+            group ? " in " : "", group ? group : "", message.m_Text);
+}
+
+// FNV-1a over the text and what identifies the message, never 0 (a free slot)
+static uint64_t Key(GLenum source, GLenum type, GLuint id, GLenum severity, const char *text, size_t length){
+    uint64_t hash = 14695981039346656037ull;
+    uint32_t words[4] = {source, type, id, severity};
+    const unsigned char *bytes = (const unsigned char *)words;
+    for(size_t i=0; i<sizeof(words); i++){
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    for(size_t i=0; i<length; i++){
+        hash = (hash ^ (unsigned char)text[i]) * 1099511628211ull;
+    }
+    return hash ? hash : 1;
+}
+
+// the slot counting key, claimed on first sight; null when the probes are all taken
+static GLDebugSlot* FindSlot(uint64_t key, GLuint id, const char *text, size_t length){
+    for(uint32_t probe=0; probe<GL_DEBUG_DEDUP_PROBES; probe++){
+        GLDebugSlot &slot = gGLDebug.m_Slots[(key + probe) & (GL_DEBUG_DEDUP_SLOTS - 1)];
+        uint64_t current = slot.m_Key.load(std::memory_order_acquire);
+        if(current == 0){
+            if(slot.m_Key.compare_exchange_strong(current, key, std::memory_order_acq_rel)){
+                slot.m_Id = id;
+                snprintf(slot.m_Text, sizeof(slot.m_Text), "%.*s", (int)length, text);
+                slot.m_Ready.store(true, std::memory_order_release);
+                return &slot;
+            }
+        }
+        if(current == key){
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// false when the drain thread is behind by a whole queue
+static bool Enqueue(GLenum source, GLenum type, GLuint id, GLenum severity, const char *text, size_t length){
+    GLDebug &debug = gGLDebug;
+    uint32_t position = debug.m_Head.load(std::memory_order_relaxed);
+    GLDebugMessage *message;
+    for(;;){
+        message = &debug.m_Queue[position & (GL_DEBUG_QUEUE_SIZE - 1)];
+        int32_t lag = (int32_t)(message->m_Sequence.load(std::memory_order_acquire) - position);
+        if(lag == 0){
+            if(debug.m_Head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                break;
+            }
+        }else if(lag < 0){
+            return false;
+        }else{
+            position = debug.m_Head.load(std::memory_order_relaxed);
+        }
+    }
+    message->m_Source = source;
+    message->m_Type = type;
+    message->m_Severity = severity;
+    message->m_Id = id;
+    message->m_Frame = debug.m_Frame.load(std::memory_order_relaxed);
+    length = std::min(length, (size_t)GL_DEBUG_TEXT_LENGTH - 1);
+    memcpy(message->m_Text, text, length);
+    message->m_Text[length] = '\0';
+    message->m_Sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+// m_ShownAt while one thread tries to print or queue the message
+#define GL_DEBUG_SHOWING UINT32_MAX
+
+// false when over the rate limit or the queue is full
+static bool Show(GLenum source, GLenum type, GLuint id, GLenum severity, size_t textLength, const GLchar *text){
+    GLDebug &debug = gGLDebug;
+    if(debug.m_Budget.fetch_sub(1, std::memory_order_relaxed) <= 0){
+        debug.m_RateLimited.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if(debug.m_Mode == GL_DEBUG_MODE_SYNC){
+        // inside the failing call, a breakpoint here shows who made it
+        GLDebugMessage message;
+        message.m_Source = source;
+        message.m_Type = type;
+        message.m_Severity = severity;
+        message.m_Id = id;
+        message.m_Frame = debug.m_Frame.load(std::memory_order_relaxed);
+        snprintf(message.m_Text, sizeof(message.m_Text), "%.*s", (int)textLength, text);
+        uint32_t depth = std::min(debug.m_GroupDepth, (uint32_t)GL_DEBUG_GROUPS);
+        Print(message, depth > 0 ? debug.m_GroupNames[depth - 1] : nullptr);
+        return true;
+    }
+    if(!Enqueue(source, type, id, severity, text, textLength)){
+        debug.m_QueueFull.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// any thread the driver calls back on (the render thread in sync mode)
+static void Receive(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *text){
+    GLDebug &debug = gGLDebug;
+    size_t textLength = length < 0 ? strlen(text) : (size_t)length;
+    debug.m_Messages.fetch_add(1, std::memory_order_relaxed);
+    if(type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH){
+        debug.m_Errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    GLDebugSlot *slot = FindSlot(Key(source, type, id, severity, text, textLength), id, text, textLength);
+    if(slot == nullptr){
+        Show(source, type, id, severity, textLength, text);
+        return;
+    }
+    // only a message that got shown folds later ones into repeats, one dropped by the
+    // rate limit or a full queue is tried again on its next occurrence
+    uint32_t count = slot->m_Count.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t shownAt = 0;
+    if(!slot->m_ShownAt.compare_exchange_strong(shownAt, GL_DEBUG_SHOWING, std::memory_order_acq_rel)){
+        debug.m_Repeats.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    bool shown = Show(source, type, id, severity, textLength, text);
+    slot->m_ShownAt.store(shown ? count : 0, std::memory_order_release);
+}
+
+static void APIENTRY Callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                              const GLchar *message, const void *userParam){
+    Receive(source, type, id, severity, length, message);
+}
+
+// drain thread, and GLDebug_Stop once it has been joined
+static void Drain(){
+    GLDebug &debug = gGLDebug;
+    for(;;){
+        GLDebugMessage &message = debug.m_Queue[debug.m_Tail & (GL_DEBUG_QUEUE_SIZE - 1)];
+        if(message.m_Sequence.load(std::memory_order_acquire) != debug.m_Tail + 1){
+            break;
+        }
+        Print(message, nullptr);
+        message.m_Sequence.store(debug.m_Tail + GL_DEBUG_QUEUE_SIZE, std::memory_order_release);
+        debug.m_Tail++;
+    }
+    // repeats since the last drain of messages already printed, a never shown one has none
+    for(GLDebugSlot &slot : debug.m_Slots){
+        uint32_t shownAt = slot.m_ShownAt.load(std::memory_order_acquire);
+        if(!slot.m_Ready.load(std::memory_order_acquire) || shownAt == 0 || shownAt == GL_DEBUG_SHOWING){
+            continue;
+        }
+        uint32_t count = slot.m_Count.load(std::memory_order_relaxed);
+        uint32_t printed = std::max(slot.m_Reported, shownAt);
+        if(count > printed){
+            fprintf(stderr, "GL debug: (0x%x) %s, repeated %u more times\n", slot.m_Id, slot.m_Text, count - printed);
+        }
+        slot.m_Reported = count;
+    }
+    debug.m_Budget.store(GL_DEBUG_MESSAGES_PER_DRAIN, std::memory_order_relaxed);
+}
+
+static void DrainLoop(){
+    while(!gGLDebug.m_Stop.load(std::memory_order_acquire)){
+        std::this_thread::sleep_for(std::chrono::milliseconds(GL_DEBUG_DRAIN_MS));
+        Drain();
+    }
+}
+
+void GLDebug_Start(GLDebugMode mode){
+    GLDebug &debug = gGLDebug;
+    debug.m_Mode = mode;
+    if(mode == GL_DEBUG_MODE_OFF){
+        return;
+    }
+    for(uint32_t i=0; i<GL_DEBUG_QUEUE_SIZE; i++){
+        debug.m_Queue[i].m_Sequence.store(i, std::memory_order_relaxed);
+    }
+    debug.m_Callback = gGLExt.m_Debug;
+    debug.m_Groups = gGLExt.m_Debug;
+    if(debug.m_Callback){
+        glDebugMessageCallback(Callback, nullptr);
+        // notifications (our own group pushes among them) are only noise
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+        glEnable(GL_DEBUG_OUTPUT);
+        if(mode == GL_DEBUG_MODE_SYNC){
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            GLint flags = 0;
+            glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+            if(!(flags & GL_CONTEXT_FLAG_DEBUG_BIT)){
+                fprintf(stderr, "GL debug: not a debug context, the driver may report less\n");
+            }
+        }else{
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+    }
+    debug.m_Stop.store(false, std::memory_order_relaxed);
+    debug.m_Drain = std::thread(DrainLoop);
+}
+
+void GLDebug_Stop(){
+    GLDebug &debug = gGLDebug;
+    if(debug.m_Mode == GL_DEBUG_MODE_OFF){
+        return;
+    }
+    if(debug.m_Callback){
+        glDisable(GL_DEBUG_OUTPUT);
+        glDebugMessageCallback(nullptr, nullptr);
+    }
+    debug.m_Stop.store(true, std::memory_order_release);
+    if(debug.m_Drain.joinable()){
+        debug.m_Drain.join();
+    }
+    Drain();
+    debug.m_Mode = GL_DEBUG_MODE_OFF;
+}
+
+bool GLDebug_PushGroup(const char *name){
+    GLDebug &debug = gGLDebug;
+    if(!debug.m_Groups){
+        return false;
+    }
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    if(debug.m_GroupDepth < GL_DEBUG_GROUPS){
+        debug.m_GroupNames[debug.m_GroupDepth] = name;
+    }
+    debug.m_GroupDepth++;
+    return true;
+}
+
+void GLDebug_PopGroup(){
+    glPopDebugGroup();
+    gGLDebug.m_GroupDepth--;
+}
+
+void GLDebug_EndFrame(){
+    GLDebug &debug = gGLDebug;
+    if(debug.m_Mode == GL_DEBUG_MODE_OFF){
+        return;
+    }
+    debug.m_Frame.store(debug.m_Frame.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if(debug.m_Callback){
+        return;
+    }
+    // one error flag is cleared per read
+    for(int i=0; i<GL_DEBUG_MAX_POLLED_ERRORS; i++){
+        GLenum error = glGetError();
+        if(error == GL_NO_ERROR){
+            break;
+        }
+        char text[64];
+        snprintf(text, sizeof(text), "glGetError 0x%x during the frame", error);
+        Receive(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, error, GL_DEBUG_SEVERITY_HIGH, -1, text);
+    }
+}
+
+const char* GLDebug_ModeName(GLDebugMode mode){
+    switch(mode){
+        case GL_DEBUG_MODE_OFF: return "off";
+        case GL_DEBUG_MODE_ASYNC: return "async";
+        case GL_DEBUG_MODE_SYNC: return "sync";
+    }
+    return "?";
+}
+
+void GLDebug_PrintStats(){
+    const GLDebug &debug = gGLDebug;
+    if(debug.m_Mode == GL_DEBUG_MODE_OFF){
+        return;
+    }
+    printf("GL debug (%s, %s): %llu messages, %llu errors, %llu repeats folded, %llu over the rate limit, %llu lost to a full queue\n",
+           GLDebug_ModeName(debug.m_Mode), debug.m_Callback ? "KHR_debug" : "glGetError once a frame",
+           (unsigned long long)debug.m_Messages.load(std::memory_order_relaxed),
+           (unsigned long long)debug.m_Errors.load(std::memory_order_relaxed),
+           (unsigned long long)debug.m_Repeats.load(std::memory_order_relaxed),
+           (unsigned long long)debug.m_RateLimited.load(std::memory_order_relaxed),
+           (unsigned long long)debug.m_QueueFull.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,109 @@
+#ifndef GL_DEBUG_HPP
+#define GL_DEBUG_HPP
+
+#include <glad/glad.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "gl_ext.hpp"
+
+// GL errors and driver warnings without glGetError polling. The driver reports
+// through the KHR_debug callback, by default asynchronously (maybe on its own
+// threads, the GL call that caused it has long returned). The callback counts
+// each distinct message in a lock-free table; a new one, while under the rate
+// limit, is copied into a lock-free ring that a background thread drains to
+// stderr every GL_DEBUG_DRAIN_MS, together with how often each message repeated.
+// The render thread never waits on the driver or on output, so this stays on.
+//  --gl-debug sync   debug context with GL_DEBUG_OUTPUT_SYNCHRONOUS: the callback
+//                    runs inside the failing call on the render thread and prints
+//                    at once with the innermost debug group. For a debugger only,
+//                    it costs frame time
+//  --gl-debug off    nothing installed
+// Without KHR_debug glGetError is read once a frame instead.
+// Debug groups (glPushDebugGroup) are pushed by the PROFILE_GPU_SCOPEs and show
+// up in capture tools as well.
+
+#define GL_DEBUG_TEXT_LENGTH 256            // longer messages are cut
+#define GL_DEBUG_REPEAT_TEXT_LENGTH 80      // of a message kept to name it in repeat counts
+#define GL_DEBUG_QUEUE_SIZE 256             // power of two, messages waiting for the drain thread
+#define GL_DEBUG_DEDUP_SLOTS 512            // power of two, distinct messages counted
+#define GL_DEBUG_DEDUP_PROBES 16            // a message not found or placed within this many slots isn't deduplicated
+#define GL_DEBUG_DRAIN_MS 100
+#define GL_DEBUG_MESSAGES_PER_DRAIN 20      // new messages queued per drain period, the rest only counted
+#define GL_DEBUG_GROUPS 32                  // debug group names tracked, deeper pushes still go to GL
+
+enum GLDebugMode{
+    GL_DEBUG_MODE_OFF,
+    GL_DEBUG_MODE_ASYNC,
+    GL_DEBUG_MODE_SYNC,
+};
+
+struct GLDebugMessage{
+    std::atomic<uint32_t> m_Sequence{0};    // ring position it can be written at (== pos) or read at (== pos + 1)
+    GLenum m_Source;
+    GLenum m_Type;
+    GLenum m_Severity;
+    GLuint m_Id;
+    uint32_t m_Frame;
+    char m_Text[GL_DEBUG_TEXT_LENGTH];
+};
+
+// one distinct message (source, type, id, severity and text)
+struct GLDebugSlot{
+    std::atomic<uint64_t> m_Key{0};         // 0 free, claimed once and never released
+    std::atomic<uint32_t> m_Count{0};
+    std::atomic<bool> m_Ready{false};       // m_Id/m_Text written by the claiming thread
+    std::atomic<uint32_t> m_ShownAt{0};     // m_Count when printed or queued, 0 not yet (rate limited, queue full)
+    GLuint m_Id = 0;
+    char m_Text[GL_DEBUG_REPEAT_TEXT_LENGTH];
+    uint32_t m_Reported = 0;                // drain thread, m_Count already printed
+};
+
+struct GLDebug{
+    GLDebugMode m_Mode = GL_DEBUG_MODE_OFF;
+    bool m_Callback = false;                // KHR_debug callback installed, otherwise glGetError once a frame
+    bool m_Groups = false;                  // glPushDebugGroup available
+
+    // multi producer (the callback), single consumer (the drain thread)
+    GLDebugMessage m_Queue[GL_DEBUG_QUEUE_SIZE];
+    alignas(64) std::atomic<uint32_t> m_Head{0};
+    alignas(64) uint32_t m_Tail = 0;        // drain thread
+    GLDebugSlot m_Slots[GL_DEBUG_DEDUP_SLOTS];
+    std::atomic<int32_t> m_Budget{GL_DEBUG_MESSAGES_PER_DRAIN};     // refilled by every drain
+    std::atomic<uint32_t> m_Frame{0};
+
+    // since GLDebug_Start
+    std::atomic<uint64_t> m_Messages{0};
+    std::atomic<uint64_t> m_Errors{0};      // GL_DEBUG_TYPE_ERROR or high severity
+    std::atomic<uint64_t> m_Repeats{0};     // folded into a message already seen
+    std::atomic<uint64_t> m_RateLimited{0};
+    std::atomic<uint64_t> m_QueueFull{0};
+
+    std::thread m_Drain;
+    std::atomic<bool> m_Stop{false};
+
+    // render thread
+    const char *m_GroupNames[GL_DEBUG_GROUPS];
+    uint32_t m_GroupDepth = 0;
+};
+
+extern GLDebug gGLDebug;
+
+// Context current and GLExt_Load done. Installs the callback and starts the drain thread
+void GLDebug_Start(GLDebugMode mode);
+// Uninstalls the callback, prints what is left in the queue
+void GLDebug_Stop();
+
+// Debug group around the GL calls until the matching pop, name must outlive it.
+// False (and nothing to pop) without KHR_debug
+bool GLDebug_PushGroup(const char *name);
+void GLDebug_PopGroup();
+
+// Frame boundary, render thread. Reads glGetError without KHR_debug
+void GLDebug_EndFrame();
+
+const char* GLDebug_ModeName(GLDebugMode mode);
+void GLDebug_PrintStats();
+
+#endif
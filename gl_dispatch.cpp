@@ -0,0 +1,519 @@
+#include "gl_dispatch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+GLDispatch gGLDispatch;
+
+static const char *gNames[GL_FN_COUNT] = {
+#define GL_DISPATCH_NAME(name) "gl" #name,
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_NAME)
+#undef GL_DISPATCH_NAME
+};
+
+// what counting forwards to, typed like the entry point
+#define GL_INNER(name) ((decltype(gl##name))gGLDispatch.m_Inner[GL_FN_##name])
+
+// buffer targets this program binds, the rest share the last slot
+#define GL_DISPATCH_TARGETS 8
+#define GL_DISPATCH_OTHER_TARGET 7
+static uint32_t TargetIndex(GLenum target){
+    switch(target){
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_COPY_READ_BUFFER: return 3;
+        case GL_COPY_WRITE_BUFFER: return 4;
+        case GL_DRAW_INDIRECT_BUFFER: return 5;
+        case GL_SHADER_STORAGE_BUFFER: return 6;
+        default: return GL_DISPATCH_OTHER_TARGET;
+    }
+}
+
+// Every entry point without a hand written version below: null returns a zero
+// value, counting counts and forwards
+template<typename Function> struct Generic;
+template<typename Result, typename... Args>
+struct Generic<Result (APIENTRYP)(Args...)>{
+    static Result APIENTRY Null(Args...){
+        return Result();
+    }
+    template<GLDispatchFunction F>
+    static Result APIENTRY Count(Args... args){
+        gGLDispatch.m_Stats.m_Calls[F]++;
+        return ((Result (APIENTRYP)(Args...))gGLDispatch.m_Inner[F])(args...);
+    }
+};
+
+///// null /////
+
+// object names are never reused, buffers get host memory to map
+struct NullState{
+    GLuint m_NextName = 1;
+    GLuint m_Bound[GL_DISPATCH_TARGETS] = {};
+    std::unordered_map<GLuint, std::vector<uint8_t>> m_Storage;
+};
+static NullState gNull;
+
+static void APIENTRY NullGen(GLsizei n, GLuint *names){
+    for(GLsizei i=0; i<n; i++){
+        names[i] = gNull.m_NextName++;
+    }
+}
+static GLuint APIENTRY NullCreateProgram(){
+    return gNull.m_NextName++;
+}
+static GLuint APIENTRY NullCreateShader(GLenum type){
+    return gNull.m_NextName++;
+}
+static GLsync APIENTRY NullFenceSync(GLenum condition, GLbitfield flags){
+    return (GLsync)(uintptr_t)gNull.m_NextName++;
+}
+static GLenum APIENTRY NullClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout){
+    return GL_ALREADY_SIGNALED;
+}
+static GLenum APIENTRY NullCheckFramebufferStatus(GLenum target){
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void APIENTRY NullBindBuffer(GLenum target, GLuint buffer){
+    gNull.m_Bound[TargetIndex(target)] = buffer;
+}
+static void APIENTRY NullBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+    gNull.m_Bound[TargetIndex(target)] = buffer;
+}
+static void APIENTRY NullBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage){
+    gNull.m_Storage[gNull.m_Bound[TargetIndex(target)]].resize((size_t)size);
+}
+static void APIENTRY NullBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags){
+    gNull.m_Storage[gNull.m_Bound[TargetIndex(target)]].resize((size_t)size);
+}
+static void* APIENTRY NullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+    std::vector<uint8_t> &storage = gNull.m_Storage[gNull.m_Bound[TargetIndex(target)]];
+    if(storage.size() < (size_t)(offset + length)){
+        storage.resize((size_t)(offset + length));
+    }
+    return storage.data() + offset;
+}
+static GLboolean APIENTRY NullUnmapBuffer(GLenum target){
+    return GL_TRUE;
+}
+static void APIENTRY NullDeleteBuffers(GLsizei n, const GLuint *buffers){
+    for(GLsizei i=0; i<n; i++){
+        gNull.m_Storage.erase(buffers[i]);
+    }
+}
+
+// compiles, links and validation succeed, nothing is active
+static void APIENTRY NullGetObjectiv(GLuint object, GLenum pname, GLint *params){
+    switch(pname){
+        case GL_COMPILE_STATUS:
+        case GL_LINK_STATUS:
+        case GL_VALIDATE_STATUS:
+        case GL_COMPLETION_STATUS_KHR:
+            *params = GL_TRUE;
+            break;
+        default:
+            *params = 0;
+    }
+}
+static void APIENTRY NullInfoLog(GLuint object, GLsizei bufSize, GLsizei *length, GLchar *log){
+    if(length){
+        *length = 0;
+    }
+    if(bufSize > 0){
+        log[0] = '\0';
+    }
+}
+static GLint APIENTRY NullGetLocation(GLuint program, const GLchar *name){
+    return -1;
+}
+
+// a 4.4 context without extensions
+static void APIENTRY NullGetIntegerv(GLenum pname, GLint *data){
+    switch(pname){
+        case GL_MAJOR_VERSION: *data = 4; break;
+        case GL_MINOR_VERSION: *data = 4; break;
+        case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+        case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+        default: *data = 0;
+    }
+}
+static void APIENTRY NullGetInteger64v(GLenum pname, GLint64 *data){
+    *data = 0;
+}
+static const GLubyte* APIENTRY NullGetString(GLenum name){
+    switch(name){
+        case GL_VENDOR: return (const GLubyte *)"none";
+        case GL_RENDERER: return (const GLubyte *)"null backend";
+        case GL_VERSION: return (const GLubyte *)"4.4 (Core Profile) null";
+        case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte *)"4.40";
+        default: return (const GLubyte *)"";
+    }
+}
+static const GLubyte* APIENTRY NullGetStringi(GLenum name, GLuint index){
+    return (const GLubyte *)"";
+}
+// timer queries are done at once and took no time
+static void APIENTRY NullGetQueryObjectuiv(GLuint id, GLenum pname, GLuint *params){
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+static void APIENTRY NullGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params){
+    *params = 0;
+}
+
+///// counting /////
+
+#define GL_DISPATCH_UNKNOWN 0xFFFFFFFFu
+
+// the state as the calls seen so far left it, GL_DISPATCH_UNKNOWN until first set
+struct CountingState{
+    GLuint m_Program;
+    GLuint m_VertexArray;
+    GLuint m_Framebuffer;
+    GLuint m_Renderbuffer;
+    GLuint m_Buffers[GL_DISPATCH_TARGETS];
+    std::unordered_map<GLenum, bool> m_Enabled;
+    bool m_ViewportKnown;
+    GLint m_Viewport[4];
+    bool m_ClearColorKnown;
+    GLfloat m_ClearColor[4];
+    GLenum m_BlendSource;
+    GLenum m_BlendDestination;
+    GLuint m_DepthMask;
+};
+static CountingState gCounting;
+
+static void ForgetState(){
+    gCounting.m_Program = GL_DISPATCH_UNKNOWN;
+    gCounting.m_VertexArray = GL_DISPATCH_UNKNOWN;
+    gCounting.m_Framebuffer = GL_DISPATCH_UNKNOWN;
+    gCounting.m_Renderbuffer = GL_DISPATCH_UNKNOWN;
+    std::fill(gCounting.m_Buffers, gCounting.m_Buffers + GL_DISPATCH_TARGETS, GL_DISPATCH_UNKNOWN);
+    gCounting.m_Enabled.clear();
+    gCounting.m_ViewportKnown = false;
+    gCounting.m_ClearColorKnown = false;
+    gCounting.m_BlendSource = GL_DISPATCH_UNKNOWN;
+    gCounting.m_BlendDestination = GL_DISPATCH_UNKNOWN;
+    gCounting.m_DepthMask = GL_DISPATCH_UNKNOWN;
+}
+
+static void Count(GLDispatchFunction function, bool redundant){
+    gGLDispatch.m_Stats.m_Calls[function]++;
+    gGLDispatch.m_Stats.m_Redundant[function] += redundant ? 1 : 0;
+}
+
+// value becomes the shadowed state, true if it already was
+template<typename Value>
+static bool Set(Value *shadow, Value value){
+    bool redundant = *shadow == value;
+    *shadow = value;
+    return redundant;
+}
+
+static void APIENTRY CountUseProgram(GLuint program){
+    Count(GL_FN_UseProgram, Set(&gCounting.m_Program, program));
+    GL_INNER(UseProgram)(program);
+}
+static void APIENTRY CountBindVertexArray(GLuint vertexArray){
+    bool redundant = Set(&gCounting.m_VertexArray, vertexArray);
+    if(!redundant){
+        // the element array binding is part of the vertex array
+        gCounting.m_Buffers[TargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = GL_DISPATCH_UNKNOWN;
+    }
+    Count(GL_FN_BindVertexArray, redundant);
+    GL_INNER(BindVertexArray)(vertexArray);
+}
+static void APIENTRY CountBindBuffer(GLenum target, GLuint buffer){
+    uint32_t slot = TargetIndex(target);
+    bool redundant = slot != GL_DISPATCH_OTHER_TARGET && Set(&gCounting.m_Buffers[slot], buffer);
+    Count(GL_FN_BindBuffer, redundant);
+    GL_INNER(BindBuffer)(target, buffer);
+}
+// also binds the target's generic binding point, the indexed ranges aren't shadowed
+static void APIENTRY CountBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+    uint32_t slot = TargetIndex(target);
+    if(slot != GL_DISPATCH_OTHER_TARGET){
+        gCounting.m_Buffers[slot] = buffer;
+    }
+    Count(GL_FN_BindBufferRange, false);
+    GL_INNER(BindBufferRange)(target, index, buffer, offset, size);
+}
+static void APIENTRY CountBindFramebuffer(GLenum target, GLuint framebuffer){
+    bool redundant = false;
+    if(target == GL_FRAMEBUFFER){
+        redundant = Set(&gCounting.m_Framebuffer, framebuffer);
+    }else{
+        gCounting.m_Framebuffer = GL_DISPATCH_UNKNOWN;
+    }
+    Count(GL_FN_BindFramebuffer, redundant);
+    GL_INNER(BindFramebuffer)(target, framebuffer);
+}
+static void APIENTRY CountBindRenderbuffer(GLenum target, GLuint renderbuffer){
+    Count(GL_FN_BindRenderbuffer, Set(&gCounting.m_Renderbuffer, renderbuffer));
+    GL_INNER(BindRenderbuffer)(target, renderbuffer);
+}
+static bool SetEnabled(GLenum cap, bool enabled){
+    auto known = gCounting.m_Enabled.find(cap);
+    bool redundant = known != gCounting.m_Enabled.end() && known->second == enabled;
+    gCounting.m_Enabled[cap] = enabled;
+    return redundant;
+}
+static void APIENTRY CountEnable(GLenum cap){
+    Count(GL_FN_Enable, SetEnabled(cap, true));
+    GL_INNER(Enable)(cap);
+}
+static void APIENTRY CountDisable(GLenum cap){
+    Count(GL_FN_Disable, SetEnabled(cap, false));
+    GL_INNER(Disable)(cap);
+}
+static void APIENTRY CountViewport(GLint x, GLint y, GLsizei width, GLsizei height){
+    GLint viewport[4] = {x, y, width, height};
+    bool redundant = gCounting.m_ViewportKnown && memcmp(viewport, gCounting.m_Viewport, sizeof(viewport)) == 0;
+    memcpy(gCounting.m_Viewport, viewport, sizeof(viewport));
+    gCounting.m_ViewportKnown = true;
+    Count(GL_FN_Viewport, redundant);
+    GL_INNER(Viewport)(x, y, width, height);
+}
+static void APIENTRY CountClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha){
+    GLfloat color[4] = {red, green, blue, alpha};
+    bool redundant = gCounting.m_ClearColorKnown && memcmp(color, gCounting.m_ClearColor, sizeof(color)) == 0;
+    memcpy(gCounting.m_ClearColor, color, sizeof(color));
+    gCounting.m_ClearColorKnown = true;
+    Count(GL_FN_ClearColor, redundant);
+    GL_INNER(ClearColor)(red, green, blue, alpha);
+}
+static void APIENTRY CountBlendFunc(GLenum source, GLenum destination){
+    bool redundant = gCounting.m_BlendSource == source && gCounting.m_BlendDestination == destination;
+    gCounting.m_BlendSource = source;
+    gCounting.m_BlendDestination = destination;
+    Count(GL_FN_BlendFunc, redundant);
+    GL_INNER(BlendFunc)(source, destination);
+}
+static void APIENTRY CountDepthMask(GLboolean flag){
+    Count(GL_FN_DepthMask, Set(&gCounting.m_DepthMask, (GLuint)flag));
+    GL_INNER(DepthMask)(flag);
+}
+
+// deleting a bound object unbinds it
+static void APIENTRY CountDeleteBuffers(GLsizei n, const GLuint *buffers){
+    for(GLsizei i=0; i<n; i++){
+        std::replace(gCounting.m_Buffers, gCounting.m_Buffers + GL_DISPATCH_TARGETS, buffers[i], 0u);
+    }
+    Count(GL_FN_DeleteBuffers, false);
+    GL_INNER(DeleteBuffers)(n, buffers);
+}
+static void APIENTRY CountDeleteVertexArrays(GLsizei n, const GLuint *vertexArrays){
+    for(GLsizei i=0; i<n; i++){
+        if(gCounting.m_VertexArray == vertexArrays[i]){
+            gCounting.m_VertexArray = 0;
+        }
+    }
+    Count(GL_FN_DeleteVertexArrays, false);
+    GL_INNER(DeleteVertexArrays)(n, vertexArrays);
+}
+static void APIENTRY CountDeleteFramebuffers(GLsizei n, const GLuint *framebuffers){
+    for(GLsizei i=0; i<n; i++){
+        if(gCounting.m_Framebuffer == framebuffers[i]){
+            gCounting.m_Framebuffer = 0;
+        }
+    }
+    Count(GL_FN_DeleteFramebuffers, false);
+    GL_INNER(DeleteFramebuffers)(n, framebuffers);
+}
+
+static void APIENTRY CountBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage){
+    gGLDispatch.m_Stats.m_BufferBytes += data ? (uint64_t)size : 0;
+    Count(GL_FN_BufferData, false);
+    GL_INNER(BufferData)(target, size, data, usage);
+}
+static void APIENTRY CountBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data){
+    gGLDispatch.m_Stats.m_BufferBytes += (uint64_t)size;
+    Count(GL_FN_BufferSubData, false);
+    GL_INNER(BufferSubData)(target, offset, size, data);
+}
+static void APIENTRY CountBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags){
+    gGLDispatch.m_Stats.m_BufferBytes += data ? (uint64_t)size : 0;
+    Count(GL_FN_BufferStorage, false);
+    GL_INNER(BufferStorage)(target, size, data, flags);
+}
+static void APIENTRY CountUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value){
+    gGLDispatch.m_Stats.m_UniformBytes += (uint64_t)count * 16 * sizeof(GLfloat);
+    Count(GL_FN_UniformMatrix4fv, false);
+    GL_INNER(UniformMatrix4fv)(location, count, transpose, value);
+}
+static void* APIENTRY CountMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+    gGLDispatch.m_Stats.m_MappedBytes += (access & GL_MAP_WRITE_BIT) ? (uint64_t)length : 0;
+    Count(GL_FN_MapBufferRange, false);
+    return GL_INNER(MapBufferRange)(target, offset, length, access);
+}
+
+///// selection /////
+
+static void *gNullFunctions[GL_FN_COUNT];
+static void *gCountFunctions[GL_FN_COUNT];
+
+static void SetOverrides(){
+    static bool done = false;
+    if(done){
+        return;
+    }
+    done = true;
+    gNullFunctions[GL_FN_GenBuffers] = (void *)NullGen;
+    gNullFunctions[GL_FN_GenVertexArrays] = (void *)NullGen;
+    gNullFunctions[GL_FN_GenQueries] = (void *)NullGen;
+    gNullFunctions[GL_FN_GenFramebuffers] = (void *)NullGen;
+    gNullFunctions[GL_FN_GenRenderbuffers] = (void *)NullGen;
+    gNullFunctions[GL_FN_CreateProgram] = (void *)NullCreateProgram;
+    gNullFunctions[GL_FN_CreateShader] = (void *)NullCreateShader;
+    gNullFunctions[GL_FN_FenceSync] = (void *)NullFenceSync;
+    gNullFunctions[GL_FN_ClientWaitSync] = (void *)NullClientWaitSync;
+    gNullFunctions[GL_FN_CheckFramebufferStatus] = (void *)NullCheckFramebufferStatus;
+    gNullFunctions[GL_FN_BindBuffer] = (void *)NullBindBuffer;
+    gNullFunctions[GL_FN_BindBufferRange] = (void *)NullBindBufferRange;
+    gNullFunctions[GL_FN_BufferData] = (void *)NullBufferData;
+    gNullFunctions[GL_FN_BufferStorage] = (void *)NullBufferStorage;
+    gNullFunctions[GL_FN_MapBufferRange] = (void *)NullMapBufferRange;
+    gNullFunctions[GL_FN_UnmapBuffer] = (void *)NullUnmapBuffer;
+    gNullFunctions[GL_FN_DeleteBuffers] = (void *)NullDeleteBuffers;
+    gNullFunctions[GL_FN_GetProgramiv] = (void *)NullGetObjectiv;
+    gNullFunctions[GL_FN_GetShaderiv] = (void *)NullGetObjectiv;
+    gNullFunctions[GL_FN_GetProgramInfoLog] = (void *)NullInfoLog;
+    gNullFunctions[GL_FN_GetShaderInfoLog] = (void *)NullInfoLog;
+    gNullFunctions[GL_FN_GetUniformLocation] = (void *)NullGetLocation;
+    gNullFunctions[GL_FN_GetAttribLocation] = (void *)NullGetLocation;
+    gNullFunctions[GL_FN_GetIntegerv] = (void *)NullGetIntegerv;
+    gNullFunctions[GL_FN_GetInteger64v] = (void *)NullGetInteger64v;
+    gNullFunctions[GL_FN_GetString] = (void *)NullGetString;
+    gNullFunctions[GL_FN_GetStringi] = (void *)NullGetStringi;
+    gNullFunctions[GL_FN_GetQueryObjectuiv] = (void *)NullGetQueryObjectuiv;
+    gNullFunctions[GL_FN_GetQueryObjectui64v] = (void *)NullGetQueryObjectui64v;
+
+    gCountFunctions[GL_FN_UseProgram] = (void *)CountUseProgram;
+    gCountFunctions[GL_FN_BindVertexArray] = (void *)CountBindVertexArray;
+    gCountFunctions[GL_FN_BindBuffer] = (void *)CountBindBuffer;
+    gCountFunctions[GL_FN_BindBufferRange] = (void *)CountBindBufferRange;
+    gCountFunctions[GL_FN_BindFramebuffer] = (void *)CountBindFramebuffer;
+    gCountFunctions[GL_FN_BindRenderbuffer] = (void *)CountBindRenderbuffer;
+    gCountFunctions[GL_FN_Enable] = (void *)CountEnable;
+    gCountFunctions[GL_FN_Disable] = (void *)CountDisable;
+    gCountFunctions[GL_FN_Viewport] = (void *)CountViewport;
+    gCountFunctions[GL_FN_ClearColor] = (void *)CountClearColor;
+    gCountFunctions[GL_FN_BlendFunc] = (void *)CountBlendFunc;
+    gCountFunctions[GL_FN_DepthMask] = (void *)CountDepthMask;
+    gCountFunctions[GL_FN_DeleteBuffers] = (void *)CountDeleteBuffers;
+    gCountFunctions[GL_FN_DeleteVertexArrays] = (void *)CountDeleteVertexArrays;
+    gCountFunctions[GL_FN_DeleteFramebuffers] = (void *)CountDeleteFramebuffers;
+    gCountFunctions[GL_FN_BufferData] = (void *)CountBufferData;
+    gCountFunctions[GL_FN_BufferSubData] = (void *)CountBufferSubData;
+    gCountFunctions[GL_FN_BufferStorage] = (void *)CountBufferStorage;
+    gCountFunctions[GL_FN_UniformMatrix4fv] = (void *)CountUniformMatrix4fv;
+    gCountFunctions[GL_FN_MapBufferRange] = (void *)CountMapBufferRange;
+}
+
+// An entry point the driver doesn't have stays null whatever the backend,
+// code checking for it (gl_ext) sees the same thing
+static void* Select(GLDispatchFunction function, GLBackend backend, void *genericNull, void *genericCount){
+    void *null = gNullFunctions[function] ? gNullFunctions[function] : genericNull;
+    gGLDispatch.m_Inner[function] = gGLDispatch.m_HasReal ? gGLDispatch.m_Real[function] : null;
+    switch(backend){
+        case GL_BACKEND_REAL:
+            return gGLDispatch.m_Real[function];
+        case GL_BACKEND_NULL:
+            return null;
+        default:
+            if(gGLDispatch.m_Inner[function] == nullptr){
+                return nullptr;
+            }
+            return gCountFunctions[function] ? gCountFunctions[function] : genericCount;
+    }
+}
+
+void GLDispatch_CaptureReal(){
+#define GL_DISPATCH_CAPTURE(name) gGLDispatch.m_Real[GL_FN_##name] = (void *)gl##name;
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_CAPTURE)
+#undef GL_DISPATCH_CAPTURE
+    gGLDispatch.m_HasReal = true;
+    gGLDispatch.m_Backend = GL_BACKEND_REAL;
+}
+
+void GLDispatch_Use(GLBackend backend){
+    SetOverrides();
+    if(backend == GL_BACKEND_REAL && !gGLDispatch.m_HasReal){
+        fprintf(stderr, "GLDispatch: no driver entry points captured, using the null backend\n");
+        backend = GL_BACKEND_NULL;
+    }
+#define GL_DISPATCH_INSTALL(name) \
+    gl##name = (decltype(gl##name))Select(GL_FN_##name, backend, (void *)&Generic<decltype(gl##name)>::Null, \
+                                          (void *)&Generic<decltype(gl##name)>::template Count<GL_FN_##name>);
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_INSTALL)
+#undef GL_DISPATCH_INSTALL
+    gGLDispatch.m_Backend = backend;
+    ForgetState();
+    GLDispatch_ResetStats();
+}
+
+void* GLDispatch_GetProcAddress(const char *name){
+#define GL_DISPATCH_LOOKUP(function) \
+    if(strcmp(name, "gl" #function) == 0){ \
+        return (void *)gl##function; \
+    }
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_LOOKUP)
+#undef GL_DISPATCH_LOOKUP
+    return nullptr;
+}
+
+const char* GLDispatch_Name(GLDispatchFunction function){
+    return function < GL_FN_COUNT ? gNames[function] : "?";
+}
+
+const char* GLDispatch_BackendName(GLBackend backend){
+    switch(backend){
+        case GL_BACKEND_REAL: return "real";
+        case GL_BACKEND_NULL: return "null";
+        default: return gGLDispatch.m_HasReal ? "counting" : "counting (null)";
+    }
+}
+
+void GLDispatch_ResetStats(){
+    gGLDispatch.m_Stats = GLDispatchStats();
+}
+
+void GLDispatch_Totals(uint64_t *calls, uint64_t *redundant){
+    *calls = 0;
+    *redundant = 0;
+    for(uint32_t f=0; f<GL_FN_COUNT; f++){
+        *calls += gGLDispatch.m_Stats.m_Calls[f];
+        *redundant += gGLDispatch.m_Stats.m_Redundant[f];
+    }
+}
+
+void GLDispatch_PrintStats(uint64_t frames){
+    const GLDispatchStats &stats = gGLDispatch.m_Stats;
+    frames = std::max<uint64_t>(frames, 1);
+    std::vector<uint32_t> order;
+    uint64_t calls = 0, redundant = 0;
+    for(uint32_t f=0; f<GL_FN_COUNT; f++){
+        if(stats.m_Calls[f] > 0){
+            order.push_back(f);
+            calls += stats.m_Calls[f];
+            redundant += stats.m_Redundant[f];
+        }
+    }
+    std::sort(order.begin(), order.end(), [&stats](uint32_t a, uint32_t b){
+        return stats.m_Calls[a] > stats.m_Calls[b];
+    });
+    printf("GL %s backend: %.1f calls/frame (%.1f redundant state sets), uploads %.0f bytes/frame buffers, %.0f uniforms, %.0f mapped\n",
+           GLDispatch_BackendName(gGLDispatch.m_Backend), (double)calls / frames, (double)redundant / frames,
+           (double)stats.m_BufferBytes / frames, (double)stats.m_UniformBytes / frames, (double)stats.m_MappedBytes / frames);
+    for(uint32_t f : order){
+        printf("  %-34s %10.1f/frame", gNames[f], (double)stats.m_Calls[f] / frames);
+        if(stats.m_Redundant[f] > 0){
+            printf(" (%.1f redundant)", (double)stats.m_Redundant[f] / frames);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef GL_DISPATCH_HPP
+#define GL_DISPATCH_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+
+#include "gl_ext.hpp"
+
+// Swappable backend behind the GL entry points this program calls. glad and
+// gl_ext call through function pointers (glFoo is a macro for glad_glFoo or
+// glext_glFoo), GLDispatch_Use points them at:
+//  real      the driver's functions, as loaded
+//  null      no-ops that still hand out object IDs, succeed compiles and links
+//            and map buffers to host memory, so everything up to the driver runs
+//            with no GPU or context at all
+//  counting  calls per entry point, redundant state sets and bytes uploaded,
+//            forwarding to the driver if one was captured, otherwise to null
+// Call sites are unchanged. Render thread only, like the GL calls themselves.
+
+// every entry point called anywhere in the program
+#define GL_DISPATCH_FUNCTIONS(X) \
+    X(ActiveTexture) X(AttachShader) X(BindBuffer) X(BindBufferRange) X(BindFramebuffer) \
+    X(BindRenderbuffer) X(BindTexture) X(BindVertexArray) X(BlendEquation) X(BlendFunc) \
+    X(BufferData) X(BufferStorage) X(BufferSubData) X(CheckFramebufferStatus) X(Clear) \
+    X(ClearColor) X(ClientWaitSync) X(CompileShader) X(CopyBufferSubData) X(CreateProgram) \
+    X(CreateShader) X(CullFace) X(DebugMessageCallback) X(DebugMessageControl) X(DeleteBuffers) \
+    X(DeleteFramebuffers) X(DeleteProgram) X(DeleteQueries) X(DeleteRenderbuffers) \
+    X(DeleteShader) X(DeleteSync) X(DeleteTextures) X(DeleteVertexArrays) X(DepthFunc) \
+    X(DepthMask) X(DetachShader) X(Disable) X(DisableVertexAttribArray) X(DrawArrays) \
+    X(DrawElements) X(DrawElementsBaseVertex) X(DrawElementsInstanced) \
+    X(DrawElementsInstancedBaseVertex) X(Enable) X(EnableVertexAttribArray) X(FenceSync) \
+    X(Finish) X(FramebufferRenderbuffer) X(FrontFace) X(GenBuffers) X(GenFramebuffers) \
+    X(GenQueries) X(GenRenderbuffers) X(GenVertexArrays) X(GetActiveAttrib) X(GetActiveUniform) \
+    X(GetActiveUniformBlockName) X(GetActiveUniformBlockiv) X(GetAttribLocation) X(GetBooleanv) \
+    X(GetError) X(GetFloatv) X(GetInteger64i_v) X(GetInteger64v) X(GetIntegeri_v) X(GetIntegerv) \
+    X(GetProgramBinary) X(GetProgramInfoLog) X(GetProgramiv) X(GetQueryObjectui64v) \
+    X(GetQueryObjectuiv) X(GetShaderInfoLog) X(GetShaderiv) X(GetString) X(GetStringi) \
+    X(GetUniformLocation) X(IsEnabled) X(LinkProgram) X(MapBufferRange) \
+    X(MaxShaderCompilerThreadsKHR) X(MultiDrawElementsIndirect) X(PopDebugGroup) \
+    X(ProgramBinary) X(ProgramParameteri) X(PushDebugGroup) X(QueryCounter) \
+    X(RenderbufferStorage) X(ShaderSource) X(StencilFunc) X(StencilMask) X(StencilOp) \
+    X(UniformBlockBinding) X(UniformMatrix4fv) X(UnmapBuffer) X(UseProgram) X(ValidateProgram) \
+    X(VertexAttribDivisor) X(VertexAttribIPointer) X(VertexAttribPointer) X(Viewport)
+
+enum GLDispatchFunction{
+#define GL_DISPATCH_ENUM(name) GL_FN_##name,
+    GL_DISPATCH_FUNCTIONS(GL_DISPATCH_ENUM)
+#undef GL_DISPATCH_ENUM
+    GL_FN_COUNT
+};
+
+enum GLBackend{
+    GL_BACKEND_REAL,
+    GL_BACKEND_NULL,
+    GL_BACKEND_COUNTING,
+};
+
+// what the counting backend saw since the last GLDispatch_ResetStats
+struct GLDispatchStats{
+    uint64_t m_Calls[GL_FN_COUNT] = {};
+    // binds/enables/state sets to the value already set, a state cache would drop these
+    uint64_t m_Redundant[GL_FN_COUNT] = {};
+    uint64_t m_BufferBytes = 0;     // glBufferData/glBufferSubData/glBufferStorage with data
+    uint64_t m_UniformBytes = 0;    // glUniform*
+    uint64_t m_MappedBytes = 0;     // glMapBufferRange for writing
+};
+
+struct GLDispatch{
+    void *m_Real[GL_FN_COUNT] = {};     // the driver's entry points, GLDispatch_CaptureReal
+    void *m_Inner[GL_FN_COUNT] = {};    // what counting forwards to
+    bool m_HasReal = false;
+    GLBackend m_Backend = GL_BACKEND_REAL;
+    GLDispatchStats m_Stats;
+};
+
+extern GLDispatch gGLDispatch;
+
+// Remembers the entry points gladLoadGL + GLExt_Load filled in as the real backend
+void GLDispatch_CaptureReal();
+// Points every dispatched entry point at backend. Real needs GLDispatch_CaptureReal first
+void GLDispatch_Use(GLBackend backend);
+// The installed function by GL name, a loader for gladLoadGLLoader/GLExt_Load when
+// there is no driver (nullptr for anything not in GL_DISPATCH_FUNCTIONS)
+void* GLDispatch_GetProcAddress(const char *name);
+
+const char* GLDispatch_Name(GLDispatchFunction function);
+const char* GLDispatch_BackendName(GLBackend backend);
+void GLDispatch_ResetStats();
+// summed over every entry point
+void GLDispatch_Totals(uint64_t *calls, uint64_t *redundant);
+// Calls per frame of every entry point used, busiest first
+void GLDispatch_PrintStats(uint64_t frames);
+
+#endif
@@ -0,0 +1,105 @@
+#include "gl_ext.hpp"
+
+#include <SDL2/SDL.h>
+#include <cstring>
+
+GLExtensions gGLExt;
+
+PFNGLEXTMAXSHADERCOMPILERTHREADSPROC glext_glMaxShaderCompilerThreadsKHR = nullptr;
+#ifndef GL_VERSION_4_1
+PFNGLEXTGETPROGRAMBINARYPROC glext_glGetProgramBinary = nullptr;
+PFNGLEXTPROGRAMBINARYPROC glext_glProgramBinary = nullptr;
+PFNGLEXTPROGRAMPARAMETERIPROC glext_glProgramParameteri = nullptr;
+#endif
+#ifndef GL_VERSION_4_3
+PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect = nullptr;
+PFNGLEXTDEBUGMESSAGECALLBACKPROC glext_glDebugMessageCallback = nullptr;
+PFNGLEXTDEBUGMESSAGECONTROLPROC glext_glDebugMessageControl = nullptr;
+PFNGLEXTPUSHDEBUGGROUPPROC glext_glPushDebugGroup = nullptr;
+PFNGLEXTPOPDEBUGGROUPPROC glext_glPopDebugGroup = nullptr;
+#endif
+#ifndef GL_VERSION_4_4
+PFNGLEXTBUFFERSTORAGEPROC glext_glBufferStorage = nullptr;
+#endif
+
+static GLExtLoadFunction gGetProcAddress = nullptr;
+
+static void* GetProcAddress(const char *name){
+    return gGetProcAddress ? gGetProcAddress(name) : SDL_GL_GetProcAddress(name);
+}
+
+// the context's list instead of SDL's, there may be no SDL window (--headless)
+static bool ExtensionSupported(const char *extension){
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(GLint i=0; i<count; i++){
+        const char *name = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if(name && strcmp(name, extension) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool VersionAtLeast(int major, int minor){
+    return gGLExt.m_Major > major || (gGLExt.m_Major == major && gGLExt.m_Minor >= minor);
+}
+
+// core version or the ARB extension, and the entry point actually resolved
+static bool Supported(int major, int minor, const char *extension, const void *function){
+    return function != nullptr && (VersionAtLeast(major, minor) || ExtensionSupported(extension));
+}
+
+void GLExt_Load(GLExtLoadFunction getProcAddress){
+    gGetProcAddress = getProcAddress;
+    gGLExt = GLExtensions();
+    glGetIntegerv(GL_MAJOR_VERSION, &gGLExt.m_Major);
+    glGetIntegerv(GL_MINOR_VERSION, &gGLExt.m_Minor);
+
+    // either extension, same entry point under a different suffix
+    if(ExtensionSupported("GL_KHR_parallel_shader_compile")){
+        glext_glMaxShaderCompilerThreadsKHR = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)GetProcAddress("glMaxShaderCompilerThreadsKHR");
+    }else if(ExtensionSupported("GL_ARB_parallel_shader_compile")){
+        glext_glMaxShaderCompilerThreadsKHR = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)GetProcAddress("glMaxShaderCompilerThreadsARB");
+    }
+    gGLExt.m_ParallelShaderCompile = glMaxShaderCompilerThreadsKHR != nullptr;
+    if(gGLExt.m_ParallelShaderCompile){
+        // let the driver pick how many threads
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    }
+
+#ifndef GL_VERSION_4_1
+    glext_glGetProgramBinary = (PFNGLEXTGETPROGRAMBINARYPROC)GetProcAddress("glGetProgramBinary");
+    glext_glProgramBinary = (PFNGLEXTPROGRAMBINARYPROC)GetProcAddress("glProgramBinary");
+    glext_glProgramParameteri = (PFNGLEXTPROGRAMPARAMETERIPROC)GetProcAddress("glProgramParameteri");
+#endif
+    gGLExt.m_ProgramBinary = Supported(4, 1, "GL_ARB_get_program_binary", (const void *)glProgramBinary)
+                          && glGetProgramBinary != nullptr && glProgramParameteri != nullptr;
+    if(gGLExt.m_ProgramBinary){
+        // some drivers expose the entry points but no format to save in
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        gGLExt.m_ProgramBinary = formats > 0;
+    }
+
+#ifndef GL_VERSION_4_3
+    glext_glMultiDrawElementsIndirect = (PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC)GetProcAddress("glMultiDrawElementsIndirect");
+#endif
+    gGLExt.m_MultiDrawIndirect = Supported(4, 3, "GL_ARB_multi_draw_indirect", (const void *)glMultiDrawElementsIndirect)
+                              && (VersionAtLeast(4, 3) || ExtensionSupported("GL_ARB_shader_storage_buffer_object"));
+
+#ifndef GL_VERSION_4_3
+    glext_glDebugMessageCallback = (PFNGLEXTDEBUGMESSAGECALLBACKPROC)GetProcAddress("glDebugMessageCallback");
+    glext_glDebugMessageControl = (PFNGLEXTDEBUGMESSAGECONTROLPROC)GetProcAddress("glDebugMessageControl");
+    glext_glPushDebugGroup = (PFNGLEXTPUSHDEBUGGROUPPROC)GetProcAddress("glPushDebugGroup");
+    glext_glPopDebugGroup = (PFNGLEXTPOPDEBUGGROUPPROC)GetProcAddress("glPopDebugGroup");
+#endif
+    // KHR_debug in a core context has no suffix
+    gGLExt.m_Debug = Supported(4, 3, "GL_KHR_debug", (const void *)glDebugMessageCallback)
+                  && glDebugMessageControl != nullptr && glPushDebugGroup != nullptr && glPopDebugGroup != nullptr;
+
+#ifndef GL_VERSION_4_4
+    glext_glBufferStorage = (PFNGLEXTBUFFERSTORAGEPROC)GetProcAddress("glBufferStorage");
+#endif
+    gGLExt.m_BufferStorage = Supported(4, 4, "GL_ARB_buffer_storage", (const void *)glBufferStorage);
+}
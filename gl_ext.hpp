@@ -0,0 +1,117 @@
+#ifndef GL_EXT_HPP
+#define GL_EXT_HPP
+
+#include <glad/glad.h>
+
+// glad is generated for 3.3 core, entry points past that are fetched here by
+// GLExt_Load. Same naming scheme as glad (glext_glFoo behind a glFoo macro) so
+// call sites read like any other GL call. Each block is skipped if glad
+// already provides that version.
+
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLEXTGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                      GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLEXTPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLEXTPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLEXTGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+extern PFNGLEXTPROGRAMBINARYPROC glext_glProgramBinary;
+extern PFNGLEXTPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+#define glGetProgramBinary glext_glGetProgramBinary
+#define glProgramBinary glext_glProgramBinary
+#define glProgramParameteri glext_glProgramParameteri
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+typedef void (APIENTRYP PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect,
+                                                               GLsizei drawcount, GLsizei stride);
+extern PFNGLEXTMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+
+// KHR_debug, core in 4.3 under the same names
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_MAX_DEBUG_MESSAGE_LENGTH 0x9143
+#define GL_MAX_DEBUG_GROUP_STACK_DEPTH 0x826C
+typedef void (APIENTRY *GLEXTDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                        const GLchar *message, const void *userParam);
+typedef void (APIENTRYP PFNGLEXTDEBUGMESSAGECALLBACKPROC)(GLEXTDEBUGPROC callback, const void *userParam);
+typedef void (APIENTRYP PFNGLEXTDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+                                                         const GLuint *ids, GLboolean enabled);
+typedef void (APIENTRYP PFNGLEXTPUSHDEBUGGROUPPROC)(GLenum source, GLuint id, GLsizei length, const GLchar *message);
+typedef void (APIENTRYP PFNGLEXTPOPDEBUGGROUPPROC)();
+extern PFNGLEXTDEBUGMESSAGECALLBACKPROC glext_glDebugMessageCallback;
+extern PFNGLEXTDEBUGMESSAGECONTROLPROC glext_glDebugMessageControl;
+extern PFNGLEXTPUSHDEBUGGROUPPROC glext_glPushDebugGroup;
+extern PFNGLEXTPOPDEBUGGROUPPROC glext_glPopDebugGroup;
+#define glDebugMessageCallback glext_glDebugMessageCallback
+#define glDebugMessageControl glext_glDebugMessageControl
+#define glPushDebugGroup glext_glPushDebugGroup
+#define glPopDebugGroup glext_glPopDebugGroup
+#else
+typedef GLDEBUGPROC GLEXTDEBUGPROC;
+#endif
+
+#ifndef GL_VERSION_4_4
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+typedef void (APIENTRYP PFNGLEXTBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+extern PFNGLEXTBUFFERSTORAGEPROC glext_glBufferStorage;
+#define glBufferStorage glext_glBufferStorage
+#endif
+
+// KHR_parallel_shader_compile (ARB_ has the same enum and signature)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+extern PFNGLEXTMAXSHADERCOMPILERTHREADSPROC glext_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glext_glMaxShaderCompilerThreadsKHR
+
+// what the context supports, filled by GLExt_Load
+struct GLExtensions{
+    int m_Major = 0;
+    int m_Minor = 0;
+    bool m_ParallelShaderCompile = false;   // GL_COMPLETION_STATUS_KHR can be polled, compiles run on driver threads
+    bool m_ProgramBinary = false;           // 4.1 or ARB_get_program_binary, and the driver has a binary format
+    bool m_MultiDrawIndirect = false;       // 4.3 or ARB_multi_draw_indirect (+ SSBOs for the per draw data)
+    bool m_BufferStorage = false;           // 4.4 or ARB_buffer_storage, persistent mapping
+    bool m_Debug = false;                   // 4.3 or KHR_debug, message callback and debug groups
+};
+
+extern GLExtensions gGLExt;
+
+typedef void* (*GLExtLoadFunction)(const char *name);
+
+// Call once after gladLoadGL with the context current. getProcAddress resolves
+// the entry points, SDL_GL_GetProcAddress if null
+void GLExt_Load(GLExtLoadFunction getProcAddress = nullptr);
+
+#endif
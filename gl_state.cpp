@@ -0,0 +1,552 @@
+#include "gl_state.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef GL_SHADER_STORAGE_BUFFER_BINDING
+#define GL_SHADER_STORAGE_BUFFER_BINDING 0x90D3
+#define GL_SHADER_STORAGE_BUFFER_START 0x90D4
+#define GL_SHADER_STORAGE_BUFFER_SIZE 0x90D5
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER_BINDING
+#define GL_DRAW_INDIRECT_BUFFER_BINDING 0x8F43
+#endif
+// 4.2 names, the same values as the targets
+#ifndef GL_COPY_READ_BUFFER_BINDING
+#define GL_COPY_READ_BUFFER_BINDING GL_COPY_READ_BUFFER
+#define GL_COPY_WRITE_BUFFER_BINDING GL_COPY_WRITE_BUFFER
+#endif
+
+// printed, later ones are only counted
+#define GL_STATE_MISMATCH_REPORTS 20
+
+GLStateCache gGLState;
+
+static uint32_t gMismatchesReported = 0;
+
+static const GLenum gBufferTargets[GL_STATE_BUFFER_TARGETS] = {
+    GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_COPY_READ_BUFFER,
+    GL_COPY_WRITE_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_SHADER_STORAGE_BUFFER,
+};
+static const GLenum gBufferBindings[GL_STATE_BUFFER_TARGETS] = {
+    GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING, GL_COPY_READ_BUFFER_BINDING,
+    GL_COPY_WRITE_BUFFER_BINDING, GL_DRAW_INDIRECT_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_BINDING,
+};
+static const GLenum gCaps[GL_STATE_CAPS] = {
+    GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_POLYGON_OFFSET_FILL,
+};
+
+static uint32_t BufferTarget(GLenum target){
+    for(uint32_t t=0; t<GL_STATE_BUFFER_TARGETS; t++){
+        if(gBufferTargets[t] == target){
+            return t;
+        }
+    }
+    return GL_STATE_BUFFER_TARGETS;
+}
+
+static uint32_t Cap(GLenum cap){
+    for(uint32_t c=0; c<GL_STATE_CAPS; c++){
+        if(gCaps[c] == cap){
+            return c;
+        }
+    }
+    return GL_STATE_CAPS;
+}
+
+static GLenum TextureBinding(GLenum target){
+    switch(target){
+        case GL_TEXTURE_2D: return GL_TEXTURE_BINDING_2D;
+        case GL_TEXTURE_3D: return GL_TEXTURE_BINDING_3D;
+        case GL_TEXTURE_CUBE_MAP: return GL_TEXTURE_BINDING_CUBE_MAP;
+        case GL_TEXTURE_2D_ARRAY: return GL_TEXTURE_BINDING_2D_ARRAY;
+        default: return 0;
+    }
+}
+
+///// verification /////
+
+static bool Mismatch(const char *name, long long shadow, long long actual){
+    gGLState.m_Frame.m_Mismatches++;
+    if(gMismatchesReported < GL_STATE_MISMATCH_REPORTS){
+        gMismatchesReported++;
+        fprintf(stderr, "GL state cache: %s is %lld, the shadow says %lld%s\n", name, actual, shadow,
+                gMismatchesReported == GL_STATE_MISMATCH_REPORTS ? " (further mismatches only counted)" : "");
+    }
+    return false;
+}
+
+static bool MatchesInteger(const char *name, GLenum pname, GLint shadow){
+    GLint actual = 0;
+    glGetIntegerv(pname, &actual);
+    return actual == shadow || Mismatch(name, shadow, actual);
+}
+
+static bool MatchesIndexed(const char *name, GLenum binding, GLenum start, GLenum size, GLuint index, const GLStateRange &range){
+    GLint buffer = 0;
+    GLint64 offset = 0, bytes = 0;
+    glGetIntegeri_v(binding, index, &buffer);
+    glGetInteger64i_v(start, index, &offset);
+    glGetInteger64i_v(size, index, &bytes);
+    return ((GLuint)buffer == range.m_Buffer || Mismatch(name, range.m_Buffer, buffer))
+        && (offset == range.m_Offset || Mismatch(name, range.m_Offset, offset))
+        && (bytes == range.m_Size || Mismatch(name, range.m_Size, bytes));
+}
+
+static bool MatchesCap(uint32_t cap){
+    GLint actual = glIsEnabled(gCaps[cap]) ? 1 : 0;
+    return actual == gGLState.m_Caps[cap] || Mismatch("enable", gGLState.m_Caps[cap], actual);
+}
+
+static bool MatchesDepthMask(){
+    GLboolean actual = GL_FALSE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &actual);
+    return actual == gGLState.m_DepthMask || Mismatch("depth mask", gGLState.m_DepthMask, actual);
+}
+
+static bool MatchesViewport(){
+    GLint actual[4] = {};
+    glGetIntegerv(GL_VIEWPORT, actual);
+    return memcmp(actual, gGLState.m_Viewport, sizeof(actual)) == 0
+        || Mismatch("viewport width", gGLState.m_Viewport[2], actual[2]);
+}
+
+static bool MatchesClearColor(){
+    GLfloat actual[4] = {};
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, actual);
+    return memcmp(actual, gGLState.m_ClearColor, sizeof(actual)) == 0
+        || Mismatch("clear color (x1000)", (long long)(gGLState.m_ClearColor[0] * 1000), (long long)(actual[0] * 1000));
+}
+
+static bool MatchesTexture(GLuint unit){
+    GLenum binding = TextureBinding(gGLState.m_TextureTargets[unit]);
+    return binding == 0 || MatchesInteger("texture", binding, (GLint)gGLState.m_Textures[unit]);
+}
+
+// true when the call can be skipped: the value is already set and, with
+// --verify-gl-state, the driver agrees. Counts the call either way
+template<typename Check>
+static bool Skip(bool same, Check check){
+    if(same && gGLState.m_Enabled && (!gGLState.m_Verify || check())){
+        gGLState.m_Frame.m_Filtered++;
+        return true;
+    }
+    gGLState.m_Frame.m_Issued++;
+    return false;
+}
+
+///// state /////
+
+void GLState_Invalidate(){
+    GLStateCache &state = gGLState;
+    state.m_Program = GL_STATE_UNKNOWN;
+    state.m_VertexArray = GL_STATE_UNKNOWN;
+    state.m_Framebuffer = GL_STATE_UNKNOWN;
+    for(GLuint &buffer : state.m_Buffers){
+        buffer = GL_STATE_UNKNOWN;
+    }
+    for(uint32_t i=0; i<GL_STATE_INDEXED_BINDINGS; i++){
+        state.m_UniformRanges[i] = GLStateRange();
+        state.m_StorageRanges[i] = GLStateRange();
+    }
+    state.m_ActiveTexture = GL_STATE_UNKNOWN;
+    for(uint32_t unit=0; unit<GL_STATE_TEXTURE_UNITS; unit++){
+        state.m_TextureTargets[unit] = GL_STATE_UNKNOWN;
+        state.m_Textures[unit] = GL_STATE_UNKNOWN;
+    }
+    memset(state.m_Caps, GL_STATE_CAP_UNKNOWN, sizeof(state.m_Caps));
+    state.m_BlendSource = GL_STATE_UNKNOWN;
+    state.m_BlendDestination = GL_STATE_UNKNOWN;
+    state.m_BlendEquation = GL_STATE_UNKNOWN;
+    state.m_DepthFunc = GL_STATE_UNKNOWN;
+    state.m_DepthMask = GL_STATE_UNKNOWN;
+    state.m_StencilFunc = GL_STATE_UNKNOWN;
+    state.m_StencilFail = GL_STATE_UNKNOWN;
+    state.m_StencilWriteMask = GL_STATE_UNKNOWN;
+    state.m_CullFace = GL_STATE_UNKNOWN;
+    state.m_FrontFace = GL_STATE_UNKNOWN;
+    state.m_ViewportKnown = false;
+    state.m_ClearColorKnown = false;
+}
+
+void GLState_UseProgram(GLuint program){
+    if(Skip(gGLState.m_Program == program, [&]{ return MatchesInteger("program", GL_CURRENT_PROGRAM, (GLint)program); })){
+        return;
+    }
+    gGLState.m_Program = program;
+    glUseProgram(program);
+}
+
+void GLState_BindVertexArray(GLuint vertexArray){
+    if(Skip(gGLState.m_VertexArray == vertexArray,
+            [&]{ return MatchesInteger("vertex array", GL_VERTEX_ARRAY_BINDING, (GLint)vertexArray); })){
+        return;
+    }
+    gGLState.m_VertexArray = vertexArray;
+    // the element array binding belongs to the vertex array
+    gGLState.m_Buffers[GL_STATE_ELEMENT_ARRAY_BUFFER] = GL_STATE_UNKNOWN;
+    glBindVertexArray(vertexArray);
+}
+
+void GLState_BindBuffer(GLenum target, GLuint buffer){
+    uint32_t t = BufferTarget(target);
+    if(t == GL_STATE_BUFFER_TARGETS){
+        gGLState.m_Frame.m_Issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if(Skip(gGLState.m_Buffers[t] == buffer, [&]{ return MatchesInteger("buffer", gBufferBindings[t], (GLint)buffer); })){
+        return;
+    }
+    gGLState.m_Buffers[t] = buffer;
+    glBindBuffer(target, buffer);
+}
+
+void GLState_BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+    GLStateRange *range = nullptr;
+    if(index < GL_STATE_INDEXED_BINDINGS && target == GL_UNIFORM_BUFFER){
+        range = &gGLState.m_UniformRanges[index];
+    }else if(index < GL_STATE_INDEXED_BINDINGS && target == GL_SHADER_STORAGE_BUFFER){
+        range = &gGLState.m_StorageRanges[index];
+    }
+    bool same = range && range->m_Buffer == buffer && range->m_Offset == offset && range->m_Size == size;
+    if(Skip(same, [&]{
+        return target == GL_UNIFORM_BUFFER
+            ? MatchesIndexed("uniform buffer range", GL_UNIFORM_BUFFER_BINDING, GL_UNIFORM_BUFFER_START, GL_UNIFORM_BUFFER_SIZE, index, *range)
+            : MatchesIndexed("storage buffer range", GL_SHADER_STORAGE_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_START,
+                             GL_SHADER_STORAGE_BUFFER_SIZE, index, *range);
+    })){
+        return;
+    }
+    if(range){
+        range->m_Buffer = buffer;
+        range->m_Offset = offset;
+        range->m_Size = size;
+    }
+    // also binds the generic binding point
+    uint32_t t = BufferTarget(target);
+    if(t < GL_STATE_BUFFER_TARGETS){
+        gGLState.m_Buffers[t] = buffer;
+    }
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLState_BindFramebuffer(GLuint framebuffer){
+    if(Skip(gGLState.m_Framebuffer == framebuffer,
+            [&]{ return MatchesInteger("framebuffer", GL_FRAMEBUFFER_BINDING, (GLint)framebuffer); })){
+        return;
+    }
+    gGLState.m_Framebuffer = framebuffer;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState_BindTexture(GLuint unit, GLenum target, GLuint texture){
+    if(unit >= GL_STATE_TEXTURE_UNITS){
+        gGLState.m_ActiveTexture = GL_STATE_UNKNOWN;
+        gGLState.m_Frame.m_Issued += 2;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        return;
+    }
+    if(!Skip(gGLState.m_ActiveTexture == unit,
+             [&]{ return MatchesInteger("active texture", GL_ACTIVE_TEXTURE, (GLint)(GL_TEXTURE0 + unit)); })){
+        gGLState.m_ActiveTexture = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    // only the last target bound on a unit is known, binding another doesn't unbind it
+    bool same = gGLState.m_TextureTargets[unit] == target && gGLState.m_Textures[unit] == texture;
+    if(Skip(same, [&]{ return MatchesTexture(unit); })){
+        return;
+    }
+    gGLState.m_TextureTargets[unit] = target;
+    gGLState.m_Textures[unit] = texture;
+    glBindTexture(target, texture);
+}
+
+static void SetCap(GLenum cap, uint8_t enabled){
+    uint32_t c = Cap(cap);
+    if(c == GL_STATE_CAPS){
+        gGLState.m_Frame.m_Issued++;
+    }else if(Skip(gGLState.m_Caps[c] == enabled, [&]{ return MatchesCap(c); })){
+        return;
+    }else{
+        gGLState.m_Caps[c] = enabled;
+    }
+    if(enabled){
+        glEnable(cap);
+    }else{
+        glDisable(cap);
+    }
+}
+
+void GLState_Enable(GLenum cap){
+    SetCap(cap, 1);
+}
+
+void GLState_Disable(GLenum cap){
+    SetCap(cap, 0);
+}
+
+void GLState_BlendFunc(GLenum source, GLenum destination){
+    bool same = gGLState.m_BlendSource == source && gGLState.m_BlendDestination == destination;
+    if(Skip(same, [&]{
+        return MatchesInteger("blend source", GL_BLEND_SRC_RGB, (GLint)source)
+            && MatchesInteger("blend destination", GL_BLEND_DST_RGB, (GLint)destination);
+    })){
+        return;
+    }
+    gGLState.m_BlendSource = source;
+    gGLState.m_BlendDestination = destination;
+    glBlendFunc(source, destination);
+}
+
+void GLState_BlendEquation(GLenum mode){
+    if(Skip(gGLState.m_BlendEquation == mode,
+            [&]{ return MatchesInteger("blend equation", GL_BLEND_EQUATION_RGB, (GLint)mode); })){
+        return;
+    }
+    gGLState.m_BlendEquation = mode;
+    glBlendEquation(mode);
+}
+
+void GLState_DepthFunc(GLenum func){
+    if(Skip(gGLState.m_DepthFunc == func, [&]{ return MatchesInteger("depth func", GL_DEPTH_FUNC, (GLint)func); })){
+        return;
+    }
+    gGLState.m_DepthFunc = func;
+    glDepthFunc(func);
+}
+
+void GLState_DepthMask(GLboolean flag){
+    if(Skip(gGLState.m_DepthMask == flag, MatchesDepthMask)){
+        return;
+    }
+    gGLState.m_DepthMask = flag;
+    glDepthMask(flag);
+}
+
+void GLState_StencilFunc(GLenum func, GLint reference, GLuint mask){
+    bool same = gGLState.m_StencilFunc == func && gGLState.m_StencilReference == reference
+             && gGLState.m_StencilValueMask == mask;
+    if(Skip(same, [&]{
+        // the reference reads back clamped to the stencil buffer's range, not checked
+        return MatchesInteger("stencil func", GL_STENCIL_FUNC, (GLint)func)
+            && MatchesInteger("stencil value mask", GL_STENCIL_VALUE_MASK, (GLint)mask);
+    })){
+        return;
+    }
+    gGLState.m_StencilFunc = func;
+    gGLState.m_StencilReference = reference;
+    gGLState.m_StencilValueMask = mask;
+    glStencilFunc(func, reference, mask);
+}
+
+void GLState_StencilOp(GLenum fail, GLenum depthFail, GLenum pass){
+    bool same = gGLState.m_StencilFail == fail && gGLState.m_StencilDepthFail == depthFail && gGLState.m_StencilPass == pass;
+    if(Skip(same, [&]{
+        return MatchesInteger("stencil fail", GL_STENCIL_FAIL, (GLint)fail)
+            && MatchesInteger("stencil depth fail", GL_STENCIL_PASS_DEPTH_FAIL, (GLint)depthFail)
+            && MatchesInteger("stencil pass", GL_STENCIL_PASS_DEPTH_PASS, (GLint)pass);
+    })){
+        return;
+    }
+    gGLState.m_StencilFail = fail;
+    gGLState.m_StencilDepthFail = depthFail;
+    gGLState.m_StencilPass = pass;
+    glStencilOp(fail, depthFail, pass);
+}
+
+void GLState_StencilMask(GLuint mask){
+    if(Skip(gGLState.m_StencilWriteMask == mask,
+            [&]{ return MatchesInteger("stencil write mask", GL_STENCIL_WRITEMASK, (GLint)mask); })){
+        return;
+    }
+    gGLState.m_StencilWriteMask = mask;
+    glStencilMask(mask);
+}
+
+void GLState_CullFace(GLenum mode){
+    if(Skip(gGLState.m_CullFace == mode, [&]{ return MatchesInteger("cull face", GL_CULL_FACE_MODE, (GLint)mode); })){
+        return;
+    }
+    gGLState.m_CullFace = mode;
+    glCullFace(mode);
+}
+
+void GLState_FrontFace(GLenum mode){
+    if(Skip(gGLState.m_FrontFace == mode, [&]{ return MatchesInteger("front face", GL_FRONT_FACE, (GLint)mode); })){
+        return;
+    }
+    gGLState.m_FrontFace = mode;
+    glFrontFace(mode);
+}
+
+void GLState_Viewport(GLint x, GLint y, GLsizei width, GLsizei height){
+    GLint viewport[4] = {x, y, width, height};
+    bool same = gGLState.m_ViewportKnown && memcmp(viewport, gGLState.m_Viewport, sizeof(viewport)) == 0;
+    if(Skip(same, MatchesViewport)){
+        return;
+    }
+    memcpy(gGLState.m_Viewport, viewport, sizeof(viewport));
+    gGLState.m_ViewportKnown = true;
+    glViewport(x, y, width, height);
+}
+
+void GLState_ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha){
+    GLfloat color[4] = {red, green, blue, alpha};
+    bool same = gGLState.m_ClearColorKnown && memcmp(color, gGLState.m_ClearColor, sizeof(color)) == 0;
+    if(Skip(same, MatchesClearColor)){
+        return;
+    }
+    memcpy(gGLState.m_ClearColor, color, sizeof(color));
+    gGLState.m_ClearColorKnown = true;
+    glClearColor(red, green, blue, alpha);
+}
+
+///// deletion /////
+
+void GLState_DeleteBuffers(GLsizei count, const GLuint *buffers){
+    for(GLsizei i=0; i<count; i++){
+        for(GLuint &bound : gGLState.m_Buffers){
+            bound = bound == buffers[i] ? 0 : bound;
+        }
+        for(uint32_t b=0; b<GL_STATE_INDEXED_BINDINGS; b++){
+            if(gGLState.m_UniformRanges[b].m_Buffer == buffers[i]){
+                gGLState.m_UniformRanges[b] = GLStateRange();
+            }
+            if(gGLState.m_StorageRanges[b].m_Buffer == buffers[i]){
+                gGLState.m_StorageRanges[b] = GLStateRange();
+            }
+        }
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GLState_DeleteVertexArrays(GLsizei count, const GLuint *vertexArrays){
+    for(GLsizei i=0; i<count; i++){
+        if(gGLState.m_VertexArray == vertexArrays[i]){
+            gGLState.m_VertexArray = 0;
+            gGLState.m_Buffers[GL_STATE_ELEMENT_ARRAY_BUFFER] = GL_STATE_UNKNOWN;
+        }
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLState_DeleteFramebuffers(GLsizei count, const GLuint *framebuffers){
+    for(GLsizei i=0; i<count; i++){
+        if(gGLState.m_Framebuffer == framebuffers[i]){
+            gGLState.m_Framebuffer = 0;
+        }
+    }
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLState_DeleteTextures(GLsizei count, const GLuint *textures){
+    for(GLsizei i=0; i<count; i++){
+        for(GLuint &bound : gGLState.m_Textures){
+            bound = bound == textures[i] ? 0 : bound;
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+///// verify /////
+
+uint32_t GLState_Verify(){
+    const GLStateCache &state = gGLState;
+    uint32_t before = state.m_Frame.m_Mismatches;
+    if(state.m_Program != GL_STATE_UNKNOWN){
+        MatchesInteger("program", GL_CURRENT_PROGRAM, (GLint)state.m_Program);
+    }
+    if(state.m_VertexArray != GL_STATE_UNKNOWN){
+        MatchesInteger("vertex array", GL_VERTEX_ARRAY_BINDING, (GLint)state.m_VertexArray);
+    }
+    if(state.m_Framebuffer != GL_STATE_UNKNOWN){
+        MatchesInteger("framebuffer", GL_FRAMEBUFFER_BINDING, (GLint)state.m_Framebuffer);
+    }
+    for(uint32_t t=0; t<GL_STATE_BUFFER_TARGETS; t++){
+        if(state.m_Buffers[t] != GL_STATE_UNKNOWN){
+            MatchesInteger("buffer", gBufferBindings[t], (GLint)state.m_Buffers[t]);
+        }
+    }
+    for(GLuint b=0; b<GL_STATE_INDEXED_BINDINGS; b++){
+        if(state.m_UniformRanges[b].m_Buffer != GL_STATE_UNKNOWN){
+            MatchesIndexed("uniform buffer range", GL_UNIFORM_BUFFER_BINDING, GL_UNIFORM_BUFFER_START,
+                           GL_UNIFORM_BUFFER_SIZE, b, state.m_UniformRanges[b]);
+        }
+        if(state.m_StorageRanges[b].m_Buffer != GL_STATE_UNKNOWN){
+            MatchesIndexed("storage buffer range", GL_SHADER_STORAGE_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_START,
+                           GL_SHADER_STORAGE_BUFFER_SIZE, b, state.m_StorageRanges[b]);
+        }
+    }
+    // each unit's binding is read with it active, the active unit is put back after
+    GLint active = GL_TEXTURE0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+    if(state.m_ActiveTexture != GL_STATE_UNKNOWN && (GLuint)active != GL_TEXTURE0 + state.m_ActiveTexture){
+        Mismatch("active texture", GL_TEXTURE0 + state.m_ActiveTexture, active);
+    }
+    for(GLuint unit=0; unit<GL_STATE_TEXTURE_UNITS; unit++){
+        if(state.m_Textures[unit] != GL_STATE_UNKNOWN && TextureBinding(state.m_TextureTargets[unit]) != 0){
+            glActiveTexture(GL_TEXTURE0 + unit);
+            MatchesTexture(unit);
+        }
+    }
+    glActiveTexture((GLenum)active);
+    for(uint32_t c=0; c<GL_STATE_CAPS; c++){
+        if(state.m_Caps[c] != GL_STATE_CAP_UNKNOWN){
+            MatchesCap(c);
+        }
+    }
+    if(state.m_BlendSource != GL_STATE_UNKNOWN){
+        MatchesInteger("blend source", GL_BLEND_SRC_RGB, (GLint)state.m_BlendSource);
+        MatchesInteger("blend destination", GL_BLEND_DST_RGB, (GLint)state.m_BlendDestination);
+    }
+    if(state.m_BlendEquation != GL_STATE_UNKNOWN){
+        MatchesInteger("blend equation", GL_BLEND_EQUATION_RGB, (GLint)state.m_BlendEquation);
+    }
+    if(state.m_DepthFunc != GL_STATE_UNKNOWN){
+        MatchesInteger("depth func", GL_DEPTH_FUNC, (GLint)state.m_DepthFunc);
+    }
+    if(state.m_DepthMask != GL_STATE_UNKNOWN){
+        MatchesDepthMask();
+    }
+    if(state.m_StencilFunc != GL_STATE_UNKNOWN){
+        MatchesInteger("stencil func", GL_STENCIL_FUNC, (GLint)state.m_StencilFunc);
+        MatchesInteger("stencil value mask", GL_STENCIL_VALUE_MASK, (GLint)state.m_StencilValueMask);
+    }
+    if(state.m_StencilFail != GL_STATE_UNKNOWN){
+        MatchesInteger("stencil fail", GL_STENCIL_FAIL, (GLint)state.m_StencilFail);
+        MatchesInteger("stencil depth fail", GL_STENCIL_PASS_DEPTH_FAIL, (GLint)state.m_StencilDepthFail);
+        MatchesInteger("stencil pass", GL_STENCIL_PASS_DEPTH_PASS, (GLint)state.m_StencilPass);
+    }
+    if(state.m_StencilWriteMask != GL_STATE_UNKNOWN){
+        MatchesInteger("stencil write mask", GL_STENCIL_WRITEMASK, (GLint)state.m_StencilWriteMask);
+    }
+    if(state.m_CullFace != GL_STATE_UNKNOWN){
+        MatchesInteger("cull face", GL_CULL_FACE_MODE, (GLint)state.m_CullFace);
+    }
+    if(state.m_FrontFace != GL_STATE_UNKNOWN){
+        MatchesInteger("front face", GL_FRONT_FACE, (GLint)state.m_FrontFace);
+    }
+    if(state.m_ViewportKnown){
+        MatchesViewport();
+    }
+    if(state.m_ClearColorKnown){
+        MatchesClearColor();
+    }
+
+    uint32_t found = state.m_Frame.m_Mismatches - before;
+    if(found > 0){
+        // whatever went behind the cache's back, the next calls set it again
+        GLState_Invalidate();
+    }
+    return found;
+}
+
+void GLState_EndFrame(){
+    if(gGLState.m_Verify){
+        GLState_Verify();
+    }
+    gGLState.m_LastFrame = gGLState.m_Frame;
+    gGLState.m_Frame = GLStateStats();
+}
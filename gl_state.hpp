@@ -0,0 +1,135 @@
+#ifndef GL_STATE_HPP
+#define GL_STATE_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+
+#include "gl_ext.hpp"
+
+// Shadow of the GL state this program sets. Binds, enables and fixed function
+// state go through GLState_* instead of the gl call, which is only issued when
+// the value differs from what is already set. Objects bound here must be deleted
+// here too (a deleted name is unbound and can be handed out again). Anything
+// that changes state behind the cache's back has to GLState_Invalidate.
+// Render thread only.
+
+#define GL_STATE_UNKNOWN 0xFFFFFFFFu
+#define GL_STATE_TEXTURE_UNITS 16
+#define GL_STATE_INDEXED_BINDINGS 8         // per indexed target, higher binding points aren't filtered
+
+enum GLStateBufferTarget{
+    GL_STATE_ARRAY_BUFFER,
+    GL_STATE_ELEMENT_ARRAY_BUFFER,          // part of the bound vertex array
+    GL_STATE_UNIFORM_BUFFER,
+    GL_STATE_COPY_READ_BUFFER,
+    GL_STATE_COPY_WRITE_BUFFER,
+    GL_STATE_DRAW_INDIRECT_BUFFER,
+    GL_STATE_SHADER_STORAGE_BUFFER,
+    GL_STATE_BUFFER_TARGETS,
+};
+
+// glEnable/glDisable caps, others are always issued
+enum GLStateCap{
+    GL_STATE_BLEND,
+    GL_STATE_DEPTH_TEST,
+    GL_STATE_CULL_FACE,
+    GL_STATE_STENCIL_TEST,
+    GL_STATE_SCISSOR_TEST,
+    GL_STATE_POLYGON_OFFSET_FILL,
+    GL_STATE_CAPS,
+};
+
+struct GLStateRange{
+    GLuint m_Buffer = GL_STATE_UNKNOWN;
+    GLintptr m_Offset = 0;
+    GLsizeiptr m_Size = 0;
+};
+
+// calls made through the cache in one frame
+struct GLStateStats{
+    uint32_t m_Issued = 0;
+    uint32_t m_Filtered = 0;
+    uint32_t m_Mismatches = 0;              // --verify-gl-state: shadow and driver disagreed
+};
+
+struct GLStateCache{
+    bool m_Enabled = true;                  // false (--no-state-cache): every call is issued
+    bool m_Verify = false;                  // --verify-gl-state: checks the shadow with glGet* on every filtered call and each frame
+
+    GLuint m_Program;
+    GLuint m_VertexArray;
+    GLuint m_Framebuffer;
+    GLuint m_Buffers[GL_STATE_BUFFER_TARGETS];
+    GLStateRange m_UniformRanges[GL_STATE_INDEXED_BINDINGS];
+    GLStateRange m_StorageRanges[GL_STATE_INDEXED_BINDINGS];
+    GLuint m_ActiveTexture;                 // unit index, not GL_TEXTURE0 + unit
+    GLenum m_TextureTargets[GL_STATE_TEXTURE_UNITS];
+    GLuint m_Textures[GL_STATE_TEXTURE_UNITS];
+    uint8_t m_Caps[GL_STATE_CAPS];          // 0, 1 or GL_STATE_CAP_UNKNOWN
+
+    // blend, depth, stencil (both faces) and raster state
+    GLenum m_BlendSource;
+    GLenum m_BlendDestination;
+    GLenum m_BlendEquation;
+    GLenum m_DepthFunc;
+    GLuint m_DepthMask;
+    GLenum m_StencilFunc;
+    GLint m_StencilReference;
+    GLuint m_StencilValueMask;
+    GLenum m_StencilFail;
+    GLenum m_StencilDepthFail;
+    GLenum m_StencilPass;
+    GLuint m_StencilWriteMask;
+    GLenum m_CullFace;
+    GLenum m_FrontFace;
+    bool m_ViewportKnown;
+    GLint m_Viewport[4];
+    bool m_ClearColorKnown;
+    GLfloat m_ClearColor[4];
+
+    GLStateStats m_Frame;                   // so far this frame
+    GLStateStats m_LastFrame;               // of the last GLState_EndFrame
+};
+
+#define GL_STATE_CAP_UNKNOWN 2
+
+extern GLStateCache gGLState;
+
+// Forgets everything, the next call of each kind is issued. Call once the context
+// is current and after any code that sets state directly
+void GLState_Invalidate();
+
+void GLState_UseProgram(GLuint program);
+void GLState_BindVertexArray(GLuint vertexArray);
+void GLState_BindBuffer(GLenum target, GLuint buffer);
+void GLState_BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+void GLState_BindFramebuffer(GLuint framebuffer);   // GL_FRAMEBUFFER, draw and read
+void GLState_BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+void GLState_Enable(GLenum cap);
+void GLState_Disable(GLenum cap);
+void GLState_BlendFunc(GLenum source, GLenum destination);
+void GLState_BlendEquation(GLenum mode);
+void GLState_DepthFunc(GLenum func);
+void GLState_DepthMask(GLboolean flag);
+void GLState_StencilFunc(GLenum func, GLint reference, GLuint mask);
+void GLState_StencilOp(GLenum fail, GLenum depthFail, GLenum pass);
+void GLState_StencilMask(GLuint mask);
+void GLState_CullFace(GLenum mode);
+void GLState_FrontFace(GLenum mode);
+void GLState_Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void GLState_ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+// glDelete* that also unbind the names from the shadow
+void GLState_DeleteBuffers(GLsizei count, const GLuint *buffers);
+void GLState_DeleteVertexArrays(GLsizei count, const GLuint *vertexArrays);
+void GLState_DeleteFramebuffers(GLsizei count, const GLuint *framebuffers);
+void GLState_DeleteTextures(GLsizei count, const GLuint *textures);
+
+// Every shadowed value against glGet*, mismatches are printed, counted and the
+// shadow reset. Returns the number found
+uint32_t GLState_Verify();
+// Frame boundary: verifies with --verify-gl-state, moves m_Frame to m_LastFrame
+void GLState_EndFrame();
+
+#endif
@@ -0,0 +1,95 @@
+#include "gpu_profiler.hpp"
+
+GpuProfiler gGpuProfiler;
+
+static void Calibrate(){
+    GLint64 gpu = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu);
+    gGpuProfiler.m_GpuToCpuNs = (int64_t)Profiler_NowNs() - (int64_t)gpu;
+}
+
+void GpuProfiler_Create(){
+    if(gGpuProfiler.m_Created || !gProfiler.m_Enabled.load()){
+        return;
+    }
+    for(GpuProfilerFrame &frame : gGpuProfiler.m_Frames){
+        glGenQueries(GPU_PROFILER_MAX_SCOPES * 2, frame.m_Queries);
+        frame.m_Count = 0;
+        frame.m_Last = 0;
+        frame.m_Pending = false;
+    }
+    Calibrate();
+    gGpuProfiler.m_Created = true;
+}
+
+void GpuProfiler_Delete(){
+    if(!gGpuProfiler.m_Created){
+        return;
+    }
+    for(GpuProfilerFrame &frame : gGpuProfiler.m_Frames){
+        glDeleteQueries(GPU_PROFILER_MAX_SCOPES * 2, frame.m_Queries);
+    }
+    gGpuProfiler.m_Created = false;
+}
+
+uint32_t GpuProfiler_Begin(const char *name){
+    GpuProfilerFrame &frame = gGpuProfiler.m_Frames[gGpuProfiler.m_Frame];
+    if(frame.m_Count == GPU_PROFILER_MAX_SCOPES){
+        return GPU_PROFILER_NO_SCOPE;
+    }
+    uint32_t scope = frame.m_Count++;
+    frame.m_Names[scope] = name;
+    glQueryCounter(frame.m_Queries[scope * 2], GL_TIMESTAMP);
+    frame.m_Last = scope * 2;
+    return scope;
+}
+
+void GpuProfiler_End(uint32_t scope){
+    GpuProfilerFrame &frame = gGpuProfiler.m_Frames[gGpuProfiler.m_Frame];
+    glQueryCounter(frame.m_Queries[scope * 2 + 1], GL_TIMESTAMP);
+    frame.m_Last = scope * 2 + 1;
+}
+
+// false if the GPU hasn't got that far yet
+static bool Resolve(GpuProfilerFrame *frame){
+    if(frame->m_Count == 0){
+        return true;
+    }
+    // queries complete in order, the last one issued being there means all are (with
+    // nested scopes that's an enclosing scope's end, not the last scope's)
+    GLuint available = 0;
+    glGetQueryObjectuiv(frame->m_Queries[frame->m_Last], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available){
+        return false;
+    }
+    for(uint32_t s=0; s<frame->m_Count; s++){
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frame->m_Queries[s * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame->m_Queries[s * 2 + 1], GL_QUERY_RESULT, &end);
+        Profiler_RecordGpu(frame->m_Names[s], (uint64_t)((int64_t)begin + gGpuProfiler.m_GpuToCpuNs),
+                           (uint64_t)((int64_t)end + gGpuProfiler.m_GpuToCpuNs));
+    }
+    return true;
+}
+
+void GpuProfiler_EndFrame(){
+    if(!gGpuProfiler.m_Created){
+        return;
+    }
+    gGpuProfiler.m_Frames[gGpuProfiler.m_Frame].m_Pending = true;
+    gGpuProfiler.m_Frame = (gGpuProfiler.m_Frame + 1) % GPU_PROFILER_FRAMES;
+    gGpuProfiler.m_FrameCount++;
+
+    // the slot about to be reused holds the oldest frame in flight
+    GpuProfilerFrame &frame = gGpuProfiler.m_Frames[gGpuProfiler.m_Frame];
+    if(frame.m_Pending && !Resolve(&frame)){
+        gGpuProfiler.m_Skipped++;
+    }
+    frame.m_Count = 0;
+    frame.m_Last = 0;
+    frame.m_Pending = false;
+
+    if(gGpuProfiler.m_FrameCount % GPU_PROFILER_CALIBRATE_FRAMES == 0){
+        Calibrate();
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+
+#include "gl_debug.hpp"
+#include "profiler.hpp"
+
+// GPU side of the profiler: a GL_TIMESTAMP query at both ends of a scope
+// (timestamps rather than GL_TIME_ELAPSED, those can't nest). Results are read
+// back GPU_PROFILER_FRAMES frames later, when the GPU is long done with them, so
+// the CPU never waits on a query; a frame whose results still aren't there is
+// skipped. Resolved scopes go to Profiler_RecordGpu. Render thread only.
+
+#define GPU_PROFILER_FRAMES 4
+#define GPU_PROFILER_MAX_SCOPES 64          // per frame, later ones are not timed
+// GPU and CPU clocks drift apart slowly, the offset between them is re-read this often
+#define GPU_PROFILER_CALIBRATE_FRAMES 256
+
+#define GPU_PROFILER_NO_SCOPE 0xFFFFFFFFu
+
+struct GpuProfilerFrame{
+    GLuint m_Queries[GPU_PROFILER_MAX_SCOPES * 2];  // begin, end
+    const char *m_Names[GPU_PROFILER_MAX_SCOPES];
+    uint32_t m_Count = 0;
+    uint32_t m_Last = 0;                    // m_Queries index of the last stamp issued (an enclosing end when nested)
+    bool m_Pending = false;
+};
+
+struct GpuProfiler{
+    GpuProfilerFrame m_Frames[GPU_PROFILER_FRAMES];
+    uint32_t m_Frame = 0;
+    uint64_t m_FrameCount = 0;
+    int64_t m_GpuToCpuNs = 0;               // added to a GPU timestamp, gives Profiler_NowNs time
+    bool m_Created = false;
+    uint32_t m_Skipped = 0;                 // frames dropped because their results weren't ready
+};
+
+extern GpuProfiler gGpuProfiler;
+
+// Needs a current context and gProfiler enabled, otherwise the scopes stay no-ops
+void GpuProfiler_Create();
+void GpuProfiler_Delete();
+
+uint32_t GpuProfiler_Begin(const char *name);
+void GpuProfiler_End(uint32_t scope);
+// After the frame's last GPU scope: resolves the oldest frame in flight and moves on
+void GpuProfiler_EndFrame();
+
+// also a GL debug group of the same name, with or without --profile
+struct GpuProfileScope{
+    uint32_t m_Scope;
+    bool m_Group;
+    explicit GpuProfileScope(const char *name){
+        m_Group = GLDebug_PushGroup(name);
+        m_Scope = gGpuProfiler.m_Created ? GpuProfiler_Begin(name) : GPU_PROFILER_NO_SCOPE;
+    }
+    ~GpuProfileScope(){
+        if(m_Scope != GPU_PROFILER_NO_SCOPE){
+            GpuProfiler_End(m_Scope);
+        }
+        if(m_Group){
+            GLDebug_PopGroup();
+        }
+    }
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILER_CONCAT(gpuProfileScope, __LINE__)(name)
+#else
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,318 @@
+#include "headless.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+
+#include "gl_ext.hpp"
+#include "gl_state.hpp"
+
+// GL/osmesa.h pulls in GL/gl.h, which clashes with glad; the few names used here
+#define OSMESA_FORMAT                0x22
+#define OSMESA_DEPTH_BITS            0x30
+#define OSMESA_STENCIL_BITS          0x31
+#define OSMESA_PROFILE               0x33
+#define OSMESA_CORE_PROFILE          0x34
+#define OSMESA_CONTEXT_MAJOR_VERSION 0x36
+#define OSMESA_CONTEXT_MINOR_VERSION 0x37
+typedef void* (*PFNOSMESACREATECONTEXTATTRIBSPROC)(const int *attribList, void *shareList);
+typedef GLboolean (*PFNOSMESAMAKECURRENTPROC)(void *context, void *buffer, GLenum type, GLsizei width, GLsizei height);
+typedef void (*PFNOSMESADESTROYCONTEXTPROC)(void *context);
+typedef void* (*PFNOSMESAGETPROCADDRESSPROC)(const char *name);
+
+// newest first, 4.4 enables the persistent buffers, 4.1 is what the shaders need
+static const int gVersions[][2] = {{4, 4}, {4, 3}, {4, 1}};
+
+static PFNEGLGETPROCADDRESSPROC gEglGetProcAddress = nullptr;
+static PFNOSMESAGETPROCADDRESSPROC gOSMesaGetProcAddress = nullptr;
+
+static void* GetProcAddress(const char *name){
+    if(gEglGetProcAddress){
+        return (void *)gEglGetProcAddress(name);
+    }
+    return gOSMesaGetProcAddress ? gOSMesaGetProcAddress(name) : nullptr;
+}
+
+template<typename Function>
+static Function Symbol(void *library, const char *name){
+    return (Function)dlsym(library, name);
+}
+
+static bool CreateEGL(HeadlessContext *headless){
+    void *library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if(library == nullptr){
+        return false;
+    }
+    gEglGetProcAddress = Symbol<PFNEGLGETPROCADDRESSPROC>(library, "eglGetProcAddress");
+    auto eglQueryString = Symbol<PFNEGLQUERYSTRINGPROC>(library, "eglQueryString");
+    auto eglGetDisplay = Symbol<PFNEGLGETDISPLAYPROC>(library, "eglGetDisplay");
+    auto eglInitialize = Symbol<PFNEGLINITIALIZEPROC>(library, "eglInitialize");
+    auto eglBindAPI = Symbol<PFNEGLBINDAPIPROC>(library, "eglBindAPI");
+    auto eglChooseConfig = Symbol<PFNEGLCHOOSECONFIGPROC>(library, "eglChooseConfig");
+    auto eglCreateContext = Symbol<PFNEGLCREATECONTEXTPROC>(library, "eglCreateContext");
+    auto eglMakeCurrent = Symbol<PFNEGLMAKECURRENTPROC>(library, "eglMakeCurrent");
+    auto eglTerminate = Symbol<PFNEGLTERMINATEPROC>(library, "eglTerminate");
+    if(!gEglGetProcAddress || !eglQueryString || !eglGetDisplay || !eglInitialize || !eglBindAPI || !eglChooseConfig
+       || !eglCreateContext || !eglMakeCurrent || !eglTerminate){
+        dlclose(library);
+        gEglGetProcAddress = nullptr;
+        return false;
+    }
+
+    // surfaceless platform: no X or Wayland server, no GPU device needed
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)gEglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && eglGetPlatformDisplayEXT){
+        display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if(display == EGL_NO_DISPLAY){
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major = 0, minor = 0;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)){
+        dlclose(library);
+        gEglGetProcAddress = nullptr;
+        return false;
+    }
+
+    // nothing is ever drawn to an EGL surface, any GL config (or none) will do
+    const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    EGLint configs = 0;
+    if(!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0){
+        config = EGL_NO_CONFIG_KHR;
+    }
+
+    EGLContext context = EGL_NO_CONTEXT;
+    for(const int *version : gVersions){
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if(context != EGL_NO_CONTEXT){
+            break;
+        }
+    }
+    if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+        eglTerminate(display);
+        dlclose(library);
+        gEglGetProcAddress = nullptr;
+        return false;
+    }
+    headless->m_Backend = HEADLESS_EGL;
+    headless->m_Library = library;
+    headless->m_Display = display;
+    headless->m_Context = context;
+    return true;
+}
+
+static bool CreateOSMesa(HeadlessContext *headless){
+    void *library = dlopen("libOSMesa.so.8", RTLD_NOW | RTLD_LOCAL);
+    if(library == nullptr){
+        library = dlopen("libOSMesa.so", RTLD_NOW | RTLD_LOCAL);
+    }
+    if(library == nullptr){
+        return false;
+    }
+    auto OSMesaCreateContextAttribs = Symbol<PFNOSMESACREATECONTEXTATTRIBSPROC>(library, "OSMesaCreateContextAttribs");
+    auto OSMesaMakeCurrent = Symbol<PFNOSMESAMAKECURRENTPROC>(library, "OSMesaMakeCurrent");
+    auto OSMesaDestroyContext = Symbol<PFNOSMESADESTROYCONTEXTPROC>(library, "OSMesaDestroyContext");
+    gOSMesaGetProcAddress = Symbol<PFNOSMESAGETPROCADDRESSPROC>(library, "OSMesaGetProcAddress");
+    if(!OSMesaCreateContextAttribs || !OSMesaMakeCurrent || !OSMesaDestroyContext || !gOSMesaGetProcAddress){
+        dlclose(library);
+        gOSMesaGetProcAddress = nullptr;
+        return false;
+    }
+
+    void *context = nullptr;
+    for(const int *version : gVersions){
+        const int attributes[] = {
+            OSMESA_FORMAT, GL_RGBA,
+            OSMESA_DEPTH_BITS, 24,
+            OSMESA_STENCIL_BITS, 0,
+            OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+            OSMESA_CONTEXT_MAJOR_VERSION, version[0],
+            OSMESA_CONTEXT_MINOR_VERSION, version[1],
+            0
+        };
+        context = OSMesaCreateContextAttribs(attributes, nullptr);
+        if(context){
+            break;
+        }
+    }
+    headless->m_OSMesaBuffer.resize((size_t)headless->m_Width * headless->m_Height * 4);
+    if(context == nullptr || !OSMesaMakeCurrent(context, headless->m_OSMesaBuffer.data(), GL_UNSIGNED_BYTE,
+                                                 headless->m_Width, headless->m_Height)){
+        if(context){
+            OSMesaDestroyContext(context);
+        }
+        dlclose(library);
+        gOSMesaGetProcAddress = nullptr;
+        return false;
+    }
+    headless->m_Backend = HEADLESS_OSMESA;
+    headless->m_Library = library;
+    headless->m_Context = context;
+    return true;
+}
+
+bool Headless_Create(HeadlessContext *headless, int width, int height){
+    headless->m_Width = width;
+    headless->m_Height = height;
+    if(!CreateEGL(headless) && !CreateOSMesa(headless)){
+        fprintf(stderr, "Headless: neither a surfaceless EGL nor an OSMesa GL 4.1+ core context could be created\n");
+        return false;
+    }
+    if(!gladLoadGLLoader((GLADloadproc)GetProcAddress)){
+        fprintf(stderr, "Headless: could not load the GL functions\n");
+        Headless_Destroy(headless);
+        return false;
+    }
+    GLExt_Load(GetProcAddress);
+
+    glGenRenderbuffers(1, &headless->m_ColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->m_ColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &headless->m_DepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->m_DepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &headless->m_Framebuffer);
+    GLState_BindFramebuffer(headless->m_Framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->m_ColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->m_DepthBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if(status != GL_FRAMEBUFFER_COMPLETE){
+        fprintf(stderr, "Headless: framebuffer incomplete (0x%x)\n", status);
+        Headless_Destroy(headless);
+        return false;
+    }
+    return true;
+}
+
+void Headless_Destroy(HeadlessContext *headless){
+    if(headless->m_Backend == HEADLESS_NONE){
+        return;
+    }
+    if(headless->m_Framebuffer){
+        GLState_BindFramebuffer(0);
+        GLState_DeleteFramebuffers(1, &headless->m_Framebuffer);
+        glDeleteRenderbuffers(1, &headless->m_ColorBuffer);
+        glDeleteRenderbuffers(1, &headless->m_DepthBuffer);
+        headless->m_Framebuffer = 0;
+    }
+    if(headless->m_Backend == HEADLESS_EGL){
+        auto eglMakeCurrent = Symbol<PFNEGLMAKECURRENTPROC>(headless->m_Library, "eglMakeCurrent");
+        auto eglDestroyContext = Symbol<PFNEGLDESTROYCONTEXTPROC>(headless->m_Library, "eglDestroyContext");
+        auto eglTerminate = Symbol<PFNEGLTERMINATEPROC>(headless->m_Library, "eglTerminate");
+        eglMakeCurrent(headless->m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(headless->m_Display, headless->m_Context);
+        eglTerminate(headless->m_Display);
+        gEglGetProcAddress = nullptr;
+    }else{
+        Symbol<PFNOSMESADESTROYCONTEXTPROC>(headless->m_Library, "OSMesaDestroyContext")(headless->m_Context);
+        gOSMesaGetProcAddress = nullptr;
+    }
+    dlclose(headless->m_Library);
+    *headless = HeadlessContext();
+}
+
+const char* Headless_BackendName(const HeadlessContext *headless){
+    switch(headless->m_Backend){
+        case HEADLESS_EGL: return "egl";
+        case HEADLESS_OSMESA: return "osmesa";
+        default: return "none";
+    }
+}
+
+void Headless_EndFrame(HeadlessContext *headless){
+    glFinish();
+}
+
+// mean and percentiles of one field over the frames
+template<typename Field>
+static void WriteDistribution(FILE *file, const char *name, const std::vector<HeadlessFrame> &frames, Field field, bool last){
+    std::vector<double> values(frames.size());
+    double sum = 0.0;
+    for(size_t i=0; i<frames.size(); i++){
+        values[i] = field(frames[i]);
+        sum += values[i];
+    }
+    std::sort(values.begin(), values.end());
+    auto percentile = [&values](int p){
+        return values.empty() ? 0.0 : values[std::min(values.size() - 1, values.size() * p / 100)];
+    };
+    fprintf(file, "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+            name, values.empty() ? 0.0 : sum / values.size(), percentile(50), percentile(90), percentile(95),
+            percentile(99), values.empty() ? 0.0 : values.back(), last ? "" : ",");
+}
+
+static std::string Escape(const std::string &text){
+    std::string escaped;
+    for(char c : text){
+        if(c == '"' || c == '\\'){
+            escaped += '\\';
+        }
+        if((unsigned char)c >= 0x20){
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+bool HeadlessReport_Write(const HeadlessReport *report, const char *path){
+    FILE *file = fopen(path, "w");
+    if(file == nullptr){
+        fprintf(stderr, "Could not open %s for the headless report\n", path);
+        return false;
+    }
+    const std::vector<HeadlessFrame> &frames = report->m_Frames;
+    fprintf(file, "{\n");
+    fprintf(file, "  \"scene\": \"%s\",\n", Escape(report->m_Scene).c_str());
+    fprintf(file, "  \"frames\": %zu,\n", frames.size());
+    fprintf(file, "  \"warmup_frames\": %u,\n", report->m_WarmupFrames);
+    fprintf(file, "  \"meshes\": %u,\n", report->m_Meshes);
+    fprintf(file, "  \"width\": %d,\n", report->m_Width);
+    fprintf(file, "  \"height\": %d,\n", report->m_Height);
+    fprintf(file, "  \"backend\": \"%s\",\n", Escape(report->m_Backend).c_str());
+    fprintf(file, "  \"renderer\": \"%s\",\n", Escape(report->m_Renderer).c_str());
+    fprintf(file, "  \"gl_version\": \"%s\",\n", Escape(report->m_Version).c_str());
+    fprintf(file, "  \"draw_path\": \"%s\",\n", Escape(report->m_DrawPath).c_str());
+    fprintf(file, "  \"gl_backend\": \"%s\",\n", Escape(report->m_GLBackend).c_str());
+    fprintf(file, "  \"job_workers\": %u,\n", report->m_Workers);
+    WriteDistribution(file, "frame_ms", frames, [](const HeadlessFrame &f){ return (double)f.m_FrameMs; }, false);
+    WriteDistribution(file, "cpu_ms", frames, [](const HeadlessFrame &f){ return (double)f.m_CpuMs; }, false);
+    WriteDistribution(file, "simulate_ms", frames, [](const HeadlessFrame &f){ return (double)f.m_SimulateMs; }, false);
+    WriteDistribution(file, "render_ms", frames, [](const HeadlessFrame &f){ return (double)f.m_RenderMs; }, false);
+    WriteDistribution(file, "visible", frames, [](const HeadlessFrame &f){ return (double)f.m_Visible; }, false);
+    WriteDistribution(file, "draw_calls", frames, [](const HeadlessFrame &f){ return (double)f.m_DrawCalls; }, false);
+    WriteDistribution(file, "program_switches", frames, [](const HeadlessFrame &f){ return (double)f.m_ProgramSwitches; }, false);
+    WriteDistribution(file, "state_calls_issued", frames, [](const HeadlessFrame &f){ return (double)f.m_StateIssued; }, false);
+    WriteDistribution(file, "state_calls_filtered", frames, [](const HeadlessFrame &f){ return (double)f.m_StateFiltered; }, false);
+    bool counted = !report->m_GLCalls.empty();
+    WriteDistribution(file, "vao_switches", frames, [](const HeadlessFrame &f){ return (double)f.m_VertexArraySwitches; }, !counted);
+    if(counted){
+        WriteDistribution(file, "gl_calls", frames, [](const HeadlessFrame &f){ return (double)f.m_GLCalls; }, false);
+        WriteDistribution(file, "redundant_state_sets", frames, [](const HeadlessFrame &f){ return (double)f.m_RedundantStateSets; }, false);
+        fprintf(file, "  \"upload_bytes_per_frame\": {\"buffers\": %.1f, \"uniforms\": %.1f, \"mapped\": %.1f},\n",
+                report->m_BufferBytesPerFrame, report->m_UniformBytesPerFrame, report->m_MappedBytesPerFrame);
+        fprintf(file, "  \"gl_calls_per_frame\": {\n");
+        for(size_t i=0; i<report->m_GLCalls.size(); i++){
+            const HeadlessGLCalls &calls = report->m_GLCalls[i];
+            fprintf(file, "    \"%s\": {\"calls\": %.2f, \"redundant\": %.2f}%s\n", Escape(calls.m_Name).c_str(),
+                    calls.m_PerFrame, calls.m_RedundantPerFrame, i + 1 < report->m_GLCalls.size() ? "," : "");
+        }
+        fprintf(file, "  }\n");
+    }
+    fprintf(file, "}\n");
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Offscreen GL context for machines without a display or GPU (CI boxes on Mesa
+// llvmpipe): EGL on the surfaceless platform, or OSMesa where EGL can't give
+// one. Both libraries are opened at runtime, the windowed build doesn't need
+// them installed. Frames render into a framebuffer object of the window's size
+// that stays bound for the whole run.
+
+enum HeadlessBackend{
+    HEADLESS_NONE,
+    HEADLESS_EGL,
+    HEADLESS_OSMESA,
+};
+
+struct HeadlessContext{
+    HeadlessBackend m_Backend = HEADLESS_NONE;
+    void *m_Library = nullptr;
+    void *m_Display = nullptr;              // EGLDisplay
+    void *m_Context = nullptr;              // EGLContext or OSMesaContext
+    std::vector<uint8_t> m_OSMesaBuffer;    // OSMesa wants a color buffer to make current with
+    int m_Width = 0;
+    int m_Height = 0;
+    GLuint m_Framebuffer = 0;
+    GLuint m_ColorBuffer = 0;
+    GLuint m_DepthBuffer = 0;
+};
+
+// Creates a GL 4.4 core context, or the newest down to 4.1 (the shaders' #version),
+// makes it current, loads glad and gl_ext through it and binds the framebuffer
+bool Headless_Create(HeadlessContext *headless, int width, int height);
+void Headless_Destroy(HeadlessContext *headless);
+const char* Headless_BackendName(const HeadlessContext *headless);
+
+// Waits for the frame's rendering, what a swap would have done
+void Headless_EndFrame(HeadlessContext *headless);
+
+// One frame of a headless run
+struct HeadlessFrame{
+    float m_FrameMs = 0.0f;                 // whole frame including the glFinish
+    float m_CpuMs = 0.0f;                   // up to the glFinish: input, simulation, draw submission
+    float m_SimulateMs = 0.0f;
+    float m_RenderMs = 0.0f;                // RenderFrame
+    uint32_t m_Visible = 0;
+    uint32_t m_DrawCalls = 0;
+    uint32_t m_ProgramSwitches = 0;         // render queue path only
+    uint32_t m_VertexArraySwitches = 0;
+    uint32_t m_GLCalls = 0;                 // --gl-backend counting only
+    uint32_t m_RedundantStateSets = 0;
+    uint32_t m_StateIssued = 0;             // calls through gGLState that reached the driver
+    uint32_t m_StateFiltered = 0;           // and that it dropped
+};
+
+// --gl-backend counting, averaged over the reported frames
+struct HeadlessGLCalls{
+    std::string m_Name;
+    double m_PerFrame = 0.0;
+    double m_RedundantPerFrame = 0.0;
+};
+
+struct HeadlessReport{
+    std::string m_Scene;
+    std::string m_Backend;
+    std::string m_Renderer;
+    std::string m_Version;
+    std::string m_DrawPath;
+    std::string m_GLBackend;
+    int m_Width = 0;
+    int m_Height = 0;
+    unsigned m_Workers = 1;
+    uint32_t m_Meshes = 0;
+    uint32_t m_WarmupFrames = 0;            // run before m_Frames, not reported
+    std::vector<HeadlessFrame> m_Frames;
+    std::vector<HeadlessGLCalls> m_GLCalls;     // busiest first, empty unless counted
+    double m_BufferBytesPerFrame = 0.0;
+    double m_UniformBytesPerFrame = 0.0;
+    double m_MappedBytesPerFrame = 0.0;
+};
+
+// JSON with mean/p50/p90/p95/p99/max of every HeadlessFrame field
+bool HeadlessReport_Write(const HeadlessReport *report, const char *path);
+
+#endif
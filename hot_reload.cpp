@@ -0,0 +1,283 @@
+#include "hot_reload.hpp"
+#include "frame_uniforms.hpp"
+#include "util.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// caller holds m_Mutex
+static void WatchDirectoryOf(HotReload *reload, const std::string &file){
+    std::string directory = DirectoryOf(file);
+    for(const auto &watched : reload->m_Directories){
+        if(watched.second == directory){
+            return;
+        }
+    }
+    // close_write for in place saves, moved_to for editors that write aside and rename
+    int descriptor = inotify_add_watch(reload->m_Notify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(descriptor < 0){
+        fprintf(stderr, "HotReload: can't watch %s\n", directory.empty() ? "." : directory.c_str());
+        return;
+    }
+    reload->m_Directories[descriptor] = directory;
+}
+
+static bool Contains(const std::vector<std::string> &files, const std::string &file){
+    return std::find(files.begin(), files.end(), file) != files.end();
+}
+
+// watcher thread: redoes the file side of every shader and mesh touched by changed
+static void PrepareUpdates(HotReload *reload, const std::vector<std::string> &changed){
+    std::vector<std::pair<size_t, HotReloadShader>> shaders;
+    std::vector<std::pair<size_t, HotReloadMesh>> meshes;
+    {
+        std::lock_guard<std::mutex> lock(reload->m_Mutex);
+        for(size_t i=0; i<reload->m_Shaders.size(); i++){
+            for(const std::string &file : changed){
+                if(Contains(reload->m_Shaders[i].m_Files, file)){
+                    shaders.push_back({i, reload->m_Shaders[i]});
+                    break;
+                }
+            }
+        }
+        for(size_t i=0; i<reload->m_Meshes.size(); i++){
+            if(Contains(changed, reload->m_Meshes[i].m_Path)){
+                meshes.push_back({i, reload->m_Meshes[i]});
+            }
+        }
+    }
+
+    std::vector<HotReloadShaderUpdate> shaderUpdates;
+    for(const auto &entry : shaders){
+        const HotReloadShader &shader = entry.second;
+        HotReloadShaderUpdate update;
+        update.m_Shader = entry.first;
+        if(!ShaderSource_Load(&update.m_Vertex, shader.m_VertexFile.c_str(), shader.m_Features)
+           || !ShaderSource_Load(&update.m_Fragment, shader.m_FragmentFile.c_str(), shader.m_Features)){
+            const std::string &error = update.m_Vertex.m_Error.empty() ? update.m_Fragment.m_Error : update.m_Vertex.m_Error;
+            fprintf(stderr, "HotReload: %s, keeping the last good version\n", error.c_str());
+            continue;
+        }
+        shaderUpdates.push_back(std::move(update));
+    }
+    std::vector<HotReloadMeshUpdate> meshUpdates;
+    for(const auto &entry : meshes){
+        HotReloadMeshUpdate update;
+        update.m_Mesh = entry.first;
+        if(!Mesh_LoadSource(&update.m_Source, entry.second.m_Path.c_str())){
+            fprintf(stderr, "HotReload: %s failed to load, keeping the last good version\n", entry.second.m_Path.c_str());
+            continue;
+        }
+        meshUpdates.push_back(std::move(update));
+    }
+    if(shaderUpdates.empty() && meshUpdates.empty()){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(reload->m_Mutex);
+    for(HotReloadShaderUpdate &update : shaderUpdates){
+        reload->m_ShaderUpdates.push_back(std::move(update));
+    }
+    for(HotReloadMeshUpdate &update : meshUpdates){
+        reload->m_MeshUpdates.push_back(std::move(update));
+    }
+    reload->m_Pending.store(true, std::memory_order_release);
+}
+
+static void WatchLoop(HotReload *reload){
+    pollfd descriptors[2] = {{reload->m_Notify, POLLIN, 0}, {reload->m_Wake, POLLIN, 0}};
+    alignas(inotify_event) char buffer[4096];
+    std::vector<std::string> changed;
+    for(;;){
+        // asleep until something is written, then gathers events until the save settles
+        int ready = poll(descriptors, 2, changed.empty() ? -1 : HOT_RELOAD_SETTLE_MS);
+        if(ready < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            break;
+        }
+        if(descriptors[1].revents & POLLIN){
+            break;
+        }
+        if(ready == 0){
+            PrepareUpdates(reload, changed);
+            changed.clear();
+            continue;
+        }
+
+        ssize_t length = read(reload->m_Notify, buffer, sizeof(buffer));
+        std::lock_guard<std::mutex> lock(reload->m_Mutex);
+        for(ssize_t at = 0; at < length; ){
+            const inotify_event *event = (const inotify_event *)(buffer + at);
+            at += sizeof(inotify_event) + event->len;
+            auto directory = reload->m_Directories.find(event->wd);
+            if(event->len == 0 || directory == reload->m_Directories.end()){
+                continue;
+            }
+            std::string path = directory->second + event->name;
+            if(!Contains(changed, path)){
+                changed.push_back(path);
+            }
+        }
+    }
+}
+
+bool HotReload_Start(HotReload *reload){
+    reload->m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    reload->m_Wake = eventfd(0, EFD_CLOEXEC);
+    if(reload->m_Notify < 0 || reload->m_Wake < 0){
+        fprintf(stderr, "HotReload: inotify not available\n");
+        HotReload_Stop(reload);
+        return false;
+    }
+    reload->m_Watcher = std::thread(WatchLoop, reload);
+    return true;
+}
+
+void HotReload_Stop(HotReload *reload){
+    if(reload->m_Watcher.joinable()){
+        uint64_t one = 1;
+        if(write(reload->m_Wake, &one, sizeof(one)) == sizeof(one)){
+            reload->m_Watcher.join();
+        }else{
+            reload->m_Watcher.detach();
+        }
+    }
+    if(reload->m_Notify >= 0){
+        close(reload->m_Notify);
+    }
+    if(reload->m_Wake >= 0){
+        close(reload->m_Wake);
+    }
+    reload->m_Notify = -1;
+    reload->m_Wake = -1;
+    for(HotReloadBuild &build : reload->m_Building){
+        Pipeline_Delete(&build.m_Pipeline);
+    }
+    reload->m_Building.clear();
+    reload->m_Shaders.clear();
+    reload->m_Meshes.clear();
+    reload->m_Directories.clear();
+    reload->m_ShaderUpdates.clear();
+    reload->m_MeshUpdates.clear();
+    reload->m_Pending = false;
+}
+
+void HotReload_WatchPipeline(HotReload *reload, Pipeline *pipeline){
+    if(reload->m_Notify < 0){
+        return;
+    }
+    std::lock_guard<std::mutex> lock(reload->m_Mutex);
+    for(const HotReloadShader &shader : reload->m_Shaders){
+        if(shader.m_Pipeline == pipeline){
+            return;
+        }
+    }
+    HotReloadShader shader;
+    shader.m_Pipeline = pipeline;
+    shader.m_VertexFile = pipeline->m_VertexFile;
+    shader.m_FragmentFile = pipeline->m_FragmentFile;
+    shader.m_Features = pipeline->m_Features;
+    shader.m_Files = pipeline->m_SourceFiles;
+    // a pipeline that failed to preprocess only knows its two stages
+    if(shader.m_Files.empty()){
+        shader.m_Files = {shader.m_VertexFile, shader.m_FragmentFile};
+    }
+    for(const std::string &file : shader.m_Files){
+        WatchDirectoryOf(reload, file);
+    }
+    reload->m_Shaders.push_back(shader);
+}
+
+void HotReload_WatchMesh(HotReload *reload, const char *path, Mesh3D *mesh, Mesh3D *const *instances, size_t instanceCount){
+    if(reload->m_Notify < 0){
+        return;
+    }
+    std::lock_guard<std::mutex> lock(reload->m_Mutex);
+    HotReloadMesh entry;
+    entry.m_Path = path;
+    entry.m_Mesh = mesh;
+    entry.m_Instances.assign(instances, instances + instanceCount);
+    WatchDirectoryOf(reload, entry.m_Path);
+    reload->m_Meshes.push_back(entry);
+}
+
+// the live Pipeline object keeps its address, meshes and renderers holding it see the new program
+static void SwapIn(HotReload *reload, HotReloadBuild *build){
+    HotReloadShader &shader = reload->m_Shaders[build->m_Shader];
+    Pipeline *live = shader.m_Pipeline;
+    std::swap(*live, build->m_Pipeline);
+    Pipeline_Delete(&build->m_Pipeline);
+    FrameUniforms_BindPipeline(live);
+    printf("HotReload: %s + %s [%s] reloaded, %.1f ms\n", live->m_VertexFile.c_str(), live->m_FragmentFile.c_str(),
+           ShaderSource_FeatureNames(live->m_Features).c_str(), live->m_BuildMs);
+
+    // an edit may have added includes
+    std::lock_guard<std::mutex> lock(reload->m_Mutex);
+    shader.m_Files = live->m_SourceFiles;
+    for(const std::string &file : shader.m_Files){
+        WatchDirectoryOf(reload, file);
+    }
+}
+
+void HotReload_Apply(HotReload *reload, bool takeUpdates){
+    if(reload->m_Building.empty() && !(takeUpdates && reload->m_Pending.load(std::memory_order_acquire))){
+        return;
+    }
+
+    std::vector<HotReloadShaderUpdate> shaderUpdates;
+    std::vector<HotReloadMeshUpdate> meshUpdates;
+    if(takeUpdates && reload->m_Pending.exchange(false, std::memory_order_acquire)){
+        std::lock_guard<std::mutex> lock(reload->m_Mutex);
+        shaderUpdates.swap(reload->m_ShaderUpdates);
+        meshUpdates.swap(reload->m_MeshUpdates);
+    }
+
+    for(HotReloadMeshUpdate &update : meshUpdates){
+        HotReloadMesh &entry = reload->m_Meshes[update.m_Mesh];
+        Mesh3D replacement;
+        if(Mesh_CreateFromSource(&replacement, &update.m_Source)){
+            Mesh_ReplaceGeometry(entry.m_Mesh, &replacement, entry.m_Instances.data(), entry.m_Instances.size());
+            printf("HotReload: %s reloaded\n", entry.m_Path.c_str());
+        }
+    }
+
+    for(HotReloadShaderUpdate &update : shaderUpdates){
+        // a newer save supersedes a build still in flight
+        for(size_t i=0; i<reload->m_Building.size(); i++){
+            if(reload->m_Building[i].m_Shader == update.m_Shader){
+                Pipeline_Delete(&reload->m_Building[i].m_Pipeline);
+                reload->m_Building.erase(reload->m_Building.begin() + i);
+                break;
+            }
+        }
+        const HotReloadShader &shader = reload->m_Shaders[update.m_Shader];
+        reload->m_Building.push_back({update.m_Shader, Pipeline()});
+        Pipeline_CreateFromSourceAsync(&reload->m_Building.back().m_Pipeline, shader.m_VertexFile.c_str(),
+                                       shader.m_FragmentFile.c_str(), update.m_Vertex, update.m_Fragment);
+    }
+
+    for(size_t i=0; i<reload->m_Building.size(); ){
+        HotReloadBuild &build = reload->m_Building[i];
+        PipelineStatus status = Pipeline_Poll(&build.m_Pipeline);
+        if(status == PIPELINE_READY){
+            SwapIn(reload, &build);
+        }else if(status == PIPELINE_FAILED){
+            // the compile/link log was printed by the pipeline
+            fprintf(stderr, "HotReload: %s + %s failed, keeping the last good version\n",
+                    build.m_Pipeline.m_VertexFile.c_str(), build.m_Pipeline.m_FragmentFile.c_str());
+            Pipeline_Delete(&build.m_Pipeline);
+        }else{
+            i++;
+            continue;
+        }
+        reload->m_Building.erase(reload->m_Building.begin() + i);
+    }
+}
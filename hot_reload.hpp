@@ -0,0 +1,89 @@
+#ifndef HOT_RELOAD_HPP
+#define HOT_RELOAD_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "pipeline.hpp"
+#include "mesh.hpp"
+
+// events closer together than this are treated as one save (editors write, rename, touch)
+#define HOT_RELOAD_SETTLE_MS 50
+
+// What the watcher needs to rebuild a pipeline, copied so it never reads the live Pipeline
+struct HotReloadShader{
+    Pipeline *m_Pipeline = nullptr;
+    std::string m_VertexFile;
+    std::string m_FragmentFile;
+    uint32_t m_Features = 0;
+    std::vector<std::string> m_Files;   // both stages and their includes
+};
+
+struct HotReloadMesh{
+    std::string m_Path;
+    Mesh3D *m_Mesh = nullptr;
+    std::vector<Mesh3D*> m_Instances;   // meshes sharing m_Mesh's geometry range
+};
+
+// Prepared on the watcher thread, applied by HotReload_Apply
+struct HotReloadShaderUpdate{
+    size_t m_Shader;
+    ShaderSource m_Vertex;
+    ShaderSource m_Fragment;
+};
+struct HotReloadMeshUpdate{
+    size_t m_Mesh;
+    MeshSource m_Source;
+};
+// a replacement compiling next to the live pipeline, swapped in once it's ready
+struct HotReloadBuild{
+    size_t m_Shader;
+    Pipeline m_Pipeline;
+};
+
+// inotify on the directories of the watched files. The watcher thread sleeps in poll()
+// and does the file work (preprocessing, mesh parsing) itself; the render thread only
+// compiles, uploads and swaps, between frames.
+struct HotReload{
+    int m_Notify = -1;
+    int m_Wake = -1;            // eventfd, stops the watcher
+    std::thread m_Watcher;
+
+    std::mutex m_Mutex;         // guards the tables and update lists below
+    std::vector<HotReloadShader> m_Shaders;
+    std::vector<HotReloadMesh> m_Meshes;
+    std::unordered_map<int, std::string> m_Directories;     // watch descriptor -> "dir/"
+    std::vector<HotReloadShaderUpdate> m_ShaderUpdates;
+    std::vector<HotReloadMeshUpdate> m_MeshUpdates;
+    // set with the update lists, all the render loop reads while nothing changes
+    std::atomic<bool> m_Pending{false};
+
+    // render thread only
+    std::vector<HotReloadBuild> m_Building;
+};
+
+// False when inotify isn't available, the watch calls are then no-ops
+bool HotReload_Start(HotReload *reload);
+void HotReload_Stop(HotReload *reload);
+
+// Rebuilds the pipeline when any of its files (includes too) change. Each pipeline once.
+void HotReload_WatchPipeline(HotReload *reload, Pipeline *pipeline);
+// Reloads mesh (and the instances sharing its geometry) when path changes
+void HotReload_WatchMesh(HotReload *reload, const char *path, Mesh3D *mesh, Mesh3D *const *instances, size_t instanceCount);
+
+// True when saved files are waiting to be applied
+inline bool HotReload_HasUpdates(const HotReload *reload){
+    return reload->m_Pending.load(std::memory_order_acquire);
+}
+
+// Once per frame on the render thread. A program that fails to compile or link is
+// dropped and the last good one stays in use. With takeUpdates false only builds
+// already in flight advance; new updates (which may swap mesh geometry and
+// bounds) wait for a call that passes true.
+void HotReload_Apply(HotReload *reload, bool takeUpdates = true);
+
+#endif
@@ -0,0 +1,143 @@
+#include "indirect.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// baseInstance picks the element, so one static 0..capacity-1 buffer serves every frame
+static void CreateDrawIndexBuffer(IndirectRenderer *renderer, uint32_t capacity){
+    std::vector<uint32_t> drawIndices(capacity);
+    for(uint32_t i=0; i<capacity; i++){
+        drawIndices[i] = i;
+    }
+    if(renderer->m_DrawIndexBuffer == 0){
+        glGenBuffers(1, &renderer->m_DrawIndexBuffer);
+    }
+    GLState_BindBuffer(GL_ARRAY_BUFFER, renderer->m_DrawIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(uint32_t), drawIndices.data(), GL_STATIC_DRAW);
+    GLState_BindBuffer(GL_ARRAY_BUFFER, 0);
+    renderer->m_Capacity = capacity;
+}
+
+// bytes one frame of count draws takes in the ring, alignment padding included
+static GLsizeiptr FrameBytes(const IndirectRenderer *renderer, size_t count){
+    return (GLsizeiptr)(count * (sizeof(DrawElementsIndirectCommand) + sizeof(IndirectDrawRecord) + sizeof(glm::mat4)))
+         + 2 * renderer->m_StorageAlignment;
+}
+
+bool Indirect_Create(IndirectRenderer *renderer, uint32_t capacity){
+    *renderer = IndirectRenderer();
+    if(!gGLExt.m_MultiDrawIndirect){
+        return false;
+    }
+    capacity = std::max(capacity, 1u);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &renderer->m_StorageAlignment);
+    if(!StreamRing_Create(&renderer->m_Stream, FrameBytes(renderer, capacity))){
+        return false;
+    }
+    CreateDrawIndexBuffer(renderer, capacity);
+    return true;
+}
+
+void Indirect_Delete(IndirectRenderer *renderer){
+    StreamRing_Delete(&renderer->m_Stream);
+    GLState_DeleteBuffers(1, &renderer->m_DrawIndexBuffer);
+    *renderer = IndirectRenderer();
+}
+
+void Indirect_RegisterPipeline(IndirectRenderer *renderer, const Pipeline *base, const Pipeline *indirect){
+    renderer->m_IndirectPipelines.push_back({base, indirect});
+}
+
+static const Pipeline* FindIndirectPipeline(const IndirectRenderer *renderer, const Pipeline *base){
+    for(const auto &pair : renderer->m_IndirectPipelines){
+        if(pair.first == base){
+            return Pipeline_IsReady(pair.second) ? pair.second : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+unsigned Indirect_Draw(IndirectRenderer *renderer, Mesh3D *const *meshes, const glm::mat4 *modelViewProjections, size_t count,
+                       ObjectUniformRing *objects){
+    renderer->m_DrawCalls = 0;
+    renderer->m_FallbackDraws = 0;
+    renderer->m_Draws = (unsigned)count;
+    if(count == 0 || renderer->m_Capacity == 0){
+        return 0;
+    }
+
+    if(count > renderer->m_Capacity){
+        CreateDrawIndexBuffer(renderer, std::max((uint32_t)count, renderer->m_Capacity * 2));
+    }
+    StreamRing *stream = &renderer->m_Stream;
+    StreamRing_Reserve(stream, FrameBytes(renderer, count));
+
+    StreamRing_BeginFrame(stream);
+    StreamAllocation commands = StreamRing_Allocate(stream, count * sizeof(DrawElementsIndirectCommand), 4);
+    StreamAllocation records = StreamRing_Allocate(stream, count * sizeof(IndirectDrawRecord), renderer->m_StorageAlignment);
+    StreamAllocation matrices = StreamRing_Allocate(stream, count * sizeof(glm::mat4), renderer->m_StorageAlignment);
+    if(!commands.m_Data || !records.m_Data || !matrices.m_Data){
+        StreamRing_EndFrame(stream);
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DrawCommands_Build(&renderer->m_Builder, meshes, modelViewProjections, count, (DrawElementsIndirectCommand *)commands.m_Data,
+                       (IndirectDrawRecord *)records.m_Data, (glm::mat4 *)matrices.m_Data);
+    renderer->m_BuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    StreamRing_Flush(stream);
+
+    GLState_BindBufferRange(GL_SHADER_STORAGE_BUFFER, INDIRECT_RECORD_BINDING, stream->m_Buffer, records.m_Offset, records.m_Size);
+    GLState_BindBufferRange(GL_SHADER_STORAGE_BUFFER, INDIRECT_MATRIX_BINDING, stream->m_Buffer, matrices.m_Offset, matrices.m_Size);
+    GLState_BindBuffer(GL_DRAW_INDIRECT_BUFFER, stream->m_Buffer);
+
+    // meshes without an indirect pipeline are the only ones needing object blocks, all
+    // written before the first draw (the ring uploads once without persistent mapping)
+    bool objectsBegun = false;
+    for(const DrawBucket &bucket : renderer->m_Builder.m_Buckets){
+        if(FindIndirectPipeline(renderer, bucket.m_Pipeline) != nullptr){
+            continue;
+        }
+        if(!objectsBegun){
+            ObjectUniforms_Begin(objects, count);
+            objectsBegun = true;
+        }
+        const uint32_t *order = renderer->m_Builder.m_Order.data() + bucket.m_First;
+        for(uint32_t i=0; i<bucket.m_Count; i++){
+            ObjectUniforms_Write(objects, order[i], modelViewProjections[order[i]]);
+        }
+    }
+    if(objectsBegun){
+        ObjectUniforms_Flush(objects);
+    }
+
+    for(const DrawBucket &bucket : renderer->m_Builder.m_Buckets){
+        const Pipeline *indirect = FindIndirectPipeline(renderer, bucket.m_Pipeline);
+        if(indirect == nullptr){
+            const uint32_t *order = renderer->m_Builder.m_Order.data() + bucket.m_First;
+            for(uint32_t i=0; i<bucket.m_Count; i++){
+                Mesh_Draw(meshes[order[i]], objects, order[i]);
+            }
+            renderer->m_FallbackDraws += bucket.m_Count;
+            continue;
+        }
+
+        GLState_UseProgram(indirect->m_Program);
+        GLState_BindVertexArray(bucket.m_VertexArrayObject);
+        // the VAO is shared with the other paths, point its draw index attribute every time
+        GLState_BindBuffer(GL_ARRAY_BUFFER, renderer->m_DrawIndexBuffer);
+        glEnableVertexAttribArray(INDIRECT_DRAW_INDEX_LOCATION);
+        glVertexAttribIPointer(INDIRECT_DRAW_INDEX_LOCATION, 1, GL_UNSIGNED_INT, 0, (void *)0);
+        glVertexAttribDivisor(INDIRECT_DRAW_INDEX_LOCATION, 1);
+
+        const void *offset = (const void *)(commands.m_Offset + bucket.m_First * sizeof(DrawElementsIndirectCommand));
+        glMultiDrawElementsIndirect(GL_TRIANGLES, bucket.m_IndexType, offset, (GLsizei)bucket.m_Count, 0);
+        // the other paths draw more instances than m_DrawIndexBuffer holds
+        glDisableVertexAttribArray(INDIRECT_DRAW_INDEX_LOCATION);
+        renderer->m_DrawCalls++;
+    }
+    StreamRing_EndFrame(stream);
+    return renderer->m_DrawCalls + renderer->m_FallbackDraws;
+}
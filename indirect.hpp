@@ -0,0 +1,57 @@
+#ifndef INDIRECT_HPP
+#define INDIRECT_HPP
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gl_ext.hpp"
+#include "stream_ring.hpp"
+#include "draw_commands.hpp"
+#include "mesh.hpp"
+#include "pipeline.hpp"
+
+// Per instance attribute carrying the draw index (= baseInstance of the command),
+// past the instance matrix (2..5) and normal/texcoord (6, 7)
+#define INDIRECT_DRAW_INDEX_LOCATION 8
+// Shader storage bindings of the IndirectDrawRecord and matrix arrays in the SHADER_INDIRECT variant of Shader/vert.glsl
+#define INDIRECT_RECORD_BINDING 1
+#define INDIRECT_MATRIX_BINDING 2
+
+// Draws every mesh of a pipeline bucket with one glMultiDrawElementsIndirect. The
+// commands, records and matrices are written by DrawCommands_Build straight into
+// this frame's segment of a persistently mapped stream ring.
+struct IndirectRenderer{
+    StreamRing m_Stream;
+    GLint m_StorageAlignment = 256; // GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+    GLuint m_DrawIndexBuffer = 0;   // 0, 1, 2, ... read through INDIRECT_DRAW_INDEX_LOCATION
+    uint32_t m_Capacity = 0;        // entries in m_DrawIndexBuffer, the most draws per frame so far
+
+    // base pipeline (Mesh3D::m_Pipeline) -> its indirect variant
+    std::vector<std::pair<const Pipeline*, const Pipeline*>> m_IndirectPipelines;
+
+    DrawCommandBuilder m_Builder;
+
+    // stats of the last Indirect_Draw
+    unsigned m_DrawCalls = 0;       // glMultiDrawElementsIndirect calls
+    unsigned m_FallbackDraws = 0;   // meshes without an indirect pipeline, drawn one by one
+    unsigned m_Draws = 0;
+    double m_BuildMs = 0.0;         // DrawCommands_Build
+};
+
+// False if the context lacks multi draw indirect
+bool Indirect_Create(IndirectRenderer *renderer, uint32_t capacity);
+void Indirect_Delete(IndirectRenderer *renderer);
+
+// Meshes using base are drawn with indirect, which must take its matrix through the
+// records as the SHADER_INDIRECT variant of Shader/vert.glsl does
+void Indirect_RegisterPipeline(IndirectRenderer *renderer, const Pipeline *base, const Pipeline *indirect);
+
+// Builds this frame's segment and issues one multi draw per bucket, returns the draw calls issued.
+// Meshes without an indirect pipeline are drawn one by one with their blocks in objects
+unsigned Indirect_Draw(IndirectRenderer *renderer, Mesh3D *const *meshes, const glm::mat4 *modelViewProjections, size_t count,
+                       ObjectUniformRing *objects);
+
+#endif
@@ -0,0 +1,131 @@
+#include "instancing.hpp"
+#include "gl_state.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+// room for this many instances per frame before the ring has to grow
+#define INSTANCING_INITIAL_INSTANCES 1024
+
+void Instancing_Create(InstanceRenderer *renderer){
+    StreamRing_Create(&renderer->m_Stream, INSTANCING_INITIAL_INSTANCES * sizeof(glm::mat4));
+}
+
+void Instancing_Delete(InstanceRenderer *renderer){
+    StreamRing_Delete(&renderer->m_Stream);
+    *renderer = InstanceRenderer();
+}
+
+void Instancing_RegisterPipeline(InstanceRenderer *renderer, const Pipeline *base, const Pipeline *instanced){
+    renderer->m_InstancedPipelines.push_back({base, instanced});
+}
+
+static const Pipeline* FindInstancedPipeline(const InstanceRenderer *renderer, const Pipeline *base){
+    for(const auto &pair : renderer->m_InstancedPipelines){
+        if(pair.first == base){
+            return Pipeline_IsReady(pair.second) ? pair.second : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void Instancing_Begin(InstanceRenderer *renderer){
+    // keep the batches (and their vectors' capacity) around between frames
+    for(size_t i=0; i<renderer->m_ActiveBatches; i++){
+        renderer->m_Batches[i].m_ModelViewProjections.clear();
+    }
+    renderer->m_ActiveBatches = 0;
+    renderer->m_BatchLookup.clear();
+}
+
+bool Instancing_Submit(InstanceRenderer *renderer, const Mesh3D *mesh, const glm::mat4 &modelViewProjection){
+    if(mesh==nullptr || mesh->m_Pipeline==nullptr){
+        return false;
+    }
+    InstanceBatchKey key = {mesh->m_VertexArrayObject, mesh->m_GeometryRange, mesh->m_Pipeline->m_Program};
+    auto it = renderer->m_BatchLookup.find(key);
+    size_t index;
+    if(it != renderer->m_BatchLookup.end()){
+        index = it->second;
+    }else{
+        const Pipeline *instanced = FindInstancedPipeline(renderer, mesh->m_Pipeline);
+        if(instanced == nullptr){
+            return false;
+        }
+        index = renderer->m_ActiveBatches++;
+        if(index == renderer->m_Batches.size()){
+            renderer->m_Batches.emplace_back();
+        }
+        InstanceBatch &batch = renderer->m_Batches[index];
+        batch.m_VertexArrayObject = mesh->m_VertexArrayObject;
+        batch.m_IndexCount = mesh->m_IndexCount;
+        batch.m_IndexType = mesh->m_IndexType;
+        batch.m_IndexOffset = Mesh_IndexOffset(mesh);
+        batch.m_BaseVertex = Mesh_BaseVertex(mesh);
+        batch.m_Pipeline = instanced;
+        renderer->m_BatchLookup.emplace(key, index);
+    }
+    renderer->m_Batches[index].m_ModelViewProjections.push_back(modelViewProjection);
+    return true;
+}
+
+void Instancing_Flush(InstanceRenderer *renderer){
+    renderer->m_DrawCalls = 0;
+    renderer->m_Instances = 0;
+
+    size_t total = 0;
+    for(size_t i=0; i<renderer->m_ActiveBatches; i++){
+        total += renderer->m_Batches[i].m_ModelViewProjections.size();
+    }
+    if(total == 0){
+        return;
+    }
+
+    // all batches in one allocation of the frame's ring segment
+    GLsizeiptr size = (GLsizeiptr)(total * sizeof(glm::mat4));
+    StreamRing *stream = &renderer->m_Stream;
+    StreamRing_Reserve(stream, size);
+    StreamRing_BeginFrame(stream);
+    StreamAllocation matrices = StreamRing_Allocate(stream, size, sizeof(glm::vec4));
+    if(matrices.m_Data == nullptr){
+        StreamRing_EndFrame(stream);
+        return;
+    }
+    uint8_t *dst = (uint8_t *)matrices.m_Data;
+    for(size_t i=0; i<renderer->m_ActiveBatches; i++){
+        const InstanceBatch &batch = renderer->m_Batches[i];
+        size_t bytes = batch.m_ModelViewProjections.size() * sizeof(glm::mat4);
+        memcpy(dst, batch.m_ModelViewProjections.data(), bytes);
+        dst += bytes;
+    }
+    StreamRing_Flush(stream);
+    GLState_BindBuffer(GL_ARRAY_BUFFER, stream->m_Buffer);
+
+    GLintptr offset = matrices.m_Offset;
+    for(size_t i=0; i<renderer->m_ActiveBatches; i++){
+        const InstanceBatch &batch = renderer->m_Batches[i];
+        GLsizei count = (GLsizei)batch.m_ModelViewProjections.size();
+
+        GLState_UseProgram(batch.m_Pipeline->m_Program);
+        GLState_BindVertexArray(batch.m_VertexArrayObject);
+        // the VAO remembers these, so they're re-pointed at this batch's range on every flush
+        for(GLuint column=0; column<4; column++){
+            GLuint location = INSTANCE_MATRIX_LOCATION + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void *)(offset + sizeof(glm::vec4)*column));
+            glVertexAttribDivisor(location, 1);
+        }
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, batch.m_IndexCount, batch.m_IndexType,
+                                          batch.m_IndexOffset, count, batch.m_BaseVertex);
+        // indirect draws on the same VAO would fetch matrices past this batch by their baseInstance
+        for(GLuint column=0; column<4; column++){
+            glDisableVertexAttribArray(INSTANCE_MATRIX_LOCATION + column);
+        }
+
+        offset += count * sizeof(glm::mat4);
+        renderer->m_DrawCalls++;
+        renderer->m_Instances += count;
+    }
+    StreamRing_EndFrame(stream);
+}
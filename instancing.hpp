@@ -0,0 +1,78 @@
+#ifndef INSTANCING_HPP
+#define INSTANCING_HPP
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "mesh.hpp"
+#include "pipeline.hpp"
+#include "stream_ring.hpp"
+
+// First attribute location of the per instance model-view-projection matrix (mat4 = 4 locations)
+#define INSTANCE_MATRIX_LOCATION 2
+
+// Meshes that share geometry and a pipeline, drawn with one glDrawElementsInstancedBaseVertex
+struct InstanceBatch{
+    GLuint m_VertexArrayObject = 0;
+    GLsizei m_IndexCount = 0;
+    GLenum m_IndexType = GL_UNSIGNED_INT;
+    const void *m_IndexOffset = nullptr;
+    GLint m_BaseVertex = 0;
+    const Pipeline *m_Pipeline = nullptr;       // instanced variant used for the draw
+    std::vector<glm::mat4> m_ModelViewProjections;
+};
+
+// Meshes with the same key go into one batch. VAOs are shared per arena, the geometry
+// range tells meshes apart; program is the base pipeline's
+struct InstanceBatchKey{
+    GLuint m_VertexArrayObject;
+    uint32_t m_GeometryRange;
+    GLuint m_Program;
+
+    bool operator==(const InstanceBatchKey &other) const{
+        return m_VertexArrayObject == other.m_VertexArrayObject && m_GeometryRange == other.m_GeometryRange
+            && m_Program == other.m_Program;
+    }
+};
+
+struct InstanceBatchKeyHash{
+    size_t operator()(const InstanceBatchKey &key) const{
+        uint64_t hash = (((uint64_t)key.m_VertexArrayObject << 32) | key.m_GeometryRange) * 0x9E3779B97F4A7C15ull;
+        hash = (hash ^ (hash >> 31) ^ key.m_Program) * 0xBF58476D1CE4E5B9ull;
+        return (size_t)(hash ^ (hash >> 32));
+    }
+};
+
+struct InstanceRenderer{
+    // per frame instance matrices
+    StreamRing m_Stream;
+
+    // base pipeline (Mesh3D::m_Pipeline) -> its instanced variant
+    std::vector<std::pair<const Pipeline*, const Pipeline*>> m_InstancedPipelines;
+
+    std::unordered_map<InstanceBatchKey, size_t, InstanceBatchKeyHash> m_BatchLookup;
+    std::vector<InstanceBatch> m_Batches;
+    size_t m_ActiveBatches = 0;
+
+    // stats of the last flush
+    unsigned m_DrawCalls = 0;
+    unsigned m_Instances = 0;
+};
+
+void Instancing_Create(InstanceRenderer *renderer);
+void Instancing_Delete(InstanceRenderer *renderer);
+
+// Meshes using base are drawn with instanced, which must read the model-view-projection
+// matrix from INSTANCE_MATRIX_LOCATION instead of u_ModelViewProjection
+void Instancing_RegisterPipeline(InstanceRenderer *renderer, const Pipeline *base, const Pipeline *instanced);
+
+void Instancing_Begin(InstanceRenderer *renderer);
+// Returns false if the mesh's pipeline has no ready instanced variant, draw it with Mesh_Draw instead
+bool Instancing_Submit(InstanceRenderer *renderer, const Mesh3D *mesh, const glm::mat4 &modelViewProjection);
+// Writes all matrices to the frame's stream ring segment and issues one draw per batch
+void Instancing_Flush(InstanceRenderer *renderer);
+
+#endif
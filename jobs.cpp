@@ -0,0 +1,289 @@
+#include "jobs.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "profiler.hpp"
+
+JobSystem gJobs;
+
+// index of the running thread's worker, -1 for threads the job system didn't start
+static thread_local int tWorker = -1;
+
+static uint64_t NowNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// jobs run inside a job's Jobs_Wait are already part of its busy time
+static thread_local int tDepth = 0;
+
+static void Execute(int worker, const Job &job){
+    uint64_t start = tDepth == 0 ? NowNs() : 0;
+    tDepth++;
+    job.m_Function(job.m_Data, job.m_Index);
+    tDepth--;
+    if(worker >= 0){
+        JobWorker &stats = gJobs.m_Workers[worker];
+        if(tDepth == 0){
+            stats.m_BusyNs.fetch_add(NowNs() - start, std::memory_order_relaxed);
+        }
+        stats.m_Executed.fetch_add(1, std::memory_order_relaxed);
+    }
+    // last, anything the job queued has already been added to the counter
+    if(job.m_Counter){
+        job.m_Counter->m_Pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+// own deque from the back, then the others from the front starting at a random victim
+static bool FindJob(int worker, Job *job){
+    if(gJobs.m_Queued.load(std::memory_order_relaxed) == 0){
+        return false;
+    }
+    if(worker >= 0){
+        JobWorker &own = gJobs.m_Workers[worker];
+        std::lock_guard<std::mutex> lock(own.m_Mutex);
+        if(!own.m_Jobs.empty()){
+            *job = own.m_Jobs.back();
+            own.m_Jobs.pop_back();
+            gJobs.m_Queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    static thread_local uint32_t seed = 2463534242u ^ (uint32_t)(size_t)&seed;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    // the extra deque after the workers' holds jobs queued from outside threads
+    unsigned count = gJobs.m_WorkerCount + 1;
+    for(unsigned n=0; n<count; n++){
+        unsigned victim = (seed + n) % count;
+        if((int)victim == worker){
+            continue;
+        }
+        JobWorker &other = gJobs.m_Workers[victim];
+        std::lock_guard<std::mutex> lock(other.m_Mutex);
+        if(!other.m_Jobs.empty()){
+            *job = other.m_Jobs.front();
+            other.m_Jobs.pop_front();
+            gJobs.m_Queued.fetch_sub(1, std::memory_order_relaxed);
+            if(worker >= 0){
+                gJobs.m_Workers[worker].m_Stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static void WorkerLoop(int worker){
+    tWorker = worker;
+    Profiler_SetThreadName(("worker " + std::to_string(worker)).c_str());
+    while(!gJobs.m_Quit.load(std::memory_order_acquire)){
+        Job job;
+        if(FindJob(worker, &job)){
+            Execute(worker, job);
+            continue;
+        }
+        bool found = false;
+        for(int spin=0; spin<JOBS_SPIN_COUNT && !found; spin++){
+            std::this_thread::yield();
+            found = gJobs.m_Queued.load(std::memory_order_relaxed) > 0;
+        }
+        if(found){
+            continue;
+        }
+        // a pusher either sees m_Sleeping > 0 and notifies under the mutex, or we see its m_Queued
+        std::unique_lock<std::mutex> lock(gJobs.m_SleepMutex);
+        gJobs.m_Sleeping.fetch_add(1);
+        gJobs.m_Wake.wait(lock, [](){
+            return gJobs.m_Queued.load() > 0 || gJobs.m_Quit.load();
+        });
+        gJobs.m_Sleeping.fetch_sub(1);
+    }
+}
+
+void Jobs_Init(unsigned threads){
+    if(gJobs.m_Workers){
+        Jobs_Shutdown();
+    }
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    gJobs.m_WorkerCount = threads;
+    gJobs.m_Workers.reset(new JobWorker[threads + 1]);
+    gJobs.m_Queued = 0;
+    gJobs.m_Quit = false;
+    gJobs.m_StatsStart = std::chrono::steady_clock::now();
+    tWorker = 0;
+    for(unsigned w=1; w<threads; w++){
+        gJobs.m_Workers[w].m_Thread = std::thread(WorkerLoop, (int)w);
+    }
+}
+
+void Jobs_Shutdown(){
+    if(gJobs.m_Workers == nullptr){
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(gJobs.m_SleepMutex);
+        gJobs.m_Quit = true;
+    }
+    gJobs.m_Wake.notify_all();
+    for(unsigned w=1; w<gJobs.m_WorkerCount; w++){
+        if(gJobs.m_Workers[w].m_Thread.joinable()){
+            gJobs.m_Workers[w].m_Thread.join();
+        }
+    }
+    gJobs.m_Workers.reset();
+    gJobs.m_WorkerCount = 1;
+    gJobs.m_Queued = 0;
+    tWorker = -1;
+}
+
+unsigned Jobs_WorkerCount(){
+    return gJobs.m_Workers ? gJobs.m_WorkerCount : 1;
+}
+
+void Jobs_Run(const Job *jobs, size_t count){
+    if(count == 0){
+        return;
+    }
+    for(size_t i=0; i<count; i++){
+        if(jobs[i].m_Counter){
+            jobs[i].m_Counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if(gJobs.m_Workers == nullptr){
+        for(size_t i=0; i<count; i++){
+            Execute(-1, jobs[i]);
+        }
+        return;
+    }
+
+    JobWorker &own = gJobs.m_Workers[tWorker >= 0 ? tWorker : gJobs.m_WorkerCount];
+    {
+        std::lock_guard<std::mutex> lock(own.m_Mutex);
+        own.m_Jobs.insert(own.m_Jobs.end(), jobs, jobs + count);
+    }
+    gJobs.m_Queued.fetch_add((uint32_t)count);
+    if(gJobs.m_Sleeping.load() > 0){
+        std::lock_guard<std::mutex> lock(gJobs.m_SleepMutex);
+        if(count == 1){
+            gJobs.m_Wake.notify_one();
+        }else{
+            gJobs.m_Wake.notify_all();
+        }
+    }
+}
+
+void Jobs_Wait(JobCounter *counter){
+    while(counter->m_Pending.load(std::memory_order_acquire) > 0){
+        Job job;
+        if(gJobs.m_Workers && FindJob(tWorker, &job)){
+            Execute(tWorker, job);
+        }else{
+            // the rest is running on other workers
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Jobs_GetStats(std::vector<JobWorkerStats> *stats, double *windowMs){
+    unsigned count = Jobs_WorkerCount();
+    *windowMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gJobs.m_StatsStart).count();
+    stats->assign(count, JobWorkerStats());
+    if(gJobs.m_Workers == nullptr){
+        return;
+    }
+    for(unsigned w=0; w<count; w++){
+        const JobWorker &worker = gJobs.m_Workers[w];
+        JobWorkerStats &out = (*stats)[w];
+        out.m_Jobs = worker.m_Executed.load(std::memory_order_relaxed);
+        out.m_Steals = worker.m_Stolen.load(std::memory_order_relaxed);
+        out.m_BusyMs = worker.m_BusyNs.load(std::memory_order_relaxed) / 1e6;
+        out.m_Utilisation = *windowMs > 0.0 ? out.m_BusyMs / *windowMs : 0.0;
+    }
+}
+
+void Jobs_ResetStats(){
+    gJobs.m_StatsStart = std::chrono::steady_clock::now();
+    if(gJobs.m_Workers == nullptr){
+        return;
+    }
+    for(unsigned w=0; w<gJobs.m_WorkerCount; w++){
+        gJobs.m_Workers[w].m_Executed = 0;
+        gJobs.m_Workers[w].m_Stolen = 0;
+        gJobs.m_Workers[w].m_BusyNs = 0;
+    }
+}
+
+void Jobs_PrintStats(){
+    std::vector<JobWorkerStats> stats;
+    double windowMs = 0.0;
+    Jobs_GetStats(&stats, &windowMs);
+    printf("jobs: %zu workers over %.0f ms\n", stats.size(), windowMs);
+    for(size_t w=0; w<stats.size(); w++){
+        printf("  worker %2zu: %5.1f%% busy, %8llu jobs, %6llu stolen\n", w, stats[w].m_Utilisation * 100.0,
+               (unsigned long long)stats[w].m_Jobs, (unsigned long long)stats[w].m_Steals);
+    }
+}
+
+size_t Jobs_ChunkCount(size_t count, size_t grain){
+    size_t chunks = count / std::max<size_t>(1, grain);
+    return std::max<size_t>(1, std::min<size_t>(chunks, (size_t)Jobs_WorkerCount() * JOBS_CHUNKS_PER_WORKER));
+}
+
+TaskId TaskGraph_Add(TaskGraph *graph, const char *name, std::function<void()> function, std::initializer_list<TaskId> dependencies){
+    TaskId id = (TaskId)graph->m_Tasks.size();
+    graph->m_Tasks.emplace_back();
+    TaskGraphTask &task = graph->m_Tasks.back();
+    task.m_Name = name;
+    task.m_Function = std::move(function);
+    for(TaskId dependency : dependencies){
+        graph->m_Tasks[dependency].m_Dependents.push_back(id);
+        task.m_DependencyCount++;
+    }
+    return id;
+}
+
+static void RunTask(void *data, size_t index){
+    TaskGraph *graph = (TaskGraph *)data;
+    TaskGraphTask &task = graph->m_Tasks[index];
+    PROFILE_SCOPE(task.m_Name);
+    auto start = std::chrono::steady_clock::now();
+    task.m_Function();
+    task.m_Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for(TaskId dependent : task.m_Dependents){
+        if(graph->m_Tasks[dependent].m_Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            Job job = {RunTask, graph, dependent, &graph->m_Counter};
+            Jobs_Run(&job, 1);
+        }
+    }
+}
+
+void TaskGraph_Run(TaskGraph *graph){
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Job> roots;
+    for(size_t t=0; t<graph->m_Tasks.size(); t++){
+        TaskGraphTask &task = graph->m_Tasks[t];
+        task.m_Remaining.store(task.m_DependencyCount, std::memory_order_relaxed);
+        if(task.m_DependencyCount == 0){
+            roots.push_back({RunTask, graph, t, &graph->m_Counter});
+        }
+    }
+    Jobs_Run(roots.data(), roots.size());
+    Jobs_Wait(&graph->m_Counter);
+    graph->m_Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TaskGraph_PrintStats(const TaskGraph *graph){
+    printf("frame tasks %.3f ms:", graph->m_Ms);
+    for(const TaskGraphTask &task : graph->m_Tasks){
+        printf(" %s %.3f", task.m_Name, task.m_Ms);
+    }
+    printf("\n");
+}
@@ -0,0 +1,159 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing scheduler for the per-frame engine work. Every worker owns a
+// deque: it pushes and pops its own jobs at the back (newest first, still in
+// cache), idle workers steal from the front of the others (oldest, usually the
+// biggest piece left). The thread that calls Jobs_Init is worker 0 and only runs
+// jobs while it waits on a counter. Other threads (e.g. the sim thread) queue on
+// a shared deque the workers steal from and help the same way while waiting.
+// Before Jobs_Init everything runs inline on the caller, so GL-free tools don't
+// need to set it up.
+
+// ranges split into at most this many chunks per worker, enough slack for stealing to even out the load
+#define JOBS_CHUNKS_PER_WORKER 4
+// polls of an idle worker before it goes to sleep, frame work arrives in bursts
+#define JOBS_SPIN_COUNT 256
+
+typedef void (*JobFunction)(void *data, size_t index);
+
+// Jobs still to finish, Jobs_Wait returns once it is back to zero
+struct JobCounter{
+    std::atomic<uint32_t> m_Pending{0};
+};
+
+struct Job{
+    JobFunction m_Function = nullptr;
+    void *m_Data = nullptr;
+    size_t m_Index = 0;
+    JobCounter *m_Counter = nullptr;    // decremented after m_Function returns, may be null
+};
+
+struct alignas(64) JobWorker{
+    std::mutex m_Mutex;                 // only held for a push/pop, never while running a job
+    std::deque<Job> m_Jobs;
+    std::thread m_Thread;               // not started for worker 0
+
+    // since the last Jobs_ResetStats
+    std::atomic<uint64_t> m_Executed{0};
+    std::atomic<uint64_t> m_Stolen{0};  // of m_Executed, taken from another worker's deque
+    std::atomic<uint64_t> m_BusyNs{0};
+};
+
+struct JobSystem{
+    unsigned m_WorkerCount = 1;
+    std::unique_ptr<JobWorker[]> m_Workers;     // null until Jobs_Init, m_WorkerCount + 1 deques
+    std::atomic<uint32_t> m_Queued{0};          // jobs sitting in any deque
+    std::atomic<uint32_t> m_Sleeping{0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_Wake;
+    std::atomic<bool> m_Quit{false};
+    std::chrono::steady_clock::time_point m_StatsStart;
+};
+
+extern JobSystem gJobs;
+
+// threads: total workers including the caller, 0 = one per hardware thread
+void Jobs_Init(unsigned threads = 0);
+// joins the workers, jobs still queued are dropped
+void Jobs_Shutdown();
+unsigned Jobs_WorkerCount();
+
+// Queues count jobs on the calling worker's deque (the shared one from other threads),
+// adding them to counter first if they carry one
+void Jobs_Run(const Job *jobs, size_t count);
+// Runs queued jobs (its own, then stolen ones) until counter reaches zero
+void Jobs_Wait(JobCounter *counter);
+
+struct JobWorkerStats{
+    uint64_t m_Jobs = 0;
+    uint64_t m_Steals = 0;
+    double m_BusyMs = 0.0;
+    double m_Utilisation = 0.0;         // busy time / time since the last reset
+};
+// One entry per worker, worker 0 first
+void Jobs_GetStats(std::vector<JobWorkerStats> *stats, double *windowMs);
+void Jobs_ResetStats();
+void Jobs_PrintStats();
+
+// How many pieces to cut count items into, at least grain items each
+size_t Jobs_ChunkCount(size_t count, size_t grain);
+
+// function(chunk, first, last) for chunks equal slices of [0, count), chunk 0 on
+// the caller. Returns when all are done; callers can keep per-chunk scratch.
+template<typename Function>
+void Jobs_ParallelChunks(size_t chunks, size_t count, Function &&function){
+    if(chunks <= 1 || gJobs.m_Workers == nullptr){
+        for(size_t c=0; c<chunks; c++){
+            function(c, count * c / chunks, count * (c + 1) / chunks);
+        }
+        return;
+    }
+    struct Range{
+        Function *m_Function;
+        size_t m_Count;
+        size_t m_Chunks;
+    } range = {&function, count, chunks};
+    JobFunction run = [](void *data, size_t c){
+        Range *range = (Range *)data;
+        (*range->m_Function)(c, range->m_Count * c / range->m_Chunks, range->m_Count * (c + 1) / range->m_Chunks);
+    };
+
+    JobCounter counter;
+    std::vector<Job> jobs(chunks - 1);
+    for(size_t c=1; c<chunks; c++){
+        jobs[c-1] = {run, &range, c, &counter};
+    }
+    Jobs_Run(jobs.data(), jobs.size());
+    run(&range, 0);
+    Jobs_Wait(&counter);
+}
+
+// function(first, last) over [0, count) in pieces of at least grain items
+template<typename Function>
+void Jobs_ParallelFor(size_t count, size_t grain, Function &&function){
+    Jobs_ParallelChunks(Jobs_ChunkCount(count, grain), count, [&function](size_t, size_t first, size_t last){
+        function(first, last);
+    });
+}
+
+// Tasks with dependencies, built once and run every frame. A task is queued as
+// soon as everything it depends on finished and may itself fan out with
+// Jobs_ParallelFor; TaskGraph_Run returns when all of them are done.
+typedef uint32_t TaskId;
+
+struct TaskGraphTask{
+    const char *m_Name = "";
+    std::function<void()> m_Function;
+    std::vector<TaskId> m_Dependents;
+    uint32_t m_DependencyCount = 0;
+    std::atomic<uint32_t> m_Remaining{0};
+    double m_Ms = 0.0;                  // of the last run
+};
+
+struct TaskGraph{
+    std::deque<TaskGraphTask> m_Tasks;  // deque: tasks hold atomics and never move
+    JobCounter m_Counter;
+    double m_Ms = 0.0;                  // whole graph, last run
+};
+
+// dependencies must already be in the graph, so it can't have cycles
+TaskId TaskGraph_Add(TaskGraph *graph, const char *name, std::function<void()> function,
+                     std::initializer_list<TaskId> dependencies = {});
+void TaskGraph_Run(TaskGraph *graph);
+void TaskGraph_PrintStats(const TaskGraph *graph);
+
+#endif
@@ -4,7 +4,11 @@
 #include <glad/glad.h>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
+#include <cstdlib>
 #include <vector>
+#include <thread>
+#include <algorithm>
 #include "util.h"
 using namespace std;
 
@@ -18,6 +22,28 @@ using namespace std;
 ///// GLM /////
 
 #include "camera.hpp"
+#include "pipeline.hpp"
+#include "frame_uniforms.hpp"
+#include "mesh.hpp"
+#include "instancing.hpp"
+#include "render_queue.hpp"
+#include "culling.hpp"
+#include "matrix_batch.hpp"
+#include "geometry_arena.hpp"
+#include "gl_ext.hpp"
+#include "indirect.hpp"
+#include "program_cache.hpp"
+#include "shader_variants.hpp"
+#include "hot_reload.hpp"
+#include "jobs.hpp"
+#include "sim_thread.hpp"
+#include "frame_pacing.hpp"
+#include "profiler.hpp"
+#include "gpu_profiler.hpp"
+#include "headless.hpp"
+#include "gl_dispatch.hpp"
+#include "gl_debug.hpp"
+#include "gl_state.hpp"
 
 // #define SCREEN_HEIGHT 480
 // #define SCREEN_WIDTH 640
@@ -27,11 +53,105 @@ struct App{
     SDL_Window *m_GraphicsAppWindow = nullptr;
     SDL_GLContext *m_OpenGLContext = nullptr;
     bool m_Quit = false;
+    // --headless: no window, an offscreen context (headless.hpp) runs --frames N
+    // frames of scripted input on a virtual clock and writes --report file.json
+    bool m_Headless = false;
+    HeadlessContext m_HeadlessContext;
+    uint32_t m_HeadlessFrames = 300;
+    const char *m_ReportPath = "headless_report.json";
+    HeadlessReport m_Report;
+    uint64_t m_VirtualTime = 0;
+    // --gl-backend real|null|counting|counting-null, see gl_dispatch.hpp; null and
+    // counting-null run headless with no driver at all
+    GLBackend m_GLBackend = GL_BACKEND_REAL;
+    bool m_GLDriver = true;
+    // --no-state-cache issues every bind/state set, --verify-gl-state checks gGLState against glGet*
+    bool m_StateCache = true;
+    bool m_VerifyGLState = false;
+    // --gl-debug off|async|sync, GL errors and driver warnings through KHR_debug, see gl_debug.hpp
+    GLDebugMode m_GLDebug = GL_DEBUG_MODE_ASYNC;
+
+    // what the simulation animates and draws, --scene grid:N adds N copies of gMesh1
+    const char *m_SceneName = "default";
+    vector<Mesh3D*> m_Scene;
+    vector<Mesh3D> m_SceneCopies;
+
+    // ShaderGraphics, variants of Shader/vert.glsl + frag.glsl owned by m_ShaderVariants
+    ShaderVariantCache m_ShaderVariants;
+    bool m_LazyShaders = false;         // --lazy-shaders, only build the variants the active draw path uses
+    Pipeline *m_GraphicsPipeline = nullptr;
+    Pipeline *m_InstancedPipeline = nullptr;    // SHADER_INSTANCED, model matrix as a per instance attribute
+
+    // group meshes sharing geometry+pipeline into one glDrawElementsInstanced (--instanced)
+    bool m_InstancedDrawing = false;
+    InstanceRenderer m_Instancer;
+    // otherwise meshes go through the sort-key render queue
+    RenderQueue m_RenderQueue;
+    // or one glMultiDrawElementsIndirect per pipeline bucket (--indirect, needs GL 4.3 + 4.4 buffer storage)
+    bool m_IndirectDrawing = false;
+    Pipeline *m_IndirectPipeline = nullptr;     // SHADER_INDIRECT, matrix fetched per draw from the indirect renderer's buffers
+    // --hot-reload, rebuilds pipelines and reloads --mesh when their files change
+    bool m_HotReloading = false;
+    HotReload m_HotReload;
+    IndirectRenderer m_Indirect;
+    bool m_PrintStats = false;      // --stats, prints the queue's bind counts once a second
+    const char *m_FrameStatsPath = nullptr;     // --frame-stats file.csv, frame times and CPU use once a second
+    FrameStats m_FrameStats;
+    // --profile: scoped CPU/GPU timers, percentiles in --stats; --profile-trace file.json also writes a Chrome trace
+    bool m_Profile = false;
+    const char *m_ProfileTracePath = nullptr;
+
+    // --swap-interval: 1 vsync, 0 off, -1 adaptive (falls back to 1 where unsupported)
+    int m_SwapInterval = 1;
+    // --fps-limit N, sleeps off the rest of each frame instead of spinning a core
+    FramePacer m_Pacer;
+
+    // frustum culling ahead of the draw stage, --no-cull draws everything
+    bool m_Culling = true;
+    BoundsTable m_WorldBounds;
+    vector<uint32_t> m_VisibleIndices;
+
+    // CPU side of a frame as a task graph on the job system (--jobs N workers):
+    // transforms -> cull -> matrices, written into m_SimTarget
+    TaskGraph m_FrameTasks;
+    Mesh3D *const *m_FrameMeshes = nullptr;
+    size_t m_FrameMeshCount = 0;
+    FrameSnapshot *m_SimTarget = nullptr;
+
+    // the simulation runs a frame ahead on its own thread while this one renders;
+    // --single-thread does both here in a fixed order on one job worker (deterministic)
+    bool m_SingleThread = false;
+    uint32_t m_Snapshots = SIM_THREAD_MIN_SNAPSHOTS;    // --snapshots 3 for triple buffering
+    SimThread m_Sim;
+    FrameSnapshot m_Snapshot;       // --single-thread and --bench-submit
+
+    // the simulation advances in fixed ticks (--tick-rate Hz) whatever the frame
+    // rate, frames are drawn between the last two simulated states
+    uint64_t m_TickNs = 1000000000ull / 60;
+    uint64_t m_SimTime = 0;         // Clock_Now time the simulation has reached
+    uint64_t m_Ticks = 0;
+    uint64_t m_PublishedTime = 0;   // of the state in the last snapshot built
+    Camera m_PublishedCamera;
+    // render thread scratch, the snapshot's matrices blended for this frame
+    vector<glm::mat4> m_RenderModels;
+    vector<glm::mat4> m_RenderModelViewProjections;
+
+    // gathered from SDL on this thread, used up by the next simulation step
+    std::atomic<int> m_MouseDeltaX{0};
+    std::atomic<int> m_MouseDeltaY{0};
+    std::atomic<uint32_t> m_KeysDown{0};
+
+    Camera m_Camera;                // owned by the simulation, the renderer gets a copy per snapshot
+    FrameUniformRing m_FrameUniforms;
+    ObjectUniformRing m_ObjectUniforms;     // every drawn mesh's MVP block, bound per draw
+};
 
-    // ShaderGraphics
-    GLuint m_GraphicsPipelineShaderProgram = 0;
-
-    Camera m_Camera;
+// movement keys held, App::m_KeysDown
+enum InputKeys{
+    INPUT_FORWARD  = 1<<0,
+    INPUT_BACKWARD = 1<<1,
+    INPUT_LEFT     = 1<<2,
+    INPUT_RIGHT    = 1<<3,
 };
 
 #define ERROR_EXIT(...) {fprintf(stderr, __VA_ARGS__); exit(1);}
@@ -41,194 +161,250 @@ struct App{
     } while (0)
 // #define printf(...) fprintf(stdout, ##__VA_ARGS__)
 
-
-////// Error Handling Routines //////
-static void GLClearAllErrors(){
-    while(glGetError() != GL_NO_ERROR){
-    }
-}
-
-static bool GLCheckErrorStatus(const char*function, int line){
-    while(GLenum error = glGetError()){
-        cout << "OpenGL Error: " << error 
-             << "\tLine: " << line 
-             << "\tfunction: " << function << endl;
-        return true;
-    }
-    return false;
-}
-
-#define GLCheck(x) GLClearAllErrors(); x; GLCheckErrorStatus(#x, __LINE__);
-// wrap the function example -> GLCheck(gl_DrawElements(GL_TRIANGLES, 6, GL_INT,0);)
-////// Error Handling Routines //////
-
-struct Transform{
-    glm::mat4 m_modelMatrix{glm::mat4(1.0f)};
-};
-
-struct Mesh3D{
-    // VAO
-    GLuint m_VertexArrayObject = 0;
-    // VBO
-    GLuint m_VertexBufferObject = 0;  //position + color
-    // EBO
-    GLuint m_ElementBufferObject = 0;
-
-    GLuint m_Pipeline = 0;
-
-    // for glsl use uniform
-    // float m_uOffset = -1.0f;
-    Transform m_Transform;
-};
-
 // Globals
 App gApp;
 Mesh3D gMesh1;
 Mesh3D gMesh2;
 
-int FindUniformLocation(GLuint pipeline, const GLchar *name){
-     GLint location = glGetUniformLocation(pipeline, name);
-     if(location<0){
-         cout << "Could not find u_Projection, maybe misspelling?\n";
-         exit(EXIT_FAILURE);
-     }
-
-     return location;
-}
-
-void Mesh_Translate(Mesh3D *mesh, float x, float y, float z){
-    mesh->m_Transform.m_modelMatrix = glm::translate(mesh->m_Transform.m_modelMatrix, glm::vec3(x,y,z));
-}
+// Submitted right after context creation and built while meshes load and the first
+// frames run, meshes using a pipeline start drawing once it's ready
+vector<Pipeline*> gPendingPipelines;
+Uint64 gPipelinesSubmitted = 0;
 
-void Mesh_Rotate(Mesh3D *mesh, float Angle, glm::vec3 axis){
-    mesh->m_Transform.m_modelMatrix = glm::rotate(mesh->m_Transform.m_modelMatrix, glm::radians(Angle), axis);
+static Pipeline* RequestVariant(uint32_t features){
+    Pipeline *pipeline = ShaderVariants_Get(&gApp.m_ShaderVariants, "Shader/vert.glsl", "Shader/frag.glsl", features);
+    if(gPendingPipelines.empty()){
+        gPipelinesSubmitted = SDL_GetPerformanceCounter();
+    }
+    gPendingPipelines.push_back(pipeline);
+    HotReload_WatchPipeline(&gApp.m_HotReload, pipeline);
+    return pipeline;
 }
 
-void Mesh_Scale(Mesh3D *mesh, float x, float y, float z){
-    mesh->m_Transform.m_modelMatrix = glm::scale(mesh->m_Transform.m_modelMatrix, glm::vec3(x,y,z));
+// Prewarms every variant at startup, with --lazy-shaders only those of the draw
+// path in use, the others are requested the first frame their path is switched on
+void RequestPipelines(){
+    if(gApp.m_GraphicsPipeline == nullptr){
+        gApp.m_GraphicsPipeline = RequestVariant(0);
+    }
+    if(gApp.m_InstancedPipeline == nullptr && (!gApp.m_LazyShaders || gApp.m_InstancedDrawing)){
+        gApp.m_InstancedPipeline = RequestVariant(SHADER_INSTANCED);
+        Instancing_RegisterPipeline(&gApp.m_Instancer, gApp.m_GraphicsPipeline, gApp.m_InstancedPipeline);
+    }
+    // GLSL 430 for shader storage blocks, only built where the indirect path can run
+    if(gApp.m_IndirectPipeline == nullptr && gApp.m_Indirect.m_Capacity > 0 && (!gApp.m_LazyShaders || gApp.m_IndirectDrawing)){
+        gApp.m_IndirectPipeline = RequestVariant(SHADER_INDIRECT);
+        Indirect_RegisterPipeline(&gApp.m_Indirect, gApp.m_GraphicsPipeline, gApp.m_IndirectPipeline);
+    }
 }
 
-void Mesh_Draw(Mesh3D *mesh){
-    if(mesh==nullptr){
+// Once per frame, nothing to do after every pipeline settled. wait blocks until they have.
+void PollPipelines(bool wait){
+    if(gPendingPipelines.empty()){
         return;
     }
-    glUseProgram(mesh->m_Pipeline);
-
-    // object matrix uniform values
-    GLint u_ModelMatrixLocation = FindUniformLocation(gApp.m_GraphicsPipelineShaderProgram, "u_ModelMatrix");
-    glUniformMatrix4fv(u_ModelMatrixLocation, 1, GL_FALSE, &mesh->m_Transform.m_modelMatrix[0][0]);
-
-
-    glm::mat4 view = gApp.m_Camera.GetViewMatrix();
-    GLint u_ViewLocation = FindUniformLocation(gApp.m_GraphicsPipelineShaderProgram, "u_ViewMatrix");
-    glUniformMatrix4fv(u_ViewLocation, 1, GL_FALSE, &view[0][0]);
-
-    // projection transform -> (this projection moves out object to z)
-    // retrieve our location of our projection matrix uniform
-    glm::mat4 projection = gApp.m_Camera.GetProjectionMatrix();
-    GLint u_ProjectionLocation = FindUniformLocation(gApp.m_GraphicsPipelineShaderProgram, "u_Projection");
-    glUniformMatrix4fv(u_ProjectionLocation, 1, GL_FALSE, &projection[0][0]);
+    for(size_t i=0; i<gPendingPipelines.size(); ){
+        Pipeline *pipeline = gPendingPipelines[i];
+        if(wait){
+            Pipeline_Wait(pipeline);
+        }
+        PipelineStatus status = Pipeline_Poll(pipeline);
+        if(status == PIPELINE_READY){
+            FrameUniforms_BindPipeline(pipeline);
+        }else if(status == PIPELINE_FAILED){
+            if(pipeline != gApp.m_IndirectPipeline){
+                ERROR_EXIT("Graphics pipeline %s [%s] could not be created:\n%s\n", pipeline->m_VertexFile.c_str(),
+                           ShaderSource_FeatureNames(pipeline->m_Features).c_str(), pipeline->m_InfoLog.c_str());
+            }
+            fprintf(stderr, "Indirect graphics pipeline could not be created:\n%s\n", pipeline->m_InfoLog.c_str());
+            if(gApp.m_IndirectDrawing){
+                fprintf(stderr, "Using the render queue\n");
+                gApp.m_IndirectDrawing = false;
+            }
+        }else{
+            i++;
+            continue;
+        }
+        gPendingPipelines[i] = gPendingPipelines.back();
+        gPendingPipelines.pop_back();
+    }
+    if(gPendingPipelines.empty()){
+        printf("pipelines ready %.1f ms after submit\n",
+               (SDL_GetPerformanceCounter() - gPipelinesSubmitted) * 1000.0 / SDL_GetPerformanceFrequency());
+        ShaderVariants_PrintStats(&gApp.m_ShaderVariants);
+        ProgramCache_PrintStats();
+    }
+}
 
-    glBindVertexArray(mesh->m_VertexArrayObject);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->m_VertexBufferObject);
+// per-mesh loops of the frame tasks are split in pieces of at least this many meshes
+#define FRAME_TASK_MIN_CHUNK 4096
+
+// keeps the meshes whose world bounding sphere touches the camera frustum
+void CullMeshes(Mesh3D *const *meshes, size_t count, FrameSnapshot *snapshot){
+    BoundsTable *bounds = &gApp.m_WorldBounds;
+    Bounds_Resize(bounds, count);
+    Jobs_ParallelFor(count, FRAME_TASK_MIN_CHUNK, [meshes, bounds](size_t first, size_t last){
+        for(size_t i=first; i<last; i++){
+            glm::vec3 center;
+            float radius;
+            Mesh_GetWorldBounds(meshes[i], &center, &radius);
+            Bounds_Set(bounds, i, center, radius);
+        }
+    });
 
-    // glDrawArrays(GL_TRIANGLES, 0, 6);
-    // GLCheck(glDrawElements(GL_TRIANGLES, 6, GL_INT, 0);) try error
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    Frustum frustum = Frustum_FromMatrix(snapshot->m_ViewProjection);
+    gApp.m_VisibleIndices.resize(count);
+    size_t visible = Cull_Spheres(frustum, bounds, gApp.m_VisibleIndices.data());
 
-    //Stop using our current graphics pipeline, necessary if have multiple graphics pipeline
-    glUseProgram(0);
+    snapshot->m_DrawList.resize(visible);
+    Jobs_ParallelFor(visible, FRAME_TASK_MIN_CHUNK, [meshes, snapshot](size_t first, size_t last){
+        for(size_t i=first; i<last; i++){
+            snapshot->m_DrawList[i] = meshes[gApp.m_VisibleIndices[i]];
+        }
+    });
 }
 
-// Single VBO (position+color)
-// void VertexSpecification(Mesh3D *mesh)
-void Mesh_Create(Mesh3D *mesh){
-    // Lives on the CPU
-    const vector<GLfloat> vertexData{
-        // Winding order CCW(is front face)
-        // 0 - Vertex
-        -0.5f, -0.5f, 0.0f,  //bottom left vertex
-        1.0f, 0.0f, 0.0f,         //color
-        // 1 - Vertex
-        0.5f, -0.5f, 0.0f,   //bottom right vertex
-        0.0f, 1.0f, 0.0f,         //color
-        // 2 - Vertex
-        -0.5f, 0.5f, 0.0f,   //top left vertex
-        0.0f, 0.0f, 1.0f,         //color
-        // 3 - Vertex
-        0.5f, 0.5f, 0.0f,  //top right vertex
-        0.0f, 0.0f, 1.0f,         //color
-    };
-
-    // Setting things up on GPU
-    glGenVertexArrays(1, &mesh->m_VertexArrayObject);
-    glBindVertexArray(mesh->m_VertexArrayObject);
-
-    // Start generating our VBO ->for Position
-    glGenBuffers(1, &mesh->m_VertexBufferObject);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->m_VertexBufferObject);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(GLfloat), vertexData.data(), GL_STATIC_DRAW);
-
-    // Start EBO setup
-    const std::vector<GLuint> elementBufferData {2,0,1, 3,2,1};  // vertices of triangle
-    glGenBuffers(1, &mesh->m_ElementBufferObject);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->m_ElementBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementBufferData.size()*sizeof(GLuint), elementBufferData.data(),GL_STATIC_DRAW);
-
-    //    vertex
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(GLfloat)*6, (void *)0);
-    //    color
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(GLfloat)*6, (void *)(sizeof(GLfloat)*3));
-
-    // Unbind
-    glBindVertexArray(0);
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
+// model matrices of the visible meshes now and before the last transform update
+static void ComputeMatrices(FrameSnapshot *snapshot){
+    Jobs_ParallelFor(snapshot->m_DrawList.size(), FRAME_TASK_MIN_CHUNK, [snapshot](size_t first, size_t last){
+        for(size_t i=first; i<last; i++){
+            const Mesh3D *mesh = snapshot->m_DrawList[i];
+            snapshot->m_ModelMatrices[i] = Mesh_GetModelMatrix(mesh);
+            snapshot->m_PreviousModelMatrices[i] = TransformPool_PreviousWorld(&gTransformPool, mesh->m_Transform);
+        }
+    });
 }
 
-void Mesh_SetPipeline(Mesh3D *mesh, GLuint pipeline){
-    mesh->m_Pipeline = pipeline;
+void BuildFrameTasks(){
+    TaskGraph *graph = &gApp.m_FrameTasks;
+    TaskId transforms = TaskGraph_Add(graph, "transforms", [](){
+        // world matrices of everything moved since the last step
+        TransformPool_Update(&gTransformPool);
+    });
+    TaskId cull = TaskGraph_Add(graph, "cull", [](){
+        FrameSnapshot *snapshot = gApp.m_SimTarget;
+        if(gApp.m_Culling){
+            CullMeshes(gApp.m_FrameMeshes, gApp.m_FrameMeshCount, snapshot);
+        }else{
+            snapshot->m_DrawList.assign(gApp.m_FrameMeshes, gApp.m_FrameMeshes + gApp.m_FrameMeshCount);
+        }
+        snapshot->m_ModelMatrices.resize(snapshot->m_DrawList.size());
+        snapshot->m_PreviousModelMatrices.resize(snapshot->m_DrawList.size());
+    }, {transforms});
+    TaskGraph_Add(graph, "matrices", [](){
+        ComputeMatrices(gApp.m_SimTarget);
+    }, {cull});
 }
 
-void Mesh_Delete(Mesh3D *mesh){
-    glDeleteBuffers(1, &mesh->m_VertexArrayObject);
-    glDeleteVertexArrays(1, &mesh->m_VertexArrayObject);
+// camera, visibility and matrices of the meshes as they are now, and as they
+// were at the previous snapshot
+void BuildSnapshot(FrameSnapshot *snapshot, Mesh3D *const *meshes, size_t count){
+    bool first = gApp.m_PublishedTime == 0;
+    snapshot->m_Tick = gApp.m_Ticks;
+    snapshot->m_Time = gApp.m_SimTime;
+    snapshot->m_PreviousTime = first ? gApp.m_SimTime : gApp.m_PublishedTime;
+    snapshot->m_PreviousCamera = first ? gApp.m_Camera : gApp.m_PublishedCamera;
+    snapshot->m_Camera = gApp.m_Camera;
+    gApp.m_PublishedTime = gApp.m_SimTime;
+    gApp.m_PublishedCamera = gApp.m_Camera;
+    snapshot->m_View = gApp.m_Camera.GetViewMatrix();
+    snapshot->m_ViewProjection = gApp.m_Camera.GetProjectionMatrix() * snapshot->m_View;
+    gApp.m_SimTarget = snapshot;
+    gApp.m_FrameMeshes = meshes;
+    gApp.m_FrameMeshCount = count;
+    TaskGraph_Run(&gApp.m_FrameTasks);
 }
 
-
-GLuint CompileShader(GLuint type, const string source){
-    GLuint shaderObject;
-    if(type==GL_VERTEX_SHADER){
-        shaderObject = glCreateShader(GL_VERTEX_SHADER);
-    }else if(type==GL_FRAGMENT_SHADER){
-        shaderObject = glCreateShader(GL_FRAGMENT_SHADER);
+// How far the frame drawn at now is from the snapshot's previous state (0) to its
+// newest (1). Frames show the simulation one step late, so there is always a
+// state on either side of them to blend.
+float FrameAlpha(const FrameSnapshot *frame, uint64_t now){
+    if(frame->m_Time <= frame->m_PreviousTime || now <= frame->m_Time){
+        return frame->m_Time <= frame->m_PreviousTime ? 1.0f : 0.0f;
     }
-    const char *src = source.c_str();
-    glShaderSource(shaderObject, 1, &src, NULL);
-    glCompileShader(shaderObject);
-    return shaderObject;
+    double alpha = (double)(now - frame->m_Time) / (double)(frame->m_Time - frame->m_PreviousTime);
+    return (float)std::min(1.0, alpha);
 }
 
-GLuint CreateShaderProgram(const char *vertexFile, const char *fragmentFile){
-    std::string vertexShaderSource = load_shader_as_string(vertexFile);       //get_file_contents(vertexFile);
-    std::string fragmentShaderSource = load_shader_as_string(fragmentFile);   //get_file_contents(fragmentFile);
-    GLuint programObject = glCreateProgram();
-    GLuint myVertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint myFragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-    glAttachShader(programObject, myVertexShader);
-    glAttachShader(programObject, myFragmentShader);
-    glLinkProgram(programObject);
+// GL side of a frame, only reads the snapshot (not the camera or transform pool).
+// alpha blends its previous and newest state, see FrameAlpha. Returns the number
+// of draw calls issued
+unsigned RenderFrame(const FrameSnapshot *frame, float alpha){
+    PROFILE_SCOPE("render frame");
+    PROFILE_GPU_SCOPE("draw");
+    Camera camera;
+    camera.Interpolate(frame->m_PreviousCamera, frame->m_Camera, alpha);
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 viewProjection = camera.GetProjectionMatrix() * view;
+    // camera matrices for every draw this frame
+    FrameUniforms_Update(&gApp.m_FrameUniforms, camera);
+
+    Mesh3D *const *meshes = frame->m_DrawList.data();
+    size_t count = frame->m_DrawList.size();
+    gApp.m_RenderModels.resize(count);
+    gApp.m_RenderModelViewProjections.resize(count);
+    // the indirect path reads the matrices from its own records, its fallbacks write their blocks
+    ObjectUniformRing *objects = &gApp.m_ObjectUniforms;
+    bool objectBlocks = !gApp.m_IndirectDrawing;
+    if(objectBlocks){
+        ObjectUniforms_Begin(objects, count);
+    }
+    {
+        PROFILE_SCOPE("blend matrices");
+        // every MVP of the frame in one batched pass instead of a multiply per vertex. The
+        // states are a tick apart, blending the matrices component-wise is as good as
+        // blending translation and rotation separately at that distance
+        Jobs_ParallelFor(count, FRAME_TASK_MIN_CHUNK, [frame, alpha, &viewProjection, objects, objectBlocks](size_t first, size_t last){
+            for(size_t i=first; i<last; i++){
+                const glm::mat4 &previous = frame->m_PreviousModelMatrices[i];
+                gApp.m_RenderModels[i] = previous + (frame->m_ModelMatrices[i] - previous) * alpha;
+            }
+            MatBatch_MultiplyShared(viewProjection, gApp.m_RenderModels.data() + first,
+                                    gApp.m_RenderModelViewProjections.data() + first, last - first);
+            for(size_t i=first; objectBlocks && i<last; i++){
+                ObjectUniforms_Write(objects, i, gApp.m_RenderModelViewProjections[i]);
+            }
+        });
+    }
+    const glm::mat4 *modelViewProjections = gApp.m_RenderModelViewProjections.data();
 
-    glValidateProgram(programObject);
+    if(gApp.m_IndirectDrawing){
+        return Indirect_Draw(&gApp.m_Indirect, meshes, modelViewProjections, count, objects);
+    }
+    ObjectUniforms_Flush(objects);
+
+    if(!gApp.m_InstancedDrawing){
+        RenderQueue *queue = &gApp.m_RenderQueue;
+        RenderQueue_Begin(queue);
+        RenderQueue_SubmitBatch(queue, meshes, count, view, gApp.m_RenderModels.data());
+        {
+            PROFILE_SCOPE("render queue sort");
+            RenderQueue_Sort(queue);
+        }
+        PROFILE_SCOPE("render queue execute");
+        RenderQueue_Execute(queue, objects);
+        return queue->m_Stats.m_DrawCalls;
+    }
 
-    return programObject;
+    unsigned drawCalls = 0;
+    Instancing_Begin(&gApp.m_Instancer);
+    for(size_t i=0; i<count; i++){
+        if(!Instancing_Submit(&gApp.m_Instancer, meshes[i], modelViewProjections[i])){
+            Mesh_Draw(meshes[i], objects, i);
+            drawCalls++;
+        }
+    }
+    Instancing_Flush(&gApp.m_Instancer);
+    return drawCalls + gApp.m_Instancer.m_DrawCalls;
 }
 
-void CreateGraphicsPipeline(){
-    gApp.m_GraphicsPipelineShaderProgram = CreateShaderProgram("Shader/vert.glsl","Shader/frag.glsl");
+void PrintGLInfo(){
+    puts("OPENGL Loaded");
+    printf("Vendor: %s\n", glGetString(GL_VENDOR));
+    printf("Renderer: %s\n", glGetString(GL_RENDERER));
+    printf("Version: %s\n", glGetString(GL_VERSION));
+    printf("Multi draw indirect: %s, buffer storage: %s\n", gGLExt.m_MultiDrawIndirect ? "yes" : "no",
+           gGLExt.m_BufferStorage ? "yes" : "no");
 }
 
 void InitializeProgram(App *app){
@@ -240,6 +416,9 @@ void InitializeProgram(App *app){
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    if(app->m_GLDebug == GL_DEBUG_MODE_SYNC){
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+    }
 
     app->m_GraphicsAppWindow = SDL_CreateWindow("OpenGL Window", 0, 0, app->SCREEN_WIDTH, app->SCREEN_HEIGHT, SDL_WINDOW_OPENGL);
     if(!app->m_GraphicsAppWindow)
@@ -249,12 +428,38 @@ void InitializeProgram(App *app){
     if(!app->m_OpenGLContext)
         ERROR_EXIT("OpenGL context not available");
 
+    // adaptive: waits for vblank unless the frame is already late, then tears
+    // instead of dropping to half the refresh rate
+    if(SDL_GL_SetSwapInterval(app->m_SwapInterval) != 0){
+        fprintf(stderr, "Swap interval %d not supported (%s)%s\n", app->m_SwapInterval, SDL_GetError(),
+                app->m_SwapInterval == -1 ? ", using vsync" : "");
+        if(app->m_SwapInterval == -1){
+            SDL_GL_SetSwapInterval(1);
+        }
+    }
+    app->m_SwapInterval = SDL_GL_GetSwapInterval();
+
     // for GL_VENDOR, GL_RENDERER, GL_VERSION
     gladLoadGL();
-    puts("OPENGL Loaded");
-    printf("Vendor: %s\n", glGetString(GL_VENDOR));
-    printf("Renderer: %s\n", glGetString(GL_RENDERER));
-    printf("Version: %s\n", glGetString(GL_VERSION));
+    GLExt_Load();
+    PrintGLInfo();
+    printf("Swap interval: %d\n", app->m_SwapInterval);
+}
+
+// --gl-backend null/counting-null: no context, the null backend stands in for the driver
+void InitializeNullGL(App *app){
+    GLDispatch_Use(app->m_GLBackend);
+    GLExt_Load(GLDispatch_GetProcAddress);
+    PrintGLInfo();
+}
+
+// --headless: same GL setup without SDL, drawing into the offscreen context's framebuffer
+void InitializeHeadless(App *app){
+    if(!Headless_Create(&app->m_HeadlessContext, app->SCREEN_WIDTH, app->SCREEN_HEIGHT))
+        ERROR_EXIT("Headless OpenGL context not available\n");
+    printf("Headless: %s, %dx%d framebuffer\n", Headless_BackendName(&app->m_HeadlessContext),
+           app->SCREEN_WIDTH, app->SCREEN_HEIGHT);
+    PrintGLInfo();
 }
 
 void Input(Mesh3D *mesh){
@@ -270,7 +475,9 @@ void Input(Mesh3D *mesh){
         }else if(e.type == SDL_MOUSEMOTION){
             mouseX = e.motion.xrel;
             mouseY = e.motion.yrel;
-            gApp.m_Camera.MouseLook(mouseX, mouseY);
+            // summed until the simulation takes them
+            gApp.m_MouseDeltaX.fetch_add(mouseX, std::memory_order_relaxed);
+            gApp.m_MouseDeltaY.fetch_add(mouseY, std::memory_order_relaxed);
         }
     }
 
@@ -293,85 +500,678 @@ void Input(Mesh3D *mesh){
     //     cout << "g_uRotate: " << mesh->m_uRotate << endl;
     // }
     // input key to move camera
-    float speed = 0.01f;
-    if(state[SDL_SCANCODE_W]){
+    uint32_t keys = 0;
+    keys |= state[SDL_SCANCODE_W] ? INPUT_FORWARD : 0;
+    keys |= state[SDL_SCANCODE_S] ? INPUT_BACKWARD : 0;
+    keys |= state[SDL_SCANCODE_D] ? INPUT_LEFT : 0;
+    keys |= state[SDL_SCANCODE_A] ? INPUT_RIGHT : 0;
+    gApp.m_KeysDown.store(keys, std::memory_order_relaxed);
+
+    if(state[SDL_SCANCODE_ESCAPE]){
+        gApp.m_Quit = true;
+    }
+}
+
+// --headless: the same camera path every run, a quarter of the frames each
+// walking forward, strafing, walking back and turning
+void ScriptedInput(uint32_t frame, uint32_t frames){
+    static const uint32_t keys[] = {INPUT_FORWARD, INPUT_LEFT, INPUT_BACKWARD, 0};
+    uint32_t phase = (uint32_t)std::min<uint64_t>(3, (uint64_t)frame * 4 / std::max(1u, frames));
+    gApp.m_KeysDown.store(keys[phase], std::memory_order_relaxed);
+    if(phase == 3){
+        gApp.m_MouseDeltaX.fetch_add(4, std::memory_order_relaxed);
+    }
+}
+
+// wall clock time, or with --headless a virtual clock moved a tick per frame so
+// every run simulates and draws the same states
+uint64_t AppNow(){
+    return gApp.m_Headless ? gApp.m_VirtualTime : Clock_Now();
+}
+
+// per second of simulated time, what used to be moved per frame at 60 fps
+#define CAMERA_SPEED 0.6f
+#define MESH_SPIN_DEGREES 3.0f
+
+// simulation side of Input, moves the camera
+void ApplyInput(float dt){
+    int mouseX = gApp.m_MouseDeltaX.exchange(0, std::memory_order_relaxed);
+    int mouseY = gApp.m_MouseDeltaY.exchange(0, std::memory_order_relaxed);
+    if(mouseX != 0 || mouseY != 0){
+        gApp.m_Camera.MouseLook(mouseX, mouseY);
+    }
+
+    uint32_t keys = gApp.m_KeysDown.load(std::memory_order_relaxed);
+    float speed = CAMERA_SPEED * dt;
+    if(keys & INPUT_FORWARD){
         gApp.m_Camera.MoveForward(speed);
     }
-    if(state[SDL_SCANCODE_S]){
+    if(keys & INPUT_BACKWARD){
         gApp.m_Camera.MoveBackward(speed);
     }
-    if(state[SDL_SCANCODE_D]){
+    if(keys & INPUT_LEFT){
         gApp.m_Camera.MoveLeft(speed);
     }
-    if(state[SDL_SCANCODE_A]){
+    if(keys & INPUT_RIGHT){
         gApp.m_Camera.MoveRight(speed);
     }
+}
 
-    if(state[SDL_SCANCODE_ESCAPE]){
-        gApp.m_Quit = true;
+// one fixed tick of dt seconds: input and animation
+void Tick(float dt){
+    ApplyInput(dt);
+
+    float rotate = MESH_SPIN_DEGREES * dt;
+    Mesh_Rotate(&gMesh1,rotate,glm::vec3(0.0f, 1.0f, 0.0f));
+    Mesh_Rotate(&gMesh2,-rotate,glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// after a stall (breakpoint, hot reload, a frame stuck in the driver) the time
+// beyond this many ticks is dropped instead of simulated in one burst
+#define SIM_MAX_TICKS_PER_STEP 5
+
+// Runs every tick due by now, then builds the frame the renderer will draw.
+// Returns false (snapshot untouched) if no tick was due yet
+bool AdvanceSimulation(FrameSnapshot *snapshot, uint64_t now){
+    PROFILE_SCOPE("simulate");
+    uint64_t start = Clock_Now();
+    unsigned ticks = 0;
+    while(gApp.m_SimTime + gApp.m_TickNs <= now){
+        if(ticks == SIM_MAX_TICKS_PER_STEP){
+            gApp.m_SimTime = now;
+            break;
+        }
+        Tick(gApp.m_TickNs / 1e9f);
+        gApp.m_SimTime += gApp.m_TickNs;
+        gApp.m_Ticks++;
+        ticks++;
+    }
+    if(ticks == 0){
+        return false;
+    }
+
+    PROFILE_SCOPE("build snapshot");
+    BuildSnapshot(snapshot, gApp.m_Scene.data(), gApp.m_Scene.size());
+    snapshot->m_SimulateMs = (Clock_Now() - start) / 1e6;
+
+    // printed from here so the graph's timings aren't read while the next step writes them
+    static unsigned step = 0;
+    if(gApp.m_PrintStats && ++step % 60 == 0){
+        TaskGraph_PrintStats(&gApp.m_FrameTasks);
+    }
+    return true;
+}
+
+// sim thread step, sleeps until the next tick is due
+void Simulate(FrameSnapshot *snapshot){
+    Clock_SleepUntil(gApp.m_SimTime + gApp.m_TickNs);
+    AdvanceSimulation(snapshot, Clock_Now());
+}
+
+// bytes of mesh data the arenas may move per frame to close holes left by freed meshes
+#define GEOMETRY_DEFRAGMENT_BUDGET (256 * 1024)
+
+void PrintGeometryArenaStats(){
+    for(const GeometryArena &arena : gGeometryArenas){
+        if(arena.m_VertexArrayObject == 0){
+            continue;
+        }
+        OffsetAllocatorStats vertices, indices;
+        GeometryArena_GetStats(&arena, &vertices, &indices);
+        printf("arena format %u: vertices %u/%u in %u ranges (%u holes, fragmentation %.2f), index units %u/%u (fragmentation %.2f), %u grows, %zu bytes moved\n",
+               arena.m_Format, vertices.m_Used, vertices.m_Size, vertices.m_Allocations, vertices.m_FreeRegions,
+               vertices.m_Fragmentation, indices.m_Used, indices.m_Size, indices.m_Fragmentation, arena.m_Grows, arena.m_BytesMoved);
     }
 }
 
+// fence waits > 0 means the GPU is more than STREAM_RING_SEGMENTS-1 frames behind,
+// overflows that a segment was too small for a frame
+void PrintStreamRingStats(const char *name, const StreamRing *ring){
+    if(ring->m_Buffer == 0){
+        return;
+    }
+    printf("%s stream ring: %u frames, peak %lld/%lld bytes per segment, %u fence waits (%.3f ms), %u overflows%s\n",
+           name, ring->m_Frames, (long long)ring->m_PeakBytes, (long long)ring->m_SegmentSize, ring->m_FenceWaits,
+           ring->m_FenceWaitMs, ring->m_Overflows, ring->m_Persistent ? "" : " (not persistent)");
+}
+
+// --headless: frames before these are not in the report (first uploads, caches warming up)
+#define HEADLESS_WARMUP_FRAMES 10
+
 void MainLoop(){
-    //Lock mouse cursor on center of window
-    SDL_WarpMouseInWindow(gApp.m_GraphicsAppWindow, gApp.SCREEN_WIDTH/2, gApp.SCREEN_HEIGHT/2);
-    SDL_SetRelativeMouseMode(SDL_TRUE);
+    if(!gApp.m_Headless){
+        //Lock mouse cursor on center of window
+        SDL_WarpMouseInWindow(gApp.m_GraphicsAppWindow, gApp.SCREEN_WIDTH/2, gApp.SCREEN_HEIGHT/2);
+        SDL_SetRelativeMouseMode(SDL_TRUE);
+    }
+    gApp.m_SimTime = Clock_Now();
+    gApp.m_VirtualTime = gApp.m_SimTime;
+    // headless runs step the simulation here on the virtual clock, see AppNow
+    bool pipelined = !gApp.m_SingleThread && !gApp.m_Headless;
+    uint32_t headlessFrames = HEADLESS_WARMUP_FRAMES + gApp.m_HeadlessFrames;
+    uint32_t frameIndex = 0;
+    uint64_t glCalls = 0, glRedundant = 0;
+    gApp.m_Report.m_WarmupFrames = HEADLESS_WARMUP_FRAMES;
+    if(pipelined){
+        // the next step is simulated while the last one renders
+        SimThread_Start(&gApp.m_Sim, gApp.m_Snapshots, Simulate);
+    }
+    FrameStats_Open(&gApp.m_FrameStats, gApp.m_FrameStatsPath);
+
+    // --stats: averages over the last FrameStats window
+    double simulateMs = 0.0, renderMs = 0.0;
+    unsigned steps = 0;
+    uint64_t stallNs = 0;
+    uint64_t stateIssued = 0, stateFiltered = 0, stateMismatches = 0;
+    uint64_t lastTick = ~0ull;
     while(!gApp.m_Quit){
-        Input(&gMesh1);
+        PROFILE_SCOPE("frame");
+        uint64_t frameStart = Clock_Now();
+        if(gApp.m_Headless && frameIndex == HEADLESS_WARMUP_FRAMES){
+            GLDispatch_ResetStats();
+        }
+        // frame boundary: nothing drawn with the old program/geometry is still being recorded.
+        // A reload swaps mesh geometry and bounds, the simulation holds still meanwhile
+        bool reload = HotReload_HasUpdates(&gApp.m_HotReload);
+        {
+            PROFILE_SCOPE("hot reload");
+            if(reload){
+                SimThread_Pause(&gApp.m_Sim);
+            }
+            HotReload_Apply(&gApp.m_HotReload, reload);
+            if(reload){
+                SimThread_Resume(&gApp.m_Sim);
+            }
+        }
+        RequestPipelines();
+        PollPipelines(false);
+        if(gApp.m_Headless){
+            ScriptedInput(frameIndex, headlessFrames);
+            gApp.m_VirtualTime += gApp.m_TickNs;
+        }else{
+            Input(&gMesh1);
+        }
 
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
+        const FrameSnapshot *frame = &gApp.m_Snapshot;
+        if(!pipelined){
+            AdvanceSimulation(&gApp.m_Snapshot, AppNow());
+        }else{
+            PROFILE_SCOPE("wait for snapshot");
+            frame = SimThread_LatestFrame(&gApp.m_Sim);
+        }
+        // a fast display draws the same snapshot several times
+        bool stepped = frame->m_Tick != lastTick;
+        if(stepped){
+            simulateMs += frame->m_SimulateMs;
+            steps++;
+            lastTick = frame->m_Tick;
+        }
+        uint64_t renderStart = Clock_Now();
+        uint64_t drawTime = gApp.m_Headless ? AppNow() : renderStart;
 
-        glViewport(0, 0, gApp.SCREEN_WIDTH, gApp.SCREEN_HEIGHT);
-        glClearColor(1.f, 1.f, 0.f, 1.f);
+        GLState_Disable(GL_DEPTH_TEST);
+        GLState_Disable(GL_CULL_FACE);
+
+        GLState_Viewport(0, 0, gApp.SCREEN_WIDTH, gApp.SCREEN_HEIGHT);
+        GLState_ClearColor(1.f, 1.f, 0.f, 1.f);
 
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-        static float rotate = 0.05f;
-        Mesh_Rotate(&gMesh1,rotate,glm::vec3(0.0f, 1.0f, 0.0f));
-        Mesh_Rotate(&gMesh2,-rotate,glm::vec3(0.0f, 1.0f, 0.0f));
+        {
+            PROFILE_SCOPE("defragment");
+            PROFILE_GPU_SCOPE("defragment");
+            GeometryArena_DefragmentAll(GEOMETRY_DEFRAGMENT_BUDGET);
+        }
 
-        Mesh_Draw(&gMesh1);
-        Mesh_Draw(&gMesh2);
+        unsigned drawCalls = RenderFrame(frame, FrameAlpha(frame, drawTime));
+        FrameUniforms_EndFrame(&gApp.m_FrameUniforms);
+        ObjectUniforms_EndFrame(&gApp.m_ObjectUniforms);
+        uint64_t renderEnd = Clock_Now();
+        renderMs += (renderEnd - renderStart) / 1e6;
 
         // Update the screen
-        SDL_GL_SwapWindow(gApp.m_GraphicsAppWindow);
+        {
+            PROFILE_SCOPE("swap");
+            if(gApp.m_Headless){
+                Headless_EndFrame(&gApp.m_HeadlessContext);
+            }else{
+                SDL_GL_SwapWindow(gApp.m_GraphicsAppWindow);
+            }
+        }
+        GLState_EndFrame();
+        GLDebug_EndFrame();
+        stateIssued += gGLState.m_LastFrame.m_Issued;
+        stateFiltered += gGLState.m_LastFrame.m_Filtered;
+        stateMismatches += gGLState.m_LastFrame.m_Mismatches;
+        if(gApp.m_Headless){
+            if(frameIndex >= HEADLESS_WARMUP_FRAMES){
+                const RenderQueueStats &stats = gApp.m_RenderQueue.m_Stats;
+                bool queued = !gApp.m_IndirectDrawing && !gApp.m_InstancedDrawing;
+                HeadlessFrame record;
+                record.m_FrameMs = (Clock_Now() - frameStart) / 1e6;
+                record.m_CpuMs = (renderEnd - frameStart) / 1e6;
+                record.m_SimulateMs = stepped ? frame->m_SimulateMs : 0.0f;
+                record.m_RenderMs = (renderEnd - renderStart) / 1e6;
+                record.m_Visible = (uint32_t)frame->m_DrawList.size();
+                record.m_DrawCalls = drawCalls;
+                record.m_ProgramSwitches = queued ? stats.m_ProgramSwitches : 0;
+                record.m_VertexArraySwitches = queued ? stats.m_VertexArraySwitches : 0;
+                uint64_t calls, redundant;
+                GLDispatch_Totals(&calls, &redundant);
+                record.m_GLCalls = (uint32_t)(calls - glCalls);
+                record.m_RedundantStateSets = (uint32_t)(redundant - glRedundant);
+                record.m_StateIssued = gGLState.m_LastFrame.m_Issued;
+                record.m_StateFiltered = gGLState.m_LastFrame.m_Filtered;
+                glCalls = calls;
+                glRedundant = redundant;
+                gApp.m_Report.m_Frames.push_back(record);
+            }
+            if(++frameIndex == headlessFrames){
+                gApp.m_Quit = true;
+            }
+        }
+        {
+            PROFILE_SCOPE("frame limiter");
+            FramePacer_Wait(&gApp.m_Pacer);
+        }
+        GpuProfiler_EndFrame();
+        Profiler_Collect();
+
+        if(FrameStats_Frame(&gApp.m_FrameStats, &gApp.m_Pacer) && gApp.m_PrintStats){
+            if(gApp.m_IndirectDrawing){
+                const IndirectRenderer &indirect = gApp.m_Indirect;
+                printf("visible %u/%zu, multi draws %u, fallback draws %u, command build %.3f ms\n",
+                       indirect.m_Draws, gApp.m_Scene.size(), indirect.m_DrawCalls, indirect.m_FallbackDraws, indirect.m_BuildMs);
+            }else if(!gApp.m_InstancedDrawing){
+                const RenderQueueStats &stats = gApp.m_RenderQueue.m_Stats;
+                printf("visible %zu/%zu, draws %u, program switches %u, vao switches %u (unfiltered binds %u)\n",
+                       frame->m_DrawList.size(), gApp.m_Scene.size(), stats.m_DrawCalls, stats.m_ProgramSwitches, stats.m_VertexArraySwitches,
+                       stats.m_UnfilteredBinds);
+            }
+            PrintGeometryArenaStats();
+            PrintStreamRingStats("instancing", &gApp.m_Instancer.m_Stream);
+            PrintStreamRingStats("indirect", &gApp.m_Indirect.m_Stream);
+
+            // pipelined, a step and a frame overlap; single threaded a frame pays for the steps it ran
+            unsigned frames = gApp.m_FrameStats.m_Summary.m_Frames;
+            uint64_t stalled = gApp.m_Sim.m_StallNs.load(std::memory_order_relaxed);
+            printf("%s: %u steps (%llu ticks at %.0f Hz), simulate %.3f ms/step, render %.3f ms/frame, simulation waited on render %.3f ms/step\n",
+                   gApp.m_SingleThread ? "single thread" : "pipelined", steps, (unsigned long long)frame->m_Tick,
+                   1e9 / gApp.m_TickNs, steps ? simulateMs / steps : 0.0, renderMs / frames,
+                   steps ? (stalled - stallNs) / 1e6 / steps : 0.0);
+            printf("state cache: %.1f calls/frame issued, %.1f filtered%s", (double)stateIssued / frames,
+                   (double)stateFiltered / frames, gGLState.m_Enabled ? "" : " (disabled)");
+            if(gGLState.m_Verify){
+                printf(", %llu mismatches", (unsigned long long)stateMismatches);
+            }
+            printf("\n");
+            FrameStats_Print(&gApp.m_FrameStats);
+            GLDebug_PrintStats();
+            Profiler_PrintStats();
+            // headless runs keep counting for the report
+            if(gApp.m_GLBackend == GL_BACKEND_COUNTING && !gApp.m_Headless){
+                GLDispatch_PrintStats(frames);
+                GLDispatch_ResetStats();
+            }
+            simulateMs = 0.0;
+            renderMs = 0.0;
+            steps = 0;
+            stateIssued = stateFiltered = stateMismatches = 0;
+            stallNs = stalled;
+            Jobs_PrintStats();
+            Jobs_ResetStats();
+        }
+    }
+    SimThread_Stop(&gApp.m_Sim);
+    FrameStats_Close(&gApp.m_FrameStats);
+}
+
+// count small copies of gMesh1 in a square grid in front of the camera, appended to meshes
+void CreateMeshGrid(vector<Mesh3D> *copies, vector<Mesh3D*> *meshes, size_t count){
+    copies->resize(count);
+    int side = 1;
+    while((size_t)side*side < count){
+        side++;
+    }
+    for(size_t i=0; i<count; i++){
+        Mesh3D *copy = &(*copies)[i];
+        Mesh_CreateInstance(copy, &gMesh1);
+        Mesh_SetPipeline(copy, gApp.m_GraphicsPipeline);
+        float x = (float)(i % side) - side*0.5f;
+        float y = (float)(i / side) - side*0.5f;
+        Mesh_Translate(copy, x*0.1f, y*0.1f, -(float)side*0.2f);
+        Mesh_Scale(copy, 0.05f, 0.05f, 0.05f);
+        meshes->push_back(copy);
+    }
+}
+
+// --bench-submit N[,N...]: N copies of gMesh1's quad drawn through the render queue
+// (one draw per mesh), instanced, and multi draw indirect where supported. "cpu" is
+// the time spent in BuildSnapshot + RenderFrame, "frame" is glFinish'ed so it includes the GPU.
+void BenchmarkSubmission(size_t count){
+    const int frames = 100;
+    vector<Mesh3D> copies;
+    vector<Mesh3D*> meshes;
+    CreateMeshGrid(&copies, &meshes, count);
+    TransformPool_Update(&gTransformPool);
+
+    const char *names[] = {"queued", "instanced", "indirect"};
+    int modes = gApp.m_Indirect.m_Capacity > 0 ? 3 : 2;
+    GLState_Viewport(0, 0, gApp.SCREEN_WIDTH, gApp.SCREEN_HEIGHT);
+    for(int mode=0; mode<modes; mode++){
+        gApp.m_InstancedDrawing = mode==1;
+        gApp.m_IndirectDrawing = mode==2;
+        unsigned drawCalls = 0;
+        uint64_t stateIssued = 0, stateFiltered = 0;
+        Uint64 cpu = 0;
+        GLDispatch_ResetStats();
+        Uint64 start = SDL_GetPerformanceCounter();
+        for(int frame=0; frame<frames; frame++){
+            glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+            Uint64 submit = SDL_GetPerformanceCounter();
+            BuildSnapshot(&gApp.m_Snapshot, meshes.data(), meshes.size());
+            drawCalls = RenderFrame(&gApp.m_Snapshot, 1.0f);
+            FrameUniforms_EndFrame(&gApp.m_FrameUniforms);
+            ObjectUniforms_EndFrame(&gApp.m_ObjectUniforms);
+            cpu += SDL_GetPerformanceCounter() - submit;
+            if(!gApp.m_Headless){
+                SDL_GL_SwapWindow(gApp.m_GraphicsAppWindow);
+            }
+            glFinish();
+            GLState_EndFrame();
+            GLDebug_EndFrame();
+            stateIssued += gGLState.m_LastFrame.m_Issued;
+            stateFiltered += gGLState.m_LastFrame.m_Filtered;
+            GpuProfiler_EndFrame();
+            Profiler_Collect();
+        }
+        double toMs = 1000.0 / SDL_GetPerformanceFrequency() / frames;
+        printf("%-10s %8zu meshes: cpu %8.3f ms/frame, frame %8.3f ms, %8u draw calls/frame",
+               names[mode], count, cpu * toMs, (SDL_GetPerformanceCounter()-start) * toMs, drawCalls);
+        printf(", frame tasks %.3f ms on %u workers", gApp.m_FrameTasks.m_Ms, Jobs_WorkerCount());
+        if(mode == 2){
+            printf(", command build %.3f ms in %u jobs", gApp.m_Indirect.m_BuildMs, gApp.m_Indirect.m_Builder.m_Chunks);
+        }
+        printf(", state calls %.1f issued %.1f filtered/frame", (double)stateIssued / frames, (double)stateFiltered / frames);
+        printf("\n");
+        if(gApp.m_GLBackend == GL_BACKEND_COUNTING){
+            GLDispatch_PrintStats(frames);
+        }
+    }
+    gApp.m_InstancedDrawing = false;
+    gApp.m_IndirectDrawing = false;
+    PrintStreamRingStats("instancing", &gApp.m_Instancer.m_Stream);
+    PrintStreamRingStats("indirect", &gApp.m_Indirect.m_Stream);
+
+    for(Mesh3D &copy : copies){
+        Mesh_Delete(&copy);
+    }
+}
+
+void WriteHeadlessReport(){
+    HeadlessReport *report = &gApp.m_Report;
+    report->m_Scene = gApp.m_SceneName;
+    report->m_Backend = gApp.m_GLDriver ? Headless_BackendName(&gApp.m_HeadlessContext) : "none";
+    report->m_GLBackend = GLDispatch_BackendName(gApp.m_GLBackend);
+    report->m_Renderer = (const char *)glGetString(GL_RENDERER);
+    report->m_Version = (const char *)glGetString(GL_VERSION);
+    report->m_DrawPath = gApp.m_IndirectDrawing ? "indirect" : gApp.m_InstancedDrawing ? "instanced" : "render queue";
+    report->m_Width = gApp.SCREEN_WIDTH;
+    report->m_Height = gApp.SCREEN_HEIGHT;
+    report->m_Workers = Jobs_WorkerCount();
+    report->m_Meshes = (uint32_t)gApp.m_Scene.size();
+    if(gApp.m_GLBackend == GL_BACKEND_COUNTING){
+        const GLDispatchStats &stats = gGLDispatch.m_Stats;
+        double frames = (double)std::max<size_t>(report->m_Frames.size(), 1);
+        for(uint32_t f=0; f<GL_FN_COUNT; f++){
+            if(stats.m_Calls[f] > 0){
+                report->m_GLCalls.push_back({GLDispatch_Name((GLDispatchFunction)f), stats.m_Calls[f] / frames,
+                                             stats.m_Redundant[f] / frames});
+            }
+        }
+        std::sort(report->m_GLCalls.begin(), report->m_GLCalls.end(), [](const HeadlessGLCalls &a, const HeadlessGLCalls &b){
+            return a.m_PerFrame > b.m_PerFrame;
+        });
+        report->m_BufferBytesPerFrame = stats.m_BufferBytes / frames;
+        report->m_UniformBytesPerFrame = stats.m_UniformBytes / frames;
+        report->m_MappedBytesPerFrame = stats.m_MappedBytes / frames;
+        GLDispatch_PrintStats(report->m_Frames.size());
+    }
+    if(HeadlessReport_Write(report, gApp.m_ReportPath)){
+        printf("Headless: %zu frames of %s written to %s\n", report->m_Frames.size(), report->m_Scene.c_str(),
+               gApp.m_ReportPath);
     }
 }
 
 void CleanUp(){
-    SDL_DestroyWindow(gApp.m_GraphicsAppWindow);
-    gApp.m_GraphicsAppWindow = nullptr;
+    // while the context is still current
+    GLDebug_Stop();
+    if(gApp.m_GraphicsAppWindow){
+        SDL_DestroyWindow(gApp.m_GraphicsAppWindow);
+        gApp.m_GraphicsAppWindow = nullptr;
+    }
 
+    for(Mesh3D &copy : gApp.m_SceneCopies){
+        Mesh_Delete(&copy);
+    }
+    Mesh_Delete(&gMesh2);
     Mesh_Delete(&gMesh1);
-    glDeleteProgram(gApp.m_GraphicsPipelineShaderProgram);
+    GeometryArena_DeleteAll();
+    Instancing_Delete(&gApp.m_Instancer);
+    Indirect_Delete(&gApp.m_Indirect);
+    FrameUniforms_Delete(&gApp.m_FrameUniforms);
+    ObjectUniforms_Delete(&gApp.m_ObjectUniforms);
+    HotReload_Stop(&gApp.m_HotReload);
+    ShaderVariants_Delete(&gApp.m_ShaderVariants);
+    GpuProfiler_Delete();
+    Headless_Destroy(&gApp.m_HeadlessContext);
+    Jobs_Shutdown();
+    Profiler_Shutdown();
 
     SDL_Quit();
 }
 
-int main(){
-    InitializeProgram(&gApp);
+int main(int argc, char **argv){
+    vector<size_t> benchCounts;
+    const char *meshPath = nullptr;
+    unsigned jobThreads = 0;
+    for(int i=1; i<argc; i++){
+        if(strcmp(argv[i], "--instanced")==0){
+            gApp.m_InstancedDrawing = true;
+        }else if(strcmp(argv[i], "--no-cull")==0){
+            gApp.m_Culling = false;
+        }else if(strcmp(argv[i], "--stats")==0){
+            gApp.m_PrintStats = true;
+        }else if(strcmp(argv[i], "--no-program-cache")==0){
+            gProgramCacheEnabled = false;
+        }else if(strcmp(argv[i], "--hot-reload")==0){
+            gApp.m_HotReloading = true;
+        }else if(strcmp(argv[i], "--lazy-shaders")==0){
+            gApp.m_LazyShaders = true;
+        }else if(strcmp(argv[i], "--indirect")==0){
+            gApp.m_IndirectDrawing = true;
+        }else if((strcmp(argv[i], "--bench-submit")==0 || strcmp(argv[i], "--bench-instancing")==0) && i+1<argc){
+            // comma separated mesh counts, e.g. 10000,100000,1000000
+            for(char *next = argv[++i]; *next; ){
+                size_t count = strtoul(next, &next, 10);
+                if(count > 0){
+                    benchCounts.push_back(count);
+                }
+                if(*next == ','){
+                    next++;
+                }else{
+                    break;
+                }
+            }
+        }else if(strcmp(argv[i], "--mesh")==0 && i+1<argc){
+            meshPath = argv[++i];
+        }else if(strcmp(argv[i], "--jobs")==0 && i+1<argc){
+            jobThreads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        }else if(strcmp(argv[i], "--single-thread")==0){
+            gApp.m_SingleThread = true;
+        }else if(strcmp(argv[i], "--snapshots")==0 && i+1<argc){
+            gApp.m_Snapshots = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }else if(strcmp(argv[i], "--tick-rate")==0 && i+1<argc){
+            double hz = strtod(argv[++i], nullptr);
+            if(hz > 0.0){
+                gApp.m_TickNs = (uint64_t)(1e9 / hz);
+            }
+        }else if(strcmp(argv[i], "--swap-interval")==0 && i+1<argc){
+            gApp.m_SwapInterval = (int)strtol(argv[++i], nullptr, 10);
+        }else if(strcmp(argv[i], "--fps-limit")==0 && i+1<argc){
+            FramePacer_SetRate(&gApp.m_Pacer, strtod(argv[++i], nullptr));
+        }else if(strcmp(argv[i], "--frame-stats")==0 && i+1<argc){
+            gApp.m_FrameStatsPath = argv[++i];
+        }else if(strcmp(argv[i], "--profile")==0){
+            gApp.m_Profile = true;
+        }else if(strcmp(argv[i], "--profile-trace")==0 && i+1<argc){
+            gApp.m_Profile = true;
+            gApp.m_ProfileTracePath = argv[++i];
+        }else if(strcmp(argv[i], "--headless")==0){
+            gApp.m_Headless = true;
+        }else if(strcmp(argv[i], "--frames")==0 && i+1<argc){
+            gApp.m_HeadlessFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }else if(strcmp(argv[i], "--scene")==0 && i+1<argc){
+            gApp.m_SceneName = argv[++i];
+        }else if(strcmp(argv[i], "--report")==0 && i+1<argc){
+            gApp.m_ReportPath = argv[++i];
+        }else if(strcmp(argv[i], "--no-state-cache")==0){
+            gApp.m_StateCache = false;
+        }else if(strcmp(argv[i], "--verify-gl-state")==0){
+            gApp.m_VerifyGLState = true;
+        }else if(strcmp(argv[i], "--gl-debug")==0 && i+1<argc){
+            const char *mode = argv[++i];
+            if(strcmp(mode, "off")==0){
+                gApp.m_GLDebug = GL_DEBUG_MODE_OFF;
+            }else if(strcmp(mode, "async")==0){
+                gApp.m_GLDebug = GL_DEBUG_MODE_ASYNC;
+            }else if(strcmp(mode, "sync")==0){
+                gApp.m_GLDebug = GL_DEBUG_MODE_SYNC;
+            }else{
+                ERROR_EXIT("Unknown --gl-debug %s (off, async or sync)\n", mode);
+            }
+        }else if(strcmp(argv[i], "--gl-backend")==0 && i+1<argc){
+            const char *backend = argv[++i];
+            gApp.m_GLDriver = strcmp(backend, "null")!=0 && strcmp(backend, "counting-null")!=0;
+            if(strcmp(backend, "real")==0){
+                gApp.m_GLBackend = GL_BACKEND_REAL;
+            }else if(strcmp(backend, "null")==0){
+                gApp.m_GLBackend = GL_BACKEND_NULL;
+            }else if(strcmp(backend, "counting")==0 || strcmp(backend, "counting-null")==0){
+                gApp.m_GLBackend = GL_BACKEND_COUNTING;
+            }else{
+                ERROR_EXIT("Unknown --gl-backend %s (real, null, counting or counting-null)\n", backend);
+            }
+        }
+    }
+    // without a driver there is nothing to open a window with
+    if(!gApp.m_GLDriver){
+        gApp.m_Headless = true;
+    }
+    // default, or grid:N
+    size_t gridCount = 0;
+    if(strncmp(gApp.m_SceneName, "grid:", 5)==0){
+        gridCount = strtoul(gApp.m_SceneName + 5, nullptr, 10);
+    }else if(strcmp(gApp.m_SceneName, "default")!=0){
+        ERROR_EXIT("Unknown --scene %s (default or grid:N)\n", gApp.m_SceneName);
+    }
+    // before any thread that records scopes starts
+    if(gApp.m_Profile){
+        Profiler_SetThreadName("render");
+        Profiler_Init(gApp.m_ProfileTracePath);
+    }
+    // deterministic: one thread runs every job in submission order
+    Jobs_Init(gApp.m_SingleThread ? 1 : jobThreads);
+    BuildFrameTasks();
+    // frames blend each mesh between its last two world matrices
+    gTransformPool.m_TrackPrevious = true;
+
+    // the file is mapped or parsed while the window opens and the shaders compile
+    MeshSource meshSource;
+    thread meshLoader;
+    if(meshPath){
+        meshLoader = thread(Mesh_LoadSource, &meshSource, meshPath);
+    }
+
+    if(!gApp.m_GLDriver){
+        InitializeNullGL(&gApp);
+    }else if(gApp.m_Headless){
+        InitializeHeadless(&gApp);
+    }else{
+        InitializeProgram(&gApp);
+    }
+    // every GL call from here on goes through the chosen backend
+    if(gApp.m_GLDriver){
+        GLDispatch_CaptureReal();
+        if(gApp.m_GLBackend != GL_BACKEND_REAL){
+            GLDispatch_Use(gApp.m_GLBackend);
+        }
+    }
+    // the null backend's glGet* report nothing worth checking against
+    gGLState.m_Enabled = gApp.m_StateCache;
+    gGLState.m_Verify = gApp.m_VerifyGLState && gApp.m_GLDriver;
+    GLState_Invalidate();
+    GLDebug_Start(gApp.m_GLDebug);
+    GpuProfiler_Create();
+    if(gApp.m_HotReloading){
+        HotReload_Start(&gApp.m_HotReload);
+    }
+    FrameUniforms_Create(&gApp.m_FrameUniforms);
+    ObjectUniforms_Create(&gApp.m_ObjectUniforms, 1024);
+    Instancing_Create(&gApp.m_Instancer);
+    if(!Indirect_Create(&gApp.m_Indirect, 1024) && gApp.m_IndirectDrawing){
+        fprintf(stderr, "Multi draw indirect not supported, using the render queue\n");
+        gApp.m_IndirectDrawing = false;
+    }
+    RequestPipelines();
 
     //setup caamera
     gApp.m_Camera.SetProjectionMatrix(glm::radians(45.0f), (float)gApp.SCREEN_WIDTH/(float)gApp.SCREEN_HEIGHT, 0.1f, 100.0f);
 
-    Mesh_Create(&gMesh1);
+    // .obj/.gltf/.glb from --mesh, the built-in quad otherwise (or if the file fails to load)
+    if(meshLoader.joinable()){
+        meshLoader.join();
+    }
+    if(!Mesh_CreateFromSource(&gMesh1, &meshSource)){
+        Mesh_Create(&gMesh1);
+    }
     // model transform -> translating our object into worldspace
     // rotate->translate (rotating at 0,0,0) then walk forward ※if camera is at 0,0 we can see that the object revolves at camera
     // translate->rotate (walkt at 0,0,0 forward) then rotate  ※if camera is at 0,0 we can see that the object spins at itself at a distance
     Mesh_Translate(&gMesh1, 0.0f, 0.0f, -2.0f);
     Mesh_Scale(&gMesh1, 1.0f, 1.0f, 1.0f);
 
-    Mesh_Create(&gMesh2);
+    // same geometry as gMesh1, share its buffers so both land in one instanced batch
+    Mesh_CreateInstance(&gMesh2, &gMesh1);
     Mesh_Translate(&gMesh1, 2.0f, 0.0f, -2.0f);
     Mesh_Scale(&gMesh2, 2.0f, 2.0f, 2.0f);
 
-    CreateGraphicsPipeline();
-
-    Mesh_SetPipeline(&gMesh1, gApp.m_GraphicsPipelineShaderProgram);
-    Mesh_SetPipeline(&gMesh2, gApp.m_GraphicsPipelineShaderProgram);
+    Mesh_SetPipeline(&gMesh1, gApp.m_GraphicsPipeline);
+    Mesh_SetPipeline(&gMesh2, gApp.m_GraphicsPipeline);
+    gApp.m_Scene = {&gMesh1, &gMesh2};
+    CreateMeshGrid(&gApp.m_SceneCopies, &gApp.m_Scene, gridCount);
+    if(meshPath){
+        // every mesh sharing gMesh1's geometry range: gMesh2 and the grid copies
+        vector<Mesh3D*> instances(gApp.m_Scene.begin() + 1, gApp.m_Scene.end());
+        HotReload_WatchMesh(&gApp.m_HotReload, meshPath, &gMesh1, instances.data(), instances.size());
+    }
 
-    MainLoop();
+    if(!benchCounts.empty()){
+        // timings need every path drawing from the first frame
+        gApp.m_LazyShaders = false;
+        RequestPipelines();
+        PollPipelines(true);
+        for(size_t count : benchCounts){
+            BenchmarkSubmission(count);
+        }
+    }else if(gApp.m_Headless){
+        // every frame of the run draws with its final pipelines
+        PollPipelines(true);
+        MainLoop();
+        WriteHeadlessReport();
+    }else{
+        MainLoop();
+    }
 
     CleanUp();
 
@@ -0,0 +1,322 @@
+#include "matrix_batch.hpp"
+
+#include <glm/glm.hpp>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MATBATCH_X86 1
+#include <immintrin.h>
+#endif
+
+struct MatBatchTable{
+    void (*Multiply)(const glm::mat4*, const glm::mat4*, glm::mat4*, size_t);
+    void (*MultiplyShared)(const glm::mat4&, const glm::mat4*, glm::mat4*, size_t);
+    void (*ComposeTRS)(const glm::vec3*, const glm::quat*, const glm::vec3*, glm::mat4*, size_t);
+    void (*InverseAffine)(const glm::mat4*, glm::mat4*, size_t);
+};
+
+////// Scalar //////
+static inline void MultiplyOne(const float *a, const float *b, float *out){
+    for(int col=0; col<4; col++){
+        float b0 = b[col*4+0], b1 = b[col*4+1], b2 = b[col*4+2], b3 = b[col*4+3];
+        for(int row=0; row<4; row++){
+            out[col*4+row] = a[row]*b0 + a[4+row]*b1 + a[8+row]*b2 + a[12+row]*b3;
+        }
+    }
+}
+
+static void MultiplyScalar(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    for(size_t i=0; i<count; i++){
+        float result[16];
+        MultiplyOne(&a[i][0][0], &b[i][0][0], result);
+        memcpy(&out[i][0][0], result, sizeof(result));
+    }
+}
+
+static void MultiplySharedScalar(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    float shared[16];
+    memcpy(shared, &a[0][0], sizeof(shared));
+    for(size_t i=0; i<count; i++){
+        float result[16];
+        MultiplyOne(shared, &b[i][0][0], result);
+        memcpy(&out[i][0][0], result, sizeof(result));
+    }
+}
+
+static void ComposeTRSScalar(const glm::vec3 *t, const glm::quat *r, const glm::vec3 *s, glm::mat4 *out, size_t count){
+    for(size_t i=0; i<count; i++){
+        const glm::quat &q = r[i];
+        float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+        float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+        float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+        float *m = &out[i][0][0];
+        m[0]  = (1.0f - 2.0f*(yy + zz)) * s[i].x;
+        m[1]  = 2.0f*(xy + wz) * s[i].x;
+        m[2]  = 2.0f*(xz - wy) * s[i].x;
+        m[3]  = 0.0f;
+        m[4]  = 2.0f*(xy - wz) * s[i].y;
+        m[5]  = (1.0f - 2.0f*(xx + zz)) * s[i].y;
+        m[6]  = 2.0f*(yz + wx) * s[i].y;
+        m[7]  = 0.0f;
+        m[8]  = 2.0f*(xz + wy) * s[i].z;
+        m[9]  = 2.0f*(yz - wx) * s[i].z;
+        m[10] = (1.0f - 2.0f*(xx + yy)) * s[i].z;
+        m[11] = 0.0f;
+        m[12] = t[i].x;
+        m[13] = t[i].y;
+        m[14] = t[i].z;
+        m[15] = 1.0f;
+    }
+}
+
+static void InverseAffineScalar(const glm::mat4 *in, glm::mat4 *out, size_t count){
+    for(size_t i=0; i<count; i++){
+        const glm::mat4 &m = in[i];
+        glm::vec3 c0(m[0]), c1(m[1]), c2(m[2]), t(m[3]);
+        // rows of the inverse 3x3 are the cross products of the columns over the determinant
+        glm::vec3 r0 = glm::cross(c1, c2);
+        glm::vec3 r1 = glm::cross(c2, c0);
+        glm::vec3 r2 = glm::cross(c0, c1);
+        float invDet = 1.0f / glm::dot(c0, r0);
+        r0 = r0 * invDet;
+        r1 = r1 * invDet;
+        r2 = r2 * invDet;
+
+        glm::mat4 &o = out[i];
+        o[0] = glm::vec4(r0.x, r1.x, r2.x, 0.0f);
+        o[1] = glm::vec4(r0.y, r1.y, r2.y, 0.0f);
+        o[2] = glm::vec4(r0.z, r1.z, r2.z, 0.0f);
+        o[3] = glm::vec4(-glm::dot(r0, t), -glm::dot(r1, t), -glm::dot(r2, t), 1.0f);
+    }
+}
+
+static const MatBatchTable gScalarTable = {
+    MultiplyScalar, MultiplySharedScalar, ComposeTRSScalar, InverseAffineScalar,
+};
+
+#ifdef MATBATCH_X86
+////// SSE4.1 //////
+// one output column: a's columns weighted by the four entries of b's column
+#define MATBATCH_SSE_COLUMN(a0, a1, a2, a3, bcol) \
+    _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_shuffle_ps(bcol, bcol, 0x00)), \
+                          _mm_mul_ps(a1, _mm_shuffle_ps(bcol, bcol, 0x55))), \
+               _mm_add_ps(_mm_mul_ps(a2, _mm_shuffle_ps(bcol, bcol, 0xAA)), \
+                          _mm_mul_ps(a3, _mm_shuffle_ps(bcol, bcol, 0xFF))))
+
+__attribute__((target("sse4.1")))
+static void MultiplySSE(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    for(size_t i=0; i<count; i++){
+        const float *pa = &a[i][0][0];
+        const float *pb = &b[i][0][0];
+        float *po = &out[i][0][0];
+        __m128 a0 = _mm_loadu_ps(pa), a1 = _mm_loadu_ps(pa+4), a2 = _mm_loadu_ps(pa+8), a3 = _mm_loadu_ps(pa+12);
+        __m128 b0 = _mm_loadu_ps(pb), b1 = _mm_loadu_ps(pb+4), b2 = _mm_loadu_ps(pb+8), b3 = _mm_loadu_ps(pb+12);
+        _mm_storeu_ps(po,    MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b0));
+        _mm_storeu_ps(po+4,  MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b1));
+        _mm_storeu_ps(po+8,  MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b2));
+        _mm_storeu_ps(po+12, MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b3));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void MultiplySharedSSE(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    const float *pa = &a[0][0];
+    __m128 a0 = _mm_loadu_ps(pa), a1 = _mm_loadu_ps(pa+4), a2 = _mm_loadu_ps(pa+8), a3 = _mm_loadu_ps(pa+12);
+    for(size_t i=0; i<count; i++){
+        const float *pb = &b[i][0][0];
+        float *po = &out[i][0][0];
+        __m128 b0 = _mm_loadu_ps(pb), b1 = _mm_loadu_ps(pb+4), b2 = _mm_loadu_ps(pb+8), b3 = _mm_loadu_ps(pb+12);
+        _mm_storeu_ps(po,    MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b0));
+        _mm_storeu_ps(po+4,  MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b1));
+        _mm_storeu_ps(po+8,  MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b2));
+        _mm_storeu_ps(po+12, MATBATCH_SSE_COLUMN(a0, a1, a2, a3, b3));
+    }
+}
+
+// (y, z, x, w) lane rotation used by the cross products
+#define MATBATCH_YZX(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))
+
+__attribute__((target("sse4.1")))
+static inline __m128 CrossSSE(__m128 a, __m128 b){
+    __m128 result = _mm_sub_ps(_mm_mul_ps(a, MATBATCH_YZX(b)), _mm_mul_ps(MATBATCH_YZX(a), b));
+    return MATBATCH_YZX(result);
+}
+
+__attribute__((target("sse4.1")))
+static void ComposeTRSSSE(const glm::vec3 *t, const glm::quat *r, const glm::vec3 *s, glm::mat4 *out, size_t count){
+    const __m128 one = _mm_set_ps(0.0f, 1.0f, 1.0f, 1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    for(size_t i=0; i<count; i++){
+        const glm::quat &q = r[i];
+        // same terms as the scalar version, three at a time per column
+        __m128 q2 = _mm_mul_ps(_mm_set_ps(0.0f, q.z, q.y, q.x), two);   // 2x 2y 2z
+        __m128 xyz = _mm_set_ps(0.0f, q.z, q.y, q.x);
+        __m128 sq = _mm_mul_ps(xyz, q2);                                // 2xx 2yy 2zz
+        float xy = 2.0f*q.x*q.y, xz = 2.0f*q.x*q.z, yz = 2.0f*q.y*q.z;
+        float wx = 2.0f*q.w*q.x, wy = 2.0f*q.w*q.y, wz = 2.0f*q.w*q.z;
+        float yy = _mm_cvtss_f32(_mm_shuffle_ps(sq, sq, 0x55));
+        float zz = _mm_cvtss_f32(_mm_shuffle_ps(sq, sq, 0xAA));
+        float xx = _mm_cvtss_f32(sq);
+
+        __m128 diag = _mm_sub_ps(one, _mm_set_ps(0.0f, xx + yy, xx + zz, yy + zz));
+        __m128 c0 = _mm_blend_ps(_mm_set_ps(0.0f, xz - wy, xy + wz, 0.0f), diag, 0x1);
+        __m128 c1 = _mm_blend_ps(_mm_set_ps(0.0f, yz + wx, 0.0f, xy - wz), diag, 0x2);
+        __m128 c2 = _mm_blend_ps(_mm_set_ps(0.0f, 0.0f, yz - wx, xz + wy), diag, 0x4);
+
+        float *po = &out[i][0][0];
+        _mm_storeu_ps(po,    _mm_mul_ps(c0, _mm_set1_ps(s[i].x)));
+        _mm_storeu_ps(po+4,  _mm_mul_ps(c1, _mm_set1_ps(s[i].y)));
+        _mm_storeu_ps(po+8,  _mm_mul_ps(c2, _mm_set1_ps(s[i].z)));
+        _mm_storeu_ps(po+12, _mm_set_ps(1.0f, t[i].z, t[i].y, t[i].x));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void InverseAffineSSE(const glm::mat4 *in, glm::mat4 *out, size_t count){
+    const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    for(size_t i=0; i<count; i++){
+        const float *pm = &in[i][0][0];
+        __m128 c0 = _mm_and_ps(_mm_loadu_ps(pm),   xyzMask);
+        __m128 c1 = _mm_and_ps(_mm_loadu_ps(pm+4), xyzMask);
+        __m128 c2 = _mm_and_ps(_mm_loadu_ps(pm+8), xyzMask);
+        __m128 t  = _mm_and_ps(_mm_loadu_ps(pm+12), xyzMask);
+
+        __m128 r0 = CrossSSE(c1, c2);
+        __m128 r1 = CrossSSE(c2, c0);
+        __m128 r2 = CrossSSE(c0, c1);
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(c0, r0, 0x7F));
+        r0 = _mm_mul_ps(r0, invDet);
+        r1 = _mm_mul_ps(r1, invDet);
+        r2 = _mm_mul_ps(r2, invDet);
+
+        // translation first, while r0..r2 are still rows
+        __m128 tx = _mm_dp_ps(r0, t, 0x71);
+        __m128 ty = _mm_dp_ps(r1, t, 0x72);
+        __m128 tz = _mm_dp_ps(r2, t, 0x74);
+        __m128 translation = _mm_sub_ps(_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), _mm_or_ps(_mm_or_ps(tx, ty), tz));
+
+        __m128 r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        float *po = &out[i][0][0];
+        _mm_storeu_ps(po,    r0);
+        _mm_storeu_ps(po+4,  r1);
+        _mm_storeu_ps(po+8,  r2);
+        _mm_storeu_ps(po+12, translation);
+    }
+}
+
+static const MatBatchTable gSSETable = {
+    MultiplySSE, MultiplySharedSSE, ComposeTRSSSE, InverseAffineSSE,
+};
+
+////// AVX2 + FMA //////
+// two output columns per register: a's columns duplicated in both 128 bit
+// lanes, weighted by b[j] in the low lane and b[j+1] in the high lane
+__attribute__((target("avx2,fma")))
+static inline __m256 TwoColumnsAVX(__m256 a0, __m256 a1, __m256 a2, __m256 a3, __m256 bb){
+    __m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(bb, 0x00));
+    result = _mm256_fmadd_ps(a1, _mm256_permute_ps(bb, 0x55), result);
+    result = _mm256_fmadd_ps(a2, _mm256_permute_ps(bb, 0xAA), result);
+    return _mm256_fmadd_ps(a3, _mm256_permute_ps(bb, 0xFF), result);
+}
+
+__attribute__((target("avx2,fma")))
+static void MultiplyAVX2(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    for(size_t i=0; i<count; i++){
+        const float *pa = &a[i][0][0];
+        const float *pb = &b[i][0][0];
+        float *po = &out[i][0][0];
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)pa);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)(pa+4));
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)(pa+8));
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)(pa+12));
+        _mm256_storeu_ps(po,   TwoColumnsAVX(a0, a1, a2, a3, _mm256_loadu_ps(pb)));
+        _mm256_storeu_ps(po+8, TwoColumnsAVX(a0, a1, a2, a3, _mm256_loadu_ps(pb+8)));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void MultiplySharedAVX2(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    const float *pa = &a[0][0];
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)pa);
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)(pa+4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)(pa+8));
+    __m256 a3 = _mm256_broadcast_ps((const __m128*)(pa+12));
+    for(size_t i=0; i<count; i++){
+        const float *pb = &b[i][0][0];
+        float *po = &out[i][0][0];
+        _mm256_storeu_ps(po,   TwoColumnsAVX(a0, a1, a2, a3, _mm256_loadu_ps(pb)));
+        _mm256_storeu_ps(po+8, TwoColumnsAVX(a0, a1, a2, a3, _mm256_loadu_ps(pb+8)));
+    }
+}
+
+// TRS and the affine inverse are per matrix 3-wide work, the SSE versions
+// already fill their registers, so AVX2 reuses them
+static const MatBatchTable gAVX2Table = {
+    MultiplyAVX2, MultiplySharedAVX2, ComposeTRSSSE, InverseAffineSSE,
+};
+#endif
+
+static MatBatchVariant DetectVariant(){
+#ifdef MATBATCH_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        return MATBATCH_AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1")){
+        return MATBATCH_SSE4;
+    }
+#endif
+    return MATBATCH_SCALAR;
+}
+
+static const MatBatchTable* TableFor(MatBatchVariant variant){
+#ifdef MATBATCH_X86
+    switch(variant){
+        case MATBATCH_AVX2: return &gAVX2Table;
+        case MATBATCH_SSE4: return &gSSETable;
+        default: break;
+    }
+#endif
+    return &gScalarTable;
+}
+
+static MatBatchVariant gMatBatchVariant = DetectVariant();
+static const MatBatchTable *gMatBatch = TableFor(gMatBatchVariant);
+
+MatBatchVariant MatBatch_GetVariant(){
+    return gMatBatchVariant;
+}
+
+void MatBatch_SetVariant(MatBatchVariant variant){
+    // never pick something the CPU can't run
+    if(variant > DetectVariant()){
+        variant = DetectVariant();
+    }
+    gMatBatchVariant = variant;
+    gMatBatch = TableFor(variant);
+}
+
+const char* MatBatch_VariantName(MatBatchVariant variant){
+    switch(variant){
+        case MATBATCH_AVX2: return "avx2";
+        case MATBATCH_SSE4: return "sse4.1";
+        default:            return "scalar";
+    }
+}
+
+void MatBatch_Multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    gMatBatch->Multiply(a, b, out, count);
+}
+
+void MatBatch_MultiplyShared(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count){
+    gMatBatch->MultiplyShared(a, b, out, count);
+}
+
+void MatBatch_ComposeTRS(const glm::vec3 *t, const glm::quat *r, const glm::vec3 *s, glm::mat4 *out, size_t count){
+    gMatBatch->ComposeTRS(t, r, s, out, count);
+}
+
+void MatBatch_InverseAffine(const glm::mat4 *in, glm::mat4 *out, size_t count){
+    gMatBatch->InverseAffine(in, out, count);
+}
@@ -0,0 +1,32 @@
+#ifndef MATRIX_BATCH_HPP
+#define MATRIX_BATCH_HPP
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <cstddef>
+
+// Array-at-a-time mat4 math. Every entry point goes through a table picked once
+// for the running CPU (AVX2+FMA, SSE4.1 or plain C++); MatBatch_SetVariant
+// forces one for benchmarking. Results match glm to float rounding.
+
+enum MatBatchVariant{
+    MATBATCH_SCALAR = 0,
+    MATBATCH_SSE4,
+    MATBATCH_AVX2,
+};
+
+MatBatchVariant MatBatch_GetVariant();
+void MatBatch_SetVariant(MatBatchVariant variant);
+const char* MatBatch_VariantName(MatBatchVariant variant);
+
+// out[i] = a[i] * b[i]
+void MatBatch_Multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count);
+// out[i] = a * b[i], e.g. view-projection * model for every visible object
+void MatBatch_MultiplyShared(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count);
+// out[i] = T(t[i]) * R(r[i]) * S(s[i]), r must be normalized
+void MatBatch_ComposeTRS(const glm::vec3 *t, const glm::quat *r, const glm::vec3 *s, glm::mat4 *out, size_t count);
+// Inverse of matrices whose last row is (0,0,0,1), any invertible upper 3x3 (scale/shear allowed)
+void MatBatch_InverseAffine(const glm::mat4 *in, glm::mat4 *out, size_t count);
+
+#endif
@@ -0,0 +1,194 @@
+#include "mesh.hpp"
+#include "gl_state.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+using namespace std;
+
+void Mesh_Translate(Mesh3D *mesh, float x, float y, float z){
+    TransformPool_Translate(&gTransformPool, mesh->m_Transform, glm::vec3(x,y,z));
+}
+
+void Mesh_Rotate(Mesh3D *mesh, float Angle, glm::vec3 axis){
+    TransformPool_Rotate(&gTransformPool, mesh->m_Transform, glm::radians(Angle), axis);
+}
+
+void Mesh_Scale(Mesh3D *mesh, float x, float y, float z){
+    TransformPool_Scale(&gTransformPool, mesh->m_Transform, glm::vec3(x,y,z));
+}
+
+void Mesh_GetWorldBounds(const Mesh3D *mesh, glm::vec3 *center, float *radius){
+    const glm::mat4 &model = Mesh_GetModelMatrix(mesh);
+    *center = glm::vec3(model * glm::vec4(mesh->m_BoundsCenter, 1.0f));
+    float scale = std::max(glm::length(glm::vec3(model[0])),
+                  std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    *radius = mesh->m_BoundsRadius * scale;
+}
+
+void Mesh_Draw(Mesh3D *mesh, const ObjectUniformRing *objects, size_t object){
+    if(mesh==nullptr || !Pipeline_IsReady(mesh->m_Pipeline)){
+        return;
+    }
+    // the matrix is already in the frame's object buffer, only its range is bound
+    if(!ObjectUniforms_Bind(objects, object)){
+        return;
+    }
+    GLState_UseProgram(mesh->m_Pipeline->m_Program);
+    GLState_BindVertexArray(mesh->m_VertexArrayObject);
+
+    // glDrawArrays(GL_TRIANGLES, 0, 6);
+    // glDrawElements(GL_TRIANGLES, 6, GL_INT, 0); try error, reported by gl_debug
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh->m_IndexCount, mesh->m_IndexType, Mesh_IndexOffset(mesh), Mesh_BaseVertex(mesh));
+    // program and VAO stay bound, gGLState skips rebinding them for the next mesh that uses the same
+}
+
+// Single interleaved VBO (position+color[+normal][+texcoord]), suballocated from the
+// arena for the vertex format. vertices/indices may point into a mapped cache file.
+static void Mesh_Upload(Mesh3D *mesh, uint32_t format, const void *vertices, size_t vertexBytes,
+                        const void *indices, size_t indexCount, uint32_t indexSize,
+                        const glm::vec3 &boundsMin, const glm::vec3 &boundsMax){
+    const uint32_t stride = VertexFormat_Stride(format);
+
+    // bounding sphere around the AABB of the positions
+    mesh->m_BoundsCenter = (boundsMin + boundsMax) * 0.5f;
+    mesh->m_BoundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+    // Setting things up on GPU
+    mesh->m_Arena = GeometryArena_ForFormat(format);
+    mesh->m_GeometryRange = GeometryArena_Allocate(mesh->m_Arena, vertices, (uint32_t)(vertexBytes / (stride*sizeof(GLfloat))),
+                                                   indices, (uint32_t)indexCount, indexSize);
+    mesh->m_VertexArrayObject = mesh->m_Arena->m_VertexArrayObject;
+    mesh->m_IndexType = indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh->m_IndexCount = (GLsizei)indexCount;
+    mesh->m_VertexFormat = format;
+    mesh->m_OwnsGeometry = true;
+    mesh->m_Transform = TransformPool_Create(&gTransformPool);
+}
+
+void Mesh_CreateFromData(Mesh3D *mesh, const MeshData *data){
+    // 16 bit indices halve the index fetch bandwidth when they fit
+    const uint32_t indexSize = MeshData_IndexSize(data);
+    vector<GLushort> shortIndices;
+    const void *indices = data->m_Indices.data();
+    if(indexSize == 2){
+        shortIndices.assign(data->m_Indices.begin(), data->m_Indices.end());
+        indices = shortIndices.data();
+    }
+    Mesh_Upload(mesh, data->m_Format, data->m_Vertices.data(), data->m_Vertices.size()*sizeof(GLfloat),
+                indices, data->m_Indices.size(), indexSize, data->m_BoundsMin, data->m_BoundsMax);
+}
+
+void Mesh_Create(Mesh3D *mesh){
+    // Lives on the CPU
+    MeshData quad;
+    quad.m_Format = VERTEX_POSITION | VERTEX_COLOR;
+    quad.m_Vertices = {
+        // Winding order CCW(is front face)
+        // 0 - Vertex
+        -0.5f, -0.5f, 0.0f,  //bottom left vertex
+        1.0f, 0.0f, 0.0f,         //color
+        // 1 - Vertex
+        0.5f, -0.5f, 0.0f,   //bottom right vertex
+        0.0f, 1.0f, 0.0f,         //color
+        // 2 - Vertex
+        -0.5f, 0.5f, 0.0f,   //top left vertex
+        0.0f, 0.0f, 1.0f,         //color
+        // 3 - Vertex
+        0.5f, 0.5f, 0.0f,  //top right vertex
+        0.0f, 0.0f, 1.0f,         //color
+    };
+    quad.m_Indices = {2,0,1, 3,2,1};  // vertices of triangle
+    MeshData_ComputeBounds(&quad);
+    Mesh_CreateFromData(mesh, &quad);
+}
+
+bool Mesh_LoadSource(MeshSource *source, const char *path){
+    // warm start: the mapped cache goes to the driver without a parse or a copy
+    if(MeshCache_Open(path, &source->m_Cache)){
+        source->m_FromCache = true;
+        source->m_Loaded = true;
+        return true;
+    }
+    if(!MeshLoader_Load(path, &source->m_Data)){
+        fprintf(stderr, "Mesh_Load: %s\n", source->m_Data.m_Error.c_str());
+        return false;
+    }
+    // a failed write (read only asset directory) only costs the next start a parse
+    MeshCache_Write(path, &source->m_Data);
+    source->m_Loaded = true;
+    return true;
+}
+
+bool Mesh_CreateFromSource(Mesh3D *mesh, MeshSource *source){
+    if(!source->m_Loaded){
+        return false;
+    }
+    if(source->m_FromCache){
+        const MeshCacheHeader *header = source->m_Cache.m_Header;
+        Mesh_Upload(mesh, header->m_Format, source->m_Cache.m_Vertices, header->m_VertexBytes,
+                    source->m_Cache.m_Indices, header->m_IndexCount, header->m_IndexSize,
+                    glm::vec3(header->m_BoundsMin[0], header->m_BoundsMin[1], header->m_BoundsMin[2]),
+                    glm::vec3(header->m_BoundsMax[0], header->m_BoundsMax[1], header->m_BoundsMax[2]));
+        MeshCache_Close(&source->m_Cache);
+    }else{
+        Mesh_CreateFromData(mesh, &source->m_Data);
+        source->m_Data = MeshData();
+    }
+    source->m_Loaded = false;
+    return true;
+}
+
+bool Mesh_Load(Mesh3D *mesh, const char *path){
+    MeshSource source;
+    return Mesh_LoadSource(&source, path) && Mesh_CreateFromSource(mesh, &source);
+}
+
+static void CopyGeometry(Mesh3D *mesh, const Mesh3D *source){
+    mesh->m_VertexArrayObject = source->m_VertexArrayObject;
+    mesh->m_Arena = source->m_Arena;
+    mesh->m_GeometryRange = source->m_GeometryRange;
+    mesh->m_IndexCount = source->m_IndexCount;
+    mesh->m_IndexType = source->m_IndexType;
+    mesh->m_VertexFormat = source->m_VertexFormat;
+    mesh->m_BoundsCenter = source->m_BoundsCenter;
+    mesh->m_BoundsRadius = source->m_BoundsRadius;
+}
+
+void Mesh_CreateInstance(Mesh3D *mesh, const Mesh3D *source){
+    CopyGeometry(mesh, source);
+    mesh->m_OwnsGeometry = false;
+    mesh->m_Transform = TransformPool_Create(&gTransformPool);
+}
+
+void Mesh_ReplaceGeometry(Mesh3D *mesh, Mesh3D *replacement, Mesh3D *const *instances, size_t instanceCount){
+    if(mesh->m_OwnsGeometry && mesh->m_Arena){
+        GeometryArena_Free(mesh->m_Arena, mesh->m_GeometryRange);
+    }
+    CopyGeometry(mesh, replacement);
+    mesh->m_OwnsGeometry = true;
+    for(size_t i=0; i<instanceCount; i++){
+        CopyGeometry(instances[i], replacement);
+    }
+    // the range now belongs to mesh, only the transform is left to release
+    replacement->m_OwnsGeometry = false;
+    Mesh_Delete(replacement);
+}
+
+void Mesh_SetPipeline(Mesh3D *mesh, Pipeline *pipeline){
+    mesh->m_Pipeline = pipeline;
+}
+
+void Mesh_Delete(Mesh3D *mesh){
+    // the arena keeps its buffers, the range goes back to its allocators
+    if(mesh->m_OwnsGeometry && mesh->m_Arena){
+        GeometryArena_Free(mesh->m_Arena, mesh->m_GeometryRange);
+    }
+    mesh->m_VertexArrayObject = 0;
+    mesh->m_Arena = nullptr;
+    mesh->m_GeometryRange = GEOMETRY_RANGE_NONE;
+    mesh->m_IndexCount = 0;
+    TransformPool_Release(&gTransformPool, mesh->m_Transform);
+    mesh->m_Transform = Transform();
+}
@@ -0,0 +1,94 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include "pipeline.hpp"
+#include "transform.hpp"
+#include "geometry_arena.hpp"
+#include "mesh_loader.hpp"
+#include "mesh_cache.hpp"
+#include "frame_uniforms.hpp"
+
+struct Mesh3D{
+    // VAO, shared by every mesh in the same arena
+    GLuint m_VertexArrayObject = 0;
+    // VBO + EBO are slices of the arena for m_VertexFormat, see Mesh_BaseVertex/Mesh_IndexOffset
+    GeometryArena *m_Arena = nullptr;
+    uint32_t m_GeometryRange = GEOMETRY_RANGE_NONE;
+    GLsizei m_IndexCount = 0;
+    // GL_UNSIGNED_SHORT when the mesh has fewer than 65536 vertices, else GL_UNSIGNED_INT
+    GLenum m_IndexType = GL_UNSIGNED_INT;
+    // VertexAttributeBits of the interleaved VBO (see mesh_loader.hpp)
+    uint32_t m_VertexFormat = 0;
+    // local space bounding sphere of the vertex positions, set by Mesh_Create
+    glm::vec3 m_BoundsCenter{0.0f};
+    float m_BoundsRadius = 0.0f;
+    // false when the range above is borrowed from another mesh (Mesh_CreateInstance)
+    bool m_OwnsGeometry = true;
+
+    Pipeline *m_Pipeline = nullptr;
+    // no material system yet, the id only groups draws in the render queue
+    uint16_t m_Material = 0;
+    // drawn after all opaque meshes, back to front with blending
+    bool m_Transparent = false;
+
+    // for glsl use uniform
+    // float m_uOffset = -1.0f;
+    Transform m_Transform;      // node in gTransformPool, allocated by Mesh_Create
+};
+
+// World matrix as of the last TransformPool_Update(&gTransformPool)
+inline const glm::mat4& Mesh_GetModelMatrix(const Mesh3D *mesh){
+    return TransformPool_World(&gTransformPool, mesh->m_Transform);
+}
+
+// Where the mesh's data sits in the arena, read at draw time since defragmentation moves it
+inline GLint Mesh_BaseVertex(const Mesh3D *mesh){
+    return GeometryArena_BaseVertex(mesh->m_Arena, mesh->m_GeometryRange);
+}
+inline const void* Mesh_IndexOffset(const Mesh3D *mesh){
+    return GeometryArena_IndexOffset(mesh->m_Arena, mesh->m_GeometryRange);
+}
+
+// Builds the built-in quad
+void Mesh_Create(Mesh3D *mesh);
+// Uploads loaded vertex/index data, picks the smallest index type that fits
+void Mesh_CreateFromData(Mesh3D *mesh, const MeshData *data);
+// Uploads from the file's binary cache when it's current, otherwise parses the file
+// and (re)writes the cache. False (and nothing created) if the file failed to load.
+bool Mesh_Load(Mesh3D *mesh, const char *path);
+
+// Mesh_Load in two halves so the file work can run on another thread while the GL
+// thread creates the window and compiles shaders
+struct MeshSource{
+    MeshCacheView m_Cache;      // mapped when the cache was current
+    MeshData m_Data;            // parsed otherwise
+    bool m_FromCache = false;
+    bool m_Loaded = false;
+};
+// No GL calls: maps the cache or parses the file and writes the cache
+bool Mesh_LoadSource(MeshSource *source, const char *path);
+// GL thread: uploads a loaded source and releases it
+bool Mesh_CreateFromSource(Mesh3D *mesh, MeshSource *source);
+// Shares source's geometry range, so both meshes can be drawn in one instanced batch
+void Mesh_CreateInstance(Mesh3D *mesh, const Mesh3D *source);
+// Moves replacement's geometry into mesh and the instances sharing mesh's range, and
+// frees the old range. mesh keeps its transform and pipeline, replacement is deleted.
+void Mesh_ReplaceGeometry(Mesh3D *mesh, Mesh3D *replacement, Mesh3D *const *instances, size_t instanceCount);
+void Mesh_SetPipeline(Mesh3D *mesh, Pipeline *pipeline);
+void Mesh_Delete(Mesh3D *mesh);
+
+void Mesh_Translate(Mesh3D *mesh, float x, float y, float z);
+void Mesh_Rotate(Mesh3D *mesh, float Angle, glm::vec3 axis);
+void Mesh_Scale(Mesh3D *mesh, float x, float y, float z);
+
+// Bounding sphere moved by the model matrix, radius grown by its largest axis scale
+void Mesh_GetWorldBounds(const Mesh3D *mesh, glm::vec3 *center, float *radius);
+
+// object is the mesh's block in this frame's objects (ObjectUniforms_Write)
+void Mesh_Draw(Mesh3D *mesh, const ObjectUniformRing *objects, size_t object);
+
+#endif
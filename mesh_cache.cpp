@@ -0,0 +1,216 @@
+#include "mesh_cache.hpp"
+#include "mesh_loader.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string CachePath(const char *sourcePath){
+    return std::string(sourcePath) + ".meshcache";
+}
+
+static int64_t ModifiedNs(const struct stat &info){
+    return (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+static size_t AlignUp(size_t value){
+    return (value + MESH_CACHE_ALIGNMENT - 1) & ~(size_t)(MESH_CACHE_ALIGNMENT - 1);
+}
+
+static bool ValidHeader(const MeshCacheHeader *header, size_t fileSize){
+    if(header->m_Magic != MESH_CACHE_MAGIC || header->m_Version != MESH_CACHE_VERSION){
+        return false;
+    }
+    if(header->m_IndexSize != 2 && header->m_IndexSize != 4){
+        return false;
+    }
+    // the dependency table sits between the header and the vertices
+    if(header->m_DependencyOffset != sizeof(MeshCacheHeader)
+       || header->m_DependencyCount > (fileSize - sizeof(MeshCacheHeader)) / sizeof(MeshCacheDependency)){
+        return false;
+    }
+    const MeshCacheDependency *dependencies = (const MeshCacheDependency*)(header + 1);
+    for(uint32_t i=0; i<header->m_DependencyCount; i++){
+        if(memchr(dependencies[i].m_Path, '\0', MESH_CACHE_PATH_LENGTH) == nullptr){
+            return false;
+        }
+    }
+    uint32_t stride = VertexFormat_Stride(header->m_Format);
+    return stride > 0
+        && header->m_VertexBytes == header->m_VertexCount * stride * sizeof(float)
+        && header->m_IndexBytes == header->m_IndexCount * header->m_IndexSize
+        && header->m_VertexOffset % MESH_CACHE_ALIGNMENT == 0
+        && header->m_IndexOffset % MESH_CACHE_ALIGNMENT == 0
+        && header->m_VertexOffset + header->m_VertexBytes <= fileSize
+        && header->m_IndexOffset + header->m_IndexBytes <= fileSize;
+}
+
+// Still the file that was recorded: same size and mtime, or after only the mtime moved
+// (checkout, copy) the same content hash. Size, mtime and hash all come from the one open,
+// the file may change again meanwhile. *touchedNs is the mtime to record, 0 if unchanged
+static bool SameSource(const char *path, uint64_t size, int64_t modifiedNs, uint64_t hash, int64_t *touchedNs){
+    *touchedNs = 0;
+    struct stat info;
+    if(stat(path, &info) != 0){
+        return false;
+    }
+    if((uint64_t)info.st_size == size && ModifiedNs(info) == modifiedNs){
+        return true;
+    }
+    FileView file;
+    if(!FileView_Open(&file, path, FILE_ACCESS_SEQUENTIAL) || file.m_Size != size || FileView_Hash(&file) != hash){
+        return false;
+    }
+    *touchedNs = file.m_ModifiedNs;
+    return true;
+}
+
+bool MeshCache_Open(const char *sourcePath, MeshCacheView *view){
+    *view = MeshCacheView();
+    std::string cachePath = CachePath(sourcePath);
+    // random until validated, a stale cache shouldn't get paged in
+    if(!FileView_Open(&view->m_File, cachePath.c_str(), FILE_ACCESS_RANDOM) || view->m_File.m_Size < sizeof(MeshCacheHeader)){
+        MeshCache_Close(view);
+        return false;
+    }
+    view->m_Header = (const MeshCacheHeader*)view->m_File.m_Data;
+    if(!ValidHeader(view->m_Header, view->m_File.m_Size)){
+        fprintf(stderr, "MeshCache: %s is stale or corrupt, rebuilding\n", cachePath.c_str());
+        MeshCache_Close(view);
+        return false;
+    }
+
+    // no source next to the cache (shipped without it): the cache is all we have
+    struct stat sourceInfo;
+    if(stat(sourcePath, &sourceInfo) == 0){
+        const MeshCacheHeader *header = view->m_Header;
+        // cache file offset and new mtime of each file that was only touched
+        std::vector<std::pair<size_t, int64_t>> touched;
+        int64_t touchedNs;
+        const char *changed = sourcePath;
+        bool same = SameSource(sourcePath, header->m_SourceSize, header->m_SourceModifiedNs, header->m_SourceHash, &touchedNs);
+        if(same && touchedNs != 0){
+            touched.push_back({offsetof(MeshCacheHeader, m_SourceModifiedNs), touchedNs});
+        }
+        // a buffer edited on its own must invalidate the cache as well
+        const MeshCacheDependency *dependencies = (const MeshCacheDependency*)(header + 1);
+        std::string directory = DirectoryOf(sourcePath);
+        std::string dependencyPath;
+        for(uint32_t i=0; same && i<header->m_DependencyCount; i++){
+            const MeshCacheDependency &dependency = dependencies[i];
+            dependencyPath = directory + dependency.m_Path;
+            changed = dependencyPath.c_str();
+            same = SameSource(changed, dependency.m_Size, dependency.m_ModifiedNs, dependency.m_Hash, &touchedNs);
+            if(same && touchedNs != 0){
+                touched.push_back({header->m_DependencyOffset + i*sizeof(MeshCacheDependency) + offsetof(MeshCacheDependency, m_ModifiedNs), touchedNs});
+            }
+        }
+        if(!same){
+            fprintf(stderr, "MeshCache: %s changed, rebuilding\n", changed);
+            MeshCache_Close(view);
+            return false;
+        }
+        // remember the new mtimes so the next start takes the fast path, if that fails
+        // (read only cache) the next start hashes again
+        int writeFd = touched.empty() ? -1 : open(cachePath.c_str(), O_WRONLY);
+        if(writeFd >= 0){
+            for(const auto &entry : touched){
+                if(pwrite(writeFd, &entry.second, sizeof(entry.second), entry.first) != (ssize_t)sizeof(entry.second)){
+                    fprintf(stderr, "MeshCache: could not refresh %s\n", cachePath.c_str());
+                    break;
+                }
+            }
+            close(writeFd);
+        }
+    }
+
+    // the whole file is about to be handed to the driver, start paging it in now
+    FileView_Advise(&view->m_File, FILE_ACCESS_WILLNEED);
+    view->m_Vertices = view->m_File.m_Data + view->m_Header->m_VertexOffset;
+    view->m_Indices = view->m_File.m_Data + view->m_Header->m_IndexOffset;
+    return true;
+}
+
+void MeshCache_Close(MeshCacheView *view){
+    *view = MeshCacheView();
+}
+
+static bool WritePadded(FILE *file, const void *data, size_t bytes, size_t *offset){
+    static const uint8_t zeros[MESH_CACHE_ALIGNMENT] = {};
+    size_t padding = AlignUp(*offset) - *offset;
+    if(fwrite(zeros, 1, padding, file) != padding || fwrite(data, 1, bytes, file) != bytes){
+        return false;
+    }
+    *offset += padding + bytes;
+    return true;
+}
+
+bool MeshCache_Write(const char *sourcePath, const MeshData *data){
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.m_Magic = MESH_CACHE_MAGIC;
+    header.m_Version = MESH_CACHE_VERSION;
+    // identity of the bytes data was parsed from, not of the files as they are now
+    header.m_SourceHash = data->m_Source.m_Hash;
+    header.m_SourceSize = data->m_Source.m_Size;
+    header.m_SourceModifiedNs = data->m_Source.m_ModifiedNs;
+    std::vector<MeshCacheDependency> dependencies(data->m_Buffers.size());
+    for(size_t i=0; i<dependencies.size(); i++){
+        const MeshSourceFile &buffer = data->m_Buffers[i];
+        if(buffer.m_Path.size() >= MESH_CACHE_PATH_LENGTH){
+            fprintf(stderr, "MeshCache: buffer path %s too long to cache\n", buffer.m_Path.c_str());
+            return false;
+        }
+        memset(&dependencies[i], 0, sizeof(MeshCacheDependency));
+        dependencies[i].m_Hash = buffer.m_Hash;
+        dependencies[i].m_Size = buffer.m_Size;
+        dependencies[i].m_ModifiedNs = buffer.m_ModifiedNs;
+        memcpy(dependencies[i].m_Path, buffer.m_Path.c_str(), buffer.m_Path.size() + 1);
+    }
+    header.m_DependencyCount = (uint32_t)dependencies.size();
+    header.m_DependencyOffset = sizeof(MeshCacheHeader);
+    header.m_Format = data->m_Format;
+    header.m_IndexSize = MeshData_IndexSize(data);
+    header.m_VertexCount = data->m_Vertices.size() / VertexFormat_Stride(data->m_Format);
+    header.m_IndexCount = data->m_Indices.size();
+    header.m_VertexBytes = data->m_Vertices.size() * sizeof(float);
+    header.m_IndexBytes = header.m_IndexCount * header.m_IndexSize;
+    header.m_VertexOffset = AlignUp(sizeof(MeshCacheHeader) + dependencies.size()*sizeof(MeshCacheDependency));
+    header.m_IndexOffset = AlignUp(header.m_VertexOffset + header.m_VertexBytes);
+    memcpy(header.m_BoundsMin, &data->m_BoundsMin[0], sizeof(header.m_BoundsMin));
+    memcpy(header.m_BoundsMax, &data->m_BoundsMax[0], sizeof(header.m_BoundsMax));
+
+    std::vector<uint16_t> shortIndices;
+    const void *indices = data->m_Indices.data();
+    if(header.m_IndexSize == 2){
+        shortIndices.assign(data->m_Indices.begin(), data->m_Indices.end());
+        indices = shortIndices.data();
+    }
+
+    // written aside and renamed, a crash mid write never leaves a truncated cache behind
+    std::string cachePath = CachePath(sourcePath);
+    std::string tempPath = cachePath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if(file == nullptr){
+        fprintf(stderr, "MeshCache: could not create %s\n", tempPath.c_str());
+        return false;
+    }
+    size_t offset = sizeof(header) + dependencies.size()*sizeof(MeshCacheDependency);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                && fwrite(dependencies.data(), sizeof(MeshCacheDependency), dependencies.size(), file) == dependencies.size()
+                && WritePadded(file, data->m_Vertices.data(), header.m_VertexBytes, &offset)
+                && WritePadded(file, indices, header.m_IndexBytes, &offset);
+    written = fclose(file) == 0 && written;
+    if(!written || rename(tempPath.c_str(), cachePath.c_str()) != 0){
+        fprintf(stderr, "MeshCache: could not write %s\n", cachePath.c_str());
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util.h"
+
+struct MeshData;
+
+// Binary mesh container written next to the source as "<source>.meshcache".
+// Layout: MeshCacheHeader, the MeshCacheDependency table, then the vertex and index
+// blobs, each starting on a MESH_CACHE_ALIGNMENT boundary. Indices are stored in their final GL type, so a
+// mapped file is handed to glBufferData as is.
+#define MESH_CACHE_MAGIC 0x4843534Du     // "MSCH" little endian
+#define MESH_CACHE_VERSION 2
+#define MESH_CACHE_ALIGNMENT 64
+#define MESH_CACHE_PATH_LENGTH 256      // longer buffer URIs aren't cached
+
+struct MeshCacheHeader{
+    uint32_t m_Magic;
+    uint32_t m_Version;
+    // source file identity: size+mtime is the fast check, the content hash decides
+    uint64_t m_SourceHash;
+    uint64_t m_SourceSize;
+    int64_t m_SourceModifiedNs;
+    uint32_t m_Format;          // VertexAttributeBits
+    uint32_t m_IndexSize;       // 2 or 4 bytes
+    uint64_t m_VertexCount;
+    uint64_t m_IndexCount;
+    uint64_t m_VertexOffset;    // bytes from the start of the file
+    uint64_t m_VertexBytes;
+    uint64_t m_IndexOffset;
+    uint64_t m_IndexBytes;
+    float m_BoundsMin[3];
+    float m_BoundsMax[3];
+    uint32_t m_DependencyCount;
+    uint32_t m_Reserved;
+    uint64_t m_DependencyOffset;
+};
+
+// Another file the mesh was built from (a glTF's external .bin buffer), checked like the source
+struct MeshCacheDependency{
+    uint64_t m_Hash;
+    uint64_t m_Size;
+    int64_t m_ModifiedNs;
+    char m_Path[MESH_CACHE_PATH_LENGTH];    // relative to the source's directory, NUL terminated
+};
+
+// Read-only mapping of a validated cache file, pointers stay valid until MeshCache_Close
+// (or the view is destroyed)
+struct MeshCacheView{
+    FileView m_File;
+    const MeshCacheHeader *m_Header = nullptr;
+    const void *m_Vertices = nullptr;
+    const void *m_Indices = nullptr;
+};
+
+// Maps "<sourcePath>.meshcache" if it exists, has the current version and was built from
+// the current source and buffers. A changed mtime alone doesn't invalidate it, the content
+// hash is compared first (and the stored mtime refreshed on a match).
+bool MeshCache_Open(const char *sourcePath, MeshCacheView *view);
+void MeshCache_Close(MeshCacheView *view);
+
+// Writes the container for data (indices narrowed to 16 bit when every index fits), the
+// source and buffer identities are the ones MeshLoader recorded in data
+bool MeshCache_Write(const char *sourcePath, const MeshData *data);
+
+#endif
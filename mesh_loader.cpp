@@ -0,0 +1,902 @@
+#include "mesh_loader.hpp"
+#include "util.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+uint32_t VertexFormat_Stride(uint32_t format){
+    uint32_t stride = 0;
+    if(format & VERTEX_POSITION) stride += 3;
+    if(format & VERTEX_COLOR)    stride += 3;
+    if(format & VERTEX_NORMAL)   stride += 3;
+    if(format & VERTEX_TEXCOORD) stride += 2;
+    return stride;
+}
+
+int VertexFormat_Offset(uint32_t format, uint32_t attribute){
+    if(!(format & attribute)){
+        return -1;
+    }
+    // everything ordered before the attribute
+    return (int)VertexFormat_Stride(format & (attribute - 1));
+}
+
+void MeshData_ComputeBounds(MeshData *data){
+    uint32_t stride = VertexFormat_Stride(data->m_Format);
+    if(data->m_Vertices.empty()){
+        data->m_BoundsMin = data->m_BoundsMax = glm::vec3(0.0f);
+        return;
+    }
+    glm::vec3 boundsMin(data->m_Vertices[0], data->m_Vertices[1], data->m_Vertices[2]);
+    glm::vec3 boundsMax = boundsMin;
+    for(size_t i=0; i<data->m_Vertices.size(); i+=stride){
+        glm::vec3 position(data->m_Vertices[i], data->m_Vertices[i+1], data->m_Vertices[i+2]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+    data->m_BoundsMin = boundsMin;
+    data->m_BoundsMax = boundsMax;
+}
+
+uint32_t MeshData_IndexSize(const MeshData *data){
+    size_t vertexCount = data->m_Vertices.size() / VertexFormat_Stride(data->m_Format);
+    return vertexCount <= 65536 ? 2 : 4;
+}
+
+static bool EndsWith(const std::string &text, const char *suffix){
+    size_t length = strlen(suffix);
+    if(text.size() < length){
+        return false;
+    }
+    for(size_t i=0; i<length; i++){
+        if(tolower((unsigned char)text[text.size()-length+i]) != suffix[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MeshLoader_Load(const char *path, MeshData *out){
+    std::string name(path);
+    if(EndsWith(name, ".obj")){
+        return MeshLoader_LoadOBJ(path, out);
+    }
+    if(EndsWith(name, ".gltf") || EndsWith(name, ".glb")){
+        return MeshLoader_LoadGLTF(path, out);
+    }
+    out->m_Error = "unknown mesh format: " + name;
+    return false;
+}
+
+// Hashed from the bytes being parsed, a reread could see a newer file
+static MeshSourceFile RecordSource(const std::string &path, const FileView *file){
+    MeshSourceFile source;
+    source.m_Path = path;
+    source.m_Hash = FileView_Hash(file);
+    source.m_Size = file->m_Size;
+    source.m_ModifiedNs = file->m_ModifiedNs;
+    return source;
+}
+
+// Fills the color slot from the normal (or white) when the source has none
+static void WriteVertex(float *dst, uint32_t format, const float *position, const float *color,
+                        const float *normal, const float *texcoord){
+    dst[0] = position[0];
+    dst[1] = position[1];
+    dst[2] = position[2];
+    if(color){
+        dst[3] = color[0];
+        dst[4] = color[1];
+        dst[5] = color[2];
+    }else if(normal){
+        dst[3] = normal[0]*0.5f + 0.5f;
+        dst[4] = normal[1]*0.5f + 0.5f;
+        dst[5] = normal[2]*0.5f + 0.5f;
+    }else{
+        dst[3] = dst[4] = dst[5] = 1.0f;
+    }
+    float *next = dst + 6;
+    if(format & VERTEX_NORMAL){
+        next[0] = normal ? normal[0] : 0.0f;
+        next[1] = normal ? normal[1] : 0.0f;
+        next[2] = normal ? normal[2] : 1.0f;
+        next += 3;
+    }
+    if(format & VERTEX_TEXCOORD){
+        next[0] = texcoord ? texcoord[0] : 0.0f;
+        next[1] = texcoord ? texcoord[1] : 0.0f;
+    }
+}
+
+////// OBJ //////
+
+// strtof is locale aware and noticeably slower, OBJ floats are plain decimals
+static const char* ParseFloat(const char *p, const char *end, float *out){
+    while(p < end && (*p == ' ' || *p == '\t')) p++;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    double value = 0.0;
+    while(p < end && *p >= '0' && *p <= '9'){
+        value = value*10.0 + (*p++ - '0');
+    }
+    if(p < end && *p == '.'){
+        p++;
+        double scale = 0.1;
+        while(p < end && *p >= '0' && *p <= '9'){
+            value += (*p++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+        p++;
+        bool negativeExponent = false;
+        if(p < end && (*p == '-' || *p == '+')){
+            negativeExponent = *p == '-';
+            p++;
+        }
+        int exponent = 0;
+        while(p < end && *p >= '0' && *p <= '9'){
+            exponent = exponent*10 + (*p++ - '0');
+        }
+        value *= pow(10.0, negativeExponent ? -exponent : exponent);
+    }
+    *out = (float)(negative ? -value : value);
+    return p;
+}
+
+static const char* ParseInt(const char *p, const char *end, int *out){
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    int value = 0;
+    while(p < end && *p >= '0' && *p <= '9'){
+        value = value*10 + (*p++ - '0');
+    }
+    *out = negative ? -value : value;
+    return p;
+}
+
+// One face corner, indices 1-based as in the file until resolved (0 = absent)
+struct ObjCorner{
+    int m_Position;
+    int m_Texcoord;
+    int m_Normal;
+};
+
+// Corner as parsed: a relative (negative) index can point before the chunk's first
+// element, so it's kept as a 0-based chunk local index (possibly negative) with its
+// bit set in m_Relative, and made absolute once every chunk's prefix offset is known
+struct ObjFaceCorner{
+    ObjCorner m_Index;
+    uint8_t m_Relative;     // 1 position, 2 texcoord, 4 normal
+};
+
+struct ObjChunk{
+    const char *m_Begin = nullptr;
+    const char *m_End = nullptr;
+    std::vector<float> m_Positions;     // xyz per v
+    std::vector<float> m_Colors;        // rgb per v, only if the chunk had "v x y z r g b"
+    std::vector<float> m_Texcoords;     // uv per vt
+    std::vector<float> m_Normals;       // xyz per vn
+    std::vector<ObjFaceCorner> m_Corners;   // 3 per triangle
+    bool m_HasColors = false;
+    bool m_ShortVertex = false;         // a "v" line with fewer than 3 numbers, the file is rejected
+};
+
+// Negative OBJ indices count back from the last element read so far
+static inline int LocalIndex(int index, size_t localCount, uint8_t bit, uint8_t *relative){
+    if(index < 0){
+        *relative |= bit;
+        return (int)localCount + index;
+    }
+    return index;
+}
+
+// -> 0-based absolute, -1 when absent (OBJ indices are 1-based, 0 never appears)
+static inline int ResolveIndex(int index, bool relative, size_t base){
+    if(relative) return (int)base + index;
+    return index - 1;
+}
+
+static void ParseObjChunk(ObjChunk *chunk){
+    const char *p = chunk->m_Begin;
+    const char *end = chunk->m_End;
+    std::vector<ObjFaceCorner> polygon;
+    while(p < end){
+        const char *lineEnd = (const char*)memchr(p, '\n', end - p);
+        if(lineEnd == nullptr){
+            lineEnd = end;
+        }
+        while(p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+
+        if(lineEnd - p > 2 && p[0] == 'v' && p[1] == ' '){
+            float values[6] = {};
+            int count = 0;
+            const char *q = p + 2;
+            while(count < 6){
+                while(q < lineEnd && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+                if(q >= lineEnd) break;
+                q = ParseFloat(q, lineEnd, &values[count++]);
+            }
+            // skipping it would shift every later vertex index
+            if(count < 3){
+                chunk->m_ShortVertex = true;
+                break;
+            }
+            chunk->m_Positions.insert(chunk->m_Positions.end(), values, values + 3);
+            if(count == 6){
+                // keep m_Colors aligned with m_Positions once the first color shows up
+                if(!chunk->m_HasColors){
+                    chunk->m_Colors.assign(chunk->m_Positions.size() - 3, 1.0f);
+                    chunk->m_HasColors = true;
+                }
+                chunk->m_Colors.insert(chunk->m_Colors.end(), values + 3, values + 6);
+            }else if(chunk->m_HasColors){
+                chunk->m_Colors.insert(chunk->m_Colors.end(), 3, 1.0f);
+            }
+        }else if(lineEnd - p > 3 && p[0] == 'v' && p[1] == 't' && p[2] == ' '){
+            float u = 0.0f, v = 0.0f;
+            const char *q = ParseFloat(p + 3, lineEnd, &u);
+            ParseFloat(q, lineEnd, &v);
+            chunk->m_Texcoords.push_back(u);
+            chunk->m_Texcoords.push_back(v);
+        }else if(lineEnd - p > 3 && p[0] == 'v' && p[1] == 'n' && p[2] == ' '){
+            float n[3];
+            const char *q = p + 3;
+            for(int i=0; i<3; i++){
+                q = ParseFloat(q, lineEnd, &n[i]);
+            }
+            chunk->m_Normals.insert(chunk->m_Normals.end(), n, n + 3);
+        }else if(lineEnd - p > 2 && p[0] == 'f' && p[1] == ' '){
+            polygon.clear();
+            const char *q = p + 2;
+            while(true){
+                while(q < lineEnd && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+                if(q >= lineEnd) break;
+                ObjFaceCorner corner = {{0, 0, 0}, 0};
+                ObjCorner &index = corner.m_Index;
+                q = ParseInt(q, lineEnd, &index.m_Position);
+                if(q < lineEnd && *q == '/'){
+                    q++;
+                    if(q < lineEnd && *q != '/'){
+                        q = ParseInt(q, lineEnd, &index.m_Texcoord);
+                    }
+                    if(q < lineEnd && *q == '/'){
+                        q = ParseInt(q + 1, lineEnd, &index.m_Normal);
+                    }
+                }
+                index.m_Position = LocalIndex(index.m_Position, chunk->m_Positions.size()/3, 1, &corner.m_Relative);
+                index.m_Texcoord = LocalIndex(index.m_Texcoord, chunk->m_Texcoords.size()/2, 2, &corner.m_Relative);
+                index.m_Normal = LocalIndex(index.m_Normal, chunk->m_Normals.size()/3, 4, &corner.m_Relative);
+                polygon.push_back(corner);
+                while(q < lineEnd && *q != ' ' && *q != '\t') q++;
+            }
+            for(size_t i=2; i<polygon.size(); i++){
+                chunk->m_Corners.push_back(polygon[0]);
+                chunk->m_Corners.push_back(polygon[i-1]);
+                chunk->m_Corners.push_back(polygon[i]);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+// Open addressing over resolved (position, texcoord, normal) triplets. The home
+// slot is anchored at the position index with the texcoord/normal hash as a small
+// offset: faces reference nearby positions, so probes stay close together instead
+// of touching a random cache line of a table much bigger than the cache.
+struct CornerEntry{
+    ObjCorner m_Corner;
+    uint32_t m_Vertex;      // ~0u marks an empty slot
+};
+
+struct CornerTable{
+    std::vector<CornerEntry> m_Entries;
+    size_t m_Mask = 0;
+    size_t m_Count = 0;
+};
+
+static inline size_t CornerHomeSlot(const ObjCorner &corner, size_t mask){
+    uint64_t attributes = ((uint64_t)(uint32_t)corner.m_Texcoord << 32) | (uint32_t)corner.m_Normal;
+    attributes *= 0x9E3779B97F4A7C15ull;
+    return ((size_t)corner.m_Position * 2 + (size_t)(attributes >> 61)) & mask;
+}
+
+static void CornerTable_Init(CornerTable *table, size_t capacity){
+    table->m_Entries.assign(capacity, CornerEntry{{0, 0, 0}, ~0u});
+    table->m_Mask = capacity - 1;
+    table->m_Count = 0;
+}
+
+static void CornerTable_Grow(CornerTable *table){
+    std::vector<CornerEntry> entries;
+    entries.swap(table->m_Entries);
+    CornerTable_Init(table, entries.size() * 2);
+    for(const CornerEntry &entry : entries){
+        if(entry.m_Vertex == ~0u){
+            continue;
+        }
+        size_t slot = CornerHomeSlot(entry.m_Corner, table->m_Mask);
+        while(table->m_Entries[slot].m_Vertex != ~0u){
+            slot = (slot + 1) & table->m_Mask;
+        }
+        table->m_Entries[slot] = entry;
+        table->m_Count++;
+    }
+}
+
+// Returns the vertex of an identical corner, or stores newVertex and returns it
+static uint32_t CornerTable_Insert(CornerTable *table, const ObjCorner &corner, uint32_t newVertex){
+    size_t slot = CornerHomeSlot(corner, table->m_Mask);
+    while(true){
+        CornerEntry &entry = table->m_Entries[slot];
+        if(entry.m_Vertex == ~0u){
+            break;
+        }
+        if(entry.m_Corner.m_Position == corner.m_Position && entry.m_Corner.m_Texcoord == corner.m_Texcoord
+           && entry.m_Corner.m_Normal == corner.m_Normal){
+            return entry.m_Vertex;
+        }
+        slot = (slot + 1) & table->m_Mask;
+    }
+    table->m_Entries[slot] = CornerEntry{corner, newVertex};
+    if(++table->m_Count * 2 > table->m_Entries.size()){
+        CornerTable_Grow(table);
+    }
+    return newVertex;
+}
+
+bool MeshLoader_LoadOBJ(const char *path, MeshData *out){
+    // parsed straight out of the mapping
+    FileView contents;
+    if(!FileView_Open(&contents, path, FILE_ACCESS_SEQUENTIAL, &out->m_Error)){
+        return false;
+    }
+    out->m_Source = RecordSource(path, &contents);
+
+    // split at newlines, one chunk per hardware thread
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t minChunk = 1 << 20;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads, contents.m_Size / minChunk));
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char *begin = contents.m_Data;
+    const char *end = begin + contents.m_Size;
+    const char *cursor = begin;
+    for(size_t c=0; c<chunkCount; c++){
+        const char *chunkEnd = c+1 == chunkCount ? end : begin + contents.m_Size * (c+1) / chunkCount;
+        if(chunkEnd < end){
+            const char *newline = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        chunks[c].m_Begin = cursor;
+        chunks[c].m_End = std::max(cursor, chunkEnd);
+        cursor = chunks[c].m_End;
+    }
+
+    std::vector<std::thread> workers;
+    for(size_t c=1; c<chunkCount; c++){
+        workers.emplace_back(ParseObjChunk, &chunks[c]);
+    }
+    ParseObjChunk(&chunks[0]);
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+
+    for(const ObjChunk &chunk : chunks){
+        if(chunk.m_ShortVertex){
+            out->m_Error = std::string(path) + ": vertex with fewer than 3 coordinates";
+            return false;
+        }
+    }
+
+    // gather the element arrays (prefix offsets make chunk-local indices absolute)
+    std::vector<float> positions, colors, texcoords, normals;
+    bool hasColors = false;
+    for(const ObjChunk &chunk : chunks){
+        hasColors |= chunk.m_HasColors;
+    }
+    std::vector<size_t> positionBase(chunkCount), texcoordBase(chunkCount), normalBase(chunkCount);
+    size_t cornerCount = 0;
+    for(size_t c=0; c<chunkCount; c++){
+        ObjChunk &chunk = chunks[c];
+        positionBase[c] = positions.size()/3;
+        texcoordBase[c] = texcoords.size()/2;
+        normalBase[c] = normals.size()/3;
+        if(hasColors){
+            if(chunk.m_HasColors){
+                colors.insert(colors.end(), chunk.m_Colors.begin(), chunk.m_Colors.end());
+            }else{
+                colors.insert(colors.end(), chunk.m_Positions.size(), 1.0f);
+            }
+        }
+        positions.insert(positions.end(), chunk.m_Positions.begin(), chunk.m_Positions.end());
+        texcoords.insert(texcoords.end(), chunk.m_Texcoords.begin(), chunk.m_Texcoords.end());
+        normals.insert(normals.end(), chunk.m_Normals.begin(), chunk.m_Normals.end());
+        cornerCount += chunk.m_Corners.size();
+        std::vector<float>().swap(chunk.m_Positions);
+        std::vector<float>().swap(chunk.m_Colors);
+        std::vector<float>().swap(chunk.m_Texcoords);
+        std::vector<float>().swap(chunk.m_Normals);
+    }
+    size_t positionCount = positions.size()/3;
+    size_t texcoordCount = texcoords.size()/2;
+    size_t normalCount = normals.size()/3;
+    if(positionCount == 0 || cornerCount == 0){
+        out->m_Error = std::string(path) + ": no faces";
+        return false;
+    }
+
+    out->m_Format = VERTEX_POSITION | VERTEX_COLOR;
+    if(normalCount > 0) out->m_Format |= VERTEX_NORMAL;
+    if(texcoordCount > 0) out->m_Format |= VERTEX_TEXCOORD;
+    uint32_t stride = VertexFormat_Stride(out->m_Format);
+
+    // merge identical corners, sized for one vertex per position (smooth meshes) and
+    // grown when half full
+    CornerTable table;
+    size_t capacity = 1024;
+    while(capacity < positionCount * 2){
+        capacity <<= 1;
+    }
+    CornerTable_Init(&table, capacity);
+
+    size_t vertexCount = 0;
+    out->m_Vertices.clear();
+    out->m_Vertices.reserve(positionCount * stride);
+    out->m_Indices.resize(cornerCount);
+
+    size_t written = 0;
+    for(size_t c=0; c<chunkCount; c++){
+        for(const ObjFaceCorner &local : chunks[c].m_Corners){
+            ObjCorner corner;
+            corner.m_Position = ResolveIndex(local.m_Index.m_Position, local.m_Relative & 1, positionBase[c]);
+            corner.m_Texcoord = ResolveIndex(local.m_Index.m_Texcoord, local.m_Relative & 2, texcoordBase[c]);
+            corner.m_Normal = ResolveIndex(local.m_Index.m_Normal, local.m_Relative & 4, normalBase[c]);
+            bool relativeUnderflow = ((local.m_Relative & 2) && corner.m_Texcoord < 0)
+                                  || ((local.m_Relative & 4) && corner.m_Normal < 0);
+            if(corner.m_Position < 0 || (size_t)corner.m_Position >= positionCount || relativeUnderflow
+               || corner.m_Texcoord < -1 || corner.m_Texcoord >= (int)texcoordCount
+               || corner.m_Normal < -1 || corner.m_Normal >= (int)normalCount){
+                out->m_Error = std::string(path) + ": face index out of range";
+                return false;
+            }
+
+            uint32_t vertex = CornerTable_Insert(&table, corner, (uint32_t)vertexCount);
+            if(vertex == vertexCount){
+                vertexCount++;
+                size_t base = out->m_Vertices.size();
+                out->m_Vertices.resize(base + stride);
+                WriteVertex(&out->m_Vertices[base], out->m_Format,
+                            &positions[corner.m_Position*3],
+                            hasColors ? &colors[corner.m_Position*3] : nullptr,
+                            corner.m_Normal >= 0 ? &normals[corner.m_Normal*3] : nullptr,
+                            corner.m_Texcoord >= 0 ? &texcoords[corner.m_Texcoord*2] : nullptr);
+            }
+            out->m_Indices[written++] = vertex;
+        }
+    }
+
+    MeshData_ComputeBounds(out);
+    return true;
+}
+
+////// glTF //////
+
+// Just enough JSON for glTF: a DOM of numbers, strings, arrays and objects
+struct JsonValue{
+    enum Type{ JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+    Type m_Type = JSON_NULL;
+    double m_Number = 0.0;
+    std::string m_String;
+    std::vector<JsonValue> m_Array;
+    std::vector<std::pair<std::string, JsonValue>> m_Object;
+
+    const JsonValue* Find(const char *key) const{
+        for(const auto &member : m_Object){
+            if(member.first == key){
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+    // fallback too when the number isn't an integer in int range (casting one is undefined)
+    int Int(const char *key, int fallback) const{
+        const JsonValue *value = Find(key);
+        if(value == nullptr || value->m_Type != JSON_NUMBER){
+            return fallback;
+        }
+        double number = value->m_Number;
+        bool integral = number >= -2147483648.0 && number <= 2147483647.0 && number == std::floor(number);
+        return integral ? (int)number : fallback;
+    }
+    // counts and byte offsets: fallback when missing, false unless a non-negative integer
+    bool Size(const char *key, size_t fallback, size_t *out) const{
+        const JsonValue *value = Find(key);
+        if(value == nullptr){
+            *out = fallback;
+            return true;
+        }
+        double number = value->m_Number;
+        if(value->m_Type != JSON_NUMBER || !(number >= 0.0 && number <= 9007199254740992.0) || number != std::floor(number)){
+            return false;
+        }
+        *out = (size_t)number;
+        return true;
+    }
+};
+
+struct JsonParser{
+    const char *m_Cursor;
+    const char *m_End;
+    bool m_Failed = false;
+
+    void SkipSpace(){
+        while(m_Cursor < m_End && (*m_Cursor == ' ' || *m_Cursor == '\t' || *m_Cursor == '\n' || *m_Cursor == '\r')){
+            m_Cursor++;
+        }
+    }
+    bool Expect(char c){
+        SkipSpace();
+        if(m_Cursor < m_End && *m_Cursor == c){
+            m_Cursor++;
+            return true;
+        }
+        m_Failed = true;
+        return false;
+    }
+    void ParseString(std::string *out){
+        if(!Expect('"')){
+            return;
+        }
+        while(m_Cursor < m_End && *m_Cursor != '"'){
+            char c = *m_Cursor++;
+            if(c == '\\' && m_Cursor < m_End){
+                char escaped = *m_Cursor++;
+                switch(escaped){
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': c = '?'; m_Cursor = std::min(m_End, m_Cursor + 4); break;  // names in glTF are ASCII
+                    default:  c = escaped; break;
+                }
+            }
+            out->push_back(c);
+        }
+        Expect('"');
+    }
+    void Parse(JsonValue *out){
+        SkipSpace();
+        if(m_Cursor >= m_End){
+            m_Failed = true;
+            return;
+        }
+        char c = *m_Cursor;
+        if(c == '{'){
+            out->m_Type = JsonValue::JSON_OBJECT;
+            m_Cursor++;
+            SkipSpace();
+            if(m_Cursor < m_End && *m_Cursor == '}'){
+                m_Cursor++;
+                return;
+            }
+            while(!m_Failed){
+                out->m_Object.emplace_back();
+                ParseString(&out->m_Object.back().first);
+                Expect(':');
+                Parse(&out->m_Object.back().second);
+                SkipSpace();
+                if(m_Cursor < m_End && *m_Cursor == ','){
+                    m_Cursor++;
+                    continue;
+                }
+                Expect('}');
+                break;
+            }
+        }else if(c == '['){
+            out->m_Type = JsonValue::JSON_ARRAY;
+            m_Cursor++;
+            SkipSpace();
+            if(m_Cursor < m_End && *m_Cursor == ']'){
+                m_Cursor++;
+                return;
+            }
+            while(!m_Failed){
+                out->m_Array.emplace_back();
+                Parse(&out->m_Array.back());
+                SkipSpace();
+                if(m_Cursor < m_End && *m_Cursor == ','){
+                    m_Cursor++;
+                    continue;
+                }
+                Expect(']');
+                break;
+            }
+        }else if(c == '"'){
+            out->m_Type = JsonValue::JSON_STRING;
+            ParseString(&out->m_String);
+        }else if(c == 't' || c == 'f' || c == 'n'){
+            const char *word = c == 't' ? "true" : c == 'f' ? "false" : "null";
+            size_t length = strlen(word);
+            if((size_t)(m_End - m_Cursor) < length || strncmp(m_Cursor, word, length) != 0){
+                m_Failed = true;
+                return;
+            }
+            out->m_Type = c == 'n' ? JsonValue::JSON_NULL : JsonValue::JSON_BOOL;
+            out->m_Number = c == 't';
+            m_Cursor += length;
+        }else{
+            out->m_Type = JsonValue::JSON_NUMBER;
+            // bounded by m_End, the mapped file isn't NUL terminated (strtod could read past it)
+            std::from_chars_result result = std::from_chars(m_Cursor, m_End, out->m_Number);
+            if(result.ec != std::errc() || result.ptr == m_Cursor){
+                m_Failed = true;
+                return;
+            }
+            m_Cursor = result.ptr;
+        }
+    }
+};
+
+#define GLTF_BYTE           5120
+#define GLTF_UNSIGNED_BYTE  5121
+#define GLTF_SHORT          5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT   5125
+#define GLTF_FLOAT          5126
+#define GLTF_TRIANGLES      4
+
+struct GltfAccessor{
+    const uint8_t *m_Data = nullptr;
+    size_t m_Count = 0;
+    size_t m_Stride = 0;
+    int m_ComponentType = 0;
+    int m_Components = 0;
+    bool m_Normalized = false;
+};
+
+static int ComponentCount(const std::string &type){
+    if(type == "SCALAR") return 1;
+    if(type == "VEC2") return 2;
+    if(type == "VEC3") return 3;
+    if(type == "VEC4") return 4;
+    return 0;
+}
+
+static int ComponentSize(int componentType){
+    switch(componentType){
+        case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+    }
+    return 0;
+}
+
+// a glTF buffer, inside the .glb or an external .bin view
+struct GltfBuffer{
+    const char *m_Data;
+    size_t m_Size;
+};
+
+static bool ResolveAccessor(const JsonValue &root, const std::vector<GltfBuffer> &buffers, int index, GltfAccessor *out){
+    const JsonValue *accessors = root.Find("accessors");
+    const JsonValue *views = root.Find("bufferViews");
+    if(!accessors || !views || index < 0 || index >= (int)accessors->m_Array.size()){
+        return false;
+    }
+    const JsonValue &accessor = accessors->m_Array[index];
+    int viewIndex = accessor.Int("bufferView", -1);
+    if(viewIndex < 0 || viewIndex >= (int)views->m_Array.size()){
+        return false;   // sparse-only accessors aren't supported
+    }
+    const JsonValue &view = views->m_Array[viewIndex];
+    int bufferIndex = view.Int("buffer", -1);
+    if(bufferIndex < 0 || bufferIndex >= (int)buffers.size()){
+        return false;
+    }
+
+    const JsonValue *type = accessor.Find("type");
+    const JsonValue *normalized = accessor.Find("normalized");
+    out->m_ComponentType = accessor.Int("componentType", 0);
+    out->m_Components = type ? ComponentCount(type->m_String) : 0;
+    out->m_Normalized = normalized && normalized->m_Number != 0.0;
+    size_t viewOffset, accessorOffset;
+    if(!accessor.Size("count", 0, &out->m_Count) || !view.Size("byteStride", 0, &out->m_Stride)
+       || !view.Size("byteOffset", 0, &viewOffset) || !accessor.Size("byteOffset", 0, &accessorOffset)){
+        return false;
+    }
+    size_t elementSize = (size_t)ComponentSize(out->m_ComponentType) * out->m_Components;
+    if(out->m_Stride == 0){
+        out->m_Stride = elementSize;
+    }
+    // every step compared against what is left of the buffer, nothing here can wrap
+    const GltfBuffer &buffer = buffers[bufferIndex];
+    if(elementSize == 0 || viewOffset > buffer.m_Size || accessorOffset > buffer.m_Size - viewOffset){
+        return false;
+    }
+    size_t offset = viewOffset + accessorOffset;
+    size_t left = buffer.m_Size - offset;
+    if(out->m_Count > 0 && (elementSize > left || out->m_Count - 1 > (left - elementSize) / out->m_Stride)){
+        return false;
+    }
+    out->m_Data = (const uint8_t*)buffer.m_Data + offset;
+    return true;
+}
+
+static float ReadComponent(const GltfAccessor &accessor, size_t element, int component){
+    const uint8_t *p = accessor.m_Data + element*accessor.m_Stride + component*ComponentSize(accessor.m_ComponentType);
+    switch(accessor.m_ComponentType){
+        case GLTF_FLOAT:{ float v; memcpy(&v, p, 4); return v; }
+        case GLTF_UNSIGNED_BYTE:{ return accessor.m_Normalized ? *p / 255.0f : *p; }
+        case GLTF_BYTE:{ int8_t v = (int8_t)*p; return accessor.m_Normalized ? std::max(v / 127.0f, -1.0f) : v; }
+        case GLTF_UNSIGNED_SHORT:{ uint16_t v; memcpy(&v, p, 2); return accessor.m_Normalized ? v / 65535.0f : v; }
+        case GLTF_SHORT:{ int16_t v; memcpy(&v, p, 2); return accessor.m_Normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+        case GLTF_UNSIGNED_INT:{ uint32_t v; memcpy(&v, p, 4); return (float)v; }
+    }
+    return 0.0f;
+}
+
+static uint32_t ReadIndex(const GltfAccessor &accessor, size_t element){
+    const uint8_t *p = accessor.m_Data + element*accessor.m_Stride;
+    switch(accessor.m_ComponentType){
+        case GLTF_UNSIGNED_BYTE:  return *p;
+        case GLTF_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return v; }
+        case GLTF_UNSIGNED_INT:   { uint32_t v; memcpy(&v, p, 4); return v; }
+    }
+    return 0;
+}
+
+bool MeshLoader_LoadGLTF(const char *path, MeshData *out){
+    FileView file;
+    if(!FileView_Open(&file, path, FILE_ACCESS_SEQUENTIAL, &out->m_Error)){
+        return false;
+    }
+    out->m_Source = RecordSource(path, &file);
+
+    // .glb: 12 byte header, then a JSON chunk and an optional BIN chunk, both used in place
+    GltfBuffer json = {file.m_Data, file.m_Size};
+    GltfBuffer glbBinary = {nullptr, 0};
+    bool isBinary = file.m_Size >= 12 && memcmp(file.m_Data, "glTF", 4) == 0;
+    if(isBinary){
+        json = {nullptr, 0};
+        size_t offset = 12;
+        while(offset + 8 <= file.m_Size){
+            uint32_t length, type;
+            memcpy(&length, file.m_Data + offset, 4);
+            memcpy(&type, file.m_Data + offset + 4, 4);
+            if(offset + 8 + length > file.m_Size){
+                break;
+            }
+            if(type == 0x4E4F534A){         // "JSON"
+                json = {file.m_Data + offset + 8, length};
+            }else if(type == 0x004E4942){   // "BIN\0"
+                glbBinary = {file.m_Data + offset + 8, length};
+            }
+            offset += 8 + length;
+        }
+    }
+
+    JsonValue root;
+    JsonParser parser{json.m_Data, json.m_Data + json.m_Size};
+    parser.Parse(&root);
+    if(json.m_Data == nullptr || parser.m_Failed || root.m_Type != JsonValue::JSON_OBJECT){
+        out->m_Error = std::string(path) + ": malformed glTF JSON";
+        return false;
+    }
+
+    // external .bin files stay open (mapped) until the vertices are copied out
+    std::vector<GltfBuffer> buffers;
+    std::vector<FileView> bufferFiles;
+    if(const JsonValue *bufferList = root.Find("buffers")){
+        std::string directory = DirectoryOf(path);
+        for(const JsonValue &buffer : bufferList->m_Array){
+            const JsonValue *uri = buffer.Find("uri");
+            if(uri == nullptr){
+                buffers.push_back(glbBinary);
+                continue;
+            }
+            if(uri->m_String.compare(0, 5, "data:") == 0){
+                out->m_Error = std::string(path) + ": embedded data URIs are not supported";
+                return false;
+            }
+            bufferFiles.emplace_back();
+            if(!FileView_Open(&bufferFiles.back(), (directory + uri->m_String).c_str(), FILE_ACCESS_RANDOM, &out->m_Error)){
+                return false;
+            }
+            buffers.push_back({bufferFiles.back().m_Data, bufferFiles.back().m_Size});
+            out->m_Buffers.push_back(RecordSource(uri->m_String, &bufferFiles.back()));
+        }
+    }
+
+    // first pass: which attributes exist anywhere, so every vertex shares one format
+    const JsonValue *meshes = root.Find("meshes");
+    if(meshes == nullptr){
+        out->m_Error = std::string(path) + ": no meshes";
+        return false;
+    }
+    out->m_Format = VERTEX_POSITION | VERTEX_COLOR;
+    for(const JsonValue &mesh : meshes->m_Array){
+        const JsonValue *primitives = mesh.Find("primitives");
+        for(size_t p=0; primitives && p<primitives->m_Array.size(); p++){
+            const JsonValue *attributes = primitives->m_Array[p].Find("attributes");
+            if(attributes && attributes->Find("NORMAL")) out->m_Format |= VERTEX_NORMAL;
+            if(attributes && attributes->Find("TEXCOORD_0")) out->m_Format |= VERTEX_TEXCOORD;
+        }
+    }
+    uint32_t stride = VertexFormat_Stride(out->m_Format);
+    out->m_Vertices.clear();
+    out->m_Indices.clear();
+
+    // glTF primitives are already indexed, vertices are copied as they are
+    for(const JsonValue &mesh : meshes->m_Array){
+        const JsonValue *primitives = mesh.Find("primitives");
+        for(size_t p=0; primitives && p<primitives->m_Array.size(); p++){
+            const JsonValue &primitive = primitives->m_Array[p];
+            const JsonValue *attributes = primitive.Find("attributes");
+            if(primitive.Int("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES || attributes == nullptr){
+                continue;
+            }
+            GltfAccessor position, normal, texcoord, color;
+            if(!ResolveAccessor(root, buffers, attributes->Int("POSITION", -1), &position)
+               || position.m_Components != 3){
+                out->m_Error = std::string(path) + ": primitive without a usable POSITION";
+                return false;
+            }
+            bool hasNormal = ResolveAccessor(root, buffers, attributes->Int("NORMAL", -1), &normal);
+            bool hasTexcoord = ResolveAccessor(root, buffers, attributes->Int("TEXCOORD_0", -1), &texcoord);
+            bool hasColor = ResolveAccessor(root, buffers, attributes->Int("COLOR_0", -1), &color);
+
+            size_t baseVertex = out->m_Vertices.size() / stride;
+            out->m_Vertices.resize((baseVertex + position.m_Count) * stride);
+            for(size_t v=0; v<position.m_Count; v++){
+                float p3[3], c3[3], n3[3], t2[2];
+                for(int i=0; i<3; i++){
+                    p3[i] = ReadComponent(position, v, i);
+                    if(hasColor)  c3[i] = v < color.m_Count ? ReadComponent(color, v, i) : 1.0f;
+                    if(hasNormal) n3[i] = v < normal.m_Count ? ReadComponent(normal, v, i) : 0.0f;
+                }
+                if(hasTexcoord){
+                    t2[0] = v < texcoord.m_Count ? ReadComponent(texcoord, v, 0) : 0.0f;
+                    t2[1] = v < texcoord.m_Count ? ReadComponent(texcoord, v, 1) : 0.0f;
+                }
+                WriteVertex(&out->m_Vertices[(baseVertex + v)*stride], out->m_Format, p3,
+                            hasColor ? c3 : nullptr, hasNormal ? n3 : nullptr, hasTexcoord ? t2 : nullptr);
+            }
+
+            GltfAccessor indices;
+            if(ResolveAccessor(root, buffers, primitive.Int("indices", -1), &indices)){
+                size_t first = out->m_Indices.size();
+                out->m_Indices.resize(first + indices.m_Count / 3 * 3);
+                for(size_t i=0; i<indices.m_Count / 3 * 3; i++){
+                    uint32_t index = ReadIndex(indices, i);
+                    if(index >= position.m_Count){
+                        out->m_Error = std::string(path) + ": index out of range";
+                        return false;
+                    }
+                    out->m_Indices[first + i] = (uint32_t)baseVertex + index;
+                }
+            }else{
+                for(size_t i=0; i<position.m_Count / 3 * 3; i++){
+                    out->m_Indices.push_back((uint32_t)(baseVertex + i));
+                }
+            }
+        }
+    }
+
+    if(out->m_Indices.empty()){
+        out->m_Error = std::string(path) + ": no triangle primitives";
+        return false;
+    }
+    MeshData_ComputeBounds(out);
+    return true;
+}
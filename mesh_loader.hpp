@@ -0,0 +1,64 @@
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Interleaved vertex layout, attributes appear in this order when present.
+// Position and color are always there (the shaders read locations 0 and 1).
+enum VertexAttributeBits{
+    VERTEX_POSITION = 1 << 0,   // location 0, 3 floats
+    VERTEX_COLOR    = 1 << 1,   // location 1, 3 floats
+    VERTEX_NORMAL   = 1 << 2,   // location 6, 3 floats
+    VERTEX_TEXCOORD = 1 << 3,   // location 7, 2 floats
+};
+#define VERTEX_NORMAL_LOCATION 6
+#define VERTEX_TEXCOORD_LOCATION 7
+
+// floats per vertex for a VertexAttributeBits mask
+uint32_t VertexFormat_Stride(uint32_t format);
+// float offset of one attribute inside a vertex, -1 if the format lacks it
+int VertexFormat_Offset(uint32_t format, uint32_t attribute);
+
+// A file a mesh was read from, as it was parsed. The mesh cache is validated against these
+struct MeshSourceFile{
+    std::string m_Path;         // as opened for the source, relative to its directory for glTF buffers
+    uint64_t m_Hash = 0;
+    uint64_t m_Size = 0;
+    int64_t m_ModifiedNs = 0;
+};
+
+// CPU side result of a load, handed to Mesh_CreateFromData
+struct MeshData{
+    uint32_t m_Format = VERTEX_POSITION | VERTEX_COLOR;
+    std::vector<float> m_Vertices;      // interleaved, VertexFormat_Stride(m_Format) floats each
+    std::vector<uint32_t> m_Indices;    // triangle list
+    glm::vec3 m_BoundsMin{0.0f};
+    glm::vec3 m_BoundsMax{0.0f};
+    std::string m_Error;                // set when a load returns false
+    MeshSourceFile m_Source;
+    std::vector<MeshSourceFile> m_Buffers;  // external glTF buffers (.bin), by URI
+};
+
+// Picks the parser from the extension: .obj, .gltf or .glb
+bool MeshLoader_Load(const char *path, MeshData *out);
+
+// Wavefront OBJ (v/vt/vn/f, polygons fan triangulated, "v x y z r g b" colors).
+// The file is split at line boundaries and parsed on all hardware threads,
+// then identical v/vt/vn corners are merged through a hash table.
+bool MeshLoader_LoadOBJ(const char *path, MeshData *out);
+
+// glTF 2.0, .gltf with external .bin buffers or a single .glb. Every
+// triangle primitive of every mesh is merged into one MeshData (node
+// transforms are not applied).
+bool MeshLoader_LoadGLTF(const char *path, MeshData *out);
+
+// Recomputes m_BoundsMin/m_BoundsMax from the positions
+void MeshData_ComputeBounds(MeshData *data);
+// Bytes per index on the GPU: 2 when the mesh has at most 65536 vertices, else 4
+uint32_t MeshData_IndexSize(const MeshData *data);
+
+#endif
@@ -0,0 +1,322 @@
+#include "offset_allocator.hpp"
+
+#include <cassert>
+
+// size -> bin index, sizes below 8 map exactly, above that 8 bins per power of two
+static uint32_t SizeToBinRoundUp(uint32_t size){
+    if(size < OFFSET_ALLOCATOR_LEAF_BINS){
+        return size;
+    }
+    uint32_t highestBit = 31 - __builtin_clz(size);
+    uint32_t mantissaShift = highestBit - 3;
+    uint32_t bin = ((mantissaShift + 1) << 3) + ((size >> mantissaShift) & 7);
+    // round up when bits below the mantissa are set, a carry moves to the next exponent
+    if(size & ((1u << mantissaShift) - 1)){
+        bin++;
+    }
+    return bin;
+}
+
+static uint32_t SizeToBinRoundDown(uint32_t size){
+    if(size < OFFSET_ALLOCATOR_LEAF_BINS){
+        return size;
+    }
+    uint32_t highestBit = 31 - __builtin_clz(size);
+    uint32_t mantissaShift = highestBit - 3;
+    return ((mantissaShift + 1) << 3) + ((size >> mantissaShift) & 7);
+}
+
+static inline uint32_t LowestBitAfter(uint32_t mask, uint32_t start){
+    uint32_t masked = start >= 32 ? 0 : mask & (~0u << start);
+    return masked ? __builtin_ctz(masked) : OFFSET_ALLOCATOR_NONE;
+}
+
+static uint32_t NewNode(OffsetAllocator *allocator){
+    if(!allocator->m_FreeNodes.empty()){
+        uint32_t node = allocator->m_FreeNodes.back();
+        allocator->m_FreeNodes.pop_back();
+        allocator->m_Nodes[node] = OffsetAllocatorNode();
+        return node;
+    }
+    allocator->m_Nodes.emplace_back();
+    return (uint32_t)allocator->m_Nodes.size() - 1;
+}
+
+static void ReleaseNode(OffsetAllocator *allocator, uint32_t node){
+    allocator->m_FreeNodes.push_back(node);
+}
+
+static void InsertIntoBin(OffsetAllocator *allocator, uint32_t node){
+    OffsetAllocatorNode &entry = allocator->m_Nodes[node];
+    uint32_t bin = SizeToBinRoundDown(entry.m_Size);
+    uint32_t top = bin >> 3, leaf = bin & 7;
+    allocator->m_TopBinMask |= 1u << top;
+    allocator->m_LeafBinMasks[top] |= (uint8_t)(1u << leaf);
+
+    uint32_t head = allocator->m_BinHeads[bin];
+    entry.m_BinPrev = OFFSET_ALLOCATOR_NONE;
+    entry.m_BinNext = head;
+    if(head != OFFSET_ALLOCATOR_NONE){
+        allocator->m_Nodes[head].m_BinPrev = node;
+    }
+    allocator->m_BinHeads[bin] = node;
+    allocator->m_FreeRegions++;
+}
+
+static void RemoveFromBin(OffsetAllocator *allocator, uint32_t node){
+    OffsetAllocatorNode &entry = allocator->m_Nodes[node];
+    if(entry.m_BinPrev != OFFSET_ALLOCATOR_NONE){
+        allocator->m_Nodes[entry.m_BinPrev].m_BinNext = entry.m_BinNext;
+    }else{
+        uint32_t bin = SizeToBinRoundDown(entry.m_Size);
+        allocator->m_BinHeads[bin] = entry.m_BinNext;
+        if(entry.m_BinNext == OFFSET_ALLOCATOR_NONE){
+            uint32_t top = bin >> 3, leaf = bin & 7;
+            allocator->m_LeafBinMasks[top] &= (uint8_t)~(1u << leaf);
+            if(allocator->m_LeafBinMasks[top] == 0){
+                allocator->m_TopBinMask &= ~(1u << top);
+            }
+        }
+    }
+    if(entry.m_BinNext != OFFSET_ALLOCATOR_NONE){
+        allocator->m_Nodes[entry.m_BinNext].m_BinPrev = entry.m_BinPrev;
+    }
+    entry.m_BinPrev = entry.m_BinNext = OFFSET_ALLOCATOR_NONE;
+    allocator->m_FreeRegions--;
+}
+
+void OffsetAllocator_Create(OffsetAllocator *allocator, uint32_t size){
+    *allocator = OffsetAllocator();
+    for(uint32_t &head : allocator->m_BinHeads){
+        head = OFFSET_ALLOCATOR_NONE;
+    }
+    allocator->m_Size = size;
+    if(size == 0){
+        return;
+    }
+    uint32_t node = NewNode(allocator);
+    allocator->m_Nodes[node].m_Size = size;
+    allocator->m_Head = allocator->m_Tail = node;
+    InsertIntoBin(allocator, node);
+}
+
+OffsetAllocation OffsetAllocator_Allocate(OffsetAllocator *allocator, uint32_t size, uint32_t userData){
+    OffsetAllocation allocation;
+    if(size == 0){
+        return allocation;
+    }
+
+    // smallest bin whose every region is guaranteed to fit
+    uint32_t minBin = SizeToBinRoundUp(size);
+    uint32_t top = minBin >> 3;
+    if(top >= OFFSET_ALLOCATOR_TOP_BINS){
+        return allocation;
+    }
+    uint32_t leaf = LowestBitAfter(allocator->m_LeafBinMasks[top], minBin & 7);
+    if(leaf == OFFSET_ALLOCATOR_NONE){
+        top = LowestBitAfter(allocator->m_TopBinMask, top + 1);
+        if(top == OFFSET_ALLOCATOR_NONE){
+            return allocation;
+        }
+        leaf = __builtin_ctz(allocator->m_LeafBinMasks[top]);
+    }
+    uint32_t node = allocator->m_BinHeads[(top << 3) | leaf];
+    RemoveFromBin(allocator, node);
+
+    // split off the tail end as a new free region
+    OffsetAllocatorNode &entry = allocator->m_Nodes[node];
+    uint32_t remainder = entry.m_Size - size;
+    entry.m_Size = size;
+    entry.m_Used = true;
+    entry.m_UserData = userData;
+    if(remainder > 0){
+        uint32_t split = NewNode(allocator);
+        OffsetAllocatorNode &splitEntry = allocator->m_Nodes[split];
+        OffsetAllocatorNode &usedEntry = allocator->m_Nodes[node];    // NewNode may have reallocated
+        splitEntry.m_Offset = usedEntry.m_Offset + size;
+        splitEntry.m_Size = remainder;
+        splitEntry.m_NeighborPrev = node;
+        splitEntry.m_NeighborNext = usedEntry.m_NeighborNext;
+        if(usedEntry.m_NeighborNext != OFFSET_ALLOCATOR_NONE){
+            allocator->m_Nodes[usedEntry.m_NeighborNext].m_NeighborPrev = split;
+        }else{
+            allocator->m_Tail = split;
+        }
+        usedEntry.m_NeighborNext = split;
+        InsertIntoBin(allocator, split);
+    }
+
+    allocator->m_Used += size;
+    allocator->m_Allocations++;
+    allocation.m_Offset = allocator->m_Nodes[node].m_Offset;
+    allocation.m_Node = node;
+    return allocation;
+}
+
+void OffsetAllocator_Free(OffsetAllocator *allocator, OffsetAllocation allocation){
+    if(allocation.m_Node == OFFSET_ALLOCATOR_NONE){
+        return;
+    }
+    uint32_t node = allocation.m_Node;
+    OffsetAllocatorNode *entry = &allocator->m_Nodes[node];
+    assert(entry->m_Used);
+    allocator->m_Used -= entry->m_Size;
+    allocator->m_Allocations--;
+    entry->m_Used = false;
+
+    // coalesce with free neighbors, the freed node absorbs them
+    uint32_t prev = entry->m_NeighborPrev;
+    if(prev != OFFSET_ALLOCATOR_NONE && !allocator->m_Nodes[prev].m_Used){
+        OffsetAllocatorNode &prevEntry = allocator->m_Nodes[prev];
+        RemoveFromBin(allocator, prev);
+        entry->m_Offset = prevEntry.m_Offset;
+        entry->m_Size += prevEntry.m_Size;
+        entry->m_NeighborPrev = prevEntry.m_NeighborPrev;
+        if(prevEntry.m_NeighborPrev != OFFSET_ALLOCATOR_NONE){
+            allocator->m_Nodes[prevEntry.m_NeighborPrev].m_NeighborNext = node;
+        }else{
+            allocator->m_Head = node;
+        }
+        ReleaseNode(allocator, prev);
+    }
+    uint32_t next = entry->m_NeighborNext;
+    if(next != OFFSET_ALLOCATOR_NONE && !allocator->m_Nodes[next].m_Used){
+        OffsetAllocatorNode &nextEntry = allocator->m_Nodes[next];
+        RemoveFromBin(allocator, next);
+        entry->m_Size += nextEntry.m_Size;
+        entry->m_NeighborNext = nextEntry.m_NeighborNext;
+        if(nextEntry.m_NeighborNext != OFFSET_ALLOCATOR_NONE){
+            allocator->m_Nodes[nextEntry.m_NeighborNext].m_NeighborPrev = node;
+        }else{
+            allocator->m_Tail = node;
+        }
+        ReleaseNode(allocator, next);
+    }
+    InsertIntoBin(allocator, node);
+}
+
+void OffsetAllocator_Grow(OffsetAllocator *allocator, uint32_t newSize){
+    if(newSize <= allocator->m_Size){
+        return;
+    }
+    uint32_t extra = newSize - allocator->m_Size;
+    uint32_t tail = allocator->m_Tail;
+    if(tail != OFFSET_ALLOCATOR_NONE && !allocator->m_Nodes[tail].m_Used){
+        RemoveFromBin(allocator, tail);
+        allocator->m_Nodes[tail].m_Size += extra;
+        InsertIntoBin(allocator, tail);
+    }else{
+        uint32_t node = NewNode(allocator);
+        OffsetAllocatorNode &entry = allocator->m_Nodes[node];
+        entry.m_Offset = allocator->m_Size;
+        entry.m_Size = extra;
+        entry.m_NeighborPrev = tail;
+        if(tail != OFFSET_ALLOCATOR_NONE){
+            allocator->m_Nodes[tail].m_NeighborNext = node;
+        }else{
+            allocator->m_Head = node;
+        }
+        allocator->m_Tail = node;
+        InsertIntoBin(allocator, node);
+    }
+    allocator->m_Size = newSize;
+}
+
+uint32_t OffsetAllocator_AllocationSize(const OffsetAllocator *allocator, OffsetAllocation allocation){
+    if(allocation.m_Node == OFFSET_ALLOCATOR_NONE){
+        return 0;
+    }
+    return allocator->m_Nodes[allocation.m_Node].m_Size;
+}
+
+OffsetAllocation OffsetAllocator_FirstMovable(const OffsetAllocator *allocator, OffsetAllocation from){
+    OffsetAllocation allocation;
+    // packed already: no holes, or a single hole at the very end
+    if(allocator->m_FreeRegions == 0 || (allocator->m_FreeRegions == 1 && !allocator->m_Nodes[allocator->m_Tail].m_Used)){
+        return allocation;
+    }
+    uint32_t start = from.m_Node != OFFSET_ALLOCATOR_NONE ? from.m_Node : allocator->m_Head;
+    for(uint32_t node = start; node != OFFSET_ALLOCATOR_NONE; node = allocator->m_Nodes[node].m_NeighborNext){
+        const OffsetAllocatorNode &entry = allocator->m_Nodes[node];
+        if(entry.m_Used && entry.m_NeighborPrev != OFFSET_ALLOCATOR_NONE && !allocator->m_Nodes[entry.m_NeighborPrev].m_Used){
+            allocation.m_Offset = entry.m_Offset;
+            allocation.m_Node = node;
+            return allocation;
+        }
+    }
+    return allocation;
+}
+
+OffsetAllocation OffsetAllocator_SlideDown(OffsetAllocator *allocator, OffsetAllocation allocation){
+    uint32_t node = allocation.m_Node;
+    uint32_t hole = allocator->m_Nodes[node].m_NeighborPrev;
+    if(hole == OFFSET_ALLOCATOR_NONE || allocator->m_Nodes[hole].m_Used){
+        return allocation;
+    }
+    RemoveFromBin(allocator, hole);
+
+    // before: before - hole - node - after, after: before - node - hole - after
+    OffsetAllocatorNode &entry = allocator->m_Nodes[node];
+    OffsetAllocatorNode &holeEntry = allocator->m_Nodes[hole];
+    uint32_t before = holeEntry.m_NeighborPrev;
+    uint32_t after = entry.m_NeighborNext;
+    entry.m_Offset = holeEntry.m_Offset;
+    holeEntry.m_Offset = entry.m_Offset + entry.m_Size;
+
+    entry.m_NeighborPrev = before;
+    entry.m_NeighborNext = hole;
+    holeEntry.m_NeighborPrev = node;
+    holeEntry.m_NeighborNext = after;
+    if(before != OFFSET_ALLOCATOR_NONE){
+        allocator->m_Nodes[before].m_NeighborNext = node;
+    }else{
+        allocator->m_Head = node;
+    }
+    if(after != OFFSET_ALLOCATOR_NONE){
+        allocator->m_Nodes[after].m_NeighborPrev = hole;
+    }else{
+        allocator->m_Tail = hole;
+    }
+
+    // the hole may now touch the next free region
+    if(after != OFFSET_ALLOCATOR_NONE && !allocator->m_Nodes[after].m_Used){
+        OffsetAllocatorNode &afterEntry = allocator->m_Nodes[after];
+        RemoveFromBin(allocator, after);
+        holeEntry.m_Size += afterEntry.m_Size;
+        holeEntry.m_NeighborNext = afterEntry.m_NeighborNext;
+        if(afterEntry.m_NeighborNext != OFFSET_ALLOCATOR_NONE){
+            allocator->m_Nodes[afterEntry.m_NeighborNext].m_NeighborPrev = hole;
+        }else{
+            allocator->m_Tail = hole;
+        }
+        ReleaseNode(allocator, after);
+    }
+    InsertIntoBin(allocator, hole);
+
+    allocation.m_Offset = entry.m_Offset;
+    return allocation;
+}
+
+OffsetAllocatorStats OffsetAllocator_GetStats(const OffsetAllocator *allocator){
+    OffsetAllocatorStats stats;
+    stats.m_Size = allocator->m_Size;
+    stats.m_Used = allocator->m_Used;
+    stats.m_Free = allocator->m_Size - allocator->m_Used;
+    stats.m_FreeRegions = allocator->m_FreeRegions;
+    stats.m_Allocations = allocator->m_Allocations;
+    // the largest region sits in the highest non-empty bin, only that bin is walked
+    if(allocator->m_TopBinMask){
+        uint32_t top = 31 - __builtin_clz(allocator->m_TopBinMask);
+        uint32_t leaf = 31 - __builtin_clz((uint32_t)allocator->m_LeafBinMasks[top]);
+        for(uint32_t node = allocator->m_BinHeads[(top << 3) | leaf]; node != OFFSET_ALLOCATOR_NONE;
+            node = allocator->m_Nodes[node].m_BinNext){
+            if(allocator->m_Nodes[node].m_Size > stats.m_LargestFree){
+                stats.m_LargestFree = allocator->m_Nodes[node].m_Size;
+            }
+        }
+    }
+    if(stats.m_Free > 0){
+        stats.m_Fragmentation = 1.0f - (float)stats.m_LargestFree / (float)stats.m_Free;
+    }
+    return stats;
+}
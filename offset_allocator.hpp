@@ -0,0 +1,78 @@
+#ifndef OFFSET_ALLOCATOR_HPP
+#define OFFSET_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define OFFSET_ALLOCATOR_NONE 0xFFFFFFFFu
+
+// Two level segregated fit (TLSF) allocator over an abstract range of units,
+// no memory of its own: it only hands out offsets (vertices, indices, bytes).
+// Sizes are binned like tiny floats, 5 exponent bits and 3 mantissa bits, so
+// allocate and free are O(1) with two bitmask scans.
+#define OFFSET_ALLOCATOR_TOP_BINS 32
+#define OFFSET_ALLOCATOR_LEAF_BINS 8
+#define OFFSET_ALLOCATOR_BINS (OFFSET_ALLOCATOR_TOP_BINS * OFFSET_ALLOCATOR_LEAF_BINS)
+
+struct OffsetAllocation{
+    uint32_t m_Offset = OFFSET_ALLOCATOR_NONE;
+    uint32_t m_Node = OFFSET_ALLOCATOR_NONE;    // pass back to free
+};
+
+// Every region, free or used, in address order through the neighbor links
+struct OffsetAllocatorNode{
+    uint32_t m_Offset = 0;
+    uint32_t m_Size = 0;
+    uint32_t m_BinPrev = OFFSET_ALLOCATOR_NONE;
+    uint32_t m_BinNext = OFFSET_ALLOCATOR_NONE;
+    uint32_t m_NeighborPrev = OFFSET_ALLOCATOR_NONE;
+    uint32_t m_NeighborNext = OFFSET_ALLOCATOR_NONE;
+    uint32_t m_UserData = 0;
+    bool m_Used = false;
+};
+
+struct OffsetAllocatorStats{
+    uint32_t m_Size = 0;
+    uint32_t m_Used = 0;
+    uint32_t m_Free = 0;
+    uint32_t m_LargestFree = 0;
+    uint32_t m_FreeRegions = 0;
+    uint32_t m_Allocations = 0;
+    // 0 = all free space in one block, close to 1 = scattered in small holes
+    float m_Fragmentation = 0.0f;
+};
+
+struct OffsetAllocator{
+    uint32_t m_Size = 0;
+    uint32_t m_Used = 0;
+    uint32_t m_Allocations = 0;
+    uint32_t m_FreeRegions = 0;
+    uint32_t m_TopBinMask = 0;
+    uint8_t m_LeafBinMasks[OFFSET_ALLOCATOR_TOP_BINS] = {};
+    uint32_t m_BinHeads[OFFSET_ALLOCATOR_BINS];
+    std::vector<OffsetAllocatorNode> m_Nodes;
+    std::vector<uint32_t> m_FreeNodes;      // unused slots of m_Nodes
+    uint32_t m_Head = OFFSET_ALLOCATOR_NONE;    // region at offset 0
+    uint32_t m_Tail = OFFSET_ALLOCATOR_NONE;    // region ending at m_Size
+};
+
+void OffsetAllocator_Create(OffsetAllocator *allocator, uint32_t size);
+// m_Offset == OFFSET_ALLOCATOR_NONE when no free region is big enough
+OffsetAllocation OffsetAllocator_Allocate(OffsetAllocator *allocator, uint32_t size, uint32_t userData = 0);
+void OffsetAllocator_Free(OffsetAllocator *allocator, OffsetAllocation allocation);
+// Extends the range, existing offsets stay valid
+void OffsetAllocator_Grow(OffsetAllocator *allocator, uint32_t newSize);
+uint32_t OffsetAllocator_AllocationSize(const OffsetAllocator *allocator, OffsetAllocation allocation);
+
+// Compaction: the lowest used region that has a free region right before it, or
+// m_Node == NONE when everything used is already packed at the front. Passing the
+// allocation just slid down continues the walk from there instead of from offset 0.
+OffsetAllocation OffsetAllocator_FirstMovable(const OffsetAllocator *allocator, OffsetAllocation from = OffsetAllocation());
+// Moves a used region down over the free region before it (the caller copies the
+// data, source and destination may overlap). Returns the new allocation.
+OffsetAllocation OffsetAllocator_SlideDown(OffsetAllocator *allocator, OffsetAllocation allocation);
+
+OffsetAllocatorStats OffsetAllocator_GetStats(const OffsetAllocator *allocator);
+
+#endif
@@ -0,0 +1,356 @@
+#include "pipeline.hpp"
+#include "program_cache.hpp"
+#include "gl_ext.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static std::string GetShaderInfoLog(GLuint shader){
+    GLint length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    std::string log(length > 0 ? length : 0, '\0');
+    if(length > 0){
+        glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+    }
+    return log;
+}
+
+static std::string GetProgramInfoLog(GLuint program){
+    GLint length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    std::string log(length > 0 ? length : 0, '\0');
+    if(length > 0){
+        glGetProgramInfoLog(program, length, nullptr, &log[0]);
+    }
+    return log;
+}
+
+static const char* StageName(GLuint type){
+    return type==GL_VERTEX_SHADER ? "Vertex" : "Fragment";
+}
+
+// queues the compile, the driver may still be working on it when this returns
+static GLuint SubmitShader(GLuint type, const std::string &source){
+    GLuint shaderObject = glCreateShader(type);
+    const char *src = source.c_str();
+    glShaderSource(shaderObject, 1, &src, NULL);
+    glCompileShader(shaderObject);
+    return shaderObject;
+}
+
+// waits for the compile if it's still running, deletes the shader on failure
+static bool CheckShader(GLuint shaderObject, GLuint type, const char *file, std::string *infoLog){
+    GLint status = GL_FALSE;
+    glGetShaderiv(shaderObject, GL_COMPILE_STATUS, &status);
+    if(status != GL_TRUE){
+        std::string log = GetShaderInfoLog(shaderObject);
+        fprintf(stderr, "%s shader %s failed to compile:\n%s\n", StageName(type), file ? file : "", log.c_str());
+        if(infoLog){
+            *infoLog += log;
+        }
+        glDeleteShader(shaderObject);
+        return false;
+    }
+    return true;
+}
+
+GLuint CompileShader(GLuint type, const std::string &source, std::string *infoLog){
+    GLuint shaderObject = SubmitShader(type, source);
+    return CheckShader(shaderObject, type, nullptr, infoLog) ? shaderObject : 0;
+}
+
+// validation depends on the GL state at the time of the call, so a failure here
+// is only reported, the program is still usable
+static void ValidateProgram(GLuint programObject, const char *vertexFile, const char *fragmentFile, std::string *infoLog){
+    GLint status = GL_FALSE;
+    glValidateProgram(programObject);
+    glGetProgramiv(programObject, GL_VALIDATE_STATUS, &status);
+    if(status != GL_TRUE){
+        std::string log = GetProgramInfoLog(programObject);
+        fprintf(stderr, "Program (%s, %s) failed validation:\n%s\n", vertexFile, fragmentFile, log.c_str());
+        if(infoLog){
+            *infoLog += log;
+        }
+    }
+}
+
+GLuint CreateShaderProgram(const char *vertexFile, const char *fragmentFile, std::string *infoLog){
+    Pipeline pipeline;
+    Pipeline_Create(&pipeline, vertexFile, fragmentFile);
+    if(infoLog){
+        *infoLog += pipeline.m_InfoLog;
+    }
+    return pipeline.m_Program;
+}
+
+// "u_Lights[0]" is reported for arrays, we hash the bare name
+static uint32_t HashVariableName(const char *name, GLsizei length){
+    std::string bare(name, length);
+    size_t bracket = bare.find('[');
+    if(bracket != std::string::npos){
+        bare.resize(bracket);
+    }
+    return HashName(bare.c_str());
+}
+
+static bool CompareHash(const PipelineVariable &a, const PipelineVariable &b){
+    return a.m_NameHash < b.m_NameHash;
+}
+
+void Pipeline_Reflect(Pipeline *pipeline){
+    GLuint program = pipeline->m_Program;
+    pipeline->m_Uniforms.clear();
+    pipeline->m_Attributes.clear();
+    pipeline->m_UniformBlocks.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> name(maxLength > 0 ? maxLength : 1);
+    for(GLint i=0; i<count; i++){
+        PipelineVariable uniform;
+        GLsizei length = 0;
+        glGetActiveUniform(program, i, (GLsizei)name.size(), &length, &uniform.m_Size, &uniform.m_Type, name.data());
+        // members of uniform blocks have no location, they're bound through the block instead
+        uniform.m_Location = glGetUniformLocation(program, name.data());
+        if(uniform.m_Location < 0){
+            continue;
+        }
+        uniform.m_NameHash = HashVariableName(name.data(), length);
+        pipeline->m_Uniforms.push_back(uniform);
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    name.resize(maxLength > 0 ? maxLength : 1);
+    for(GLint i=0; i<count; i++){
+        PipelineVariable attribute;
+        GLsizei length = 0;
+        glGetActiveAttrib(program, i, (GLsizei)name.size(), &length, &attribute.m_Size, &attribute.m_Type, name.data());
+        attribute.m_Location = glGetAttribLocation(program, name.data());
+        attribute.m_NameHash = HashVariableName(name.data(), length);
+        pipeline->m_Attributes.push_back(attribute);
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    name.resize(maxLength > 0 ? maxLength : 1);
+    for(GLint i=0; i<count; i++){
+        PipelineVariable block;
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, i, (GLsizei)name.size(), &length, name.data());
+        glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.m_Size);
+        block.m_Location = i;
+        block.m_NameHash = HashVariableName(name.data(), length);
+        pipeline->m_UniformBlocks.push_back(block);
+    }
+
+    std::sort(pipeline->m_Uniforms.begin(), pipeline->m_Uniforms.end(), CompareHash);
+    std::sort(pipeline->m_Attributes.begin(), pipeline->m_Attributes.end(), CompareHash);
+    std::sort(pipeline->m_UniformBlocks.begin(), pipeline->m_UniformBlocks.end(), CompareHash);
+
+    for(size_t i=1; i<pipeline->m_Uniforms.size(); i++){
+        if(pipeline->m_Uniforms[i].m_NameHash == pipeline->m_Uniforms[i-1].m_NameHash){
+            fprintf(stderr, "Pipeline %u: uniform name hash collision (0x%08x)\n", program, pipeline->m_Uniforms[i].m_NameHash);
+        }
+    }
+}
+
+static uint64_t NowNs(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void DeleteStages(Pipeline *pipeline){
+    glDeleteShader(pipeline->m_VertexShader);
+    glDeleteShader(pipeline->m_FragmentShader);
+    pipeline->m_VertexShader = 0;
+    pipeline->m_FragmentShader = 0;
+}
+
+static PipelineStatus Fail(Pipeline *pipeline){
+    DeleteStages(pipeline);
+    glDeleteProgram(pipeline->m_Program);
+    pipeline->m_Program = 0;
+    pipeline->m_Linked = false;
+    pipeline->m_Uniforms.clear();
+    pipeline->m_Attributes.clear();
+    pipeline->m_UniformBlocks.clear();
+    pipeline->m_Status = PIPELINE_FAILED;
+    return pipeline->m_Status;
+}
+
+static PipelineStatus Finish(Pipeline *pipeline){
+    pipeline->m_Linked = true;
+    pipeline->m_BuildMs = (NowNs() - pipeline->m_BuildStart) * 1e-6;
+    ValidateProgram(pipeline->m_Program, pipeline->m_VertexFile.c_str(), pipeline->m_FragmentFile.c_str(), &pipeline->m_InfoLog);
+    GLint status = GL_FALSE;
+    glGetProgramiv(pipeline->m_Program, GL_VALIDATE_STATUS, &status);
+    pipeline->m_Validated = status == GL_TRUE;
+    Pipeline_Reflect(pipeline);
+    pipeline->m_Status = PIPELINE_READY;
+    return pipeline->m_Status;
+}
+
+// true if asking for the object's status now wouldn't block. Without the extension
+// there's no way to tell, so the status query is left to block.
+static bool Completed(GLuint object, bool program, bool block){
+    if(block || !gGLExt.m_ParallelShaderCompile){
+        return true;
+    }
+    GLint done = GL_FALSE;
+    if(program){
+        glGetProgramiv(object, GL_COMPLETION_STATUS_KHR, &done);
+    }else{
+        glGetShaderiv(object, GL_COMPLETION_STATUS_KHR, &done);
+    }
+    return done == GL_TRUE;
+}
+
+void Pipeline_CreateFromSourceAsync(Pipeline *pipeline, const char *vertexFile, const char *fragmentFile,
+                                    const ShaderSource &vertex, const ShaderSource &fragment){
+    pipeline->m_InfoLog.clear();
+    pipeline->m_Program = 0;
+    pipeline->m_Linked = false;
+    pipeline->m_Validated = false;
+    pipeline->m_VertexFile = vertexFile;
+    pipeline->m_FragmentFile = fragmentFile;
+    pipeline->m_Features = vertex.m_Requested;
+    pipeline->m_SourceFiles = vertex.m_Files;
+    pipeline->m_SourceFiles.insert(pipeline->m_SourceFiles.end(), fragment.m_Files.begin(), fragment.m_Files.end());
+    pipeline->m_BuildStart = NowNs();
+
+    // a binary linked by an earlier run skips compile + link entirely
+    pipeline->m_CacheKey = ProgramCache_Key(vertex.m_Text, fragment.m_Text, vertex.m_Defines + ";" + fragment.m_Defines);
+    pipeline->m_Program = ProgramCache_Load(pipeline->m_CacheKey);
+    if(pipeline->m_Program != 0){
+        Finish(pipeline);
+        return;
+    }
+
+    pipeline->m_VertexShader = SubmitShader(GL_VERTEX_SHADER, vertex.m_Text);
+    pipeline->m_FragmentShader = SubmitShader(GL_FRAGMENT_SHADER, fragment.m_Text);
+    pipeline->m_Status = PIPELINE_COMPILING;
+}
+
+void Pipeline_CreateAsync(Pipeline *pipeline, const char *vertexFile, const char *fragmentFile, uint32_t features){
+    ShaderSource vertex, fragment;
+    if(!ShaderSource_Load(&vertex, vertexFile, features) || !ShaderSource_Load(&fragment, fragmentFile, features)){
+        std::string &error = vertex.m_Error.empty() ? fragment.m_Error : vertex.m_Error;
+        fprintf(stderr, "Pipeline (%s, %s): %s\n", vertexFile, fragmentFile, error.c_str());
+        pipeline->m_VertexFile = vertexFile;
+        pipeline->m_FragmentFile = fragmentFile;
+        pipeline->m_InfoLog = error;
+        Fail(pipeline);
+        return;
+    }
+    Pipeline_CreateFromSourceAsync(pipeline, vertexFile, fragmentFile, vertex, fragment);
+}
+
+// one step of the build, or as many as are done when the driver reports completion
+static PipelineStatus Advance(Pipeline *pipeline, bool block){
+    if(pipeline->m_Status == PIPELINE_COMPILING){
+        if(!Completed(pipeline->m_VertexShader, false, block) || !Completed(pipeline->m_FragmentShader, false, block)){
+            return pipeline->m_Status;
+        }
+        bool vertexOk = CheckShader(pipeline->m_VertexShader, GL_VERTEX_SHADER, pipeline->m_VertexFile.c_str(), &pipeline->m_InfoLog);
+        bool fragmentOk = CheckShader(pipeline->m_FragmentShader, GL_FRAGMENT_SHADER, pipeline->m_FragmentFile.c_str(), &pipeline->m_InfoLog);
+        // CheckShader already deleted the failed one
+        if(!vertexOk){
+            pipeline->m_VertexShader = 0;
+        }
+        if(!fragmentOk){
+            pipeline->m_FragmentShader = 0;
+        }
+        if(!vertexOk || !fragmentOk){
+            return Fail(pipeline);
+        }
+
+        pipeline->m_Program = glCreateProgram();
+        glAttachShader(pipeline->m_Program, pipeline->m_VertexShader);
+        glAttachShader(pipeline->m_Program, pipeline->m_FragmentShader);
+        ProgramCache_PrepareLink(pipeline->m_Program);
+        glLinkProgram(pipeline->m_Program);
+
+        // the program keeps the compiled stages alive, we don't need our handles anymore
+        glDetachShader(pipeline->m_Program, pipeline->m_VertexShader);
+        glDetachShader(pipeline->m_Program, pipeline->m_FragmentShader);
+        DeleteStages(pipeline);
+        pipeline->m_Status = PIPELINE_LINKING;
+        // the link was only just queued, checking it now would wait on it
+        if(!block){
+            return pipeline->m_Status;
+        }
+    }
+
+    if(pipeline->m_Status == PIPELINE_LINKING){
+        if(!Completed(pipeline->m_Program, true, block)){
+            return pipeline->m_Status;
+        }
+        GLint status = GL_FALSE;
+        glGetProgramiv(pipeline->m_Program, GL_LINK_STATUS, &status);
+        if(status != GL_TRUE){
+            std::string log = GetProgramInfoLog(pipeline->m_Program);
+            fprintf(stderr, "Program (%s, %s) failed to link:\n%s\n", pipeline->m_VertexFile.c_str(),
+                    pipeline->m_FragmentFile.c_str(), log.c_str());
+            pipeline->m_InfoLog += log;
+            return Fail(pipeline);
+        }
+        ProgramCache_Store(pipeline->m_CacheKey, pipeline->m_Program, (NowNs() - pipeline->m_BuildStart) * 1e-6);
+        return Finish(pipeline);
+    }
+    return pipeline->m_Status;
+}
+
+PipelineStatus Pipeline_Poll(Pipeline *pipeline){
+    return Advance(pipeline, false);
+}
+
+bool Pipeline_Wait(Pipeline *pipeline){
+    // the status queries block until the driver is done, no need to spin on completion
+    Advance(pipeline, true);
+    return pipeline->m_Linked;
+}
+
+bool Pipeline_Create(Pipeline *pipeline, const char *vertexFile, const char *fragmentFile, uint32_t features){
+    Pipeline_CreateAsync(pipeline, vertexFile, fragmentFile, features);
+    return Pipeline_Wait(pipeline);
+}
+
+void Pipeline_Delete(Pipeline *pipeline){
+    DeleteStages(pipeline);
+    glDeleteProgram(pipeline->m_Program);
+    *pipeline = Pipeline();
+}
+
+static int FindSlot(const std::vector<PipelineVariable> &table, uint32_t nameHash){
+    PipelineVariable key;
+    key.m_NameHash = nameHash;
+    auto it = std::lower_bound(table.begin(), table.end(), key, CompareHash);
+    if(it == table.end() || it->m_NameHash != nameHash){
+        return -1;
+    }
+    return (int)(it - table.begin());
+}
+
+int Pipeline_FindUniformSlot(const Pipeline *pipeline, uint32_t nameHash){
+    return FindSlot(pipeline->m_Uniforms, nameHash);
+}
+
+int Pipeline_FindAttributeSlot(const Pipeline *pipeline, uint32_t nameHash){
+    return FindSlot(pipeline->m_Attributes, nameHash);
+}
+
+int Pipeline_FindUniformBlockSlot(const Pipeline *pipeline, uint32_t nameHash){
+    return FindSlot(pipeline->m_UniformBlocks, nameHash);
+}
+
+bool Pipeline_BindUniformBlock(const Pipeline *pipeline, uint32_t nameHash, GLuint binding){
+    int slot = Pipeline_FindUniformBlockSlot(pipeline, nameHash);
+    if(slot < 0){
+        return false;
+    }
+    glUniformBlockBinding(pipeline->m_Program, pipeline->m_UniformBlocks[slot].m_Location, binding);
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shader_source.hpp"
+
+// FNV-1a over a uniform/attribute name, constexpr so HashName("u_ModelMatrix")
+// folds to a constant at the call site
+constexpr uint32_t HashName(const char *name, uint32_t hash = 2166136261u){
+    return *name ? HashName(name+1, (hash ^ (uint32_t)(unsigned char)*name) * 16777619u) : hash;
+}
+
+// One active uniform or attribute, as reported by the driver after link
+struct PipelineVariable{
+    uint32_t m_NameHash = 0;
+    GLint m_Location = -1;
+    GLenum m_Type = 0;
+    GLint m_Size = 0;       // array length, 1 for non arrays
+};
+
+enum PipelineStatus{
+    PIPELINE_EMPTY = 0,
+    PIPELINE_COMPILING,     // stages submitted, the driver may be compiling them on its own threads
+    PIPELINE_LINKING,
+    PIPELINE_READY,
+    PIPELINE_FAILED,
+};
+
+struct Pipeline{
+    GLuint m_Program = 0;
+    PipelineStatus m_Status = PIPELINE_EMPTY;
+
+    // flat tables sorted by m_NameHash, filled once after glLinkProgram
+    std::vector<PipelineVariable> m_Uniforms;
+    std::vector<PipelineVariable> m_Attributes;
+    std::vector<PipelineVariable> m_UniformBlocks;  // m_Location = block index, m_Size = data size
+
+    bool m_Linked = false;
+    bool m_Validated = false;
+    std::string m_InfoLog;  // compile/link/validate log of the last build
+
+    // build in flight, see Pipeline_CreateAsync
+    std::string m_VertexFile;
+    std::string m_FragmentFile;
+    uint32_t m_Features = 0;                // ShaderFeatureBits the build was requested with
+    std::vector<std::string> m_SourceFiles; // both stages' files, includes too
+    GLuint m_VertexShader = 0;
+    GLuint m_FragmentShader = 0;
+    uint64_t m_CacheKey = 0;
+    double m_BuildMs = 0.0;     // submit to ready, the program cache's compile time on a miss
+    uint64_t m_BuildStart = 0;  // steady clock ns
+};
+
+GLuint CompileShader(GLuint type, const std::string &source, std::string *infoLog = nullptr);
+GLuint CreateShaderProgram(const char *vertexFile, const char *fragmentFile, std::string *infoLog = nullptr);
+
+// Builds the program and reflects its active uniforms/attributes.
+// Returns false (with m_InfoLog filled) if compile or link failed.
+bool Pipeline_Create(Pipeline *pipeline, const char *vertexFile, const char *fragmentFile, uint32_t features = 0);
+
+// Same build without blocking: the pipeline itself is the future. Reads the sources,
+// takes the program from the binary cache if it can, otherwise submits both stages
+// and returns. With KHR_parallel_shader_compile the driver compiles them on its own
+// threads and Pipeline_Poll only checks GL_COMPLETION_STATUS_KHR; without it each
+// Pipeline_Poll does one step (compile check + link, then link check), waiting on the driver.
+// Both files go through ShaderSource_Load with the given ShaderFeatureBits.
+void Pipeline_CreateAsync(Pipeline *pipeline, const char *vertexFile, const char *fragmentFile, uint32_t features = 0);
+// Same from already preprocessed stages (see shader_variants.hpp)
+void Pipeline_CreateFromSourceAsync(Pipeline *pipeline, const char *vertexFile, const char *fragmentFile,
+                                    const ShaderSource &vertex, const ShaderSource &fragment);
+// Advances the build as far as it can, returns the status (READY or FAILED once settled)
+PipelineStatus Pipeline_Poll(Pipeline *pipeline);
+// Blocks until settled, returns m_Linked
+bool Pipeline_Wait(Pipeline *pipeline);
+
+// Meshes whose pipeline isn't ready yet are skipped by the draw paths
+inline bool Pipeline_IsReady(const Pipeline *pipeline){
+    return pipeline != nullptr && pipeline->m_Status == PIPELINE_READY;
+}
+void Pipeline_Reflect(Pipeline *pipeline);
+void Pipeline_Delete(Pipeline *pipeline);
+
+// Slot = index into m_Uniforms, stable for the lifetime of the program. -1 if not active.
+int Pipeline_FindUniformSlot(const Pipeline *pipeline, uint32_t nameHash);
+int Pipeline_FindAttributeSlot(const Pipeline *pipeline, uint32_t nameHash);
+int Pipeline_FindUniformBlockSlot(const Pipeline *pipeline, uint32_t nameHash);
+
+// Points a uniform block at a buffer binding point (GLSL 410 has no layout(binding=)).
+// Returns false if the program has no such active block.
+bool Pipeline_BindUniformBlock(const Pipeline *pipeline, uint32_t nameHash, GLuint binding);
+
+inline GLint Pipeline_UniformLocationAt(const Pipeline *pipeline, int slot){
+    return slot < 0 ? -1 : pipeline->m_Uniforms[slot].m_Location;
+}
+
+// -1 when the uniform was optimised out, glUniform* silently ignores that location
+inline GLint Pipeline_UniformLocation(const Pipeline *pipeline, uint32_t nameHash){
+    return Pipeline_UniformLocationAt(pipeline, Pipeline_FindUniformSlot(pipeline, nameHash));
+}
+
+#endif
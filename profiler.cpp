@@ -0,0 +1,160 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+Profiler gProfiler;
+
+static thread_local std::string tThreadName;
+
+uint64_t Profiler_NowNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Calibrate(){
+    uint64_t ticks = Profiler_Ticks() - gProfiler.m_StartTicks;
+    uint64_t ns = Profiler_NowNs() - gProfiler.m_StartNs;
+    if(ticks > 0 && ns > 0){
+        gProfiler.m_NsPerTick = (double)ns / (double)ticks;
+    }
+}
+
+static uint64_t TicksToNs(uint64_t ticks){
+    return gProfiler.m_StartNs + (uint64_t)((double)(int64_t)(ticks - gProfiler.m_StartTicks) * gProfiler.m_NsPerTick);
+}
+
+bool Profiler_Init(const char *tracePath){
+    gProfiler.m_StartTicks = Profiler_Ticks();
+    gProfiler.m_StartNs = Profiler_NowNs();
+    // a first tick rate for the early events, Profiler_Collect keeps refining it
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    Calibrate();
+
+    if(tracePath){
+        gProfiler.m_Trace = fopen(tracePath, "w");
+        if(gProfiler.m_Trace == nullptr){
+            fprintf(stderr, "Could not open %s for the profiler trace\n", tracePath);
+        }else{
+            fprintf(gProfiler.m_Trace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            fprintf(gProfiler.m_Trace, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"gpu\"}}");
+        }
+    }
+    gProfiler.m_Enabled.store(true, std::memory_order_release);
+    return tracePath == nullptr || gProfiler.m_Trace != nullptr;
+}
+
+void Profiler_Shutdown(){
+    if(!gProfiler.m_Enabled.load()){
+        return;
+    }
+    Profiler_Collect();
+    gProfiler.m_Enabled.store(false);
+    if(gProfiler.m_Trace){
+        fprintf(gProfiler.m_Trace, "\n]}\n");
+        fclose(gProfiler.m_Trace);
+        gProfiler.m_Trace = nullptr;
+        printf("profiler: %llu trace events written\n", (unsigned long long)gProfiler.m_TraceEvents);
+    }
+}
+
+void Profiler_SetThreadName(const char *name){
+    tThreadName = name;
+}
+
+ProfilerRing* Profiler_RegisterThread(){
+    std::lock_guard<std::mutex> lock(gProfiler.m_ThreadsMutex);
+    gProfiler.m_Threads.emplace_back(new ProfilerRing());
+    ProfilerRing *ring = gProfiler.m_Threads.back().get();
+    // tid 0 is the gpu
+    ring->m_Id = (uint32_t)gProfiler.m_Threads.size();
+    ring->m_Name = tThreadName.empty() ? "thread " + std::to_string(ring->m_Id) : tThreadName;
+    return ring;
+}
+
+static ProfilerScopeStats* FindScope(const char *name, bool gpu){
+    std::unordered_map<const char*, uint32_t> &index = gpu ? gProfiler.m_GpuScopeIndex : gProfiler.m_CpuScopeIndex;
+    auto found = index.find(name);
+    if(found != index.end()){
+        return &gProfiler.m_Scopes[found->second];
+    }
+    std::string key = gpu ? std::string("gpu ") + name : std::string(name);
+    auto named = gProfiler.m_ScopeByName.find(key);
+    uint32_t scope;
+    if(named != gProfiler.m_ScopeByName.end()){
+        scope = named->second;
+    }else{
+        scope = (uint32_t)gProfiler.m_Scopes.size();
+        gProfiler.m_Scopes.emplace_back();
+        gProfiler.m_Scopes.back().m_Name = key;
+        gProfiler.m_Scopes.back().m_Gpu = gpu;
+        gProfiler.m_ScopeByName[key] = scope;
+    }
+    index[name] = scope;
+    return &gProfiler.m_Scopes[scope];
+}
+
+static void AddSample(const char *name, bool gpu, uint32_t tid, uint64_t startNs, uint64_t endNs){
+    ProfilerScopeStats *scope = FindScope(name, gpu);
+    float ms = endNs > startNs ? (float)((endNs - startNs) / 1e6) : 0.0f;
+    scope->m_SamplesMs[scope->m_Next] = ms;
+    scope->m_Next = (scope->m_Next + 1) % PROFILER_STATS_SAMPLES;
+    scope->m_Calls++;
+
+    if(gProfiler.m_Trace && gProfiler.m_TraceEvents < PROFILER_TRACE_MAX_EVENTS){
+        // microseconds since Profiler_Init
+        fprintf(gProfiler.m_Trace, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", name, tid,
+                (int64_t)(startNs - gProfiler.m_StartNs) / 1e3, (endNs > startNs ? endNs - startNs : 0) / 1e3);
+        if(++gProfiler.m_TraceEvents == PROFILER_TRACE_MAX_EVENTS){
+            fprintf(stderr, "profiler: trace is full at %d events, later ones are left out\n", PROFILER_TRACE_MAX_EVENTS);
+        }
+    }
+}
+
+void Profiler_Collect(){
+    if(!gProfiler.m_Enabled.load(std::memory_order_relaxed)){
+        return;
+    }
+    Calibrate();
+    std::lock_guard<std::mutex> lock(gProfiler.m_ThreadsMutex);
+    for(std::unique_ptr<ProfilerRing> &ring : gProfiler.m_Threads){
+        if(gProfiler.m_Trace && !ring->m_Announced){
+            fprintf(gProfiler.m_Trace, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    ring->m_Id, ring->m_Name.c_str());
+        }
+        ring->m_Announced = true;
+        uint32_t tail = ring->m_Tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->m_Head.load(std::memory_order_acquire);
+        for(; tail != head; tail++){
+            const ProfilerEvent &event = ring->m_Events[tail % PROFILER_RING_SIZE];
+            AddSample(event.m_Name, false, ring->m_Id, TicksToNs(event.m_Start), TicksToNs(event.m_End));
+        }
+        ring->m_Tail.store(tail, std::memory_order_release);
+        gProfiler.m_Dropped += ring->m_Dropped.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void Profiler_RecordGpu(const char *name, uint64_t startNs, uint64_t endNs){
+    if(!gProfiler.m_Enabled.load(std::memory_order_relaxed)){
+        return;
+    }
+    AddSample(name, true, 0, startNs, endNs);
+}
+
+void Profiler_PrintStats(){
+    if(!gProfiler.m_Enabled.load(std::memory_order_relaxed)){
+        return;
+    }
+    printf("profiler: %zu scopes, %llu events dropped\n", gProfiler.m_Scopes.size(), (unsigned long long)gProfiler.m_Dropped);
+    std::vector<float> sorted;
+    for(const ProfilerScopeStats &scope : gProfiler.m_Scopes){
+        size_t count = (size_t)std::min<uint64_t>(scope.m_Calls, PROFILER_STATS_SAMPLES);
+        if(count == 0){
+            continue;
+        }
+        sorted.assign(scope.m_SamplesMs, scope.m_SamplesMs + count);
+        std::sort(sorted.begin(), sorted.end());
+        printf("  %-24s p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms  (%llu calls)\n", scope.m_Name.c_str(),
+               sorted[count * 50 / 100], sorted[count * 95 / 100], sorted[std::min(count - 1, count * 99 / 100)],
+               sorted.back(), (unsigned long long)scope.m_Calls);
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_TSC
+#endif
+
+// make PROFILER=0 builds without it, every PROFILE_* macro then expands to nothing
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Scoped CPU timers recorded into one ring per thread. Only the owning thread
+// writes its ring and only Profiler_Collect (once a frame, render thread) reads
+// it, so recording is two timestamps and a store, no locks. Collect turns the
+// events into rolling per-scope percentiles and, with a trace file, Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev). Scope names must be
+// string literals or otherwise outlive the profiler.
+
+// events per thread between two Profiler_Collect, the rest are dropped and counted
+#define PROFILER_RING_SIZE 16384
+// durations per scope the percentiles are computed over
+#define PROFILER_STATS_SAMPLES 512
+// the trace stops growing here (about 100 bytes per event)
+#define PROFILER_TRACE_MAX_EVENTS 1000000
+
+struct ProfilerEvent{
+    const char *m_Name;
+    uint64_t m_Start;                   // Profiler_Ticks
+    uint64_t m_End;
+};
+
+struct ProfilerRing{
+    ProfilerEvent m_Events[PROFILER_RING_SIZE];
+    alignas(64) std::atomic<uint32_t> m_Head{0};    // written by the owning thread
+    alignas(64) std::atomic<uint32_t> m_Tail{0};    // written by the collector
+    std::atomic<uint32_t> m_Dropped{0};
+    uint32_t m_Id = 0;                  // trace tid
+    std::string m_Name;
+    bool m_Announced = false;           // name written to the trace
+};
+
+struct ProfilerScopeStats{
+    std::string m_Name;
+    bool m_Gpu = false;
+    float m_SamplesMs[PROFILER_STATS_SAMPLES];
+    uint32_t m_Next = 0;                // ring position in m_SamplesMs
+    uint64_t m_Calls = 0;               // since start
+};
+
+struct Profiler{
+    std::atomic<bool> m_Enabled{false};
+
+    std::mutex m_ThreadsMutex;          // registering a thread, first scope it records
+    std::vector<std::unique_ptr<ProfilerRing>> m_Threads;
+
+    // ticks -> ns, refined on every collect
+    uint64_t m_StartTicks = 0;
+    uint64_t m_StartNs = 0;
+    double m_NsPerTick = 1.0;
+
+    // collector side
+    std::vector<ProfilerScopeStats> m_Scopes;
+    std::unordered_map<const char*, uint32_t> m_CpuScopeIndex;
+    std::unordered_map<const char*, uint32_t> m_GpuScopeIndex;
+    std::unordered_map<std::string, uint32_t> m_ScopeByName;    // the same name from two translation units
+    FILE *m_Trace = nullptr;
+    uint64_t m_TraceEvents = 0;
+    uint64_t m_Dropped = 0;
+};
+
+extern Profiler gProfiler;
+
+inline uint64_t Profiler_Ticks(){
+#ifdef PROFILER_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// steady clock ns, the time base of the trace and of Profiler_RecordGpu
+uint64_t Profiler_NowNs();
+
+// Starts recording, tracePath (may be null) gets the Chrome trace JSON
+bool Profiler_Init(const char *tracePath);
+// Collects what is left and finishes the trace file
+void Profiler_Shutdown();
+// trace name of the calling thread, before its first scope
+void Profiler_SetThreadName(const char *name);
+
+ProfilerRing* Profiler_RegisterThread();
+
+inline void Profiler_Record(const char *name, uint64_t start, uint64_t end){
+    static thread_local ProfilerRing *ring = nullptr;
+    if(ring == nullptr){
+        ring = Profiler_RegisterThread();
+    }
+    uint32_t head = ring->m_Head.load(std::memory_order_relaxed);
+    if(head - ring->m_Tail.load(std::memory_order_acquire) >= PROFILER_RING_SIZE){
+        ring->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->m_Events[head % PROFILER_RING_SIZE] = {name, start, end};
+    ring->m_Head.store(head + 1, std::memory_order_release);
+}
+
+// Drains every thread's ring, call once a frame from one thread
+void Profiler_Collect();
+// GPU scope resolved by the GPU profiler, ns in the Profiler_NowNs time base. Collector thread only
+void Profiler_RecordGpu(const char *name, uint64_t startNs, uint64_t endNs);
+// p50/p95/p99/max of the last PROFILER_STATS_SAMPLES calls of every scope
+void Profiler_PrintStats();
+
+struct ProfileScope{
+    const char *m_Name;
+    uint64_t m_Start;
+    explicit ProfileScope(const char *name){
+        m_Name = gProfiler.m_Enabled.load(std::memory_order_relaxed) ? name : nullptr;
+        m_Start = m_Name ? Profiler_Ticks() : 0;
+    }
+    ~ProfileScope(){
+        if(m_Name){
+            Profiler_Record(m_Name, m_Start, Profiler_Ticks());
+        }
+    }
+};
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif
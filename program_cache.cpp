@@ -0,0 +1,160 @@
+#include "program_cache.hpp"
+#include "gl_ext.hpp"
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+ProgramCacheStats gProgramCacheStats;
+bool gProgramCacheEnabled = true;
+
+// FNV-1a 64, programs are hashed a handful of times at startup
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size){
+    const uint8_t *bytes = (const uint8_t *)data;
+    for(size_t i=0; i<size; i++){
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// length first so "ab"+"c" and "a"+"bc" differ
+static uint64_t HashString(uint64_t hash, const char *text){
+    size_t length = text ? strlen(text) : 0;
+    hash = HashBytes(hash, &length, sizeof(length));
+    return HashBytes(hash, text, length);
+}
+
+static std::string CachePath(uint64_t key){
+    char name[64];
+    snprintf(name, sizeof(name), PROGRAM_CACHE_DIRECTORY "/%016llx.bin", (unsigned long long)key);
+    return name;
+}
+
+static bool Usable(){
+    return gProgramCacheEnabled && gGLExt.m_ProgramBinary;
+}
+
+uint64_t ProgramCache_Key(const std::string &vertexSource, const std::string &fragmentSource, const std::string &defines){
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = HashString(hash, vertexSource.c_str());
+    hash = HashString(hash, fragmentSource.c_str());
+    hash = HashString(hash, defines.c_str());
+    // a binary is only valid for the driver build that produced it
+    hash = HashString(hash, (const char *)glGetString(GL_VENDOR));
+    hash = HashString(hash, (const char *)glGetString(GL_RENDERER));
+    hash = HashString(hash, (const char *)glGetString(GL_VERSION));
+    return hash;
+}
+
+GLuint ProgramCache_Load(uint64_t key){
+    if(!Usable()){
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string path = CachePath(key);
+    FileView file;
+    if(!FileView_Open(&file, path.c_str(), FILE_ACCESS_WILLNEED)){
+        gProgramCacheStats.m_Misses++;
+        return 0;
+    }
+    // the driver reads the binary straight out of the view
+    ProgramCacheHeader header;
+    bool valid = file.m_Size >= sizeof(header);
+    if(valid){
+        memcpy(&header, file.m_Data, sizeof(header));
+        valid = header.m_Magic == PROGRAM_CACHE_MAGIC && header.m_Version == PROGRAM_CACHE_VERSION
+             && header.m_Key == key && header.m_Length <= file.m_Size - sizeof(header);
+    }
+
+    GLuint program = 0;
+    if(valid){
+        program = glCreateProgram();
+        glProgramBinary(program, header.m_Format, file.m_Data + sizeof(header), (GLsizei)header.m_Length);
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if(status != GL_TRUE){
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if(program == 0){
+        // stale or corrupt, the caller compiles and stores a fresh one
+        fprintf(stderr, "ProgramCache: %s rejected, recompiling\n", path.c_str());
+        unlink(path.c_str());
+        gProgramCacheStats.m_Rejected++;
+        gProgramCacheStats.m_Misses++;
+        return 0;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    gProgramCacheStats.m_Hits++;
+    gProgramCacheStats.m_LoadMs += ms;
+    gProgramCacheStats.m_SavedMs += header.m_BuildMs - ms;
+    return program;
+}
+
+void ProgramCache_PrepareLink(GLuint program){
+    if(Usable()){
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ProgramCache_Store(uint64_t key, GLuint program, double buildMs){
+    gProgramCacheStats.m_BuildMs += buildMs;
+    if(!Usable()){
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0){
+        return;
+    }
+    ProgramCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    std::vector<uint8_t> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if(written <= 0){
+        return;
+    }
+    header.m_Magic = PROGRAM_CACHE_MAGIC;
+    header.m_Version = PROGRAM_CACHE_VERSION;
+    header.m_Key = key;
+    header.m_Format = format;
+    header.m_Length = (uint32_t)written;
+    header.m_BuildMs = buildMs;
+
+    // written aside and renamed, a crash mid write never leaves a truncated binary behind
+    mkdir(PROGRAM_CACHE_DIRECTORY, 0755);
+    std::string path = CachePath(key);
+    std::string tempPath = path + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if(file == nullptr){
+        fprintf(stderr, "ProgramCache: could not create %s\n", tempPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary.data(), 1, written, file) == (size_t)written;
+    ok = fclose(file) == 0 && ok;
+    if(!ok || rename(tempPath.c_str(), path.c_str()) != 0){
+        unlink(tempPath.c_str());
+        return;
+    }
+    gProgramCacheStats.m_Writes++;
+}
+
+void ProgramCache_PrintStats(){
+    const ProgramCacheStats &stats = gProgramCacheStats;
+    if(!Usable()){
+        printf("program cache: off (%s), %.1f ms compiling\n",
+               gProgramCacheEnabled ? "no program binary support" : "--no-program-cache", stats.m_BuildMs);
+        return;
+    }
+    printf("program cache: %u hits, %u misses (%u rejected), %u written, %.1f ms compile time saved (%.1f ms loading), %.1f ms compiling\n",
+           stats.m_Hits, stats.m_Misses, stats.m_Rejected, stats.m_Writes, stats.m_SavedMs, stats.m_LoadMs, stats.m_BuildMs);
+}
@@ -0,0 +1,50 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+// Linked programs saved with glGetProgramBinary, one file per key under this directory
+#define PROGRAM_CACHE_DIRECTORY "shader_cache"
+#define PROGRAM_CACHE_MAGIC 0x48435250      // "PRCH"
+#define PROGRAM_CACHE_VERSION 1
+
+// File layout: header, then m_Length bytes of driver binary
+struct ProgramCacheHeader{
+    uint32_t m_Magic;
+    uint32_t m_Version;
+    uint64_t m_Key;
+    uint32_t m_Format;          // binaryFormat from glGetProgramBinary
+    uint32_t m_Length;
+    double m_BuildMs;           // what compiling + linking took, reported as saved on a hit
+};
+
+struct ProgramCacheStats{
+    unsigned m_Hits = 0;
+    unsigned m_Misses = 0;
+    unsigned m_Rejected = 0;    // binaries the driver refused (driver update, ...), counted in misses too
+    unsigned m_Writes = 0;
+    double m_LoadMs = 0.0;      // spent in glProgramBinary on hits
+    double m_BuildMs = 0.0;     // spent compiling + linking on misses
+    double m_SavedMs = 0.0;     // build time of the hits as recorded when they were cached, minus m_LoadMs
+};
+
+extern ProgramCacheStats gProgramCacheStats;
+// --no-program-cache, always compile and never write
+extern bool gProgramCacheEnabled;
+
+// Hash of everything a binary depends on: the sources as compiled (after any
+// preprocessing), the defines and the driver's vendor/renderer/version strings
+uint64_t ProgramCache_Key(const std::string &vertexSource, const std::string &fragmentSource, const std::string &defines);
+
+// Linked program from the cache, or 0 on a miss or when the driver rejects the binary
+GLuint ProgramCache_Load(uint64_t key);
+// Marks the program's binary as retrievable, between glAttachShader and glLinkProgram
+void ProgramCache_PrepareLink(GLuint program);
+// Saves a freshly linked program, buildMs is its compile + link time
+void ProgramCache_Store(uint64_t key, GLuint program, double buildMs);
+
+void ProgramCache_PrintStats();
+
+#endif
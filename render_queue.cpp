@@ -0,0 +1,199 @@
+#include "render_queue.hpp"
+#include "jobs.hpp"
+#include "gl_state.hpp"
+
+#include <cstring>
+
+// below this the keys are made on the calling thread
+#define RENDER_QUEUE_MIN_PARALLEL_CHUNK 4096
+
+// positive floats compare like their bit patterns, keep the top 24 of the 31 magnitude bits
+static uint64_t QuantizeDepth(float viewDepth){
+    if(!(viewDepth > 0.0f)){
+        return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &viewDepth, sizeof(bits));
+    return bits >> 7;
+}
+
+uint64_t RenderQueue_MakeKey(const Mesh3D *mesh, float viewDepth){
+    uint64_t pipeline = mesh->m_Pipeline ? (mesh->m_Pipeline->m_Program & 0xFFF) : 0;
+    uint64_t material = mesh->m_Material & 0xFFF;
+    uint64_t vao = mesh->m_VertexArrayObject & 0x7FFF;
+    uint64_t depth = QuantizeDepth(viewDepth);
+    uint64_t state = (pipeline << 27) | (material << 15) | vao;
+
+    if(mesh->m_Transparent){
+        return RENDER_KEY_TRANSPARENT_BIT | ((0xFFFFFFull - depth) << 39) | state;
+    }
+    return (state << 24) | depth;
+}
+
+// only the z row of view * translation is needed for the view space depth
+static float ViewDepth(const glm::mat4 &view, const glm::mat4 &model){
+    return -(view[0][2]*model[3][0] + view[1][2]*model[3][1] + view[2][2]*model[3][2] + view[3][2]);
+}
+
+void RenderQueue_Begin(RenderQueue *queue){
+    queue->m_Keys.clear();
+    queue->m_Items.clear();
+    queue->m_Meshes.clear();
+    queue->m_Objects.clear();
+}
+
+void RenderQueue_Submit(RenderQueue *queue, const Mesh3D *mesh, const glm::mat4 &view, uint32_t object){
+    if(mesh==nullptr || !Pipeline_IsReady(mesh->m_Pipeline)){
+        return;
+    }
+    queue->m_Keys.push_back(RenderQueue_MakeKey(mesh, ViewDepth(view, Mesh_GetModelMatrix(mesh))));
+    queue->m_Items.push_back((uint32_t)queue->m_Meshes.size());
+    queue->m_Meshes.push_back(mesh);
+    queue->m_Objects.push_back(object);
+}
+
+void RenderQueue_SubmitBatch(RenderQueue *queue, const Mesh3D *const *meshes, size_t count, const glm::mat4 &view,
+                             const glm::mat4 *models){
+    size_t base = queue->m_Keys.size();
+    queue->m_Keys.resize(base + count);
+    queue->m_Items.resize(base + count);
+    queue->m_Meshes.resize(base + count);
+    queue->m_Objects.resize(base + count);
+
+    // every chunk fills its own slice, skipping meshes whose pipeline isn't ready yet
+    size_t chunks = Jobs_ChunkCount(count, RENDER_QUEUE_MIN_PARALLEL_CHUNK);
+    std::vector<size_t> &written = queue->m_ChunkWritten;
+    written.assign(chunks, 0);
+    Jobs_ParallelChunks(chunks, count, [&](size_t c, size_t first, size_t last){
+        size_t out = base + first;
+        for(size_t i=first; i<last; i++){
+            const Mesh3D *mesh = meshes[i];
+            if(mesh==nullptr || !Pipeline_IsReady(mesh->m_Pipeline)){
+                continue;
+            }
+            queue->m_Keys[out] = RenderQueue_MakeKey(mesh, ViewDepth(view, models[i]));
+            queue->m_Meshes[out] = mesh;
+            queue->m_Objects[out] = (uint32_t)i;
+            out++;
+        }
+        written[c] = out - (base + first);
+    });
+
+    // close the gaps the skipped meshes left, items follow their mesh
+    size_t end = base;
+    for(size_t c=0; c<chunks; c++){
+        size_t first = base + count * c / chunks;
+        for(size_t i=first; i<first + written[c]; i++, end++){
+            queue->m_Keys[end] = queue->m_Keys[i];
+            queue->m_Meshes[end] = queue->m_Meshes[i];
+            queue->m_Objects[end] = queue->m_Objects[i];
+            queue->m_Items[end] = (uint32_t)end;
+        }
+    }
+    queue->m_Keys.resize(end);
+    queue->m_Items.resize(end);
+    queue->m_Meshes.resize(end);
+    queue->m_Objects.resize(end);
+}
+
+void RenderQueue_Sort(RenderQueue *queue){
+    size_t count = queue->m_Keys.size();
+    if(count < 2){
+        return;
+    }
+    queue->m_KeysScratch.resize(count);
+    queue->m_ItemsScratch.resize(count);
+
+    uint64_t *keys = queue->m_Keys.data();
+    uint32_t *items = queue->m_Items.data();
+    uint64_t *keysOut = queue->m_KeysScratch.data();
+    uint32_t *itemsOut = queue->m_ItemsScratch.data();
+
+    // all eight histograms in one read of the keys
+    size_t histogram[8][256];
+    memset(histogram, 0, sizeof(histogram));
+    for(size_t i=0; i<count; i++){
+        uint64_t key = keys[i];
+        for(int pass=0; pass<8; pass++){
+            histogram[pass][(key >> (pass*8)) & 0xFF]++;
+        }
+    }
+
+    for(int pass=0; pass<8; pass++){
+        size_t *buckets = histogram[pass];
+        int shift = pass*8;
+        // every key has the same byte here, the pass wouldn't move anything
+        if(buckets[(keys[0] >> shift) & 0xFF] == count){
+            continue;
+        }
+        size_t offset = 0;
+        for(int b=0; b<256; b++){
+            size_t n = buckets[b];
+            buckets[b] = offset;
+            offset += n;
+        }
+        for(size_t i=0; i<count; i++){
+            size_t dst = buckets[(keys[i] >> shift) & 0xFF]++;
+            keysOut[dst] = keys[i];
+            itemsOut[dst] = items[i];
+        }
+        std::swap(keys, keysOut);
+        std::swap(items, itemsOut);
+    }
+
+    // an odd number of passes leaves the result in the scratch arrays
+    if(keys != queue->m_Keys.data()){
+        queue->m_Keys.swap(queue->m_KeysScratch);
+        queue->m_Items.swap(queue->m_ItemsScratch);
+    }
+}
+
+void RenderQueue_Execute(RenderQueue *queue, const ObjectUniformRing *objects){
+    RenderQueueStats stats;
+    const Pipeline *currentPipeline = nullptr;
+    GLuint currentVertexArray = 0;
+    bool blending = false;
+
+    for(size_t i=0; i<queue->m_Keys.size(); i++){
+        uint32_t item = queue->m_Items[i];
+        const Mesh3D *mesh = queue->m_Meshes[item];
+        // the frame's matrices were uploaded in one buffer, a draw only binds its block
+        if(!ObjectUniforms_Bind(objects, queue->m_Objects[item])){
+            continue;
+        }
+
+        bool transparent = (queue->m_Keys[i] & RENDER_KEY_TRANSPARENT_BIT) != 0;
+        if(transparent && !blending){
+            GLState_Enable(GL_BLEND);
+            GLState_BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLState_DepthMask(GL_FALSE);
+            blending = true;
+        }
+
+        if(mesh->m_Pipeline != currentPipeline){
+            currentPipeline = mesh->m_Pipeline;
+            GLState_UseProgram(currentPipeline->m_Program);
+            stats.m_ProgramSwitches++;
+        }
+
+        if(mesh->m_VertexArrayObject != currentVertexArray){
+            currentVertexArray = mesh->m_VertexArrayObject;
+            GLState_BindVertexArray(currentVertexArray);
+            stats.m_VertexArraySwitches++;
+        }
+
+        // meshes of one arena share the VAO, only the offsets change between draws
+        glDrawElementsBaseVertex(GL_TRIANGLES, mesh->m_IndexCount, mesh->m_IndexType,
+                                 Mesh_IndexOffset(mesh), Mesh_BaseVertex(mesh));
+        stats.m_DrawCalls++;
+    }
+    // the original Mesh_Draw bound program, VAO and GL_ARRAY_BUFFER for every mesh, then unbound the program
+    stats.m_UnfilteredBinds = stats.m_DrawCalls * 4;
+
+    if(blending){
+        GLState_DepthMask(GL_TRUE);
+        GLState_Disable(GL_BLEND);
+    }
+
+    queue->m_Stats = stats;
+}
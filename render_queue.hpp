@@ -0,0 +1,57 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+// Key layout, most significant first:
+//  opaque      | 0 | pipeline:12 | material:12 | vao:15 | depth:24 (front to back)
+//  transparent | 1 | depth:24 (back to front)  | pipeline:12 | material:12 | vao:15
+// so opaque draws are grouped by state and transparent ones are strictly depth ordered
+#define RENDER_KEY_TRANSPARENT_BIT  (1ull << 63)
+
+struct RenderQueueStats{
+    unsigned m_DrawCalls = 0;
+    unsigned m_ProgramSwitches = 0;
+    unsigned m_VertexArraySwitches = 0;
+    // binds the old one-call-per-mesh loop would have issued for the same draws
+    unsigned m_UnfilteredBinds = 0;
+};
+
+struct RenderQueue{
+    std::vector<uint64_t> m_Keys;
+    std::vector<uint32_t> m_Items;          // index into m_Meshes, travels with its key
+    std::vector<const Mesh3D*> m_Meshes;
+    std::vector<uint32_t> m_Objects;        // parallel to m_Meshes, the mesh's block in the frame's ObjectUniformRing
+
+    // radix sort scratch, kept between frames
+    std::vector<uint64_t> m_KeysScratch;
+    std::vector<uint32_t> m_ItemsScratch;
+    std::vector<size_t> m_ChunkWritten;     // RenderQueue_SubmitBatch, entries kept per chunk
+
+    RenderQueueStats m_Stats;               // of the last RenderQueue_Execute
+};
+
+uint64_t RenderQueue_MakeKey(const Mesh3D *mesh, float viewDepth);
+
+void RenderQueue_Begin(RenderQueue *queue);
+// view is the frame's view matrix, used for the depth part of the key.
+// object is the mesh's block written with ObjectUniforms_Write
+void RenderQueue_Submit(RenderQueue *queue, const Mesh3D *mesh, const glm::mat4 &view, uint32_t object);
+// RenderQueue_Submit for every mesh, the keys made in parallel on the job system.
+// Same order as submitting them one by one. models[i] is meshes[i]'s model matrix,
+// passed in so a frame snapshot can be drawn while the transform pool moves on;
+// meshes[i]'s object block is i
+void RenderQueue_SubmitBatch(RenderQueue *queue, const Mesh3D *const *meshes, size_t count, const glm::mat4 &view,
+                             const glm::mat4 *models);
+// LSD radix sort on the 64 bit keys, skipping byte passes where every key agrees
+void RenderQueue_Sort(RenderQueue *queue);
+// Draws in key order, switching program and VAO only when they change (each draw
+// still binds its block in objects)
+void RenderQueue_Execute(RenderQueue *queue, const ObjectUniformRing *objects);
+
+#endif
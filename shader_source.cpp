@@ -0,0 +1,155 @@
+#include "shader_source.hpp"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#define SHADER_SOURCE_MAX_INCLUDE_DEPTH 16
+
+struct ShaderFeature{
+    uint32_t m_Bit;
+    const char *m_Define;
+    int m_MinVersion;       // GLSL version the feature's code needs, 0 for any
+};
+
+static const ShaderFeature gShaderFeatures[] = {
+    {SHADER_INSTANCED, "SHADER_INSTANCED", 0},
+    {SHADER_INDIRECT, "SHADER_INDIRECT", 430},      // shader storage blocks
+};
+
+static bool IsIdentifierChar(char c){
+    return (c>='a' && c<='z') || (c>='A' && c<='Z') || (c>='0' && c<='9') || c=='_';
+}
+
+// whole identifier match, "SHADER_INDIRECT" doesn't count inside "SHADER_INDIRECT_X"
+static bool ContainsIdentifier(const std::string &text, const char *name){
+    size_t length = strlen(name);
+    for(size_t at = text.find(name); at != std::string::npos; at = text.find(name, at + 1)){
+        bool startOk = at == 0 || !IsIdentifierChar(text[at-1]);
+        bool endOk = at + length == text.size() || !IsIdentifierChar(text[at+length]);
+        if(startOk && endOk){
+            return true;
+        }
+    }
+    return false;
+}
+
+// the directive name after '#' and any blanks, the rest of the line in *rest
+static bool IsDirective(const std::string &line, const char *directive, std::string *rest){
+    size_t at = line.find_first_not_of(" \t");
+    if(at == std::string::npos || line[at] != '#'){
+        return false;
+    }
+    at = line.find_first_not_of(" \t", at + 1);
+    size_t length = strlen(directive);
+    if(at == std::string::npos || line.compare(at, length, directive) != 0
+       || (at + length < line.size() && IsIdentifierChar(line[at+length]))){
+        return false;
+    }
+    *rest = line.substr(at + length);
+    return true;
+}
+
+static bool Expand(ShaderSource *source, const std::string &path, int depth, std::string *out, std::string *versionLine){
+    if(depth > SHADER_SOURCE_MAX_INCLUDE_DEPTH){
+        source->m_Error = path + ": includes nested too deep";
+        return false;
+    }
+    FileView file;
+    if(!FileView_Open(&file, path.c_str(), FILE_ACCESS_SEQUENTIAL, &source->m_Error)){
+        return false;
+    }
+    const int fileIndex = (int)source->m_Files.size();
+    source->m_Files.push_back(path);
+    if(fileIndex > 0){
+        *out += "#line 1 " + std::to_string(fileIndex) + "\n";
+    }
+
+    int lineNumber = 0;
+    const char *cursor = file.m_Data;
+    const char *end = file.m_Data + file.m_Size;
+    while(cursor < end){
+        const char *newline = (const char *)memchr(cursor, '\n', end - cursor);
+        std::string line(cursor, newline ? newline : end);
+        cursor = newline ? newline + 1 : end;
+        lineNumber++;
+
+        std::string rest;
+        if(IsDirective(line, "version", &rest)){
+            if(fileIndex > 0 || !versionLine->empty()){
+                source->m_Error = path + ":" + std::to_string(lineNumber) + ": #version is only allowed once, in the main file";
+                return false;
+            }
+            // re-emitted in front of the defines, the blank keeps the line numbers
+            *versionLine = rest;
+            *out += "\n";
+            continue;
+        }
+        if(!IsDirective(line, "include", &rest)){
+            *out += line;
+            *out += '\n';
+            continue;
+        }
+
+        size_t open = rest.find('"');
+        size_t close = open == std::string::npos ? std::string::npos : rest.find('"', open + 1);
+        if(close == std::string::npos){
+            source->m_Error = path + ":" + std::to_string(lineNumber) + ": expected #include \"file\"";
+            return false;
+        }
+        std::string includePath = DirectoryOf(path) + rest.substr(open + 1, close - open - 1);
+        if(std::find(source->m_Files.begin(), source->m_Files.end(), includePath) != source->m_Files.end()){
+            *out += "\n";
+            continue;
+        }
+        if(!Expand(source, includePath, depth + 1, out, versionLine)){
+            return false;
+        }
+        *out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+    }
+    return true;
+}
+
+bool ShaderSource_Load(ShaderSource *source, const char *path, uint32_t features){
+    *source = ShaderSource();
+    source->m_Requested = features;
+    std::string body;
+    std::string versionLine;
+    if(!Expand(source, path, 0, &body, &versionLine)){
+        return false;
+    }
+
+    // " 410 core" -> 410, " core"
+    char *profile = nullptr;
+    int version = versionLine.empty() ? 110 : (int)strtol(versionLine.c_str(), &profile, 10);
+    std::string header;
+    for(const ShaderFeature &feature : gShaderFeatures){
+        if(!ContainsIdentifier(body, feature.m_Define)){
+            continue;
+        }
+        bool enabled = (features & feature.m_Bit) != 0;
+        header += std::string("#define ") + feature.m_Define + (enabled ? " 1\n" : " 0\n");
+        if(enabled){
+            source->m_Features |= feature.m_Bit;
+            source->m_Defines += std::string(source->m_Defines.empty() ? "" : " ") + feature.m_Define + "=1";
+            version = std::max(version, feature.m_MinVersion);
+        }
+    }
+
+    source->m_Text = "#version " + std::to_string(version) + (profile ? profile : "") + "\n";
+    source->m_Text += header;
+    source->m_Text += "#line 1 0\n";
+    source->m_Text += body;
+    return true;
+}
+
+std::string ShaderSource_FeatureNames(uint32_t features){
+    std::string names;
+    for(const ShaderFeature &feature : gShaderFeatures){
+        if(features & feature.m_Bit){
+            names += std::string(names.empty() ? "" : "|") + feature.m_Define;
+        }
+    }
+    return names.empty() ? "none" : names;
+}
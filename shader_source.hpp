@@ -0,0 +1,38 @@
+#ifndef SHADER_SOURCE_HPP
+#define SHADER_SOURCE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compile time features of a shader variant. Each bit is a "#define SHADER_X 0/1"
+// in front of the source, so a variant's branches are resolved by the GLSL
+// preprocessor and the compiled program carries none of them.
+enum ShaderFeatureBits{
+    SHADER_INSTANCED = 1 << 0,  // model-view-projection from a per instance attribute (instancing.hpp)
+    SHADER_INDIRECT  = 1 << 1,  // model-view-projection from the indirect renderer's storage buffers (indirect.hpp)
+};
+
+// A shader file with its includes expanded and the feature defines applied
+struct ShaderSource{
+    std::string m_Text;                 // ready for glShaderSource
+    // m_Files[0] is the file itself, then every include; the index is the source
+    // string number of the "#line" directives, so "1(12)" in a log is m_Files[1] line 12
+    std::vector<std::string> m_Files;
+    uint32_t m_Requested = 0;           // features asked for
+    uint32_t m_Features = 0;            // the subset the source actually tests
+    std::string m_Defines;              // those as "NAME=1 ...", part of the program cache key
+    std::string m_Error;                // set when ShaderSource_Load returns false
+};
+
+// Reads path and splices in every `#include "file"` (relative to the including file,
+// each file once). The `#version` line of path stays first; features that need a
+// newer GLSL (SHADER_INDIRECT: 430) raise it. Defines are only emitted for features
+// the source mentions, so variants differing in features a shader ignores come out
+// identical and are deduplicated by their text.
+bool ShaderSource_Load(ShaderSource *source, const char *path, uint32_t features);
+
+// "SHADER_INSTANCED|SHADER_INDIRECT", "none" for 0
+std::string ShaderSource_FeatureNames(uint32_t features);
+
+#endif
@@ -0,0 +1,58 @@
+#include "shader_variants.hpp"
+#include "program_cache.hpp"
+
+#include <cstdio>
+
+Pipeline* ShaderVariants_Get(ShaderVariantCache *cache, const char *vertexFile, const char *fragmentFile, uint32_t features){
+    cache->m_Stats.m_Requested++;
+    std::string request = std::string(vertexFile) + "|" + fragmentFile + "|" + std::to_string(features);
+    auto known = cache->m_ByRequest.find(request);
+    if(known != cache->m_ByRequest.end()){
+        cache->m_Stats.m_Reused++;
+        return known->second;
+    }
+
+    ShaderSource vertex, fragment;
+    bool loaded = ShaderSource_Load(&vertex, vertexFile, features) && ShaderSource_Load(&fragment, fragmentFile, features);
+    // the program cache key already hashes exactly what gets compiled
+    uint64_t hash = loaded ? ProgramCache_Key(vertex.m_Text, fragment.m_Text, "") : 0;
+    auto same = loaded ? cache->m_BySource.find(hash) : cache->m_BySource.end();
+    if(same != cache->m_BySource.end()){
+        cache->m_Stats.m_Reused++;
+        cache->m_Stats.m_Deduplicated++;
+        cache->m_ByRequest[request] = same->second;
+        return same->second;
+    }
+
+    cache->m_Pipelines.emplace_back();
+    Pipeline *pipeline = &cache->m_Pipelines.back();
+    cache->m_ByRequest[request] = pipeline;
+    cache->m_Stats.m_Compiled++;
+    if(loaded){
+        cache->m_BySource[hash] = pipeline;
+        Pipeline_CreateFromSourceAsync(pipeline, vertexFile, fragmentFile, vertex, fragment);
+    }else{
+        // reports the preprocessing error and settles as failed
+        Pipeline_CreateAsync(pipeline, vertexFile, fragmentFile, features);
+    }
+    return pipeline;
+}
+
+void ShaderVariants_Delete(ShaderVariantCache *cache){
+    for(Pipeline &pipeline : cache->m_Pipelines){
+        Pipeline_Delete(&pipeline);
+    }
+    *cache = ShaderVariantCache();
+}
+
+void ShaderVariants_PrintStats(const ShaderVariantCache *cache){
+    const ShaderVariantStats &stats = cache->m_Stats;
+    printf("shader variants: %u requested, %u compiled, %u reused (%u deduplicated by source)\n",
+           stats.m_Requested, stats.m_Compiled, stats.m_Reused, stats.m_Deduplicated);
+    for(const Pipeline &pipeline : cache->m_Pipelines){
+        printf("  %s + %s [%s]: %s, %.1f ms\n", pipeline.m_VertexFile.c_str(), pipeline.m_FragmentFile.c_str(),
+               ShaderSource_FeatureNames(pipeline.m_Features).c_str(),
+               pipeline.m_Status == PIPELINE_READY ? "ready" : pipeline.m_Status == PIPELINE_FAILED ? "failed" : "building",
+               pipeline.m_BuildMs);
+    }
+}
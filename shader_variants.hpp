@@ -0,0 +1,37 @@
+#ifndef SHADER_VARIANTS_HPP
+#define SHADER_VARIANTS_HPP
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "pipeline.hpp"
+
+struct ShaderVariantStats{
+    unsigned m_Requested = 0;   // ShaderVariants_Get calls
+    unsigned m_Compiled = 0;    // distinct programs built (from source or the program cache)
+    unsigned m_Reused = 0;      // requests served by an existing program
+    unsigned m_Deduplicated = 0;    // of those, different feature sets that preprocessed to the same sources
+};
+
+// Owns one Pipeline per distinct preprocessed (vertex, fragment) pair
+struct ShaderVariantCache{
+    std::deque<Pipeline> m_Pipelines;       // deque, handed out pointers stay valid
+    // "vertex|fragment|features" -> pipeline, the fast path for repeated requests
+    std::unordered_map<std::string, Pipeline*> m_ByRequest;
+    // hash of both preprocessed stages -> pipeline
+    std::unordered_map<uint64_t, Pipeline*> m_BySource;
+    ShaderVariantStats m_Stats;
+};
+
+// The variant of the pair for features (ShaderFeatureBits). The first request
+// preprocesses both files and submits the build with Pipeline_CreateFromSourceAsync,
+// so it may not be ready yet: poll it, the draw paths skip it until then. Requesting
+// every variant at startup prewarms them, requesting on first use compiles lazily.
+Pipeline* ShaderVariants_Get(ShaderVariantCache *cache, const char *vertexFile, const char *fragmentFile, uint32_t features);
+void ShaderVariants_Delete(ShaderVariantCache *cache);
+
+void ShaderVariants_PrintStats(const ShaderVariantCache *cache);
+
+#endif
@@ -0,0 +1,126 @@
+#include "sim_thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "profiler.hpp"
+
+// the other side usually catches up within a few microseconds, spin before sleeping
+#define SIM_THREAD_SPIN_COUNT 64
+
+// sleeps while *word == value (or until woken)
+static void FutexWait(std::atomic<uint32_t> *word, uint32_t value){
+    for(int spin=0; spin<SIM_THREAD_SPIN_COUNT; spin++){
+        if(word->load(std::memory_order_acquire) != value){
+            return;
+        }
+        std::this_thread::yield();
+    }
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+}
+
+static void FutexWakeAll(std::atomic<uint32_t> *word){
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// anything the sim thread may be asleep for changes m_Wake first, so no wakeup gets lost
+static void Signal(SimThread *sim){
+    sim->m_Wake.fetch_add(1, std::memory_order_release);
+    FutexWakeAll(&sim->m_Wake);
+}
+
+static void SimLoop(SimThread *sim){
+    Profiler_SetThreadName("sim");
+    uint32_t produced = 0;
+    for(;;){
+        uint32_t wake = sim->m_Wake.load(std::memory_order_acquire);
+        if(sim->m_Quit.load(std::memory_order_acquire)){
+            break;
+        }
+        if(sim->m_PauseRequested.load(std::memory_order_acquire)){
+            if(sim->m_Paused.exchange(1, std::memory_order_acq_rel) == 0){
+                FutexWakeAll(&sim->m_Paused);
+            }
+            FutexWait(&sim->m_Wake, wake);
+            continue;
+        }
+        sim->m_Paused.store(0, std::memory_order_release);
+
+        // the slot is free once the render thread moved past what was in it
+        if(produced - sim->m_Consumed.load(std::memory_order_acquire) >= sim->m_SnapshotCount){
+            auto start = std::chrono::steady_clock::now();
+            FutexWait(&sim->m_Wake, wake);
+            sim->m_StallNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+                                     std::memory_order_relaxed);
+            continue;
+        }
+
+        sim->m_Step(&sim->m_Snapshots[produced % sim->m_SnapshotCount]);
+        sim->m_Produced.store(++produced, std::memory_order_release);
+        FutexWakeAll(&sim->m_Produced);
+    }
+}
+
+void SimThread_Start(SimThread *sim, uint32_t snapshots, std::function<void(FrameSnapshot *snapshot)> step){
+    sim->m_SnapshotCount = std::min<uint32_t>(SIM_THREAD_MAX_SNAPSHOTS, std::max<uint32_t>(SIM_THREAD_MIN_SNAPSHOTS, snapshots));
+    sim->m_Step = std::move(step);
+    sim->m_Produced = 0;
+    sim->m_Consumed = 0;
+    sim->m_Wake = 0;
+    sim->m_PauseRequested = false;
+    sim->m_Paused = 0;
+    sim->m_Quit = false;
+    sim->m_StallNs = 0;
+    sim->m_Thread = std::thread(SimLoop, sim);
+}
+
+void SimThread_Stop(SimThread *sim){
+    if(!sim->m_Thread.joinable()){
+        return;
+    }
+    sim->m_Quit.store(true, std::memory_order_release);
+    Signal(sim);
+    sim->m_Thread.join();
+}
+
+const FrameSnapshot* SimThread_LatestFrame(SimThread *sim){
+    uint32_t produced;
+    while((produced = sim->m_Produced.load(std::memory_order_acquire)) == 0){
+        FutexWait(&sim->m_Produced, produced);
+    }
+    // everything before the newest is free to overwrite
+    uint32_t latest = produced - 1;
+    if(sim->m_Consumed.load(std::memory_order_relaxed) != latest){
+        sim->m_Consumed.store(latest, std::memory_order_release);
+        Signal(sim);
+    }
+    return &sim->m_Snapshots[latest % sim->m_SnapshotCount];
+}
+
+void SimThread_Pause(SimThread *sim){
+    if(!sim->m_Thread.joinable()){
+        return;
+    }
+    sim->m_PauseRequested.store(true, std::memory_order_release);
+    Signal(sim);
+    while(sim->m_Paused.load(std::memory_order_acquire) == 0){
+        FutexWait(&sim->m_Paused, 0);
+    }
+}
+
+void SimThread_Resume(SimThread *sim){
+    if(!sim->m_Thread.joinable()){
+        return;
+    }
+    sim->m_PauseRequested.store(false, std::memory_order_release);
+    Signal(sim);
+    // don't return before it has left the pause, a second Pause must see a fresh acknowledgement
+    while(sim->m_Paused.load(std::memory_order_acquire) != 0){
+        std::this_thread::yield();
+    }
+}
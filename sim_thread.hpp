@@ -0,0 +1,72 @@
+#ifndef SIM_THREAD_HPP
+#define SIM_THREAD_HPP
+
+#include <glm/mat4x4.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "camera.hpp"
+#include "mesh.hpp"
+
+// double buffering by default: the simulation writes the next state while the last one renders
+#define SIM_THREAD_MIN_SNAPSHOTS 2
+#define SIM_THREAD_MAX_SNAPSHOTS 3
+
+// Everything the render thread needs from one simulation step, so it never
+// reads the camera or the transform pool while the next step is changing them.
+// Holds the state before the step too, frames drawn until the next snapshot
+// arrives blend between the two.
+struct FrameSnapshot{
+    uint64_t m_Tick = 0;                            // fixed ticks simulated up to this state
+    uint64_t m_Time = 0;                            // simulation clock (Clock_Now time base) of the state
+    uint64_t m_PreviousTime = 0;                    // of the previous snapshot's state, equal to m_Time if there was none
+    Camera m_Camera;
+    Camera m_PreviousCamera;
+    glm::mat4 m_View;                               // m_Camera's, what culling used
+    glm::mat4 m_ViewProjection;
+    std::vector<Mesh3D*> m_DrawList;                // visible meshes
+    std::vector<glm::mat4> m_ModelMatrices;         // parallel to m_DrawList
+    std::vector<glm::mat4> m_PreviousModelMatrices;
+    double m_SimulateMs = 0.0;
+};
+
+// Runs m_Step on its own thread, one snapshot per step, into a ring the render
+// thread always takes the newest snapshot of. Single producer/single consumer
+// without locks: publishing or moving to a newer snapshot is one atomic counter
+// update, a side only sleeps (futex) when the ring is full or still empty.
+// The step paces itself (e.g. sleeps until its next tick is due).
+struct SimThread{
+    FrameSnapshot m_Snapshots[SIM_THREAD_MAX_SNAPSHOTS];
+    uint32_t m_SnapshotCount = SIM_THREAD_MIN_SNAPSHOTS;
+    std::function<void(FrameSnapshot *snapshot)> m_Step;
+    std::thread m_Thread;
+
+    std::atomic<uint32_t> m_Produced{0};    // snapshots published, written by the sim thread
+    std::atomic<uint32_t> m_Consumed{0};    // snapshot the render thread holds, written by the render thread
+    std::atomic<uint32_t> m_Wake{0};        // bumped on release/pause/resume/stop, what the sim thread sleeps on
+    std::atomic<bool> m_PauseRequested{false};
+    std::atomic<uint32_t> m_Paused{0};      // set by the sim thread while it holds still
+    std::atomic<bool> m_Quit{false};
+
+    // sim thread time blocked on a full ring (render bound) since start
+    std::atomic<uint64_t> m_StallNs{0};
+};
+
+// snapshots: 2 (double) or 3 (triple, one more frame of latency to absorb spikes)
+void SimThread_Start(SimThread *sim, uint32_t snapshots, std::function<void(FrameSnapshot *snapshot)> step);
+void SimThread_Stop(SimThread *sim);
+
+// Newest published snapshot, waits for the first one. The older ones go back to
+// the sim thread; the returned one stays valid until the next call (it may come
+// back again when no new step finished in between).
+const FrameSnapshot* SimThread_LatestFrame(SimThread *sim);
+
+// Returns once the sim thread is between steps and keeps it there until
+// SimThread_Resume, for changes to state the steps read (e.g. mesh bounds)
+void SimThread_Pause(SimThread *sim);
+void SimThread_Resume(SimThread *sim);
+
+#endif
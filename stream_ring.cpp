@@ -0,0 +1,131 @@
+#include "stream_ring.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+static const GLbitfield kPersistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+// segments start on this boundary so any UBO/SSBO offset alignment holds at the segment start
+#define STREAM_RING_SEGMENT_ALIGNMENT 4096
+
+static void WaitSegment(StreamRing *ring, unsigned segment){
+    GLsync fence = ring->m_Fences[segment];
+    if(fence == nullptr){
+        return;
+    }
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if(status == GL_TIMEOUT_EXPIRED){
+        ring->m_FenceWaits++;
+        auto start = std::chrono::steady_clock::now();
+        while(status == GL_TIMEOUT_EXPIRED){
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        ring->m_FenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(fence);
+    ring->m_Fences[segment] = nullptr;
+}
+
+static bool CreateBuffer(StreamRing *ring, GLsizeiptr segmentSize){
+    segmentSize = (segmentSize + STREAM_RING_SEGMENT_ALIGNMENT - 1) / STREAM_RING_SEGMENT_ALIGNMENT * STREAM_RING_SEGMENT_ALIGNMENT;
+    GLsizeiptr size = segmentSize * STREAM_RING_SEGMENTS;
+    ring->m_SegmentSize = segmentSize;
+    ring->m_Persistent = gGLExt.m_BufferStorage;
+
+    glGenBuffers(1, &ring->m_Buffer);
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, ring->m_Buffer);
+    if(ring->m_Persistent){
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, kPersistentFlags);
+        ring->m_Mapped = (uint8_t *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, kPersistentFlags);
+    }else{
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        ring->m_Mapped = (uint8_t *)malloc(size);
+    }
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return ring->m_Mapped != nullptr;
+}
+
+static void DeleteBuffer(StreamRing *ring){
+    for(unsigned segment=0; segment<STREAM_RING_SEGMENTS; segment++){
+        if(ring->m_Fences[segment]){
+            glDeleteSync(ring->m_Fences[segment]);
+            ring->m_Fences[segment] = nullptr;
+        }
+    }
+    if(!ring->m_Persistent){
+        free(ring->m_Mapped);
+    }
+    // deleting the buffer unmaps it
+    GLState_DeleteBuffers(1, &ring->m_Buffer);
+    ring->m_Buffer = 0;
+    ring->m_Mapped = nullptr;
+}
+
+bool StreamRing_Create(StreamRing *ring, GLsizeiptr segmentSize){
+    *ring = StreamRing();
+    if(!CreateBuffer(ring, std::max<GLsizeiptr>(segmentSize, 1))){
+        DeleteBuffer(ring);
+        return false;
+    }
+    return true;
+}
+
+void StreamRing_Delete(StreamRing *ring){
+    DeleteBuffer(ring);
+    *ring = StreamRing();
+}
+
+void StreamRing_Reserve(StreamRing *ring, GLsizeiptr segmentSize){
+    if(segmentSize <= ring->m_SegmentSize || ring->m_InFrame){
+        return;
+    }
+    for(unsigned segment=0; segment<STREAM_RING_SEGMENTS; segment++){
+        WaitSegment(ring, segment);
+    }
+    DeleteBuffer(ring);
+    CreateBuffer(ring, std::max(segmentSize, ring->m_SegmentSize * 2));
+}
+
+void StreamRing_BeginFrame(StreamRing *ring){
+    ring->m_Segment = (ring->m_Segment + 1) % STREAM_RING_SEGMENTS;
+    ring->m_Head = 0;
+    ring->m_Flushed = 0;
+    ring->m_InFrame = true;
+    WaitSegment(ring, ring->m_Segment);
+}
+
+StreamAllocation StreamRing_Allocate(StreamRing *ring, GLsizeiptr size, GLsizeiptr alignment){
+    StreamAllocation allocation;
+    GLsizeiptr offset = (ring->m_Head + alignment - 1) & ~(alignment - 1);
+    if(!ring->m_InFrame || ring->m_Mapped == nullptr || offset + size > ring->m_SegmentSize){
+        ring->m_Overflows++;
+        return allocation;
+    }
+    ring->m_Head = offset + size;
+    allocation.m_Offset = ring->m_SegmentSize * ring->m_Segment + offset;
+    allocation.m_Data = ring->m_Mapped + allocation.m_Offset;
+    allocation.m_Size = size;
+    return allocation;
+}
+
+void StreamRing_Flush(StreamRing *ring){
+    if(ring->m_Persistent || ring->m_Head <= ring->m_Flushed){
+        return;
+    }
+    GLintptr start = ring->m_SegmentSize * ring->m_Segment + ring->m_Flushed;
+    GLState_BindBuffer(GL_COPY_WRITE_BUFFER, ring->m_Buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, start, ring->m_Head - ring->m_Flushed, ring->m_Mapped + start);
+    ring->m_Flushed = ring->m_Head;
+}
+
+void StreamRing_EndFrame(StreamRing *ring){
+    if(!ring->m_InFrame){
+        return;
+    }
+    ring->m_InFrame = false;
+    ring->m_Frames++;
+    ring->m_PeakBytes = std::max(ring->m_PeakBytes, ring->m_Head);
+    ring->m_Fences[ring->m_Segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,63 @@
+#ifndef STREAM_RING_HPP
+#define STREAM_RING_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+#include "gl_ext.hpp"
+
+// Segments in the ring, the GPU can still be reading the previous frames' data
+#define STREAM_RING_SEGMENTS 3
+
+// Where an allocation lives, m_Data == nullptr if it didn't fit this frame
+struct StreamAllocation{
+    void *m_Data = nullptr;         // CPU write pointer, valid until the frame's StreamRing_EndFrame
+    GLintptr m_Offset = 0;          // same bytes as seen by the GPU, offset into StreamRing::m_Buffer
+    GLsizeiptr m_Size = 0;
+};
+
+// Per frame upload space for dynamic data (matrices, draw commands, ...). One buffer
+// mapped persistent + coherent for its whole life, split into STREAM_RING_SEGMENTS
+// segments; a frame bump allocates from one segment, and the fence issued at the end
+// of the frame is waited on before that segment is reused, three frames later.
+// Without buffer storage the segment is written to CPU memory and uploaded by
+// StreamRing_Flush with glBufferSubData instead.
+struct StreamRing{
+    GLuint m_Buffer = 0;
+    uint8_t *m_Mapped = nullptr;    // whole ring
+    GLsizeiptr m_SegmentSize = 0;
+    bool m_Persistent = false;
+
+    unsigned m_Segment = 0;         // being written this frame
+    GLsizeiptr m_Head = 0;          // bytes used in it
+    GLsizeiptr m_Flushed = 0;       // bytes of it already uploaded (non persistent fallback)
+    bool m_InFrame = false;
+    GLsync m_Fences[STREAM_RING_SEGMENTS] = {};
+
+    // stats, for sizing the ring
+    unsigned m_Frames = 0;
+    unsigned m_FenceWaits = 0;      // segment still in use by the GPU when its frame began
+    double m_FenceWaitMs = 0.0;
+    unsigned m_Overflows = 0;       // allocations refused because the segment was full
+    GLsizeiptr m_PeakBytes = 0;     // most bytes used by one frame
+};
+
+bool StreamRing_Create(StreamRing *ring, GLsizeiptr segmentSize);
+void StreamRing_Delete(StreamRing *ring);
+
+// Between frames only: makes every segment at least segmentSize bytes, waiting for
+// the GPU to let go of the old buffer first. Previous allocations become invalid.
+void StreamRing_Reserve(StreamRing *ring, GLsizeiptr segmentSize);
+
+// Moves to the next segment, waiting on its fence if the GPU is still reading it
+void StreamRing_BeginFrame(StreamRing *ring);
+// O(1) bump allocation inside the current segment, alignment must be a power of two
+StreamAllocation StreamRing_Allocate(StreamRing *ring, GLsizeiptr size, GLsizeiptr alignment);
+// After writing and before drawing with the data, uploads it when the ring isn't
+// persistently mapped (no-op otherwise, coherent writes are seen by later draws)
+void StreamRing_Flush(StreamRing *ring);
+// After the frame's last draw reading the ring, fences the segment
+void StreamRing_EndFrame(StreamRing *ring);
+
+#endif
@@ -0,0 +1,237 @@
+#include "transform.hpp"
+#include "jobs.hpp"
+
+#include <algorithm>
+
+// smaller pieces of a level cost more to hand to a worker than to update
+#define TRANSFORM_MIN_PARALLEL_CHUNK 4096
+
+TransformPool gTransformPool;
+
+glm::mat4 Transform_Compose(glm::vec3 t, glm::quat q, glm::vec3 s){
+    float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+    float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+    float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+
+    glm::mat4 m;
+    m[0] = glm::vec4((1.0f - 2.0f*(yy + zz)) * s.x, 2.0f*(xy + wz) * s.x, 2.0f*(xz - wy) * s.x, 0.0f);
+    m[1] = glm::vec4(2.0f*(xy - wz) * s.y, (1.0f - 2.0f*(xx + zz)) * s.y, 2.0f*(yz + wx) * s.y, 0.0f);
+    m[2] = glm::vec4(2.0f*(xz + wy) * s.z, 2.0f*(yz - wx) * s.z, (1.0f - 2.0f*(xx + yy)) * s.z, 0.0f);
+    m[3] = glm::vec4(t, 1.0f);
+    return m;
+}
+
+static void LinkChild(TransformPool *pool, uint32_t child, uint32_t parent){
+    pool->m_Parent[child] = parent;
+    pool->m_PreviousSibling[child] = TRANSFORM_NONE;
+    pool->m_NextSibling[child] = TRANSFORM_NONE;
+    if(parent == TRANSFORM_NONE){
+        return;
+    }
+    uint32_t next = pool->m_FirstChild[parent];
+    pool->m_NextSibling[child] = next;
+    if(next != TRANSFORM_NONE){
+        pool->m_PreviousSibling[next] = child;
+    }
+    pool->m_FirstChild[parent] = child;
+}
+
+static void UnlinkChild(TransformPool *pool, uint32_t child){
+    uint32_t parent = pool->m_Parent[child];
+    if(parent == TRANSFORM_NONE){
+        return;
+    }
+    uint32_t previous = pool->m_PreviousSibling[child];
+    uint32_t next = pool->m_NextSibling[child];
+    if(previous != TRANSFORM_NONE){
+        pool->m_NextSibling[previous] = next;
+    }else{
+        pool->m_FirstChild[parent] = next;
+    }
+    if(next != TRANSFORM_NONE){
+        pool->m_PreviousSibling[next] = previous;
+    }
+    pool->m_Parent[child] = TRANSFORM_NONE;
+}
+
+Transform TransformPool_Create(TransformPool *pool, Transform parent){
+    Transform transform;
+    // a recycled slot is only usable if it stays behind its parent
+    for(size_t i=0; i<pool->m_FreeList.size(); i++){
+        uint32_t slot = pool->m_FreeList[i];
+        if(parent.m_Index == TRANSFORM_NONE || slot > parent.m_Index){
+            pool->m_FreeList[i] = pool->m_FreeList.back();
+            pool->m_FreeList.pop_back();
+            transform.m_Index = slot;
+            break;
+        }
+    }
+    if(transform.m_Index == TRANSFORM_NONE){
+        transform.m_Index = (uint32_t)pool->m_Translation.size();
+        pool->m_Translation.emplace_back();
+        pool->m_Rotation.emplace_back();
+        pool->m_Scale.emplace_back();
+        pool->m_Parent.emplace_back();
+        pool->m_FirstChild.emplace_back();
+        pool->m_NextSibling.emplace_back();
+        pool->m_PreviousSibling.emplace_back();
+        pool->m_Dirty.emplace_back();
+        pool->m_Changed.emplace_back();
+        pool->m_Alive.emplace_back();
+        pool->m_World.emplace_back();
+        pool->m_PreviousWorld.emplace_back();
+        pool->m_Depth.emplace_back();
+    }
+
+    uint32_t i = transform.m_Index;
+    pool->m_Translation[i] = glm::vec3(0.0f);
+    pool->m_Rotation[i] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    pool->m_Scale[i] = glm::vec3(1.0f);
+    pool->m_FirstChild[i] = TRANSFORM_NONE;
+    LinkChild(pool, i, parent.m_Index);
+    pool->m_Dirty[i] = 1;
+    pool->m_Changed[i] = TRANSFORM_CHANGED_NEW;
+    pool->m_Alive[i] = 1;
+    pool->m_World[i] = glm::mat4(1.0f);
+    pool->m_HierarchyChanged = true;
+    return transform;
+}
+
+void TransformPool_Release(TransformPool *pool, Transform transform){
+    uint32_t i = transform.m_Index;
+    if(i == TRANSFORM_NONE || !pool->m_Alive[i]){
+        return;
+    }
+    pool->m_Alive[i] = 0;
+    UnlinkChild(pool, i);
+    // children become roots rather than pointing at a recycled slot
+    uint32_t child = pool->m_FirstChild[i];
+    while(child != TRANSFORM_NONE){
+        uint32_t next = pool->m_NextSibling[child];
+        pool->m_Parent[child] = TRANSFORM_NONE;
+        pool->m_PreviousSibling[child] = TRANSFORM_NONE;
+        pool->m_NextSibling[child] = TRANSFORM_NONE;
+        pool->m_Dirty[child] = 1;
+        child = next;
+    }
+    pool->m_FirstChild[i] = TRANSFORM_NONE;
+    pool->m_FreeList.push_back(i);
+    pool->m_HierarchyChanged = true;
+}
+
+bool TransformPool_SetParent(TransformPool *pool, Transform child, Transform parent){
+    if(parent.m_Index != TRANSFORM_NONE && parent.m_Index >= child.m_Index){
+        return false;
+    }
+    UnlinkChild(pool, child.m_Index);
+    LinkChild(pool, child.m_Index, parent.m_Index);
+    pool->m_Dirty[child.m_Index] = 1;
+    pool->m_HierarchyChanged = true;
+    return true;
+}
+
+void TransformPool_SetTranslation(TransformPool *pool, Transform transform, glm::vec3 translation){
+    pool->m_Translation[transform.m_Index] = translation;
+    pool->m_Dirty[transform.m_Index] = 1;
+}
+
+void TransformPool_SetRotation(TransformPool *pool, Transform transform, glm::quat rotation){
+    pool->m_Rotation[transform.m_Index] = glm::normalize(rotation);
+    pool->m_Dirty[transform.m_Index] = 1;
+}
+
+void TransformPool_SetScale(TransformPool *pool, Transform transform, glm::vec3 scale){
+    pool->m_Scale[transform.m_Index] = scale;
+    pool->m_Dirty[transform.m_Index] = 1;
+}
+
+void TransformPool_Translate(TransformPool *pool, Transform transform, glm::vec3 offset){
+    uint32_t i = transform.m_Index;
+    // (T R S) * T(offset) moves by R * (S * offset)
+    pool->m_Translation[i] += pool->m_Rotation[i] * (pool->m_Scale[i] * offset);
+    pool->m_Dirty[i] = 1;
+}
+
+void TransformPool_Rotate(TransformPool *pool, Transform transform, float radians, glm::vec3 axis){
+    uint32_t i = transform.m_Index;
+    pool->m_Rotation[i] = glm::normalize(pool->m_Rotation[i] * glm::angleAxis(radians, glm::normalize(axis)));
+    pool->m_Dirty[i] = 1;
+}
+
+void TransformPool_Scale(TransformPool *pool, Transform transform, glm::vec3 scale){
+    uint32_t i = transform.m_Index;
+    pool->m_Scale[i] = pool->m_Scale[i] * scale;
+    pool->m_Dirty[i] = 1;
+}
+
+static void RebuildLevels(TransformPool *pool){
+    size_t count = pool->m_Parent.size();
+    for(std::vector<uint32_t> &level : pool->m_Levels){
+        level.clear();
+    }
+    for(size_t i=0; i<count; i++){
+        if(!pool->m_Alive[i]){
+            continue;
+        }
+        uint32_t parent = pool->m_Parent[i];
+        // parents come first, so their depth is already known
+        uint32_t depth = parent == TRANSFORM_NONE ? 0 : pool->m_Depth[parent] + 1;
+        pool->m_Depth[i] = depth;
+        if(depth >= pool->m_Levels.size()){
+            pool->m_Levels.resize(depth + 1);
+        }
+        pool->m_Levels[depth].push_back((uint32_t)i);
+    }
+    pool->m_HierarchyChanged = false;
+}
+
+static size_t UpdateRange(TransformPool *pool, const uint32_t *nodes, size_t count){
+    size_t updated = 0;
+    for(size_t n=0; n<count; n++){
+        uint32_t i = nodes[n];
+        uint32_t parent = pool->m_Parent[i];
+        bool changed = pool->m_Dirty[i] || (parent != TRANSFORM_NONE && pool->m_Changed[parent]);
+        bool created = pool->m_Changed[i] == TRANSFORM_CHANGED_NEW;
+        pool->m_Changed[i] = changed;
+        if(!changed){
+            continue;
+        }
+        glm::mat4 local = Transform_Compose(pool->m_Translation[i], pool->m_Rotation[i], pool->m_Scale[i]);
+        glm::mat4 world = parent == TRANSFORM_NONE ? local : pool->m_World[parent] * local;
+        if(pool->m_TrackPrevious){
+            // a new node has no earlier position to come from
+            pool->m_PreviousWorld[i] = created ? world : pool->m_World[i];
+        }
+        pool->m_World[i] = world;
+        pool->m_Dirty[i] = 0;
+        updated++;
+    }
+    return updated;
+}
+
+void TransformPool_Update(TransformPool *pool){
+    if(pool->m_HierarchyChanged){
+        RebuildLevels(pool);
+    }
+
+    size_t updated = 0;
+    std::vector<size_t> &chunkUpdated = pool->m_ChunkUpdated;
+    for(const std::vector<uint32_t> &level : pool->m_Levels){
+        size_t count = level.size();
+        size_t chunks = Jobs_ChunkCount(count, TRANSFORM_MIN_PARALLEL_CHUNK);
+        if(chunks <= 1){
+            updated += UpdateRange(pool, level.data(), count);
+            continue;
+        }
+
+        // each chunk only writes its own nodes and reads parents from finished levels
+        chunkUpdated.assign(chunks, 0);
+        Jobs_ParallelChunks(chunks, count, [pool, &level, &chunkUpdated](size_t c, size_t first, size_t last){
+            chunkUpdated[c] = UpdateRange(pool, level.data() + first, last - first);
+        });
+        for(size_t n : chunkUpdated){
+            updated += n;
+        }
+    }
+    pool->m_UpdatedCount = updated;
+}
@@ -0,0 +1,91 @@
+#ifndef TRANSFORM_HPP
+#define TRANSFORM_HPP
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define TRANSFORM_NONE 0xFFFFFFFFu
+// m_Changed of a node created since the last update
+#define TRANSFORM_CHANGED_NEW 2
+
+// Handle into a TransformPool
+struct Transform{
+    uint32_t m_Index = TRANSFORM_NONE;
+};
+
+// Local translation/rotation/scale per node in dense parallel arrays.
+// A parent always has a lower index than its children, so walking the
+// arrays front to back (or level by level) visits parents first.
+struct TransformPool{
+    std::vector<glm::vec3> m_Translation;
+    std::vector<glm::quat> m_Rotation;
+    std::vector<glm::vec3> m_Scale;
+    std::vector<uint32_t> m_Parent;         // TRANSFORM_NONE for roots
+    // children of a node as a doubly linked list, so a release only visits its own
+    std::vector<uint32_t> m_FirstChild;
+    std::vector<uint32_t> m_NextSibling;
+    std::vector<uint32_t> m_PreviousSibling;
+    std::vector<uint8_t> m_Dirty;           // local TRS changed since the last update
+    std::vector<uint8_t> m_Changed;         // world matrix was recomputed by the last update
+    std::vector<uint8_t> m_Alive;
+    std::vector<glm::mat4> m_World;
+
+    // world matrices from before the last update, for rendering in between two
+    // simulation steps; only written while m_TrackPrevious is set
+    bool m_TrackPrevious = false;
+    std::vector<glm::mat4> m_PreviousWorld;
+
+    std::vector<uint32_t> m_FreeList;
+
+    // node indices grouped by depth, rebuilt when parenting changes;
+    // everything in one level can be updated in parallel
+    std::vector<uint32_t> m_Depth;
+    std::vector<std::vector<uint32_t>> m_Levels;
+    bool m_HierarchyChanged = false;
+    std::vector<size_t> m_ChunkUpdated;     // scratch, per chunk of the level being updated
+
+    // stats of the last update
+    size_t m_UpdatedCount = 0;
+};
+
+// The pool meshes allocate their transforms from
+extern TransformPool gTransformPool;
+
+// parent must already exist (it ends up with a lower index than the new node)
+Transform TransformPool_Create(TransformPool *pool, Transform parent = Transform());
+void TransformPool_Release(TransformPool *pool, Transform transform);
+// Fails (returns false) if it would put the parent after the child in the arrays
+bool TransformPool_SetParent(TransformPool *pool, Transform child, Transform parent);
+
+void TransformPool_SetTranslation(TransformPool *pool, Transform transform, glm::vec3 translation);
+void TransformPool_SetRotation(TransformPool *pool, Transform transform, glm::quat rotation);
+void TransformPool_SetScale(TransformPool *pool, Transform transform, glm::vec3 scale);
+
+// Same meaning as glm::translate/rotate/scale applied on the right of the local
+// matrix, but kept as TRS so the rotation doesn't drift frame after frame
+void TransformPool_Translate(TransformPool *pool, Transform transform, glm::vec3 offset);
+void TransformPool_Rotate(TransformPool *pool, Transform transform, float radians, glm::vec3 axis);
+void TransformPool_Scale(TransformPool *pool, Transform transform, glm::vec3 scale);
+
+// Recomputes world matrices of dirty nodes and their descendants, level by
+// level, splitting big levels into chunks across the job system's workers
+void TransformPool_Update(TransformPool *pool);
+
+inline const glm::mat4& TransformPool_World(const TransformPool *pool, Transform transform){
+    return pool->m_World[transform.m_Index];
+}
+
+// World matrix before the last update, the current one if that update didn't move it
+inline const glm::mat4& TransformPool_PreviousWorld(const TransformPool *pool, Transform transform){
+    uint32_t i = transform.m_Index;
+    return pool->m_TrackPrevious && pool->m_Changed[i] ? pool->m_PreviousWorld[i] : pool->m_World[i];
+}
+
+// T * R * S without going through three mat4 multiplies
+glm::mat4 Transform_Compose(glm::vec3 translation, glm::quat rotation, glm::vec3 scale);
+
+#endif
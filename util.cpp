@@ -1,32 +1,219 @@
 #include "util.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileView::FileView(FileView &&other) noexcept{
+    *this = std::move(other);
+}
+
+FileView& FileView::operator=(FileView &&other) noexcept{
+    if(this != &other){
+        FileView_Close(this);
+        m_Data = other.m_Data;
+        m_Size = other.m_Size;
+        m_Mapping = other.m_Mapping;
+        m_Buffer = other.m_Buffer;
+        m_ModifiedNs = other.m_ModifiedNs;
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+        other.m_Mapping = nullptr;
+        other.m_Buffer = nullptr;
+    }
+    return *this;
+}
+
+FileView::~FileView(){
+    FileView_Close(this);
+}
+
+void FileView_Advise(const FileView *view, FileAccess access){
+    if(view->m_Mapping == nullptr){
+        return;
+    }
+    int advice = access == FILE_ACCESS_RANDOM ? MADV_RANDOM : access == FILE_ACCESS_WILLNEED ? MADV_WILLNEED : MADV_SEQUENTIAL;
+    madvise(view->m_Mapping, view->m_Size, advice);
+}
+
+// takes ownership of fd
+static bool OpenDescriptor(FileView *view, int fd, size_t size, int64_t modifiedNs, FileAccess access){
+    FileView_Close(view);
+    view->m_ModifiedNs = modifiedNs;
+    if(size == 0){
+        close(fd);
+        view->m_Data = "";
+        return true;
+    }
+    if(size < FILE_VIEW_MMAP_THRESHOLD){
+        char *buffer = (char *)malloc(size);
+        size_t done = 0;
+        while(buffer && done < size){
+            ssize_t got = pread(fd, buffer + done, size - done, done);
+            if(got <= 0){
+                if(got < 0 && errno == EINTR){
+                    continue;
+                }
+                break;
+            }
+            done += got;
+        }
+        close(fd);
+        if(buffer == nullptr || done != size){
+            free(buffer);
+            return false;
+        }
+        view->m_Buffer = buffer;
+        view->m_Data = buffer;
+        view->m_Size = size;
+        return true;
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED){
+        return false;
+    }
+    view->m_Mapping = mapping;
+    view->m_Data = (const char *)mapping;
+    view->m_Size = size;
+    FileView_Advise(view, access);
+    return true;
+}
+
+static int OpenFile(const char *path, size_t *size, int64_t *modifiedNs){
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        return -1;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+        close(fd);
+        errno = EISDIR;
+        return -1;
+    }
+    *size = (size_t)info.st_size;
+    *modifiedNs = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    return fd;
+}
+
+bool FileView_Open(FileView *view, const char *path, FileAccess access, std::string *error){
+    size_t size = 0;
+    int64_t modifiedNs = 0;
+    int fd = OpenFile(path, &size, &modifiedNs);
+    if(fd < 0 || !OpenDescriptor(view, fd, size, modifiedNs, access)){
+        if(error){
+            *error = std::string("could not read ") + path + ": " + strerror(errno);
+        }
+        return false;
+    }
+    return true;
+}
+
+void FileView_Close(FileView *view){
+    if(view->m_Mapping){
+        munmap(view->m_Mapping, view->m_Size);
+    }
+    free(view->m_Buffer);
+    view->m_Data = nullptr;
+    view->m_Size = 0;
+    view->m_Mapping = nullptr;
+    view->m_Buffer = nullptr;
+    view->m_ModifiedNs = 0;
+}
+
+// 8 bytes per step, a multiply and a rotate each, so hashing runs near memory speed
+uint64_t FileView_Hash(const FileView *view){
+    const uint8_t *data = (const uint8_t*)view->m_Data;
+    size_t size = view->m_Size;
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = 0xCBF29CE484222325ull ^ (size * prime);
+    size_t i = 0;
+    for(; i+8 <= size; i+=8){
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+        hash = (hash << 31) | (hash >> 33);
+    }
+    uint64_t tail = 0;
+    if(size > i){
+        memcpy(&tail, data + i, size - i);
+    }
+    hash = (hash ^ tail) * prime;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+size_t FileView_OpenBatch(FileView *views, const char *const *paths, size_t count, FileAccess access, unsigned threads){
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, count));
+    std::vector<size_t> opened(threads, 0);
+
+    // contiguous ranges, files listed together usually sit together on disk
+    auto work = [&](unsigned worker){
+        size_t begin = count * worker / threads, end = count * (worker + 1) / threads;
+        std::vector<int> descriptors(end - begin, -1);
+        std::vector<size_t> sizes(end - begin, 0);
+        std::vector<int64_t> modified(end - begin, 0);
+        for(size_t i=begin; i<end; i++){
+            descriptors[i-begin] = OpenFile(paths[i], &sizes[i-begin], &modified[i-begin]);
+            if(descriptors[i-begin] >= 0 && sizes[i-begin] > 0){
+                readahead(descriptors[i-begin], 0, sizes[i-begin]);
+            }
+        }
+        for(size_t i=begin; i<end; i++){
+            if(descriptors[i-begin] >= 0 && OpenDescriptor(&views[i], descriptors[i-begin], sizes[i-begin], modified[i-begin], access)){
+                opened[worker]++;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned worker=1; worker<threads; worker++){
+        workers.emplace_back(work, worker);
+    }
+    work(0);
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+
+    size_t total = 0;
+    for(size_t n : opened){
+        total += n;
+    }
+    return total;
+}
+
+std::string DirectoryOf(const std::string &path){
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
 std::string get_file_contents(const char* filename)
 {
-	std::ifstream in(filename, std::ios::binary);
-	if (in.is_open())
+	FileView view;
+	if (FileView_Open(&view, filename))
 	{
-		std::string contents;
-		in.seekg(0, std::ios::end);
-		contents.resize(in.tellg());
-		in.seekg(0, std::ios::beg);
-		in.read(&contents[0], contents.size());
-		in.close();
-		return(contents);
+		return std::string(view.m_Data, view.m_Size);
 	}
-	throw(errno);
+	throw std::system_error(errno, std::generic_category(), filename);
 }
 
 std::string load_shader_as_string(const char* filename){
-    std::string result = "";
-
-    std::string line = "";
-    std::ifstream myFile(filename);
-
-    if(myFile.is_open()){
-        while(std::getline(myFile, line)){
-            result += line + '\n';
-        }
-        myFile.close();
+    // one copy out of the view instead of a concatenation per line
+    FileView view;
+    if(!FileView_Open(&view, filename)){
+        return "";
     }
-    return result;
+    return std::string(view.m_Data, view.m_Size);
 }
@@ -3,6 +3,59 @@
 #include<sstream>
 #include<iostream>
 #include<cerrno>
+#include<cstddef>
+#include<cstdint>
 
+#ifndef UTIL_H
+#define UTIL_H
+
+// Files below this are read into a buffer the view owns, mapping and unmapping a
+// few pages costs more than copying them (see bench/bench_file_view.cpp)
+#define FILE_VIEW_MMAP_THRESHOLD (64*1024)
+
+// madvise hint for the mapping
+enum FileAccess{
+    FILE_ACCESS_SEQUENTIAL = 0,     // read once front to back (parsers, hashing)
+    FILE_ACCESS_RANDOM,             // jumped around in, no readahead
+    FILE_ACCESS_WILLNEED,           // all of it soon, page it in now (cache files going to the GPU)
+};
+
+// Read-only contents of a whole file, valid until the view is closed or destroyed.
+// Move only, the mapping (or small file buffer) goes with it.
+struct FileView{
+    const char *m_Data = nullptr;
+    size_t m_Size = 0;
+    void *m_Mapping = nullptr;      // munmap'ed on close, null for small/empty files
+    char *m_Buffer = nullptr;       // small files, freed on close
+    int64_t m_ModifiedNs = 0;       // mtime from the same fstat as m_Size, identifies what was read
+
+    FileView() = default;
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+    FileView(FileView &&other) noexcept;
+    FileView& operator=(FileView &&other) noexcept;
+    ~FileView();
+};
+
+// False (and *error set if given) if the file can't be opened or read
+bool FileView_Open(FileView *view, const char *path, FileAccess access = FILE_ACCESS_SEQUENTIAL, std::string *error = nullptr);
+void FileView_Advise(const FileView *view, FileAccess access);
+void FileView_Close(FileView *view);
+// 64 bit hash of the contents
+uint64_t FileView_Hash(const FileView *view);
+
+// Opens count files on up to threads workers (0: one per core). Each worker issues
+// readahead() for all of its files before mapping any, so the disk sees the whole
+// batch at once. views[i] stays empty where paths[i] failed; returns how many opened.
+size_t FileView_OpenBatch(FileView *views, const char *const *paths, size_t count,
+                          FileAccess access = FILE_ACCESS_SEQUENTIAL, unsigned threads = 0);
+
+// Everything up to and including the last '/', empty for a bare file name
+std::string DirectoryOf(const std::string &path);
+
+// Whole file as a string, throws std::system_error (errno and the path) if it can't be read
 std::string get_file_contents(const char* filename);
+// Whole file as a string, empty if it can't be read
 std::string load_shader_as_string(const char* filename);
+
+#endif